@@ -6,7 +6,7 @@
 
 #include <array>
 #include <cstddef>
-#include <deque>
+#include "common/assert.h"
 #include "common/common_types.h"
 
 namespace AudioCore {
@@ -23,8 +23,59 @@ using StereoFrame16 = std::array<std::array<s16, 2>, samples_per_frame>;
 /// The DSP is quadraphonic internally.
 using QuadFrame32 = std::array<std::array<s32, 4>, samples_per_frame>;
 
-/// A variable length buffer of signed PCM16 stereo samples.
-using StereoBuffer16 = std::deque<std::array<s16, 2>>;
+/**
+ * A fixed-capacity FIFO of signed PCM16 stereo samples. The storage is part of the object, so
+ * adding and removing samples never allocates.
+ */
+class StereoBuffer16 {
+public:
+    using Sample = std::array<s16, 2>;
+
+    /// Maximum number of samples in the buffer. Must be a power of two.
+    static constexpr size_t capacity = 1024;
+
+    size_t size() const {
+        return write_index - read_index;
+    }
+
+    bool empty() const {
+        return write_index == read_index;
+    }
+
+    /// Number of samples that can be added before the buffer is full
+    size_t free_space() const {
+        return capacity - size();
+    }
+
+    /// Accesses the i-th oldest sample in the buffer
+    const Sample& operator[](size_t i) const {
+        DEBUG_ASSERT(i < size());
+        return samples[(read_index + i) & index_mask];
+    }
+
+    void push_back(const Sample& sample) {
+        DEBUG_ASSERT(size() < capacity);
+        samples[write_index++ & index_mask] = sample;
+    }
+
+    /// Removes the `count` oldest samples from the buffer
+    void pop_front(size_t count) {
+        DEBUG_ASSERT(count <= size());
+        read_index += count;
+    }
+
+    void clear() {
+        read_index = write_index = 0;
+    }
+
+private:
+    static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+    static constexpr size_t index_mask = capacity - 1;
+
+    std::array<Sample, capacity> samples;
+    size_t read_index = 0;
+    size_t write_index = 0;
+};
 
 constexpr size_t num_dsp_pipe = 8;
 enum class DspPipe {
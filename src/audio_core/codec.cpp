@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
@@ -14,8 +15,9 @@
 namespace AudioCore {
 namespace Codec {
 
-StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count,
-                           const std::array<s16, 16>& adpcm_coeff, ADPCMState& state) {
+void DecodeADPCM(const u8* const data, const size_t first_sample, const size_t sample_count,
+                 const std::array<s16, 16>& adpcm_coeff, ADPCMState& state,
+                 StereoBuffer16& output) {
     // GC-ADPCM with scale factor and variable coefficients.
     // Frames are 8 bytes long containing 14 samples each.
     // Samples are 4 bits (one nibble) long.
@@ -25,15 +27,14 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count,
     constexpr std::array<int, 16> SIGNED_NIBBLES = {
         {0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3, -2, -1}};
 
-    const size_t ret_size =
-        sample_count % 2 == 0 ? sample_count : sample_count + 1; // Ensure multiple of two.
-    StereoBuffer16 ret(ret_size);
+    DEBUG_ASSERT(sample_count <= output.free_space());
 
     int yn1 = state.yn1, yn2 = state.yn2;
 
-    const size_t NUM_FRAMES =
-        (sample_count + (SAMPLES_PER_FRAME - 1)) / SAMPLES_PER_FRAME; // Round up.
-    for (size_t framei = 0; framei < NUM_FRAMES; framei++) {
+    size_t samplei = first_sample;
+    const size_t end_sample = first_sample + sample_count;
+    while (samplei < end_sample) {
+        const size_t framei = samplei / SAMPLES_PER_FRAME;
         const int frame_header = data[framei * FRAME_LEN];
         const int scale = 1 << (frame_header & 0xF);
         const int idx = (frame_header >> 4) & 0x7;
@@ -58,70 +59,62 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count,
             return (s16)val;
         };
 
-        size_t outputi = framei * SAMPLES_PER_FRAME;
-        size_t datai = framei * FRAME_LEN + 1;
-        for (size_t i = 0; i < SAMPLES_PER_FRAME && outputi < sample_count; i += 2) {
-            const s16 sample1 = decode_sample(SIGNED_NIBBLES[data[datai] >> 4]);
-            ret[outputi].fill(sample1);
-            outputi++;
-
-            const s16 sample2 = decode_sample(SIGNED_NIBBLES[data[datai] & 0xF]);
-            ret[outputi].fill(sample2);
-            outputi++;
-
-            datai++;
+        // Each byte after the header holds two samples, the first one in the upper nibble.
+        const size_t frame_end =
+            std::min(end_sample, (framei + 1) * SAMPLES_PER_FRAME) - framei * SAMPLES_PER_FRAME;
+        for (size_t i = samplei - framei * SAMPLES_PER_FRAME; i < frame_end; i++) {
+            const u8 byte = data[framei * FRAME_LEN + 1 + i / 2];
+            const s16 sample = decode_sample(SIGNED_NIBBLES[i % 2 == 0 ? byte >> 4 : byte & 0xF]);
+            output.push_back({sample, sample});
         }
+        samplei = framei * SAMPLES_PER_FRAME + frame_end;
     }
 
     state.yn1 = yn1;
     state.yn2 = yn2;
-
-    return ret;
 }
 
-StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data,
-                          const size_t sample_count) {
+void DecodePCM8(const unsigned num_channels, const u8* const data, const size_t first_sample,
+                const size_t sample_count, StereoBuffer16& output) {
     ASSERT(num_channels == 1 || num_channels == 2);
+    DEBUG_ASSERT(sample_count <= output.free_space());
 
     const auto decode_sample = [](u8 sample) {
         return static_cast<s16>(static_cast<u16>(sample) << 8);
     };
 
-    StereoBuffer16 ret(sample_count);
-
+    const size_t end_sample = first_sample + sample_count;
     if (num_channels == 1) {
-        for (size_t i = 0; i < sample_count; i++) {
-            ret[i].fill(decode_sample(data[i]));
+        for (size_t i = first_sample; i < end_sample; i++) {
+            const s16 sample = decode_sample(data[i]);
+            output.push_back({sample, sample});
         }
     } else {
-        for (size_t i = 0; i < sample_count; i++) {
-            ret[i][0] = decode_sample(data[i * 2 + 0]);
-            ret[i][1] = decode_sample(data[i * 2 + 1]);
+        for (size_t i = first_sample; i < end_sample; i++) {
+            output.push_back({decode_sample(data[i * 2 + 0]), decode_sample(data[i * 2 + 1])});
         }
     }
-
-    return ret;
 }
 
-StereoBuffer16 DecodePCM16(const unsigned num_channels, const u8* const data,
-                           const size_t sample_count) {
+void DecodePCM16(const unsigned num_channels, const u8* const data, const size_t first_sample,
+                 const size_t sample_count, StereoBuffer16& output) {
     ASSERT(num_channels == 1 || num_channels == 2);
+    DEBUG_ASSERT(sample_count <= output.free_space());
 
-    StereoBuffer16 ret(sample_count);
-
+    const size_t end_sample = first_sample + sample_count;
     if (num_channels == 1) {
-        for (size_t i = 0; i < sample_count; i++) {
+        for (size_t i = first_sample; i < end_sample; i++) {
             s16 sample;
             std::memcpy(&sample, data + i * sizeof(s16), sizeof(s16));
-            ret[i].fill(sample);
+            output.push_back({sample, sample});
         }
     } else {
-        for (size_t i = 0; i < sample_count; ++i) {
-            std::memcpy(&ret[i], data + i * sizeof(s16) * 2, 2 * sizeof(s16));
+        for (size_t i = first_sample; i < end_sample; ++i) {
+            StereoBuffer16::Sample sample;
+            std::memcpy(&sample, data + i * sizeof(s16) * 2, 2 * sizeof(s16));
+            output.push_back(sample);
         }
     }
-
-    return ret;
 }
 } // namespace Codec
 } // namespace AudioCore
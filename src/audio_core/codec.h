@@ -20,31 +20,45 @@ struct ADPCMState {
 };
 
 /**
+ * Number of samples produced by decoding an ADPCM buffer. Samples are decoded in pairs, so odd
+ * lengths are rounded up.
+ */
+constexpr size_t GetADPCMDecodedLength(size_t sample_count) {
+    return sample_count % 2 == 0 ? sample_count : sample_count + 1;
+}
+
+/**
+ * Decodes part of an ADPCM buffer. Each sample depends on the previous ones through state, so the
+ * samples of a buffer have to be decoded in order.
  * @param data Pointer to buffer that contains ADPCM data to decode
- * @param sample_count Length of buffer in terms of number of samples
+ * @param first_sample Index of the first sample to decode
+ * @param sample_count Number of samples to decode
  * @param adpcm_coeff ADPCM coefficients
  * @param state ADPCM state, this is updated with new state
- * @return Decoded stereo signed PCM16 data, sample_count in length
+ * @param output Decoded stereo signed PCM16 samples are appended to this buffer
  */
-StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count,
-                           const std::array<s16, 16>& adpcm_coeff, ADPCMState& state);
+void DecodeADPCM(const u8* const data, const size_t first_sample, const size_t sample_count,
+                 const std::array<s16, 16>& adpcm_coeff, ADPCMState& state,
+                 StereoBuffer16& output);
 
 /**
  * @param num_channels Number of channels
  * @param data Pointer to buffer that contains PCM8 data to decode
- * @param sample_count Length of buffer in terms of number of samples
- * @return Decoded stereo signed PCM16 data, sample_count in length
+ * @param first_sample Index of the first sample to decode
+ * @param sample_count Number of samples to decode
+ * @param output Decoded stereo signed PCM16 samples are appended to this buffer
  */
-StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data,
-                          const size_t sample_count);
+void DecodePCM8(const unsigned num_channels, const u8* const data, const size_t first_sample,
+                const size_t sample_count, StereoBuffer16& output);
 
 /**
  * @param num_channels Number of channels
  * @param data Pointer to buffer that contains PCM16 data to decode
- * @param sample_count Length of buffer in terms of number of samples
- * @return Decoded stereo signed PCM16 data, sample_count in length
+ * @param first_sample Index of the first sample to decode
+ * @param sample_count Number of samples to decode
+ * @param output Decoded stereo signed PCM16 samples are appended to this buffer
  */
-StereoBuffer16 DecodePCM16(const unsigned num_channels, const u8* const data,
-                           const size_t sample_count);
+void DecodePCM16(const unsigned num_channels, const u8* const data, const size_t first_sample,
+                 const size_t sample_count, StereoBuffer16& output);
 } // namespace Codec
 } // namespace AudioCore
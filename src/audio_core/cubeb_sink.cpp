@@ -2,10 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
 #include <vector>
 #include <cubeb/cubeb.h>
 #include "audio_core/audio_types.h"
 #include "audio_core/cubeb_sink.h"
+#include "audio_core/sample_ring.h"
 #include "common/logging/log.h"
 #include "core/settings.h"
 
@@ -18,7 +20,7 @@ struct CubebSink::Impl {
     cubeb* ctx = nullptr;
     cubeb_stream* stream = nullptr;
 
-    std::vector<s16> queue;
+    SampleRing queue{sink_queue_capacity};
 
     static long DataCallback(cubeb_stream* stream, void* user_data, const void* input_buffer,
                              void* output_buffer, long num_frames);
@@ -109,15 +111,18 @@ void CubebSink::EnqueueSamples(const s16* samples, size_t sample_count) {
     if (!impl->ctx)
         return;
 
-    impl->queue.reserve(impl->queue.size() + sample_count * 2);
-    std::copy(samples, samples + sample_count * 2, std::back_inserter(impl->queue));
+    impl->queue.Push(samples, sample_count);
 }
 
 size_t CubebSink::SamplesInQueue() const {
     if (!impl->ctx)
         return 0;
 
-    return impl->queue.size() / 2;
+    return impl->queue.Size();
+}
+
+SinkStats CubebSink::GetStats() const {
+    return impl->queue.GetStats();
 }
 
 void CubebSink::SetDevice(int device_id) {}
@@ -125,20 +130,17 @@ void CubebSink::SetDevice(int device_id) {}
 long CubebSink::Impl::DataCallback(cubeb_stream* stream, void* user_data, const void* input_buffer,
                                    void* output_buffer, long num_frames) {
     Impl* impl = static_cast<Impl*>(user_data);
-    u8* buffer = reinterpret_cast<u8*>(output_buffer);
+    s16* buffer = static_cast<s16*>(output_buffer);
 
     if (!impl)
         return 0;
 
-    size_t frames_to_write = std::min(impl->queue.size() / 2, static_cast<size_t>(num_frames));
-
-    memcpy(buffer, impl->queue.data(), frames_to_write * sizeof(s16) * 2);
-    impl->queue.erase(impl->queue.begin(), impl->queue.begin() + frames_to_write * 2);
+    const size_t frames_written = impl->queue.Pop(buffer, static_cast<size_t>(num_frames));
 
-    if (frames_to_write < num_frames) {
+    if (frames_written < static_cast<size_t>(num_frames)) {
         // Fill the rest of the frames with silence
-        memset(buffer + frames_to_write * sizeof(s16) * 2, 0,
-               (num_frames - frames_to_write) * sizeof(s16) * 2);
+        std::memset(buffer + frames_written * 2, 0,
+                    (num_frames - frames_written) * sizeof(s16) * 2);
     }
 
     return num_frames;
@@ -21,6 +21,8 @@ public:
 
     size_t SamplesInQueue() const override;
 
+    SinkStats GetStats() const override;
+
     std::vector<std::string> GetDeviceList() const override;
     void SetDevice(int device_id) override;
 
@@ -39,19 +39,24 @@ void DspInterface::EnableStretching(bool enable) {
     perform_time_stretching = enable;
 }
 
+u32 DspInterface::GetAndResetDroppedFrameCount() {
+    return dropped_frame_count.exchange(0);
+}
+
 void DspInterface::OutputFrame(const StereoFrame16& frame) {
     if (!sink)
         return;
 
     if (perform_time_stretching) {
         time_stretcher.AddSamples(&frame[0][0], frame.size());
-        std::vector<s16> stretched_samples = time_stretcher.Process(sink->SamplesInQueue());
-        sink->EnqueueSamples(stretched_samples.data(), stretched_samples.size() / 2);
+        time_stretcher.Process(sink->SamplesInQueue());
+        EnqueueStretchedSamples();
     } else {
         constexpr size_t maximum_sample_latency = 2048; // about 64 miliseconds
         if (sink->SamplesInQueue() > maximum_sample_latency) {
             // This can occur if we're running too fast and samples are starting to back up.
             // Just drop the samples.
+            dropped_frame_count++;
             return;
         }
 
@@ -64,11 +69,17 @@ void DspInterface::FlushResidualStretcherAudio() {
         return;
 
     time_stretcher.Flush();
+    time_stretcher.Process(sink->SamplesInQueue());
+    EnqueueStretchedSamples();
+}
+
+void DspInterface::EnqueueStretchedSamples() {
+    const size_t max_samples = stretched_samples.size() / 2;
     while (true) {
-        std::vector<s16> residual_audio = time_stretcher.Process(sink->SamplesInQueue());
-        if (residual_audio.empty())
+        const size_t num_samples = time_stretcher.GetSamples(stretched_samples.data(), max_samples);
+        if (num_samples == 0)
             break;
-        sink->EnqueueSamples(residual_audio.data(), residual_audio.size() / 2);
+        sink->EnqueueSamples(stretched_samples.data(), num_samples);
     }
 }
 
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <vector>
 #include "audio_core/audio_types.h"
@@ -66,16 +68,23 @@ public:
     Sink& GetSink();
     /// Enable/Disable audio stretching.
     void EnableStretching(bool enable);
+    /// Returns the number of frames dropped because the sink's queue was full, and resets it.
+    u32 GetAndResetDroppedFrameCount();
 
 protected:
     void OutputFrame(const StereoFrame16& frame);
 
 private:
     void FlushResidualStretcherAudio();
+    void EnqueueStretchedSamples();
 
     std::unique_ptr<Sink> sink;
     bool perform_time_stretching = false;
     TimeStretcher time_stretcher;
+    /// Staging buffer for samples moved from time_stretcher to sink
+    std::array<s16, 2 * 1024> stretched_samples;
+    /// Frames dropped since the last GetAndResetDroppedFrameCount call
+    std::atomic<u32> dropped_frame_count{0};
 };
 
 } // namespace AudioCore
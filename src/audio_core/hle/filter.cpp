@@ -40,11 +40,11 @@ void SourceFilters::ProcessFrame(StereoFrame16& frame) {
         return;
 
     if (simple_filter_enabled) {
-        FilterFrame(frame, simple_filter);
+        simple_filter.ProcessFrame(frame);
     }
 
     if (biquad_filter_enabled) {
-        FilterFrame(frame, biquad_filter);
+        biquad_filter.ProcessFrame(frame);
     }
 }
 
@@ -76,6 +76,23 @@ std::array<s16, 2> SourceFilters::SimpleFilter::ProcessSample(const std::array<s
     return y0;
 }
 
+void SourceFilters::SimpleFilter::ProcessFrame(StereoFrame16& frame) {
+    // Work on local copies of the state: stores to the frame could otherwise alias it, forcing
+    // every sample to reload it from memory.
+    const s32 a1_ = a1;
+    const s32 b0_ = b0;
+    std::array<s32, 2> y1_ = {y1[0], y1[1]};
+
+    for (auto& sample : frame) {
+        for (size_t i = 0; i < 2; i++) {
+            y1_[i] = MathUtil::Clamp((b0_ * sample[i] + a1_ * y1_[i]) >> 15, -32768, 32767);
+            sample[i] = static_cast<s16>(y1_[i]);
+        }
+    }
+
+    y1 = {static_cast<s16>(y1_[0]), static_cast<s16>(y1_[1])};
+}
+
 // BiquadFilter
 
 void SourceFilters::BiquadFilter::Reset() {
@@ -113,5 +130,34 @@ std::array<s16, 2> SourceFilters::BiquadFilter::ProcessSample(const std::array<s
     return y0;
 }
 
+void SourceFilters::BiquadFilter::ProcessFrame(StereoFrame16& frame) {
+    // See SimpleFilter::ProcessFrame
+    const s32 a1_ = a1, a2_ = a2, b0_ = b0, b1_ = b1, b2_ = b2;
+    std::array<s32, 2> x1_ = {x1[0], x1[1]};
+    std::array<s32, 2> x2_ = {x2[0], x2[1]};
+    std::array<s32, 2> y1_ = {y1[0], y1[1]};
+    std::array<s32, 2> y2_ = {y2[0], y2[1]};
+
+    for (auto& sample : frame) {
+        for (size_t i = 0; i < 2; i++) {
+            const s32 x0 = sample[i];
+            const s32 sum = b0_ * x0 + b1_ * x1_[i] + b2_ * x2_[i] + a1_ * y1_[i] + a2_ * y2_[i];
+            const s32 y0 = MathUtil::Clamp(sum >> 14, -32768, 32767);
+            x2_[i] = x1_[i];
+            x1_[i] = x0;
+            y2_[i] = y1_[i];
+            y1_[i] = y0;
+            sample[i] = static_cast<s16>(y0);
+        }
+    }
+
+    for (size_t i = 0; i < 2; i++) {
+        x1[i] = static_cast<s16>(x1_[i]);
+        x2[i] = static_cast<s16>(x2_[i]);
+        y1[i] = static_cast<s16>(y1_[i]);
+        y2[i] = static_cast<s16>(y2_[i]);
+    }
+}
+
 } // namespace HLE
 } // namespace AudioCore
@@ -2,6 +2,12 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <type_traits>
 #include "audio_core/audio_types.h"
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/hle.h"
@@ -12,12 +18,22 @@
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
 #include "core/core_timing.h"
 #include "core/hle/service/dsp_dsp.h"
+#include "core/settings.h"
+
+MICROPROFILE_DEFINE(Audio_Tick, "Audio", "DSP Tick", MP_RGB(100, 200, 100));
+MICROPROFILE_DEFINE(Audio_Render, "Audio", "Render Frame", MP_RGB(50, 150, 50));
 
 namespace AudioCore {
 
 static constexpr u64 audio_frame_ticks = 1310252ull; ///< Units: ARM11 cycles
+/// Number of audio frames per emulated second, used to report the time spent on the CPU thread
+static constexpr u64 audio_frames_per_second = BASE_CLOCK_RATE_ARM11 / audio_frame_ticks;
+/// Number of playing voices above which sources are ticked in parallel, when helpers are available
+static constexpr size_t parallel_source_threshold = 12;
 
 struct DspHle::Impl final {
 public:
@@ -41,7 +57,34 @@ private:
     HLE::SharedMemory& ReadRegion();
     HLE::SharedMemory& WriteRegion();
 
-    StereoFrame16 GenerateCurrentFrame();
+    /// Parts of the shared memory region read by the DSP to generate a frame
+    struct FrameInput {
+        HLE::SourceConfiguration source_configurations;
+        HLE::AdpcmCoefficients adpcm_coefficients;
+        HLE::DspConfiguration dsp_configuration;
+        HLE::IntermediateMixSamples intermediate_mix_samples;
+    };
+
+    /// Parts of the shared memory region written by the DSP after generating a frame
+    struct FrameOutput {
+        HLE::SourceStatus source_statuses;
+        HLE::DspStatus dsp_status;
+        HLE::IntermediateMixSamples intermediate_mix_samples;
+        StereoFrame16 samples;
+    };
+
+    const StereoFrame16& RenderFrame(HLE::SourceConfiguration& source_configurations,
+                                     const HLE::AdpcmCoefficients& adpcm_coefficients,
+                                     HLE::DspConfiguration& dsp_configuration,
+                                     const HLE::IntermediateMixSamples& read_mix_samples,
+                                     HLE::SourceStatus& source_statuses, HLE::DspStatus& dsp_status,
+                                     HLE::IntermediateMixSamples& write_mix_samples);
+    void TickSources(size_t thread_index);
+    void SourceThread(size_t thread_index);
+    void GenerateCurrentFrame();
+    void SnapshotFrameInput();
+    void WriteFrameOutput();
+    void WorkerThread();
     bool Tick();
     void AudioTickCallback(int cycles_late);
 
@@ -60,11 +103,58 @@ private:
 
     DspHle& parent;
     CoreTiming::EventType* tick_event;
+
+    /// Time spent in AudioTickCallback, reported once per emulated second
+    std::chrono::nanoseconds tick_time{};
+    u64 ticks_since_report = 0;
+
+    /**
+     * When enabled, frames are rendered on worker_thread one tick behind: each tick hands a copy of
+     * the current inputs to the worker, and writes back the frame rendered from the previous
+     * tick's inputs. sources and mixers are then only accessed by the worker.
+     */
+    bool use_worker_thread = false;
+    std::thread worker_thread;
+    Common::Event frame_requested;
+    Common::Event frame_rendered;
+    std::atomic<bool> stop_worker{false};
+    bool frame_in_flight = false;
+    FrameInput frame_input;
+    FrameOutput frame_output;
+
+    /**
+     * Helper threads which tick a share of the sources when many voices are playing. Source i is
+     * ticked by thread i % (source_threads.size() + 1), where thread 0 is the one rendering.
+     */
+    std::vector<std::thread> source_threads;
+    std::unique_ptr<Common::Barrier> source_barrier;
+    bool stop_source_threads = false;
+    size_t active_sources = 0;
+    struct {
+        HLE::SourceConfiguration* configurations;
+        const HLE::AdpcmCoefficients* adpcm_coefficients;
+        HLE::SourceStatus* statuses;
+    } source_job = {};
 };
 
 DspHle::Impl::Impl(DspHle& parent_) : parent(parent_) {
     dsp_memory.raw_memory.fill(0);
 
+    // Leave cores for the CPU and GPU threads
+    const unsigned num_cores = std::thread::hardware_concurrency();
+    if (num_cores >= 4) {
+        const size_t num_helpers = std::min(3u, num_cores / 2 - 1);
+        source_barrier = std::make_unique<Common::Barrier>(num_helpers + 1);
+        for (size_t i = 0; i < num_helpers; i++) {
+            source_threads.emplace_back(&Impl::SourceThread, this, i + 1);
+        }
+    }
+
+    use_worker_thread = Settings::values.enable_dsp_thread;
+    if (use_worker_thread) {
+        worker_thread = std::thread(&Impl::WorkerThread, this);
+    }
+
     tick_event =
         CoreTiming::RegisterEvent("AudioCore::DspHle::tick_event", [this](u64, int cycles_late) {
             this->AudioTickCallback(cycles_late);
@@ -74,6 +164,20 @@ DspHle::Impl::Impl(DspHle& parent_) : parent(parent_) {
 
 DspHle::Impl::~Impl() {
     CoreTiming::UnscheduleEvent(tick_event, 0);
+
+    if (worker_thread.joinable()) {
+        stop_worker = true;
+        frame_requested.Set();
+        worker_thread.join();
+    }
+
+    if (!source_threads.empty()) {
+        stop_source_threads = true;
+        source_barrier->Sync();
+        for (auto& thread : source_threads) {
+            thread.join();
+        }
+    }
 }
 
 DspState DspHle::Impl::GetDspState() const {
@@ -262,50 +366,168 @@ HLE::SharedMemory& DspHle::Impl::WriteRegion() {
     return CurrentRegionIndex() != 0 ? dsp_memory.region_0 : dsp_memory.region_1;
 }
 
-StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
-    HLE::SharedMemory& read = ReadRegion();
-    HLE::SharedMemory& write = WriteRegion();
-
-    std::array<QuadFrame32, 3> intermediate_mixes = {};
+const StereoFrame16& DspHle::Impl::RenderFrame(
+    HLE::SourceConfiguration& source_configurations,
+    const HLE::AdpcmCoefficients& adpcm_coefficients, HLE::DspConfiguration& dsp_configuration,
+    const HLE::IntermediateMixSamples& read_mix_samples, HLE::SourceStatus& source_statuses,
+    HLE::DspStatus& dsp_status, HLE::IntermediateMixSamples& write_mix_samples) {
+    MICROPROFILE_SCOPE(Audio_Render);
+
+    // Sources are independent of each other until they are mixed
+    source_job = {&source_configurations, &adpcm_coefficients, &source_statuses};
+    if (!source_threads.empty() && active_sources >= parallel_source_threshold) {
+        source_barrier->Sync();
+        TickSources(0);
+        source_barrier->Sync();
+    } else {
+        for (size_t i = 0; i < HLE::num_sources; i++) {
+            source_statuses.status[i] =
+                sources[i].Tick(source_configurations.config[i], adpcm_coefficients.coeff[i]);
+        }
+    }
+    active_sources = std::count_if(std::begin(source_statuses.status),
+                                   std::end(source_statuses.status),
+                                   [](const auto& status) { return status.is_enabled != 0; });
 
     // Generate intermediate mixes
+    std::array<QuadFrame32, 3> intermediate_mixes = {};
     for (size_t i = 0; i < HLE::num_sources; i++) {
-        write.source_statuses.status[i] =
-            sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
         for (size_t mix = 0; mix < 3; mix++) {
             sources[i].MixInto(intermediate_mixes[mix], mix);
         }
     }
 
     // Generate final mix
-    write.dsp_status = mixers.Tick(read.dsp_configuration, read.intermediate_mix_samples,
-                                   write.intermediate_mix_samples, intermediate_mixes);
+    dsp_status =
+        mixers.Tick(dsp_configuration, read_mix_samples, write_mix_samples, intermediate_mixes);
 
-    StereoFrame16 output_frame = mixers.GetOutput();
+    return mixers.GetOutput();
+}
 
-    // Write current output frame to the shared memory region
+void DspHle::Impl::TickSources(size_t thread_index) {
+    const size_t stride = source_threads.size() + 1;
+    for (size_t i = thread_index; i < HLE::num_sources; i += stride) {
+        source_job.statuses->status[i] = sources[i].Tick(source_job.configurations->config[i],
+                                                         source_job.adpcm_coefficients->coeff[i]);
+    }
+}
+
+void DspHle::Impl::SourceThread(size_t thread_index) {
+    Common::SetCurrentThreadName("DspHle sources");
+
+    while (true) {
+        // Wait for RenderFrame to start a frame, then signal that our share of it is done
+        source_barrier->Sync();
+        if (stop_source_threads)
+            return;
+        TickSources(thread_index);
+        source_barrier->Sync();
+    }
+}
+
+static void WriteFinalSamples(HLE::SharedMemory& write, const StereoFrame16& output_frame) {
     for (size_t samplei = 0; samplei < output_frame.size(); samplei++) {
         for (size_t channeli = 0; channeli < output_frame[0].size(); channeli++) {
             write.final_samples.pcm16[samplei][channeli] = s16_le(output_frame[samplei][channeli]);
         }
     }
+}
 
-    return output_frame;
+void DspHle::Impl::GenerateCurrentFrame() {
+    HLE::SharedMemory& read = ReadRegion();
+    HLE::SharedMemory& write = WriteRegion();
+
+    const StereoFrame16& output_frame =
+        RenderFrame(read.source_configurations, read.adpcm_coefficients, read.dsp_configuration,
+                    read.intermediate_mix_samples, write.source_statuses, write.dsp_status,
+                    write.intermediate_mix_samples);
+
+    // Write current output frame to the shared memory region
+    WriteFinalSamples(write, output_frame);
+
+    parent.OutputFrame(output_frame);
 }
 
-bool DspHle::Impl::Tick() {
-    StereoFrame16 current_frame = {};
+/// Copies a shared memory structure. BitField hides its assignment operator, but these structures
+/// are trivially copyable.
+template <typename T>
+static void CopySharedStruct(T& dest, const T& source) {
+    static_assert(std::is_trivially_copyable<T>::value, "Structure must be trivially copyable");
+    std::memcpy(&dest, &source, sizeof(T));
+}
+
+void DspHle::Impl::SnapshotFrameInput() {
+    HLE::SharedMemory& read = ReadRegion();
+
+    CopySharedStruct(frame_input.source_configurations, read.source_configurations);
+    CopySharedStruct(frame_input.adpcm_coefficients, read.adpcm_coefficients);
+    CopySharedStruct(frame_input.dsp_configuration, read.dsp_configuration);
+    CopySharedStruct(frame_input.intermediate_mix_samples, read.intermediate_mix_samples);
+
+    // The worker consumes the dirty flags from its copy; acknowledge them in shared memory now, the
+    // same way Source::ParseConfig and Mixers::ParseConfig would have.
+    for (auto& config : read.source_configurations.config) {
+        if (config.dirty_raw && config.buffer_queue_dirty) {
+            config.buffers_dirty = 0;
+        }
+        config.dirty_raw = 0;
+    }
+    read.dsp_configuration.dirty_raw = 0;
+}
+
+void DspHle::Impl::WriteFrameOutput() {
+    HLE::SharedMemory& write = WriteRegion();
 
+    CopySharedStruct(write.source_statuses, frame_output.source_statuses);
+    CopySharedStruct(write.dsp_status, frame_output.dsp_status);
+    CopySharedStruct(write.intermediate_mix_samples, frame_output.intermediate_mix_samples);
+    WriteFinalSamples(write, frame_output.samples);
+}
+
+void DspHle::Impl::WorkerThread() {
+    Common::SetCurrentThreadName("DspHle");
+
+    while (true) {
+        frame_requested.Wait();
+        if (stop_worker)
+            return;
+
+        frame_output.samples = RenderFrame(
+            frame_input.source_configurations, frame_input.adpcm_coefficients,
+            frame_input.dsp_configuration, frame_input.intermediate_mix_samples,
+            frame_output.source_statuses, frame_output.dsp_status,
+            frame_output.intermediate_mix_samples);
+        parent.OutputFrame(frame_output.samples);
+
+        frame_rendered.Set();
+    }
+}
+
+bool DspHle::Impl::Tick() {
     // TODO: Check dsp::DSP semaphore (which indicates emulated application has finished writing to
     // shared memory region)
-    current_frame = GenerateCurrentFrame();
+    if (!use_worker_thread) {
+        GenerateCurrentFrame();
+        return true;
+    }
+
+    // Never run more than one frame ahead of the worker
+    if (frame_in_flight) {
+        frame_rendered.Wait();
+        WriteFrameOutput();
+    }
 
-    parent.OutputFrame(current_frame);
+    SnapshotFrameInput();
+    frame_in_flight = true;
+    frame_requested.Set();
 
     return true;
 }
 
 void DspHle::Impl::AudioTickCallback(int cycles_late) {
+    MICROPROFILE_SCOPE(Audio_Tick);
+    const auto start = std::chrono::steady_clock::now();
+
     if (Tick()) {
         // TODO(merry): Signal all the other interrupts as appropriate.
         Service::DSP_DSP::SignalPipeInterrupt(DspPipe::Audio);
@@ -315,6 +537,15 @@ void DspHle::Impl::AudioTickCallback(int cycles_late) {
 
     // Reschedule recurrent event
     CoreTiming::ScheduleEvent(audio_frame_ticks - cycles_late, tick_event);
+
+    tick_time += std::chrono::steady_clock::now() - start;
+    if (++ticks_since_report == audio_frames_per_second) {
+        NGLOG_DEBUG(Audio_DSP, "{} us of emulation thread time per emulated second ({})",
+                    std::chrono::duration_cast<std::chrono::microseconds>(tick_time).count(),
+                    use_worker_thread ? "worker thread" : "inline");
+        tick_time = {};
+        ticks_since_report = 0;
+    }
 }
 
 DspHle::DspHle() : impl(std::make_unique<Impl>(*this)) {}
@@ -2,7 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstddef>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 
 #include "audio_core/hle/mixers.h"
 #include "common/assert.h"
@@ -96,7 +100,35 @@ static std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a,
             ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))};
 }
 
+#ifdef ARCHITECTURE_x86_64
+/// SSE2 version of the stereo case of Mixers::DownmixAndMixIntoCurrentFrame
+static void DownmixStereoAndMix(StereoFrame16& accumulator, float gain,
+                                const QuadFrame32& samples) {
+    static_assert(samples_per_frame % 2 == 0, "Frames are processed two samples at a time");
+    const __m128 gain_v = _mm_set1_ps(gain);
+    for (size_t samplei = 0; samplei < samples_per_frame; samplei += 2) {
+        const __m128i* in = reinterpret_cast<const __m128i*>(&samples[samplei]);
+        const __m128 quad0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(in)), gain_v);
+        const __m128 quad1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128(in + 1)), gain_v);
+
+        // Downmix to stereo: left = 0 + 2, right = 1 + 3
+        const __m128 stereo0 = _mm_add_ps(quad0, _mm_movehl_ps(quad0, quad0));
+        const __m128 stereo1 = _mm_add_ps(quad1, _mm_movehl_ps(quad1, quad1));
+        const __m128i stereo = _mm_cvttps_epi32(_mm_movelh_ps(stereo0, stereo1));
+
+        // Mix into current frame. The saturating pack and add clamp like ClampToS16.
+        __m128i* out = reinterpret_cast<__m128i*>(&accumulator[samplei]);
+        const __m128i mixed = _mm_adds_epi16(_mm_loadl_epi64(out), _mm_packs_epi32(stereo, stereo));
+        _mm_storel_epi64(out, mixed);
+    }
+}
+#endif
+
 void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& samples) {
+    // A muted intermediate mix does not contribute anything
+    if (gain == 0.0f)
+        return;
+
     // TODO(merry): Limiter. (Currently we're performing final mixing assuming a disabled limiter.)
 
     switch (state.output_format) {
@@ -119,6 +151,9 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
         // fallthrough
 
     case OutputFormat::Stereo:
+#ifdef ARCHITECTURE_x86_64
+        DownmixStereoAndMix(current_frame, gain, samples);
+#else
         std::transform(
             current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
             [gain](const std::array<s16, 2>& accumulator,
@@ -129,6 +164,7 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
                 // Mix into current frame
                 return AddAndClampToS16(accumulator, {left, right});
             });
+#endif
         return;
     }
 
@@ -4,6 +4,9 @@
 
 #include <algorithm>
 #include <array>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include "audio_core/codec.h"
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/source.h"
@@ -31,6 +34,29 @@ void Source::MixInto(QuadFrame32& dest, size_t intermediate_mix_id) const {
         return;
 
     const std::array<float, 4>& gains = state.gain.at(intermediate_mix_id);
+    // Most sources only feed one of the intermediate mixes
+    if (std::all_of(gains.begin(), gains.end(), [](float gain) { return gain == 0.0f; }))
+        return;
+
+#ifdef ARCHITECTURE_x86_64
+    static_assert(samples_per_frame % 2 == 0, "Frames are processed two samples at a time");
+    const __m128 gain = _mm_loadu_ps(gains.data());
+    for (size_t samplei = 0; samplei < samples_per_frame; samplei += 2) {
+        // Sign-extend L0 R0 L1 R1 to 32 bits, and duplicate each sample to L R L R
+        const __m128i in =
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&current_frame[samplei]));
+        const __m128 in_f = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(in, in), 16));
+        const __m128 quad0 = _mm_movelh_ps(in_f, in_f);
+        const __m128 quad1 = _mm_movehl_ps(in_f, in_f);
+
+        // Truncating conversion, like static_cast<s32>
+        __m128i* out = reinterpret_cast<__m128i*>(&dest[samplei]);
+        _mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out),
+                                            _mm_cvttps_epi32(_mm_mul_ps(quad0, gain))));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1),
+                                                _mm_cvttps_epi32(_mm_mul_ps(quad1, gain))));
+    }
+#else
     for (size_t samplei = 0; samplei < samples_per_frame; samplei++) {
         // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here.
         dest[samplei][0] += static_cast<s32>(gains[0] * current_frame[samplei][0]);
@@ -38,6 +64,7 @@ void Source::MixInto(QuadFrame32& dest, size_t intermediate_mix_id) const {
         dest[samplei][2] += static_cast<s32>(gains[2] * current_frame[samplei][0]);
         dest[samplei][3] += static_cast<s32>(gains[3] * current_frame[samplei][1]);
     }
+#endif
 }
 
 void Source::Reset() {
@@ -229,7 +256,8 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
 void Source::GenerateFrame() {
     current_frame.fill({});
 
-    if (state.current_buffer.empty() && !DequeueBuffer()) {
+    if (state.current_buffer.empty() && state.decoded_samples == state.decoding_length &&
+        !DequeueBuffer()) {
         state.enabled = false;
         state.buffer_update = true;
         state.current_buffer_id = 0;
@@ -240,7 +268,7 @@ void Source::GenerateFrame() {
 
     state.current_sample_number = state.next_sample_number;
     while (frame_position < current_frame.size()) {
-        if (state.current_buffer.empty() && !DequeueBuffer()) {
+        if (state.current_buffer.empty() && !DecodeSamples() && !DequeueBuffer()) {
             break;
         }
 
@@ -254,10 +282,8 @@ void Source::GenerateFrame() {
                                 current_frame, frame_position);
             break;
         case InterpolationMode::Polyphase:
-            // TODO(merry): Implement polyphase interpolation
-            NGLOG_DEBUG(Audio_DSP, "Polyphase interpolation unimplemented; falling back to linear");
-            AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier,
-                                current_frame, frame_position);
+            AudioInterp::Polyphase(state.interp_state, state.current_buffer,
+                                   state.rate_multiplier, current_frame, frame_position);
             break;
         default:
             UNIMPLEMENTED();
@@ -284,33 +310,23 @@ bool Source::DequeueBuffer() {
         state.adpcm_state.yn2 = buf.adpcm_yn[1];
     }
 
-    const u8* const memory = Memory::GetPhysicalPointer(buf.physical_address);
-    if (memory) {
-        const unsigned num_channels = buf.mono_or_stereo == MonoOrStereo::Stereo ? 2 : 1;
-        switch (buf.format) {
-        case Format::PCM8:
-            state.current_buffer = Codec::DecodePCM8(num_channels, memory, buf.length);
-            break;
-        case Format::PCM16:
-            state.current_buffer = Codec::DecodePCM16(num_channels, memory, buf.length);
-            break;
-        case Format::ADPCM:
-            DEBUG_ASSERT(num_channels == 1);
-            state.current_buffer =
-                Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state);
-            break;
-        default:
-            UNIMPLEMENTED();
-            break;
-        }
-    } else {
+    if (!Memory::GetPhysicalPointer(buf.physical_address)) {
         NGLOG_WARNING(Audio_DSP,
                       "source_id={} buffer_id={} length={}: Invalid physical address {:#010x}",
                       source_id, buf.buffer_id, buf.length, buf.physical_address);
         state.current_buffer.clear();
+        state.decoding_length = state.decoded_samples = 0;
         return true;
     }
 
+    // Samples are decoded into current_buffer as they are needed, see DecodeSamples
+    state.current_buffer.clear();
+    state.decoding_buffer = buf;
+    state.decoding_length = buf.format == Format::ADPCM
+                                ? static_cast<u32>(Codec::GetADPCMDecodedLength(buf.length))
+                                : buf.length;
+    state.decoded_samples = 0;
+
     // the first playthrough starts at play_position, loops start at the beginning of the buffer
     state.current_sample_number = (!buf.has_played) ? buf.play_position : 0;
     state.next_sample_number = state.current_sample_number;
@@ -322,8 +338,41 @@ bool Source::DequeueBuffer() {
         state.input_queue.push(buf);
     }
 
-    NGLOG_TRACE(Audio_DSP, "source_id={} buffer_id={} from_queue={} current_buffer.size()={}",
-                source_id, buf.buffer_id, buf.from_queue, state.current_buffer.size());
+    NGLOG_TRACE(Audio_DSP, "source_id={} buffer_id={} from_queue={} length={}", source_id,
+                buf.buffer_id, buf.from_queue, state.decoding_length);
+    return true;
+}
+
+bool Source::DecodeSamples() {
+    if (state.decoded_samples == state.decoding_length)
+        return false;
+
+    const Buffer& buf = state.decoding_buffer;
+    const u8* const memory = Memory::GetPhysicalPointer(buf.physical_address);
+    const u32 sample_count = static_cast<u32>(std::min<size_t>(
+        state.decoding_length - state.decoded_samples, state.current_buffer.free_space()));
+
+    const unsigned num_channels = buf.mono_or_stereo == MonoOrStereo::Stereo ? 2 : 1;
+    switch (buf.format) {
+    case Format::PCM8:
+        Codec::DecodePCM8(num_channels, memory, state.decoded_samples, sample_count,
+                          state.current_buffer);
+        break;
+    case Format::PCM16:
+        Codec::DecodePCM16(num_channels, memory, state.decoded_samples, sample_count,
+                           state.current_buffer);
+        break;
+    case Format::ADPCM:
+        DEBUG_ASSERT(num_channels == 1);
+        Codec::DecodeADPCM(memory, state.decoded_samples, sample_count, state.adpcm_coeffs,
+                           state.adpcm_state, state.current_buffer);
+        break;
+    default:
+        UNIMPLEMENTED();
+        break;
+    }
+
+    state.decoded_samples += sample_count;
     return true;
 }
 
@@ -108,7 +108,12 @@ private:
 
         u32 current_sample_number = 0;
         u32 next_sample_number = 0;
-        AudioInterp::StereoBuffer16 current_buffer;
+        /// Decoded samples of the current buffer which haven't been interpolated yet
+        StereoBuffer16 current_buffer;
+        /// The buffer being decoded, and how many of its samples have been decoded so far
+        Buffer decoding_buffer = {};
+        u32 decoding_length = 0;
+        u32 decoded_samples = 0;
 
         // buffer_id state
 
@@ -138,9 +143,11 @@ private:
     void ParseConfig(SourceConfiguration::Configuration& config, const s16_le (&adpcm_coeffs)[16]);
     /// INTERNAL: Generate the current audio output for this frame based on our internal state.
     void GenerateFrame();
-    /// INTERNAL: Dequeues a buffer and does preprocessing on it (decoding, resampling). Puts it
-    /// into current_buffer.
+    /// INTERNAL: Dequeues a buffer and starts decoding it.
     bool DequeueBuffer();
+    /// INTERNAL: Decodes as many samples of the current buffer as fit into current_buffer.
+    /// Returns false if the whole buffer has been decoded already.
+    bool DecodeSamples();
     /// INTERNAL: Generates a SourceStatus::Status based on our internal state.
     SourceStatus::Status GetCurrentStatus();
 };
@@ -2,6 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cmath>
+#ifdef ARCHITECTURE_x86_64
+#include <xmmintrin.h>
+#endif
 #include "audio_core/interpolate.h"
 #include "common/assert.h"
 #include "common/math_util.h"
@@ -24,7 +29,11 @@ static void StepOverSamples(State& state, StereoBuffer16& input, float rate, Ste
     if (input.empty())
         return;
 
-    input.insert(input.begin(), {state.xn2, state.xn1});
+    // The two samples of history from state come before the samples in input.
+    const auto sample_at = [&](size_t i) -> const std::array<s16, 2>& {
+        return i == 0 ? state.xn2 : i == 1 ? state.xn1 : input[i - 2];
+    };
+    const size_t num_samples = input.size() + 2;
 
     const u64 step_size = static_cast<u64>(rate * scale_factor);
     u64 fposition = state.fposition;
@@ -33,22 +42,25 @@ static void StepOverSamples(State& state, StereoBuffer16& input, float rate, Ste
     while (outputi < output.size()) {
         inputi = static_cast<size_t>(fposition / scale_factor);
 
-        if (inputi + 2 >= input.size()) {
-            inputi = input.size() - 2;
+        if (inputi + 2 >= num_samples) {
+            inputi = num_samples - 2;
             break;
         }
 
         u64 fraction = fposition & scale_mask;
-        output[outputi++] = fn(fraction, input[inputi], input[inputi + 1], input[inputi + 2]);
+        output[outputi++] = fn(fraction, sample_at(inputi), sample_at(inputi + 1),
+                               sample_at(inputi + 2));
 
         fposition += step_size;
     }
 
-    state.xn2 = input[inputi];
-    state.xn1 = input[inputi + 1];
+    const std::array<s16, 2> xn2 = sample_at(inputi);
+    const std::array<s16, 2> xn1 = sample_at(inputi + 1);
+    state.xn2 = xn2;
+    state.xn1 = xn1;
     state.fposition = fposition - inputi * scale_factor;
 
-    input.erase(input.begin(), std::next(input.begin(), inputi + 2));
+    input.pop_front(inputi);
 }
 
 void None(State& state, StereoBuffer16& input, float rate, StereoFrame16& output, size_t& outputi) {
@@ -73,5 +85,179 @@ void Linear(State& state, StereoBuffer16& input, float rate, StereoFrame16& outp
                     });
 }
 
+namespace {
+
+constexpr size_t history_length = polyphase_taps - 1;
+/// Number of fractional positions the filter is tabulated at. Coefficients between two phases
+/// are linearly interpolated.
+constexpr size_t num_phases = 256;
+/// Kaiser window shape parameter, trading main lobe width for stopband attenuation
+constexpr double kaiser_beta = 7.0;
+
+/// Filter cutoffs, relative to the input Nyquist frequency, used for increasing decimation rates
+constexpr std::array<double, 4> bank_cutoffs = {1.0, 0.75, 0.5, 0.25};
+
+using FilterBank = std::array<std::array<float, polyphase_taps>, num_phases + 1>;
+
+/// Modified Bessel function of the first kind of order zero, for the Kaiser window
+double BesselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+FilterBank MakeFilterBank(double cutoff) {
+    constexpr double pi = 3.14159265358979323846;
+    constexpr double half_width = polyphase_taps / 2;
+
+    FilterBank bank;
+    for (size_t phase = 0; phase <= num_phases; phase++) {
+        const double fraction = static_cast<double>(phase) / num_phases;
+        double sum = 0.0;
+        std::array<double, polyphase_taps> taps;
+        for (size_t k = 0; k < polyphase_taps; k++) {
+            // Tap k multiplies the input sample k - (half_width - 1) - fraction samples away from
+            // the output position.
+            const double t = static_cast<double>(k) - (half_width - 1) - fraction;
+            const double x = t / half_width;
+            const double window =
+                std::abs(x) >= 1.0 ? 0.0
+                                   : BesselI0(kaiser_beta * std::sqrt(1.0 - x * x)) /
+                                         BesselI0(kaiser_beta);
+            const double sinc = t == 0.0 ? 1.0 : std::sin(pi * cutoff * t) / (pi * cutoff * t);
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+        // Normalise to unity gain at DC
+        for (size_t k = 0; k < polyphase_taps; k++) {
+            bank[phase][k] = static_cast<float>(taps[k] / sum);
+        }
+    }
+    return bank;
+}
+
+const FilterBank& GetFilterBank(float rate) {
+    static const std::array<FilterBank, bank_cutoffs.size()> banks = [] {
+        std::array<FilterBank, bank_cutoffs.size()> result;
+        for (size_t i = 0; i < bank_cutoffs.size(); i++) {
+            result[i] = MakeFilterBank(bank_cutoffs[i]);
+        }
+        return result;
+    }();
+
+    // Use the widest cutoff that is still at or below the output Nyquist frequency
+    for (size_t i = 0; i + 1 < bank_cutoffs.size(); i++) {
+        if (rate * bank_cutoffs[i] <= 1.0)
+            return banks[i];
+    }
+    return banks.back();
+}
+
+/**
+ * Computes one output sample from polyphase_taps consecutive samples of each channel.
+ * @param left, right Planar input samples, starting at the first tap
+ * @param coeff0, coeff1 Filter taps of the two tabulated phases surrounding the position
+ * @param mix Position between coeff0 (0.0) and coeff1 (1.0)
+ */
+std::array<s16, 2> FilterSample(const float* left, const float* right, const float* coeff0,
+                                const float* coeff1, float mix) {
+    float sum_left;
+    float sum_right;
+#ifdef ARCHITECTURE_x86_64
+    static_assert(polyphase_taps % 4 == 0, "Taps are processed four at a time");
+    const __m128 mix_v = _mm_set1_ps(mix);
+    __m128 acc_left = _mm_setzero_ps();
+    __m128 acc_right = _mm_setzero_ps();
+    for (size_t k = 0; k < polyphase_taps; k += 4) {
+        const __m128 c0 = _mm_loadu_ps(coeff0 + k);
+        const __m128 c1 = _mm_loadu_ps(coeff1 + k);
+        const __m128 coeff = _mm_add_ps(c0, _mm_mul_ps(_mm_sub_ps(c1, c0), mix_v));
+        acc_left = _mm_add_ps(acc_left, _mm_mul_ps(_mm_loadu_ps(left + k), coeff));
+        acc_right = _mm_add_ps(acc_right, _mm_mul_ps(_mm_loadu_ps(right + k), coeff));
+    }
+    // Horizontal sums of both accumulators
+    const __m128 low = _mm_unpacklo_ps(acc_left, acc_right);  // l0 r0 l1 r1
+    const __m128 high = _mm_unpackhi_ps(acc_left, acc_right); // l2 r2 l3 r3
+    const __m128 pairs = _mm_add_ps(low, high);
+    const __m128 sums = _mm_add_ps(pairs, _mm_movehl_ps(pairs, pairs));
+    sum_left = _mm_cvtss_f32(sums);
+    sum_right = _mm_cvtss_f32(_mm_shuffle_ps(sums, sums, _MM_SHUFFLE(1, 1, 1, 1)));
+#else
+    sum_left = 0.0f;
+    sum_right = 0.0f;
+    for (size_t k = 0; k < polyphase_taps; k++) {
+        const float coeff = coeff0[k] + (coeff1[k] - coeff0[k]) * mix;
+        sum_left += left[k] * coeff;
+        sum_right += right[k] * coeff;
+    }
+#endif
+    return {static_cast<s16>(MathUtil::Clamp(std::lround(sum_left), -32768l, 32767l)),
+            static_cast<s16>(MathUtil::Clamp(std::lround(sum_right), -32768l, 32767l))};
+}
+
+} // Anonymous namespace
+
+void Polyphase(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
+               size_t& outputi) {
+    ASSERT(rate > 0);
+
+    if (input.empty() || outputi >= output.size())
+        return;
+
+    const FilterBank& bank = GetFilterBank(rate);
+    const u64 step_size = static_cast<u64>(rate * scale_factor);
+    u64 fposition = state.fposition;
+
+    // Only convert as much input as the rest of this frame can use
+    const u64 last_position = fposition + (output.size() - outputi - 1) * step_size;
+    const size_t num_input =
+        static_cast<size_t>(std::min<u64>(input.size(), last_position / scale_factor + 1));
+
+    // The history is followed by the input, deinterleaved to floats for the filter
+    std::array<float, history_length + StereoBuffer16::capacity> left;
+    std::array<float, history_length + StereoBuffer16::capacity> right;
+    for (size_t i = 0; i < history_length; i++) {
+        left[i] = state.history[i][0];
+        right[i] = state.history[i][1];
+    }
+    for (size_t i = 0; i < num_input; i++) {
+        left[history_length + i] = input[i][0];
+        right[history_length + i] = input[i][1];
+    }
+    const size_t num_samples = history_length + num_input;
+
+    while (outputi < output.size()) {
+        const size_t inputi = static_cast<size_t>(fposition / scale_factor);
+        if (inputi + polyphase_taps > num_samples)
+            break;
+
+        // Split the 24 fractional bits into a phase index and the position between two phases
+        const u64 fraction = fposition & scale_mask;
+        const size_t phase = static_cast<size_t>(fraction * num_phases / scale_factor);
+        const float mix = static_cast<float>(fraction * num_phases - phase * scale_factor) /
+                          static_cast<float>(scale_factor);
+        output[outputi++] = FilterSample(&left[inputi], &right[inputi], bank[phase].data(),
+                                         bank[phase + 1].data(), mix);
+
+        fposition += step_size;
+    }
+
+    // Drop the input before the next position, keeping history_length samples of history
+    const size_t consumed = std::min(static_cast<size_t>(fposition / scale_factor), num_input);
+    for (size_t i = 0; i < history_length; i++) {
+        state.history[i] = {static_cast<s16>(left[consumed + i]),
+                            static_cast<s16>(right[consumed + i])};
+    }
+    state.xn2 = state.history[history_length - 2];
+    state.xn1 = state.history[history_length - 1];
+    state.fposition = fposition - consumed * scale_factor;
+
+    input.pop_front(consumed);
+}
+
 } // namespace AudioInterp
 } // namespace AudioCore
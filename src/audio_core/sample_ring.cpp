@@ -0,0 +1,83 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "audio_core/sample_ring.h"
+#include "common/assert.h"
+
+namespace AudioCore {
+
+static size_t RoundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+SampleRing::SampleRing(size_t capacity_)
+    : capacity(RoundUpToPowerOfTwo(capacity_)), mask(capacity - 1), samples(capacity * 2) {
+    ASSERT(capacity_ > 0);
+}
+
+size_t SampleRing::Push(const s16* input, size_t sample_count) {
+    const size_t write = write_index.load(std::memory_order_relaxed);
+    const size_t read = read_index.load(std::memory_order_acquire);
+    const size_t count = std::min(sample_count, capacity - (write - read));
+
+    // Copy in up to two pieces, the second one wrapping around to the start of the buffer
+    const size_t start = write & mask;
+    const size_t first_part = std::min(count, capacity - start);
+    std::memcpy(&samples[start * 2], input, first_part * 2 * sizeof(s16));
+    std::memcpy(&samples[0], input + first_part * 2, (count - first_part) * 2 * sizeof(s16));
+
+    write_index.store(write + count, std::memory_order_release);
+
+    if (count < sample_count) {
+        dropped_samples.fetch_add(sample_count - count, std::memory_order_relaxed);
+    }
+    return count;
+}
+
+size_t SampleRing::Pop(s16* output, size_t sample_count) {
+    const size_t read = read_index.load(std::memory_order_relaxed);
+    const size_t write = write_index.load(std::memory_order_acquire);
+    const size_t count = std::min(sample_count, write - read);
+
+    const size_t start = read & mask;
+    const size_t first_part = std::min(count, capacity - start);
+    std::memcpy(output, &samples[start * 2], first_part * 2 * sizeof(s16));
+    std::memcpy(output + first_part * 2, &samples[0], (count - first_part) * 2 * sizeof(s16));
+
+    read_index.store(read + count, std::memory_order_release);
+
+    // Only count the start of each starvation period, not every silent callback while paused
+    if (count < sample_count) {
+        if (!starved) {
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        starved = true;
+    } else {
+        starved = false;
+    }
+    return count;
+}
+
+size_t SampleRing::Size() const {
+    const size_t read = read_index.load(std::memory_order_acquire);
+    const size_t write = write_index.load(std::memory_order_acquire);
+    // On a third thread read may be observed after write has moved on; clamp rather than wrap
+    return std::min(write - read, capacity);
+}
+
+SinkStats SampleRing::GetStats() const {
+    SinkStats stats;
+    stats.queued_samples = Size();
+    stats.underruns = underruns.load(std::memory_order_relaxed);
+    stats.dropped_samples = dropped_samples.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace AudioCore
@@ -0,0 +1,74 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "audio_core/sink.h"
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+/// Queue size used by the sinks, about half a second of audio at the native sample rate
+constexpr size_t sink_queue_capacity = 16 * 1024;
+
+/**
+ * Lock-free single-producer single-consumer queue of interleaved stereo PCM16 samples. Sinks use
+ * this to pass samples from the emulation thread (the producer) to the realtime audio callback
+ * (the consumer) without locking or allocating on either side.
+ */
+class SampleRing final {
+public:
+    /// @param capacity Maximum number of stereo samples held, rounded up to a power of two.
+    explicit SampleRing(size_t capacity);
+
+    SampleRing(const SampleRing&) = delete;
+    SampleRing& operator=(const SampleRing&) = delete;
+
+    /**
+     * Appends stereo samples to the queue. Only call from the producer thread. Samples that do not
+     * fit are dropped and counted in SinkStats::dropped_samples.
+     * @param samples Samples in interleaved stereo PCM16 format.
+     * @param sample_count Number of stereo samples.
+     * @return Number of stereo samples actually queued.
+     */
+    size_t Push(const s16* samples, size_t sample_count);
+
+    /**
+     * Removes stereo samples from the front of the queue. Only call from the consumer thread. A
+     * read that cannot be fully satisfied after a satisfied one is counted as an underrun.
+     * @param output Destination for the samples in interleaved stereo PCM16 format.
+     * @param sample_count Number of stereo samples requested.
+     * @return Number of stereo samples written to output.
+     */
+    size_t Pop(s16* output, size_t sample_count);
+
+    /// Number of stereo samples currently queued. Exact on either thread, stale on any other.
+    size_t Size() const;
+
+    size_t Capacity() const {
+        return capacity;
+    }
+
+    /// Snapshot of the queue's latency and underrun counters. Safe to call from any thread.
+    SinkStats GetStats() const;
+
+private:
+    const size_t capacity;
+    const size_t mask;
+    std::vector<s16> samples;
+
+    // The indices grow without bound and are masked on access, so full and empty are distinct.
+    alignas(64) std::atomic<size_t> write_index{0};
+    alignas(64) std::atomic<size_t> read_index{0};
+
+    std::atomic<u64> underruns{0};
+    std::atomic<u64> dropped_samples{0};
+    /// Consumer-only: whether the previous Pop ran out of samples
+    bool starved = true;
+};
+
+} // namespace AudioCore
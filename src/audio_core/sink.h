@@ -4,11 +4,19 @@
 
 #pragma once
 
+#include <string>
 #include <vector>
 #include "common/common_types.h"
 
 namespace AudioCore {
 
+/// Counters describing the state of a sink's sample queue
+struct SinkStats {
+    size_t queued_samples = 0; ///< Stereo samples waiting to be played, i.e. the output latency
+    u64 underruns = 0;         ///< Number of times the audio device ran out of samples to play
+    u64 dropped_samples = 0;   ///< Stereo samples discarded because the queue was full
+};
+
 /**
  * This class is an interface for an audio sink. An audio sink accepts samples in stereo signed
  * PCM16 format to be output. Sinks *do not* handle resampling and expect the correct sample rate.
@@ -32,6 +40,11 @@ public:
     /// Samples enqueued that have not been played yet.
     virtual std::size_t SamplesInQueue() const = 0;
 
+    /// Latency and underrun counters of this sink. Safe to call from any thread.
+    virtual SinkStats GetStats() const {
+        return {};
+    }
+
     /**
      * Sets the desired output device.
      * @param device_id ID of the desired device.
@@ -4,7 +4,6 @@
 
 #include <chrono>
 #include <cmath>
-#include <vector>
 #include <SoundTouch.h>
 #include "audio_core/audio_types.h"
 #include "audio_core/time_stretch.h"
@@ -40,7 +39,7 @@ struct TimeStretcher::Impl {
     double sample_rate = static_cast<double>(native_sample_rate);
 };
 
-std::vector<s16> TimeStretcher::Process(size_t samples_in_queue) {
+void TimeStretcher::Process(size_t samples_in_queue) {
     // This is a very simple algorithm without any fancy control theory. It works and is stable.
 
     double ratio = CalculateCurrentRatio();
@@ -52,12 +51,11 @@ std::vector<s16> TimeStretcher::Process(size_t samples_in_queue) {
     // SoundTouch's tempo definition the inverse of our ratio definition.
     impl->soundtouch.setTempo(1.0 / impl->smoothed_ratio);
 
-    std::vector<s16> samples = GetSamples();
     if (samples_in_queue >= DROP_FRAMES_SAMPLE_DELAY) {
-        samples.clear();
+        // Discard the available output without copying it anywhere
+        impl->soundtouch.receiveSamples(impl->soundtouch.numSamples());
         NGLOG_DEBUG(Audio, "Dropping frames!");
     }
-    return samples;
 }
 
 TimeStretcher::TimeStretcher() : impl(std::make_unique<Impl>()) {
@@ -130,14 +128,8 @@ double TimeStretcher::CorrectForUnderAndOverflow(double ratio, size_t sample_del
     return ClampRatio(ratio);
 }
 
-std::vector<s16> TimeStretcher::GetSamples() {
-    uint available = impl->soundtouch.numSamples();
-
-    std::vector<s16> output(static_cast<size_t>(available) * 2);
-
-    impl->soundtouch.receiveSamples(output.data(), available);
-
-    return output;
+size_t TimeStretcher::GetSamples(s16* output, size_t max_samples) {
+    return impl->soundtouch.receiveSamples(output, static_cast<uint>(max_samples));
 }
 
 } // namespace AudioCore
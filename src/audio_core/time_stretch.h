@@ -6,7 +6,6 @@
 
 #include <cstddef>
 #include <memory>
-#include <vector>
 #include "common/common_types.h"
 
 namespace AudioCore {
@@ -36,13 +35,20 @@ public:
     void Reset();
 
     /**
-     * Does audio stretching and produces the time-stretched samples.
+     * Does audio stretching. The time-stretched samples are then retrieved with GetSamples.
      * Timer calculations use sample_delay to determine how much of a margin we have.
      * @param sample_delay How many samples are buffered downstream of this module and haven't been
      * played yet.
-     * @return Samples to play in interleaved stereo PCM16 format.
      */
-    std::vector<s16> Process(size_t sample_delay);
+    void Process(size_t sample_delay);
+
+    /**
+     * Moves time-stretched samples produced by Process into the given buffer.
+     * @param output Buffer for samples in interleaved stereo PCM16 format.
+     * @param max_samples Capacity of output in samples.
+     * @return Number of samples written. Less than max_samples if no more samples are available.
+     */
+    size_t GetSamples(s16* output, size_t max_samples);
 
 private:
     struct Impl;
@@ -53,8 +59,6 @@ private:
     /// INTERNAL: If we have too many or too few samples downstream, nudge ratio in the appropriate
     /// direction.
     double CorrectForUnderAndOverflow(double ratio, size_t sample_delay) const;
-    /// INTERNAL: Gets the time-stretched samples from SoundTouch.
-    std::vector<s16> GetSamples();
 };
 
 } // namespace AudioCore
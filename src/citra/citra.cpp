@@ -33,6 +33,7 @@
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #include "common/string_util.h"
+#include "core/boot_profiler.h"
 #include "core/core.h"
 #include "core/file_sys/cia_container.h"
 #include "core/gdbstub/gdbstub.h"
@@ -57,6 +58,8 @@ static void PrintHelp(const char* argv0) {
                  " Nickname, password, address and port for multiplayer\n"
                  "-r, --movie-record=[file]  Record a movie (game inputs) to the given file\n"
                  "-p, --movie-play=[file]    Playback the movie (game inputs) from the given file\n"
+                 "-t, --boot-trace=FILE Save the timings of the boot to FILE on exit, for "
+                 "chrome://tracing\n"
                  "-f, --fullscreen     Start in fullscreen mode\n"
                  "-h, --help           Display this help and exit\n"
                  "-v, --version        Output version information and exit\n";
@@ -121,6 +124,7 @@ int main(int argc, char** argv) {
     u32 gdb_port = static_cast<u32>(Settings::values.gdbstub_port);
     std::string movie_record;
     std::string movie_play;
+    std::string boot_trace;
 
     char* endarg;
 #ifdef _WIN32
@@ -147,6 +151,7 @@ int main(int argc, char** argv) {
         {"multiplayer", required_argument, 0, 'm'},
         {"movie-record", required_argument, 0, 'r'},
         {"movie-play", required_argument, 0, 'p'},
+        {"boot-trace", required_argument, 0, 't'},
         {"fullscreen", no_argument, 0, 'f'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
@@ -154,7 +159,7 @@ int main(int argc, char** argv) {
     };
 
     while (optind < argc) {
-        char arg = getopt_long(argc, argv, "g:i:m:r:p:fhv", long_options, &option_index);
+        char arg = getopt_long(argc, argv, "g:i:m:r:p:t:fhv", long_options, &option_index);
         if (arg != -1) {
             switch (arg) {
             case 'g':
@@ -172,9 +177,18 @@ int main(int argc, char** argv) {
                 const auto cia_progress = [](size_t written, size_t total) {
                     NGLOG_INFO(Frontend, "{:02d}%", (written * 100 / total));
                 };
-                if (Service::AM::InstallCIA(std::string(optarg), cia_progress) !=
-                    Service::AM::InstallStatus::Success)
+                Service::AM::InstallStats stats;
+                if (Service::AM::InstallCIA(std::string(optarg), cia_progress, &stats) !=
+                    Service::AM::InstallStatus::Success) {
                     errno = EINVAL;
+                } else {
+                    NGLOG_INFO(Frontend,
+                               "Installed {} bytes at {:.1f} MB/s (read {} ms, verify {} ms, "
+                               "write {} ms, summed over all threads)",
+                               stats.bytes, stats.GetMegabytesPerSecond(),
+                               stats.read_ns / 1000000, stats.verify_ns / 1000000,
+                               stats.write_ns / 1000000);
+                }
                 if (errno != 0)
                     exit(1);
                 break;
@@ -217,6 +231,9 @@ int main(int argc, char** argv) {
             case 'p':
                 movie_play = optarg;
                 break;
+            case 't':
+                boot_trace = optarg;
+                break;
             case 'f':
                 fullscreen = true;
                 NGLOG_INFO(Frontend, "Starting in fullscreen mode...");
@@ -327,5 +344,9 @@ int main(int argc, char** argv) {
         system.RunLoop();
     }
 
+    if (!boot_trace.empty()) {
+        Core::BootProfiler::DumpToFile(boot_trace);
+    }
+
     return 0;
 }
@@ -142,11 +142,17 @@ void Config::ReadValues() {
     Settings::values.sink_id = sdl2_config->Get("Audio", "output_engine", "auto");
     Settings::values.enable_audio_stretching =
         sdl2_config->GetBoolean("Audio", "enable_audio_stretching", true);
+    Settings::values.enable_dsp_thread =
+        sdl2_config->GetBoolean("Audio", "enable_dsp_thread", false);
+    Settings::values.enable_audio_pacing =
+        sdl2_config->GetBoolean("Audio", "enable_audio_pacing", false);
     Settings::values.audio_device_id = sdl2_config->Get("Audio", "output_device", "auto");
 
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.watch_host_files =
+        sdl2_config->GetBoolean("Data Storage", "watch_host_files", true);
 
     // System
     Settings::values.is_new_3ds = sdl2_config->GetBoolean("System", "is_new_3ds", false);
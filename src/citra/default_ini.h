@@ -160,6 +160,17 @@ output_engine =
 # 0: No, 1 (default): Yes
 enable_audio_stretching =
 
+# Whether to generate audio frames on a separate thread, one frame behind emulation.
+# This takes audio processing off the emulation thread, at the cost of one frame of latency.
+# 0 (default): No, 1: Yes
+enable_dsp_thread =
+
+# Whether to pace emulation by the audio output device instead of the system clock.
+# This keeps audio latency low and steady, at the cost of small variations in emulation speed.
+# Audio stretching is not used while this is enabled. Only applies when the speed limit is 100%.
+# 0 (default): No, 1: Yes
+enable_audio_pacing =
+
 # Which audio device to use.
 # auto (default): Auto-select
 output_device =
@@ -169,6 +180,11 @@ output_device =
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Whether to watch the SD card and NAND folders for changes made by other programs while a game is
+# running. Without it, those changes may not be seen until the game is restarted. Linux only.
+# 1 (default): Yes, 0: No
+watch_host_files =
+
 [System]
 # The system model that Citra will try to emulate
 # 0: Old 3DS (default), 1: New 3DS
@@ -120,6 +120,9 @@ void Config::ReadValues() {
     Settings::values.sink_id = qt_config->value("output_engine", "auto").toString().toStdString();
     Settings::values.enable_audio_stretching =
         qt_config->value("enable_audio_stretching", true).toBool();
+    Settings::values.enable_dsp_thread = qt_config->value("enable_dsp_thread", false).toBool();
+    Settings::values.enable_audio_pacing =
+        qt_config->value("enable_audio_pacing", false).toBool();
     Settings::values.audio_device_id =
         qt_config->value("output_device", "auto").toString().toStdString();
     qt_config->endGroup();
@@ -147,6 +150,7 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Data Storage");
     Settings::values.use_virtual_sd = qt_config->value("use_virtual_sd", true).toBool();
+    Settings::values.watch_host_files = qt_config->value("watch_host_files", true).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -343,6 +347,8 @@ void Config::SaveValues() {
     qt_config->beginGroup("Audio");
     qt_config->setValue("output_engine", QString::fromStdString(Settings::values.sink_id));
     qt_config->setValue("enable_audio_stretching", Settings::values.enable_audio_stretching);
+    qt_config->setValue("enable_dsp_thread", Settings::values.enable_dsp_thread);
+    qt_config->setValue("enable_audio_pacing", Settings::values.enable_audio_pacing);
     qt_config->setValue("output_device", QString::fromStdString(Settings::values.audio_device_id));
     qt_config->endGroup();
 
@@ -367,6 +373,7 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Data Storage");
     qt_config->setValue("use_virtual_sd", Settings::values.use_virtual_sd);
+    qt_config->setValue("watch_host_files", Settings::values.watch_host_files);
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -6,6 +6,7 @@
 #include "audio_core/sink.h"
 #include "audio_core/sink_details.h"
 #include "citra_qt/configuration/configure_audio.h"
+#include "core/core.h"
 #include "core/settings.h"
 #include "ui_configure_audio.h"
 
@@ -39,6 +40,11 @@ void ConfigureAudio::setConfiguration() {
 
     ui->toggle_audio_stretching->setChecked(Settings::values.enable_audio_stretching);
 
+    ui->toggle_dsp_thread->setEnabled(!Core::System::GetInstance().IsPoweredOn());
+    ui->toggle_dsp_thread->setChecked(Settings::values.enable_dsp_thread);
+
+    ui->toggle_audio_pacing->setChecked(Settings::values.enable_audio_pacing);
+
     // The device list cannot be pre-populated (nor listed) until the output sink is known.
     updateAudioDevices(new_sink_index);
 
@@ -58,6 +64,8 @@ void ConfigureAudio::applyConfiguration() {
         ui->output_sink_combo_box->itemText(ui->output_sink_combo_box->currentIndex())
             .toStdString();
     Settings::values.enable_audio_stretching = ui->toggle_audio_stretching->isChecked();
+    Settings::values.enable_dsp_thread = ui->toggle_dsp_thread->isChecked();
+    Settings::values.enable_audio_pacing = ui->toggle_audio_pacing->isChecked();
     Settings::values.audio_device_id =
         ui->audio_device_combo_box->itemText(ui->audio_device_combo_box->currentIndex())
             .toStdString();
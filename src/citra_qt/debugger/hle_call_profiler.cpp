@@ -0,0 +1,128 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <QCheckBox>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include "citra_qt/debugger/hle_call_profiler.h"
+#include "core/hle/call_profiler.h"
+
+namespace {
+enum Column {
+    COLUMN_SERVICE,
+    COLUMN_COMMAND,
+    COLUMN_ID,
+    COLUMN_CALLS,
+    COLUMN_TOTAL,
+    COLUMN_AVERAGE,
+    COLUMN_MAX,
+    COLUMN_COUNT,
+};
+} // Anonymous namespace
+
+HLECallProfilerWidget::HLECallProfilerWidget(QWidget* parent)
+    : QDockWidget(tr("HLE Call Profiler"), parent) {
+    setObjectName("HLECallProfiler");
+
+    record_checkbox = new QCheckBox(tr("Record calls"));
+    record_checkbox->setChecked(HLE::CallProfiler::IsEnabled());
+    QPushButton* reset_button = new QPushButton(tr("Reset"));
+    QPushButton* save_button = new QPushButton(QIcon::fromTheme("document-save"), tr("Save..."));
+
+    call_list = new QTreeWidget;
+    call_list->setColumnCount(COLUMN_COUNT);
+    call_list->setHeaderLabels({tr("Service"), tr("Command"), tr("ID"), tr("Calls"),
+                                tr("Total (ms)"), tr("Average (us)"), tr("Max (us)")});
+    call_list->setRootIsDecorated(false);
+    call_list->setSortingEnabled(true);
+    call_list->sortByColumn(COLUMN_TOTAL, Qt::DescendingOrder);
+    call_list->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    connect(record_checkbox, &QCheckBox::toggled, this, &HLECallProfilerWidget::OnRecordToggled);
+    connect(reset_button, &QPushButton::clicked, this, &HLECallProfilerWidget::OnReset);
+    connect(save_button, &QPushButton::clicked, this, &HLECallProfilerWidget::OnSave);
+    connect(&update_timer, &QTimer::timeout, this, &HLECallProfilerWidget::Refresh);
+
+    auto main_widget = new QWidget;
+    auto main_layout = new QVBoxLayout;
+    {
+        auto sub_layout = new QHBoxLayout;
+        sub_layout->addWidget(record_checkbox);
+        sub_layout->addStretch();
+        sub_layout->addWidget(reset_button);
+        sub_layout->addWidget(save_button);
+        main_layout->addLayout(sub_layout);
+    }
+    main_layout->addWidget(call_list);
+    main_widget->setLayout(main_layout);
+    setWidget(main_widget);
+}
+
+void HLECallProfilerWidget::showEvent(QShowEvent* ev) {
+    Refresh();
+    update_timer.start(1000);
+    QDockWidget::showEvent(ev);
+}
+
+void HLECallProfilerWidget::hideEvent(QHideEvent* ev) {
+    update_timer.stop();
+    QDockWidget::hideEvent(ev);
+}
+
+void HLECallProfilerWidget::OnRecordToggled(bool checked) {
+    HLE::CallProfiler::SetEnabled(checked);
+}
+
+void HLECallProfilerWidget::OnReset() {
+    HLE::CallProfiler::Reset();
+    Refresh();
+}
+
+void HLECallProfilerWidget::OnSave() {
+    const QString json_filter = tr("JSON File (*.json)");
+    const QString csv_filter = tr("CSV File (*.csv)");
+    QString selected_filter;
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save HLE Call Profile"),
+                                                    "hle_calls.json",
+                                                    json_filter + ";;" + csv_filter,
+                                                    &selected_filter);
+    if (filename.isEmpty())
+        return;
+
+    // The format is picked from the extension, make sure it matches the selected filter
+    const QString extension = selected_filter == csv_filter ? ".csv" : ".json";
+    if (!filename.endsWith(extension, Qt::CaseInsensitive))
+        filename += extension;
+
+    if (!HLE::CallProfiler::DumpToFile(filename.toStdString())) {
+        QMessageBox::critical(this, tr("Error"),
+                              tr("Could not save the profile to %1").arg(filename));
+    }
+}
+
+void HLECallProfilerWidget::Refresh() {
+    const std::vector<HLE::CallProfiler::CallStats> stats = HLE::CallProfiler::GetStats();
+
+    // Sorting while rebuilding the list would reorder it after every insertion
+    call_list->setSortingEnabled(false);
+    call_list->clear();
+    for (const auto& call : stats) {
+        auto item = new QTreeWidgetItem;
+        item->setText(COLUMN_SERVICE, QString::fromStdString(call.group));
+        item->setText(COLUMN_COMMAND, QString::fromStdString(call.name));
+        item->setText(COLUMN_ID, QString("0x%1").arg(call.id, 8, 16, QLatin1Char('0')));
+        item->setData(COLUMN_CALLS, Qt::DisplayRole, static_cast<qulonglong>(call.count));
+        item->setData(COLUMN_TOTAL, Qt::DisplayRole, call.total_ns / 1e6);
+        item->setData(COLUMN_AVERAGE, Qt::DisplayRole,
+                      call.count == 0 ? 0.0 : call.total_ns / 1e3 / call.count);
+        item->setData(COLUMN_MAX, Qt::DisplayRole, call.max_ns / 1e3);
+        call_list->addTopLevelItem(item);
+    }
+    call_list->setSortingEnabled(true);
+}
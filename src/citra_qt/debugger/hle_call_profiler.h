@@ -0,0 +1,35 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+#include <QTimer>
+
+class QCheckBox;
+class QTreeWidget;
+
+/// Shows how often each HLE service command and SVC was called, and how long the calls took.
+class HLECallProfilerWidget : public QDockWidget {
+    Q_OBJECT
+
+public:
+    explicit HLECallProfilerWidget(QWidget* parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent* ev) override;
+    void hideEvent(QHideEvent* ev) override;
+
+private slots:
+    void OnRecordToggled(bool checked);
+    void OnReset();
+    void OnSave();
+    void Refresh();
+
+private:
+    QCheckBox* record_checkbox;
+    QTreeWidget* call_list;
+    /// Refreshes the list while the widget is visible
+    QTimer update_timer;
+};
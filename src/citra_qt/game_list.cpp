@@ -2,8 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
+#include <thread>
 #include <QApplication>
+#include <QDateTime>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
 #include <QHBoxLayout>
@@ -22,12 +25,15 @@
 #include <QToolButton>
 #include <QTreeView>
 #include "citra_qt/game_list.h"
+#include "citra_qt/game_list_cache.h"
 #include "citra_qt/game_list_p.h"
 #include "citra_qt/main.h"
 #include "citra_qt/ui_settings.h"
 #include "common/common_paths.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread_worker.h"
+#include "core/hle/service/am/am.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/loader/loader.h"
 
@@ -266,6 +272,10 @@ void GameList::onFilterCloseClicked() {
 }
 
 GameList::GameList(GMainWindow* parent) : QWidget{parent} {
+    cache = std::make_unique<GameListCache>(FileUtil::GetUserPath(D_CACHE_IDX) +
+                                            "game_list" DIR_SEP "index.bin");
+    cache->Load();
+
     watcher = new QFileSystemWatcher(this);
     connect(watcher, &QFileSystemWatcher::directoryChanged, this, &GameList::RefreshGameDirectory);
 
@@ -583,7 +593,7 @@ void GameList::PopulateAsync(QList<UISettings::GameDir>& game_dirs) {
 
     emit ShouldCancelWorker();
 
-    GameListWorker* worker = new GameListWorker(game_dirs, compatibility_list);
+    GameListWorker* worker = new GameListWorker(game_dirs, compatibility_list, *cache);
 
     connect(worker, &GameListWorker::EntryReady, this, &GameList::AddEntry, Qt::QueuedConnection);
     connect(worker, &GameListWorker::DirEntryReady, this, &GameList::AddDirEntry,
@@ -629,6 +639,72 @@ void GameList::RefreshGameDirectory() {
     }
 }
 
+namespace {
+
+/// Reads what the game list shows about a game file. Sets the file type to Error if the file
+/// cannot be loaded, so that it is remembered as not being a game.
+GameListCache::Entry ReadGameMetadata(const std::string& physical_name) {
+    GameListCache::Entry entry;
+    entry.file_type = static_cast<u32>(Loader::FileType::Error);
+
+    std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
+    if (!loader)
+        return entry;
+
+    entry.file_type = static_cast<u32>(loader->GetFileType());
+    loader->ReadProgramId(entry.program_id);
+    loader->ReadIcon(entry.smdh);
+    return entry;
+}
+
+/// Returns the SMDH of the installed update of a title, or an empty vector if there is none.
+std::vector<u8> ReadUpdateSMDH(u64 program_id) {
+    if (program_id < 0x00040000'00000000 || program_id > 0x00040000'FFFFFFFF)
+        return {};
+
+    std::string update_path = Service::AM::GetTitleContentPath(Service::FS::MediaType::SDMC,
+                                                               program_id + 0x0000000E'00000000);
+
+    if (!FileUtil::Exists(update_path))
+        return {};
+
+    std::unique_ptr<Loader::AppLoader> update_loader = Loader::GetLoader(update_path);
+
+    if (!update_loader)
+        return {};
+
+    std::vector<u8> update_smdh;
+    update_loader->ReadIcon(update_smdh);
+    return update_smdh;
+}
+
+} // Anonymous namespace
+
+void GameListWorker::AddGameEntry(const std::string& physical_name,
+                                  const GameListCache::Entry& entry, GameListDir* parent_dir) {
+    // Updates are installed separately from the game, so their SMDH is not part of the index
+    std::vector<u8> smdh = ReadUpdateSMDH(entry.program_id);
+    if (smdh.empty())
+        smdh = entry.smdh;
+
+    // The game list uses this as compatibility number for untested games
+    QString compatibility("99");
+    auto it = compatibility_list.find(Common::StringFromFormat("%016" PRIX64, entry.program_id));
+    if (it != compatibility_list.end())
+        compatibility = it->second.first;
+
+    emit EntryReady(
+        {
+            new GameListItemPath(QString::fromStdString(physical_name), smdh, entry.program_id),
+            new GameListItemCompat(compatibility),
+            new GameListItemRegion(smdh),
+            new GameListItem(QString::fromStdString(
+                Loader::GetFileTypeString(static_cast<Loader::FileType>(entry.file_type)))),
+            new GameListItemSize(entry.size),
+        },
+        parent_dir);
+}
+
 void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
                                              GameListDir* parent_dir) {
     const auto callback = [this, recursion, parent_dir](unsigned* num_entries_out,
@@ -639,60 +715,32 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
         if (stop_processing)
             return false; // Breaks the callback loop.
 
-        bool is_dir = FileUtil::IsDirectory(physical_name);
+        // A single stat per entry, which matters when the games are on a network share
+        const QFileInfo file_info(QString::fromStdString(physical_name));
+        bool is_dir = file_info.isDir();
         if (!is_dir && HasSupportedFileExtension(physical_name)) {
-            std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
-            if (!loader)
-                return true;
-
-            u64 program_id = 0;
-            loader->ReadProgramId(program_id);
-
-            std::vector<u8> smdh = [program_id, &loader]() -> std::vector<u8> {
-                std::vector<u8> original_smdh;
-                loader->ReadIcon(original_smdh);
-
-                if (program_id < 0x00040000'00000000 || program_id > 0x00040000'FFFFFFFF)
-                    return original_smdh;
-
-                std::string update_path = Service::AM::GetTitleContentPath(
-                    Service::FS::MediaType::SDMC, program_id + 0x0000000E'00000000);
-
-                if (!FileUtil::Exists(update_path))
-                    return original_smdh;
-
-                std::unique_ptr<Loader::AppLoader> update_loader = Loader::GetLoader(update_path);
+            const u64 size = static_cast<u64>(file_info.size());
+            const s64 modified_time = file_info.lastModified().toMSecsSinceEpoch();
 
-                if (!update_loader)
-                    return original_smdh;
-
-                std::vector<u8> update_smdh;
-                update_loader->ReadIcon(update_smdh);
-                return update_smdh;
-            }();
-
-            auto it = std::find_if(
-                compatibility_list.begin(), compatibility_list.end(),
-                [program_id](const std::pair<std::string, std::pair<QString, QString>>& element) {
-                    std::string pid = Common::StringFromFormat("%016" PRIX64, program_id);
-                    return element.first == pid;
-                });
+            GameListCache::Entry entry;
+            if (cache.Lookup(physical_name, size, modified_time, entry)) {
+                if (entry.file_type != static_cast<u32>(Loader::FileType::Error))
+                    AddGameEntry(physical_name, entry, parent_dir);
+                return true;
+            }
 
-            // The game list uses this as compatibility number for untested games
-            QString compatibility("99");
-            if (it != compatibility_list.end())
-                compatibility = it->second.first;
+            // Files that are new or have changed are opened on the pool while the scan goes on
+            loader_pool->Submit([this, physical_name, size, modified_time, parent_dir] {
+                if (stop_processing)
+                    return;
 
-            emit EntryReady(
-                {
-                    new GameListItemPath(QString::fromStdString(physical_name), smdh, program_id),
-                    new GameListItemCompat(compatibility),
-                    new GameListItemRegion(smdh),
-                    new GameListItem(
-                        QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
-                    new GameListItemSize(FileUtil::GetSize(physical_name)),
-                },
-                parent_dir);
+                GameListCache::Entry entry = ReadGameMetadata(physical_name);
+                entry.size = size;
+                entry.modified_time = modified_time;
+                if (entry.file_type != static_cast<u32>(Loader::FileType::Error))
+                    AddGameEntry(physical_name, entry, parent_dir);
+                cache.Insert(physical_name, std::move(entry));
+            });
 
         } else if (is_dir && recursion > 0) {
             watch_list.append(QString::fromStdString(physical_name));
@@ -707,6 +755,12 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
 
 void GameListWorker::run() {
     stop_processing = false;
+    cache.BeginScan();
+
+    // Loading a game is mostly waiting for its file to be read, so use more threads than cores
+    loader_pool = std::make_unique<Common::ThreadWorker>(
+        std::max(4u, std::thread::hardware_concurrency()), "GameListWorker");
+
     for (UISettings::GameDir& game_dir : game_dirs) {
         if (game_dir.path == "INSTALLED") {
             QString path = QString(FileUtil::GetUserPath(D_SDMC_IDX).c_str()) +
@@ -734,6 +788,13 @@ void GameListWorker::run() {
                                     game_list_dir);
         }
     };
+
+    // Waits for the files that were queued on the pool to be loaded
+    loader_pool.reset();
+
+    // A cancelled scan has not seen every game, and would drop the ones it missed from the index
+    if (!stop_processing)
+        cache.Save();
     emit Finished(watch_list);
 }
 
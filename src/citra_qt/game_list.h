@@ -4,12 +4,14 @@
 
 #pragma once
 
+#include <memory>
 #include <unordered_map>
 #include <QString>
 #include <QWidget>
 #include "common/common_types.h"
 #include "ui_settings.h"
 
+class GameListCache;
 class GameListWorker;
 class GameListDir;
 class GMainWindow;
@@ -130,6 +132,7 @@ private:
     GameListWorker* current_worker = nullptr;
     QFileSystemWatcher* watcher = nullptr;
     std::unordered_map<std::string, std::pair<QString, QString>> compatibility_list;
+    std::unique_ptr<GameListCache> cache;
 };
 
 Q_DECLARE_METATYPE(GameListOpenTarget);
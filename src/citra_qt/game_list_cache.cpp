@@ -0,0 +1,132 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QString>
+#include "citra_qt/game_list_cache.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+
+namespace {
+
+constexpr quint32 index_magic = 0x494C4743; // "CGLI"
+
+/// Bump this whenever the layout of the index or what is stored in it changes.
+constexpr quint32 index_version = 1;
+
+} // Anonymous namespace
+
+GameListCache::GameListCache(std::string path) : path(std::move(path)) {}
+
+void GameListCache::Load() {
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    const QByteArray data = qUncompress(file.readAll());
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != index_magic || version != index_version) {
+        NGLOG_WARNING(Frontend, "Ignoring game list index {} from another version", path);
+        return;
+    }
+
+    std::unordered_map<std::string, Entry> loaded;
+    loaded.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        QString file_path;
+        quint64 size, program_id;
+        qint64 modified_time;
+        quint32 file_type;
+        QByteArray smdh;
+        stream >> file_path >> size >> modified_time >> program_id >> file_type >> smdh;
+        if (stream.status() != QDataStream::Ok) {
+            NGLOG_WARNING(Frontend, "Game list index {} is truncated", path);
+            return;
+        }
+
+        Entry& entry = loaded[file_path.toStdString()];
+        entry.size = size;
+        entry.modified_time = modified_time;
+        entry.program_id = program_id;
+        entry.file_type = file_type;
+        entry.smdh.assign(smdh.begin(), smdh.end());
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries = std::move(loaded);
+    dirty = false;
+    NGLOG_INFO(Frontend, "Loaded {} entries from the game list index", entries.size());
+}
+
+void GameListCache::Save() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (used_paths.count(it->first) == 0) {
+            it = entries.erase(it);
+            dirty = true;
+        } else {
+            ++it;
+        }
+    }
+
+    if (!dirty)
+        return;
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << index_magic << index_version << static_cast<quint32>(entries.size());
+    for (const auto& pair : entries) {
+        const Entry& entry = pair.second;
+        stream << QString::fromStdString(pair.first) << static_cast<quint64>(entry.size)
+               << static_cast<qint64>(entry.modified_time)
+               << static_cast<quint64>(entry.program_id) << static_cast<quint32>(entry.file_type)
+               << QByteArray(reinterpret_cast<const char*>(entry.smdh.data()),
+                             static_cast<int>(entry.smdh.size()));
+    }
+
+    FileUtil::CreateFullPath(path);
+    // Written to a temporary file first, so that a crash cannot leave a truncated index behind
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::WriteOnly) || file.write(qCompress(data)) < 0 || !file.commit()) {
+        NGLOG_ERROR(Frontend, "Could not write the game list index to {}", path);
+        return;
+    }
+    dirty = false;
+}
+
+void GameListCache::BeginScan() {
+    std::lock_guard<std::mutex> lock(mutex);
+    used_paths.clear();
+}
+
+bool GameListCache::Lookup(const std::string& file_path, u64 size, s64 modified_time,
+                           Entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = entries.find(file_path);
+    if (it == entries.end() || it->second.size != size ||
+        it->second.modified_time != modified_time) {
+        return false;
+    }
+
+    used_paths.insert(file_path);
+    entry = it->second;
+    return true;
+}
+
+void GameListCache::Insert(const std::string& file_path, Entry entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    used_paths.insert(file_path);
+    entries[file_path] = std::move(entry);
+    dirty = true;
+}
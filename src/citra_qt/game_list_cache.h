@@ -0,0 +1,70 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * On-disk index of the metadata the game list shows for each game file, so that refreshing the
+ * list does not have to open every file and run its loader again. Entries are keyed by path and
+ * are only used while the size and modification time of the file still match.
+ *
+ * All methods are thread-safe.
+ */
+class GameListCache {
+public:
+    /// Metadata read from a game file by its loader
+    struct Entry {
+        u64 size = 0;
+        s64 modified_time = 0;
+        u64 program_id = 0;
+        /// Loader::FileType of the file
+        u32 file_type = 0;
+        /// SMDH of the file, which holds the titles, icons and region, or empty if it has none
+        std::vector<u8> smdh;
+    };
+
+    /// @param path File the index is loaded from and saved to
+    explicit GameListCache(std::string path);
+
+    /// Replaces the entries in memory with the ones saved on disk, if there are any.
+    void Load();
+
+    /**
+     * Saves the entries that were looked up or inserted since the last call to BeginScan, and
+     * drops the others from memory too. Does nothing if the index has not changed since it was
+     * loaded or last saved.
+     */
+    void Save();
+
+    /// Starts tracking which entries are still in use, see Save.
+    void BeginScan();
+
+    /**
+     * Looks up the metadata of a file.
+     * @param file_path Path of the file
+     * @param size Current size of the file
+     * @param modified_time Current modification time of the file
+     * @param entry Receives the metadata if it was found
+     * @returns true if the file is in the index and has not changed since it was added
+     */
+    bool Lookup(const std::string& file_path, u64 size, s64 modified_time, Entry& entry);
+
+    /// Adds or replaces the metadata of a file.
+    void Insert(const std::string& file_path, Entry entry);
+
+private:
+    std::string path;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::unordered_set<std::string> used_paths;
+    bool dirty = false;
+};
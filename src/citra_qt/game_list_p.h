@@ -6,6 +6,7 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <QCoreApplication>
 #include <QFileInfo>
@@ -15,11 +16,13 @@
 #include <QRunnable>
 #include <QStandardItem>
 #include <QString>
+#include "citra_qt/game_list_cache.h"
 #include "citra_qt/ui_settings.h"
 #include "citra_qt/util/util.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread_worker.h"
 #include "core/loader/smdh.h"
 
 enum class GameListItemType {
@@ -367,6 +370,9 @@ public:
 /**
  * Asynchronous worker object for populating the game list.
  * Communicates with other threads through Qt's signal/slot system.
+ *
+ * Games that are in the index are added without opening their files. The others are loaded on a
+ * pool of threads while the directories are still being scanned, and added to the index.
  */
 class GameListWorker : public QObject, public QRunnable {
     Q_OBJECT
@@ -374,8 +380,10 @@ class GameListWorker : public QObject, public QRunnable {
 public:
     explicit GameListWorker(
         QList<UISettings::GameDir>& game_dirs,
-        const std::unordered_map<std::string, std::pair<QString, QString>>& compatibility_list)
-        : QObject(), QRunnable(), game_dirs(game_dirs), compatibility_list(compatibility_list) {}
+        const std::unordered_map<std::string, std::pair<QString, QString>>& compatibility_list,
+        GameListCache& cache)
+        : QObject(), QRunnable(), game_dirs(game_dirs), compatibility_list(compatibility_list),
+          cache(cache) {}
 
 public slots:
     /// Starts the processing of directory tree information.
@@ -403,8 +411,12 @@ private:
     QStringList watch_list;
     const std::unordered_map<std::string, std::pair<QString, QString>>& compatibility_list;
     QList<UISettings::GameDir>& game_dirs;
+    GameListCache& cache;
+    std::unique_ptr<Common::ThreadWorker> loader_pool;
     std::atomic_bool stop_processing;
 
+    void AddGameEntry(const std::string& physical_name, const GameListCache::Entry& entry,
+                      GameListDir* parent_dir);
     void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion,
                                  GameListDir* parent_dir);
 };
@@ -15,6 +15,8 @@
 #include <QtConcurrent/QtConcurrentRun>
 #include <QtGui>
 #include <QtWidgets>
+#include "audio_core/dsp_interface.h"
+#include "audio_core/sink.h"
 #include "citra_qt/aboutdialog.h"
 #include "citra_qt/bootmanager.h"
 #include "citra_qt/camera/qt_multimedia_camera.h"
@@ -29,6 +31,7 @@
 #include "citra_qt/debugger/graphics/graphics_surface.h"
 #include "citra_qt/debugger/graphics/graphics_tracing.h"
 #include "citra_qt/debugger/graphics/graphics_vertex_shader.h"
+#include "citra_qt/debugger/hle_call_profiler.h"
 #include "citra_qt/debugger/profiler.h"
 #include "citra_qt/debugger/registers.h"
 #include "citra_qt/debugger/wait_tree.h"
@@ -48,6 +51,7 @@
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #include "common/string_util.h"
+#include "core/boot_profiler.h"
 #include "core/core.h"
 #include "core/file_sys/archive_source_sd_savedata.h"
 #include "core/gdbstub/gdbstub.h"
@@ -111,6 +115,7 @@ GMainWindow::GMainWindow() : config(new Config()), emu_thread(nullptr) {
     // register types to use in slots and signals
     qRegisterMetaType<size_t>("size_t");
     qRegisterMetaType<Service::AM::InstallStatus>("Service::AM::InstallStatus");
+    qRegisterMetaType<Service::AM::InstallStats>("Service::AM::InstallStats");
 
     LoadTranslation();
 
@@ -212,8 +217,14 @@ void GMainWindow::InitializeWidgets() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a 3DS frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
-
-    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label}) {
+    audio_latency_label = new QLabel();
+    audio_latency_label->setToolTip(
+        tr("Amount of audio queued for the output device, and how many times the device ran out "
+           "of audio to play. Underruns are heard as crackling. With audio pacing, also shows the "
+           "speed emulation was adjusted to, to keep up with the device."));
+
+    for (auto& label :
+         {emu_speed_label, game_fps_label, emu_frametime_label, audio_latency_label}) {
         label->setVisible(false);
         label->setFrameStyle(QFrame::NoFrame);
         label->setContentsMargins(4, 0, 4, 0);
@@ -291,6 +302,15 @@ void GMainWindow::InitializeDebugWidgets() {
             &WaitTreeWidget::OnEmulationStarting);
     connect(this, &GMainWindow::EmulationStopping, waitTreeWidget,
             &WaitTreeWidget::OnEmulationStopping);
+
+    hleCallProfilerWidget = new HLECallProfilerWidget(this);
+    addDockWidget(Qt::LeftDockWidgetArea, hleCallProfilerWidget);
+    hleCallProfilerWidget->hide();
+    debug_menu->addAction(hleCallProfilerWidget->toggleViewAction());
+
+    QAction* save_boot_trace = new QAction(tr("Save Boot Trace..."), this);
+    connect(save_boot_trace, &QAction::triggered, this, &GMainWindow::OnSaveBootTrace);
+    debug_menu->addAction(save_boot_trace);
 }
 
 void GMainWindow::InitializeRecentFileMenuActions() {
@@ -749,6 +769,7 @@ void GMainWindow::ShutdownGame() {
     emu_speed_label->setVisible(false);
     game_fps_label->setVisible(false);
     emu_frametime_label->setVisible(false);
+    audio_latency_label->setVisible(false);
 
     emulation_running = false;
 
@@ -931,8 +952,9 @@ void GMainWindow::OnMenuInstallCIA() {
             emit UpdateProgress(written, total);
         };
         for (const auto current_path : filepaths) {
-            status = Service::AM::InstallCIA(current_path.toStdString(), cia_progress);
-            emit CIAInstallReport(status, current_path);
+            Service::AM::InstallStats stats;
+            status = Service::AM::InstallCIA(current_path.toStdString(), cia_progress, &stats);
+            emit CIAInstallReport(status, current_path, stats);
         }
         emit CIAInstallFinished();
         return;
@@ -944,11 +966,15 @@ void GMainWindow::OnUpdateProgress(size_t written, size_t total) {
     progress_bar->setValue(written);
 }
 
-void GMainWindow::OnCIAInstallReport(Service::AM::InstallStatus status, QString filepath) {
+void GMainWindow::OnCIAInstallReport(Service::AM::InstallStatus status, QString filepath,
+                                     Service::AM::InstallStats stats) {
     QString filename = QFileInfo(filepath).fileName();
     switch (status) {
     case Service::AM::InstallStatus::Success:
-        this->statusBar()->showMessage(tr("%1 has been installed successfully.").arg(filename));
+        this->statusBar()->showMessage(
+            tr("%1 has been installed successfully (%2 MB/s).")
+                .arg(filename)
+                .arg(stats.GetMegabytesPerSecond(), 0, 'f', 1));
         break;
     case Service::AM::InstallStatus::ErrorFailedToOpenFile:
         QMessageBox::critical(this, tr("Unable to open File"),
@@ -969,6 +995,12 @@ void GMainWindow::OnCIAInstallReport(Service::AM::InstallStatus status, QString
                                  "before being used with Citra. A real 3DS is required.")
                                   .arg(filename));
         break;
+    case Service::AM::InstallStatus::ErrorHashMismatch:
+        QMessageBox::critical(this, tr("Corrupted File"),
+                              tr("The contents of %1 do not match their hashes. The file may be "
+                                 "corrupted or incomplete.")
+                                  .arg(filename));
+        break;
     }
 }
 
@@ -1172,6 +1204,18 @@ void GMainWindow::OnCreateGraphicsSurfaceViewer() {
     graphicsSurfaceViewerWidget->show();
 }
 
+void GMainWindow::OnSaveBootTrace() {
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save Boot Trace"), "boot.json",
+                                                    tr("Chrome Trace (*.json)"));
+    if (filename.isEmpty())
+        return;
+
+    if (!Core::BootProfiler::DumpToFile(filename.toStdString())) {
+        QMessageBox::critical(this, tr("Error"),
+                              tr("Could not save the boot trace to %1").arg(filename));
+    }
+}
+
 void GMainWindow::UpdateStatusBar() {
     if (emu_thread == nullptr) {
         status_bar_update_timer.stop();
@@ -1190,9 +1234,25 @@ void GMainWindow::UpdateStatusBar() {
     game_fps_label->setText(tr("Game: %1 FPS").arg(results.game_fps, 0, 'f', 0));
     emu_frametime_label->setText(tr("Frame: %1 ms").arg(results.frametime * 1000.0, 0, 'f', 2));
 
+    const AudioCore::Sink& sink = Core::DSP().GetSink();
+    const AudioCore::SinkStats audio_stats = sink.GetStats();
+    QString audio_text =
+        tr("Audio: %1 ms, %2 underruns")
+            .arg(audio_stats.queued_samples * 1000.0 / sink.GetNativeSampleRate(), 0, 'f', 0)
+            .arg(audio_stats.underruns);
+    if (Settings::values.enable_audio_pacing) {
+        audio_text += tr(", paced to %1%").arg(results.audio_speed_correction * 100.0, 0, 'f', 1);
+    }
+    if (results.dropped_audio_frames > 0) {
+        audio_text +=
+            tr(", %n frame(s) dropped", "", static_cast<int>(results.dropped_audio_frames));
+    }
+    audio_latency_label->setText(audio_text);
+
     emu_speed_label->setVisible(true);
     game_fps_label->setVisible(true);
     emu_frametime_label->setVisible(true);
+    audio_latency_label->setVisible(true);
 }
 
 void GMainWindow::OnCoreError(Core::System::ResultStatus result, std::string details) {
@@ -28,6 +28,7 @@ class GraphicsBreakPointsWidget;
 class GraphicsTracingWidget;
 class GraphicsVertexShaderWidget;
 class GRenderWindow;
+class HLECallProfilerWidget;
 class MicroProfileDialog;
 class MultiplayerState;
 class ProfilerWidget;
@@ -80,7 +81,8 @@ signals:
     void EmulationStopping();
 
     void UpdateProgress(size_t written, size_t total);
-    void CIAInstallReport(Service::AM::InstallStatus status, QString filepath);
+    void CIAInstallReport(Service::AM::InstallStatus status, QString filepath,
+                          Service::AM::InstallStats stats);
     void CIAInstallFinished();
     // Signal that tells widgets to update icons to use the current theme
     void UpdateThemedIcons();
@@ -155,7 +157,8 @@ private slots:
     void OnMenuLoadFile();
     void OnMenuInstallCIA();
     void OnUpdateProgress(size_t written, size_t total);
-    void OnCIAInstallReport(Service::AM::InstallStatus status, QString filepath);
+    void OnCIAInstallReport(Service::AM::InstallStatus status, QString filepath,
+                            Service::AM::InstallStats stats);
     void OnCIAInstallFinished();
     void OnMenuRecentFile();
     void OnConfigure();
@@ -169,6 +172,7 @@ private slots:
     void HideFullscreen();
     void ToggleWindowMode();
     void OnCreateGraphicsSurfaceViewer();
+    void OnSaveBootTrace();
     void OnCoreError(Core::System::ResultStatus, std::string);
     /// Called whenever a user selects Help->About Citra
     void OnMenuAboutCitra();
@@ -194,6 +198,7 @@ private:
     QLabel* emu_speed_label = nullptr;
     QLabel* game_fps_label = nullptr;
     QLabel* emu_frametime_label = nullptr;
+    QLabel* audio_latency_label = nullptr;
     QTimer status_bar_update_timer;
 
     MultiplayerState* multiplayer_state = nullptr;
@@ -213,6 +218,7 @@ private:
     GraphicsVertexShaderWidget* graphicsVertexShaderWidget;
     GraphicsTracingWidget* graphicsTracingWidget;
     WaitTreeWidget* waitTreeWidget;
+    HLECallProfilerWidget* hleCallProfilerWidget;
     Updater* updater;
 
     bool explicit_update_check = false;
@@ -233,3 +239,4 @@ protected:
 
 Q_DECLARE_METATYPE(size_t);
 Q_DECLARE_METATYPE(Service::AM::InstallStatus);
+Q_DECLARE_METATYPE(Service::AM::InstallStats);
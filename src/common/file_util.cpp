@@ -35,7 +35,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -57,6 +59,8 @@
 #endif
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
 #include <sys/stat.h>
 
 #ifndef S_ISDIR
@@ -261,6 +265,23 @@ bool Rename(const std::string& srcFilename, const std::string& destFilename) {
     return false;
 }
 
+bool RenameReplacing(const std::string& srcFilename, const std::string& destFilename) {
+    NGLOG_TRACE(Common_Filesystem, "{} --> {}", srcFilename, destFilename);
+#ifdef _WIN32
+    if (MoveFileExW(Common::UTF8ToUTF16W(srcFilename).c_str(),
+                    Common::UTF8ToUTF16W(destFilename).c_str(),
+                    MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        return true;
+#else
+    // rename already replaces the destination atomically
+    if (rename(srcFilename.c_str(), destFilename.c_str()) == 0)
+        return true;
+#endif
+    NGLOG_ERROR(Common_Filesystem, "failed {} --> {}: {}", srcFilename, destFilename,
+                GetLastErrorMsg());
+    return false;
+}
+
 // copies file srcFilename to destFilename, returns true on success
 bool Copy(const std::string& srcFilename, const std::string& destFilename) {
     NGLOG_TRACE(Common_Filesystem, "{} --> {}", srcFilename, destFilename);
@@ -366,6 +387,20 @@ u64 GetSize(const int fd) {
     return buf.st_size;
 }
 
+// Returns the time filename was last modified, in seconds since the epoch, or 0 on failure
+s64 GetModificationTime(const std::string& filename) {
+    struct stat buf;
+#ifdef _WIN32
+    if (_wstat64(Common::UTF8ToUTF16W(filename).c_str(), &buf) == 0)
+#else
+    if (stat(filename.c_str(), &buf) == 0)
+#endif
+        return static_cast<s64>(buf.st_mtime);
+
+    NGLOG_DEBUG(Common_Filesystem, "stat failed on {}: {}", filename, GetLastErrorMsg());
+    return 0;
+}
+
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE* f) {
     // can't use off_t here because it can be 32-bit
@@ -893,4 +928,147 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFile::MappedFile() {}
+
+MappedFile::MappedFile(const std::string& filename) {
+    Open(filename);
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) {
+    Swap(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) {
+    Swap(other);
+    return *this;
+}
+
+void MappedFile::Swap(MappedFile& other) {
+#ifdef _WIN32
+    std::swap(file_handle, other.file_handle);
+    std::swap(mapping_handle, other.mapping_handle);
+#else
+    std::swap(fd, other.fd);
+#endif
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    std::swap(is_open, other.is_open);
+}
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(Common::UTF8ToUTF16W(filename).c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+    file_handle = file;
+    size = static_cast<u64>(file_size.QuadPart);
+    is_open = true;
+
+    // Empty files can not be mapped, and a mapping larger than the address space fails.
+    if (size != 0 && size <= std::numeric_limits<size_t>::max()) {
+        mapping_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle)
+            data = static_cast<const u8*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    size = static_cast<u64>(file_info.st_size);
+    is_open = true;
+
+    // Empty files can not be mapped, and a mapping larger than the address space fails.
+    // If another process truncates the file, accessing the pages past its new end raises SIGBUS.
+    // MAP_PRIVATE would not prevent that, as pages that were never written still read the file.
+    if (size != 0 && size <= std::numeric_limits<size_t>::max()) {
+        void* pointer = mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_SHARED, fd, 0);
+        if (pointer != MAP_FAILED)
+            data = static_cast<const u8*>(pointer);
+    }
+#endif
+
+    if (!data && size != 0) {
+        NGLOG_WARNING(Common_Filesystem, "Could not map {}, falling back to regular reads",
+                      filename);
+    }
+    return true;
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping_handle)
+        CloseHandle(mapping_handle);
+    if (file_handle)
+        CloseHandle(file_handle);
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+#else
+    if (data)
+        munmap(const_cast<u8*>(data), static_cast<size_t>(size));
+    if (fd != -1)
+        close(fd);
+    fd = -1;
+#endif
+    data = nullptr;
+    size = 0;
+    is_open = false;
+}
+
+size_t MappedFile::ReadAt(u64 offset, size_t length, void* buffer) const {
+    if (!is_open || offset >= size)
+        return 0;
+    length = static_cast<size_t>(std::min<u64>(length, size - offset));
+
+    if (data) {
+        std::memcpy(buffer, data + offset, length);
+        return length;
+    }
+
+    u8* out = static_cast<u8*>(buffer);
+    size_t total = 0;
+    while (total < length) {
+#ifdef _WIN32
+        // ReadFile takes 32-bit lengths, the offset goes through the OVERLAPPED structure.
+        OVERLAPPED overlapped{};
+        const u64 position = offset + total;
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD chunk = static_cast<DWORD>(std::min<size_t>(length - total, 0x40000000));
+        DWORD read = 0;
+        if (!ReadFile(file_handle, out + total, chunk, &read, &overlapped) || read == 0)
+            break;
+#else
+        const ssize_t read = pread(fd, out + total, length - total, offset + total);
+        if (read < 0 && errno == EINTR)
+            continue;
+        if (read <= 0)
+            break;
+#endif
+        total += read;
+    }
+    return total;
+}
+
 } // namespace FileUtil
@@ -55,6 +55,9 @@ u64 GetSize(const int fd);
 // Overloaded GetSize, accepts FILE*
 u64 GetSize(FILE* f);
 
+// Returns the time filename was last modified, in seconds since the epoch, or 0 on failure
+s64 GetModificationTime(const std::string& filename);
+
 // Returns true if successful, or path already exists.
 bool CreateDir(const std::string& filename);
 
@@ -71,6 +74,10 @@ bool DeleteDir(const std::string& filename);
 // renames file srcFilename to destFilename, returns true on success
 bool Rename(const std::string& srcFilename, const std::string& destFilename);
 
+// renames file srcFilename to destFilename, replacing destFilename if it exists, in a single step
+// so that destFilename always holds either the old or the new file. Returns true on success
+bool RenameReplacing(const std::string& srcFilename, const std::string& destFilename);
+
 // copies file srcFilename to destFilename, returns true on success
 bool Copy(const std::string& srcFilename, const std::string& destFilename);
 
@@ -261,6 +268,69 @@ private:
     bool m_good = true;
 };
 
+/**
+ * Read-only access to a whole file, for large images such as game dumps. The file is mapped into
+ * memory when possible, so reads are a copy out of the page cache and GetPointer() gives
+ * zero-copy access. If the file can not be mapped, reads fall back to positioned reads. Unlike
+ * IOFile, there is no file position: ReadAt may be called from several threads at once.
+ *
+ * The file must not be truncated by another program while it is open: on POSIX hosts, reading the
+ * part that was cut off from the mapping crashes the emulator with SIGBUS.
+ */
+class MappedFile : public NonCopyable {
+public:
+    MappedFile();
+    explicit MappedFile(const std::string& filename);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+
+    void Swap(MappedFile& other);
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    bool IsOpen() const {
+        return is_open;
+    }
+
+    /// Returns true if the file is mapped into memory, see GetPointer.
+    bool IsMapped() const {
+        return data != nullptr;
+    }
+
+    u64 GetSize() const {
+        return size;
+    }
+
+    /// Returns the contents of the file, or nullptr if the file is not mapped.
+    const u8* GetPointer() const {
+        return data;
+    }
+
+    /**
+     * Reads from the file. Reads past the end of the file are truncated.
+     * @param offset Offset in the file to start reading from
+     * @param length Number of bytes to read
+     * @param buffer Buffer to read into
+     * @returns The number of bytes read
+     */
+    size_t ReadAt(u64 offset, size_t length, void* buffer) const;
+
+private:
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int fd = -1;
+#endif
+    const u8* data = nullptr;
+    u64 size = 0;
+    bool is_open = false;
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
@@ -405,12 +405,12 @@ std::u16string UTF8ToUTF16(const std::string& input) {
     const size_t out_buffer_size = 4 * sizeof(char16_t) * in_bytes;
 
     std::u16string out_buffer;
-    out_buffer.resize(out_buffer_size);
+    out_buffer.resize(out_buffer_size / sizeof(char16_t));
 
     char* src_buffer = const_cast<char*>(&input[0]);
     size_t src_bytes = in_bytes;
     char* dst_buffer = (char*)(&out_buffer[0]);
-    size_t dst_bytes = out_buffer.size();
+    size_t dst_bytes = out_buffer_size;
 
     while (0 != src_bytes) {
         size_t const iconv_result =
@@ -430,7 +430,7 @@ std::u16string UTF8ToUTF16(const std::string& input) {
         }
     }
 
-    out_buffer.resize(out_buffer_size - dst_bytes);
+    out_buffer.resize((out_buffer_size - dst_bytes) / sizeof(char16_t));
     out_buffer.swap(result);
 
     iconv_close(conv_desc);
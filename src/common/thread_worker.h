@@ -0,0 +1,69 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Common {
+
+/**
+ * A pool of host threads that run tasks in the background. Tasks start in the order they were
+ * submitted, so a worker with a single thread also completes them in that order.
+ */
+class ThreadWorker final {
+public:
+    /**
+     * Starts the worker threads.
+     * @param num_threads Number of threads, at least one
+     * @param name Name given to the threads, for debuggers and profilers
+     */
+    ThreadWorker(size_t num_threads, const std::string& name);
+
+    /// Runs the tasks that are still queued, then stops the threads.
+    ~ThreadWorker();
+
+    ThreadWorker(const ThreadWorker&) = delete;
+    ThreadWorker& operator=(const ThreadWorker&) = delete;
+
+    /**
+     * Queues a task to run on one of the worker threads.
+     * @returns A future that becomes ready with the task's return value once it has run
+     */
+    template <typename F>
+    std::future<std::result_of_t<F()>> Submit(F&& task) {
+        using Result = std::result_of_t<F()>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        Enqueue([packaged] { (*packaged)(); });
+        return future;
+    }
+
+    /// Returns the number of tasks that have been submitted but have not started yet.
+    size_t GetPendingTaskCount() const;
+
+private:
+    void Enqueue(std::function<void()> task);
+    void ThreadLoop();
+
+    std::string name;
+    std::vector<std::thread> threads;
+
+    mutable std::mutex mutex;
+    std::condition_variable task_available;
+    std::deque<std::function<void()>> tasks;
+    bool stop_requested = false;
+};
+
+} // namespace Common
@@ -0,0 +1,119 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/boot_profiler.h"
+
+namespace Core {
+namespace BootProfiler {
+
+namespace {
+
+std::mutex profiler_mutex;
+Clock::time_point boot_start = Clock::now();
+Clock::time_point load_end;
+/// Checked on every frame, so that only the first one takes the lock
+std::atomic<bool> waiting_for_first_frame{false};
+std::vector<Phase> phases;
+std::unordered_map<std::thread::id, u32> thread_numbers;
+
+u64 ToMicroseconds(Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+/// Adds a step, profiler_mutex must be held.
+void AddPhase(const char* name, Clock::time_point start, Clock::time_point end) {
+    const auto thread =
+        thread_numbers.emplace(std::this_thread::get_id(), static_cast<u32>(thread_numbers.size()))
+            .first->second;
+    const u64 start_us = start > boot_start ? ToMicroseconds(start - boot_start) : 0;
+    phases.push_back({name, thread, start_us, ToMicroseconds(end - start)});
+}
+
+} // Anonymous namespace
+
+void BeginBoot() {
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    boot_start = Clock::now();
+    waiting_for_first_frame = false;
+    phases.clear();
+    thread_numbers.clear();
+    // The thread that boots is thread 0
+    thread_numbers.emplace(std::this_thread::get_id(), 0);
+}
+
+void EndLoad() {
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    load_end = Clock::now();
+    waiting_for_first_frame = true;
+    AddPhase("System::Load", boot_start, load_end);
+
+    for (const Phase& phase : phases) {
+        NGLOG_DEBUG(Core, "Boot step {} took {:.1f} ms on thread {}", phase.name,
+                    phase.duration_us / 1000.0, phase.thread);
+    }
+    NGLOG_INFO(Core, "Loaded the title in {:.1f} ms",
+               ToMicroseconds(load_end - boot_start) / 1000.0);
+}
+
+void MarkFirstFrame() {
+    if (!waiting_for_first_frame.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    if (!waiting_for_first_frame.exchange(false))
+        return;
+
+    const auto now = Clock::now();
+    AddPhase("Run until the first frame", load_end, now);
+    NGLOG_INFO(Core, "The first frame was presented {:.1f} ms after starting to load the title",
+               ToMicroseconds(now - boot_start) / 1000.0);
+}
+
+void RecordPhase(const char* name, Clock::time_point start, Clock::time_point end) {
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    AddPhase(name, start, end);
+}
+
+std::vector<Phase> GetPhases() {
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    return phases;
+}
+
+std::string FormatChromeTrace(const std::vector<Phase>& phases) {
+    fmt::memory_buffer buf;
+    fmt::format_to(buf, "{{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    for (size_t i = 0; i < phases.size(); ++i) {
+        const Phase& phase = phases[i];
+        // Complete events ("X") carry their own duration, so they do not need to be nested
+        fmt::format_to(buf,
+                       "{}\n  {{\"name\": \"{}\", \"cat\": \"boot\", \"ph\": \"X\", \"pid\": 0, "
+                       "\"tid\": {}, \"ts\": {}, \"dur\": {}}}",
+                       i == 0 ? "" : ",", phase.name, phase.thread, phase.start_us,
+                       phase.duration_us);
+    }
+    fmt::format_to(buf, "\n]}}\n");
+    return fmt::to_string(buf);
+}
+
+bool DumpToFile(const std::string& path) {
+    const std::vector<Phase> phases = GetPhases();
+    const std::string contents = FormatChromeTrace(phases);
+
+    if (FileUtil::WriteStringToFile(true, contents, path.c_str()) != contents.size()) {
+        NGLOG_ERROR(Core, "Could not write the boot trace to {}", path);
+        return false;
+    }
+    NGLOG_INFO(Core, "Wrote the {} steps of the boot to {}", phases.size(), path);
+    return true;
+}
+
+} // namespace BootProfiler
+} // namespace Core
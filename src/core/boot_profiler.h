@@ -0,0 +1,83 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Times the steps of booting a title, from the start of System::Load until the title presents its
+ * first frame. Steps that run at the same time on different host threads are kept apart, so the
+ * result can be viewed as a timeline in chrome://tracing.
+ *
+ * All functions are thread-safe.
+ */
+namespace BootProfiler {
+
+using Clock = std::chrono::steady_clock;
+
+struct Phase {
+    /// Name of the step
+    const char* name;
+    /// Host thread the step ran on, numbered in the order the threads first recorded a step
+    u32 thread;
+    /// Time the step started, relative to the start of the boot
+    u64 start_us;
+    u64 duration_us;
+};
+
+/// Discards the steps of the previous boot and starts timing a new one.
+void BeginBoot();
+
+/**
+ * Records that System::Load has finished, and logs how long it took. The time from here to the
+ * first frame is recorded as a step of its own.
+ */
+void EndLoad();
+
+/// Records the first frame of the title. Calls after the first one of each boot are ignored.
+void MarkFirstFrame();
+
+/**
+ * Adds a step to the current boot.
+ * @param name Name of the step. Must stay valid until the next boot, so usually a string literal.
+ */
+void RecordPhase(const char* name, Clock::time_point start, Clock::time_point end);
+
+/// Returns the steps of the current boot, in the order they finished.
+std::vector<Phase> GetPhases();
+
+/// Formats the steps in the JSON trace event format read by chrome://tracing.
+std::string FormatChromeTrace(const std::vector<Phase>& phases);
+
+/**
+ * Writes the steps of the current boot to a file, in the format of FormatChromeTrace.
+ * @returns true on success
+ */
+bool DumpToFile(const std::string& path);
+
+/// Times a step of the boot for the duration of the object.
+class ScopedPhase {
+public:
+    explicit ScopedPhase(const char* name) : name(name), start(Clock::now()) {}
+
+    ~ScopedPhase() {
+        RecordPhase(name, start, Clock::now());
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    const char* name;
+    Clock::time_point start;
+};
+
+} // namespace BootProfiler
+} // namespace Core
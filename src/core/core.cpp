@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <future>
 #include <memory>
 #include <utility>
 #include "audio_core/dsp_interface.h"
@@ -12,6 +13,7 @@
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #endif
 #include "core/arm/dyncom/arm_dyncom.h"
+#include "core/boot_profiler.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/gdbstub/gdbstub.h"
@@ -81,14 +83,22 @@ System::ResultStatus System::SingleStep() {
 }
 
 System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& filepath) {
-    app_loader = Loader::GetLoader(filepath);
+    BootProfiler::BeginBoot();
+
+    {
+        BootProfiler::ScopedPhase phase("Loader::GetLoader");
+        app_loader = Loader::GetLoader(filepath);
+    }
 
     if (!app_loader) {
         LOG_CRITICAL(Core, "Failed to obtain loader for %s!", filepath.c_str());
         return ResultStatus::ErrorGetLoader;
     }
-    std::pair<boost::optional<u32>, Loader::ResultStatus> system_mode =
-        app_loader->LoadKernelSystemMode();
+    std::pair<boost::optional<u32>, Loader::ResultStatus> system_mode;
+    {
+        BootProfiler::ScopedPhase phase("AppLoader::LoadKernelSystemMode");
+        system_mode = app_loader->LoadKernelSystemMode();
+    }
 
     if (system_mode.second != Loader::ResultStatus::Success) {
         LOG_CRITICAL(Core, "Failed to determine system mode (Error %i)!",
@@ -104,7 +114,15 @@ System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& file
         }
     }
 
-    ResultStatus init_result{Init(emu_window, system_mode.first.get())};
+    // Reading the application does not depend on the emulated system, so the loader starts on it
+    // while the system is initialized
+    app_loader->Preload();
+
+    ResultStatus init_result;
+    {
+        BootProfiler::ScopedPhase phase("System::Init");
+        init_result = Init(emu_window, system_mode.first.get());
+    }
     if (init_result != ResultStatus::Success) {
         LOG_CRITICAL(Core, "Failed to initialize system (Error %u)!",
                      static_cast<u32>(init_result));
@@ -112,7 +130,11 @@ System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& file
         return init_result;
     }
 
-    const Loader::ResultStatus load_result{app_loader->Load(Kernel::g_current_process)};
+    Loader::ResultStatus load_result;
+    {
+        BootProfiler::ScopedPhase phase("AppLoader::Load");
+        load_result = app_loader->Load(Kernel::g_current_process);
+    }
     if (Loader::ResultStatus::Success != load_result) {
         LOG_CRITICAL(Core, "Failed to load ROM (Error %u)!", static_cast<u32>(load_result));
         System::Shutdown();
@@ -128,6 +150,7 @@ System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& file
     }
     Memory::SetCurrentPageTable(&Kernel::g_current_process->vm_manager.page_table);
     status = ResultStatus::Success;
+    BootProfiler::EndLoad();
     return status;
 }
 
@@ -154,31 +177,61 @@ System::ResultStatus System::Init(EmuWindow* emu_window, u32 system_mode) {
 
     CoreTiming::Init();
 
-    if (Settings::values.use_cpu_jit) {
+    {
+        BootProfiler::ScopedPhase phase("Create CPU core");
+        if (Settings::values.use_cpu_jit) {
 #ifdef ARCHITECTURE_x86_64
-        cpu_core = std::make_unique<ARM_Dynarmic>(USER32MODE);
+            cpu_core = std::make_unique<ARM_Dynarmic>(USER32MODE);
 #else
-        cpu_core = std::make_unique<ARM_DynCom>(USER32MODE);
-        LOG_WARNING(Core, "CPU JIT requested, but Dynarmic not available");
+            cpu_core = std::make_unique<ARM_DynCom>(USER32MODE);
+            LOG_WARNING(Core, "CPU JIT requested, but Dynarmic not available");
 #endif
-    } else {
-        cpu_core = std::make_unique<ARM_DynCom>(USER32MODE);
+        } else {
+            cpu_core = std::make_unique<ARM_DynCom>(USER32MODE);
+        }
     }
 
-    dsp_core = std::make_unique<AudioCore::DspHle>();
-    dsp_core->SetSink(Settings::values.sink_id);
-    dsp_core->EnableStretching(Settings::values.enable_audio_stretching);
+    {
+        BootProfiler::ScopedPhase phase("Create DSP core");
+        dsp_core = std::make_unique<AudioCore::DspHle>();
+        dsp_core->SetSink(Settings::values.sink_id);
+        dsp_core->EnableStretching(Settings::values.enable_audio_stretching &&
+                                   !Settings::values.enable_audio_pacing);
+    }
 
     telemetry_session = std::make_unique<Core::TelemetrySession>();
     service_manager = std::make_shared<Service::SM::ServiceManager>();
 
-    HW::Init();
-    Kernel::Init(system_mode);
-    Service::Init(service_manager);
+    {
+        BootProfiler::ScopedPhase phase("HW::Init");
+        HW::Init();
+    }
+    {
+        BootProfiler::ScopedPhase phase("Kernel::Init");
+        Kernel::Init(system_mode);
+    }
+
+    // The services only need the kernel, and the renderer does not use either of them, so they
+    // are set up on another thread while the renderer is set up on this one, which owns the
+    // graphics context.
+    auto services_initialized = std::async(std::launch::async, [this] {
+        BootProfiler::ScopedPhase phase("Service::Init");
+        Service::Init(service_manager);
+    });
+    bool video_initialized;
+    {
+        BootProfiler::ScopedPhase phase("VideoCore::Init");
+        video_initialized = VideoCore::Init(emu_window);
+    }
+    services_initialized.get();
+
     GDBStub::Init();
-    Movie::GetInstance().Init();
+    {
+        BootProfiler::ScopedPhase phase("Movie::Init");
+        Movie::GetInstance().Init();
+    }
 
-    if (!VideoCore::Init(emu_window)) {
+    if (!video_initialized) {
         return ResultStatus::ErrorVideoCore;
     }
 
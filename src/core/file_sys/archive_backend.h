@@ -153,6 +153,15 @@ public:
      * @return The number of free bytes in the archive
      */
     virtual u64 GetFreeBytes() const = 0;
+
+    /**
+     * Writes the changes made to the archive to the host, like CommitSaveData does on the 3DS.
+     * Archives that are not cached have nothing to commit.
+     * @return Result of the operation
+     */
+    virtual ResultCode Commit() const {
+        return RESULT_SUCCESS;
+    }
 };
 
 class ArchiveFactory : NonCopyable {
@@ -12,8 +12,10 @@
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/path_parser.h"
 #include "core/file_sys/savedata_archive.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/service/fs/archive.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -27,7 +29,7 @@ namespace FileSys {
  */
 class FixSizeDiskFile : public DiskFile {
 public:
-    FixSizeDiskFile(FileUtil::IOFile&& file, const Mode& mode,
+    FixSizeDiskFile(std::shared_ptr<WriteBackFile> file, const Mode& mode,
                     std::unique_ptr<DelayGenerator> delay_generator_)
         : DiskFile(std::move(file), mode, std::move(delay_generator_)) {
         size = GetSize();
@@ -137,8 +139,8 @@ public:
         rwmode.read_flag.Assign(1);
         std::unique_ptr<DelayGenerator> delay_generator =
             std::make_unique<ExtSaveDataDelayGenerator>();
-        auto disk_file =
-            std::make_unique<FixSizeDiskFile>(std::move(file), rwmode, std::move(delay_generator));
+        auto disk_file = std::make_unique<FixSizeDiskFile>(
+            WriteBackCache::Open(full_path, std::move(file)), rwmode, std::move(delay_generator));
         return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
     }
 
@@ -258,6 +260,8 @@ ResultCode ArchiveFactory_ExtSaveData::Format(const Path& path,
     }
 
     file.WriteBytes(&format_info, sizeof(format_info));
+    file.Close();
+    HostMetadataCache::Invalidate(GetExtSaveDataPath(mount_point, corrected_path));
     return RESULT_SUCCESS;
 }
 
@@ -281,6 +285,8 @@ void ArchiveFactory_ExtSaveData::WriteIcon(const Path& path, const u8* icon_data
     std::string game_path = FileSys::GetExtSaveDataPath(GetMountPoint(), path);
     FileUtil::IOFile icon_file(game_path + "icon", "wb");
     icon_file.WriteBytes(icon_data, icon_size);
+    icon_file.Close();
+    HostMetadataCache::Invalidate(game_path + "icon");
 }
 
 } // namespace FileSys
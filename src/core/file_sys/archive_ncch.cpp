@@ -16,6 +16,7 @@
 #include "core/file_sys/errors.h"
 #include "core/file_sys/ivfc_archive.h"
 #include "core/file_sys/ncch_container.h"
+#include "core/file_sys/system_archive_cache.h"
 #include "core/hle/service/am/am.h"
 #include "core/hle/service/fs/archive.h"
 #include "core/loader/loader.h"
@@ -38,6 +39,13 @@ struct NCCHArchivePath {
 };
 static_assert(sizeof(NCCHArchivePath) == 0x10, "NCCHArchivePath has wrong size!");
 
+/// Whether a title is one of the system data archives, which hold data rather than a program.
+static bool IsSystemDataArchive(u64 title_id) {
+    // High Title ID of the archive: The category (https://3dbrew.org/wiki/Title_list).
+    const u32 high = static_cast<u32>(title_id >> 32);
+    return high == 0x0004001B || high == 0x0004009B || high == 0x000400DB;
+}
+
 struct NCCHFilePath {
     u32_le open_type;
     u32_le content_index;
@@ -71,15 +79,31 @@ ResultVal<std::unique_ptr<FileBackend>> NCCHArchive::OpenFile(const Path& path,
 
     // NCCH RomFS
     NCCHFilePathType filepath_type = static_cast<NCCHFilePathType>(openfile_path.filepath_type);
-    if (filepath_type == NCCHFilePathType::RomFS) {
-        std::shared_ptr<FileUtil::IOFile> romfs_file;
-        u64 romfs_offset = 0;
-        u64 romfs_size = 0;
+    if (filepath_type == NCCHFilePathType::RomFS && IsSystemDataArchive(title_id)) {
+        // System data such as the shared fonts and the Mii data is read on every boot, so it is
+        // kept decrypted in memory and shared by every file opened on it
+        result = Loader::ResultStatus::Error;
+        auto romfs_data = SystemArchiveCache::Get(
+            file_path + ":romfs", file_path, [&](std::vector<u8>& buffer) {
+                std::shared_ptr<RomFSReader> romfs_file;
+                result = ncch_container.ReadRomFS(romfs_file);
+                if (result != Loader::ResultStatus::Success)
+                    return false;
+                buffer.resize(static_cast<size_t>(romfs_file->GetSize()));
+                return romfs_file->Read(0, buffer.size(), buffer.data()) == buffer.size();
+            });
+        if (romfs_data != nullptr) {
+            result = Loader::ResultStatus::Success;
+            std::unique_ptr<DelayGenerator> delay_generator =
+                std::make_unique<RomFSDelayGenerator>();
+            file = std::make_unique<NCCHFile>(std::move(romfs_data), std::move(delay_generator));
+        }
+    } else if (filepath_type == NCCHFilePathType::RomFS) {
+        std::shared_ptr<RomFSReader> romfs_file;
 
-        result = ncch_container.ReadRomFS(romfs_file, romfs_offset, romfs_size);
+        result = ncch_container.ReadRomFS(romfs_file);
         std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<RomFSDelayGenerator>();
-        file = std::make_unique<IVFCFile>(std::move(romfs_file), romfs_offset, romfs_size,
-                                          std::move(delay_generator));
+        file = std::make_unique<IVFCFile>(std::move(romfs_file), std::move(delay_generator));
     } else if (filepath_type == NCCHFilePathType::Code ||
                filepath_type == NCCHFilePathType::ExeFS) {
         std::vector<u8> buffer;
@@ -198,18 +222,23 @@ u64 NCCHArchive::GetFreeBytes() const {
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 NCCHFile::NCCHFile(std::vector<u8> buffer, std::unique_ptr<DelayGenerator> delay_generator_)
+    : NCCHFile(std::make_shared<const std::vector<u8>>(std::move(buffer)),
+               std::move(delay_generator_)) {}
+
+NCCHFile::NCCHFile(std::shared_ptr<const std::vector<u8>> buffer,
+                   std::unique_ptr<DelayGenerator> delay_generator_)
     : file_buffer(std::move(buffer)) {
     delay_generator = std::move(delay_generator_);
 }
 
 ResultVal<size_t> NCCHFile::Read(const u64 offset, const size_t length, u8* buffer) const {
     LOG_TRACE(Service_FS, "called offset=%" PRIu64 ", length=%zu", offset, length);
-    size_t length_left = static_cast<size_t>(data_size - offset);
-    size_t read_length = static_cast<size_t>(std::min(length, length_left));
+    if (offset >= file_buffer->size())
+        return MakeResult<size_t>(0);
 
-    size_t available_size = static_cast<size_t>(file_buffer.size() - offset);
+    size_t available_size = static_cast<size_t>(file_buffer->size() - offset);
     size_t copy_size = std::min(length, available_size);
-    memcpy(buffer, file_buffer.data() + offset, copy_size);
+    memcpy(buffer, file_buffer->data() + offset, copy_size);
 
     return MakeResult<size_t>(copy_size);
 }
@@ -222,7 +251,7 @@ ResultVal<size_t> NCCHFile::Write(const u64 offset, const size_t length, const b
 }
 
 u64 NCCHFile::GetSize() const {
-    return file_buffer.size();
+    return file_buffer->size();
 }
 
 bool NCCHFile::SetSize(const u64 size) const {
@@ -52,6 +52,9 @@ protected:
 class NCCHFile : public FileBackend {
 public:
     explicit NCCHFile(std::vector<u8> buffer, std::unique_ptr<DelayGenerator> delay_generator_);
+    /// Creates a file over contents that are shared with other users, and are not changed
+    NCCHFile(std::shared_ptr<const std::vector<u8>> buffer,
+             std::unique_ptr<DelayGenerator> delay_generator_);
 
     ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
     ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) override;
@@ -63,9 +66,7 @@ public:
     void Flush() const override {}
 
 private:
-    std::vector<u8> file_buffer;
-    u64 data_offset;
-    u64 data_size;
+    std::shared_ptr<const std::vector<u8>> file_buffer;
 };
 
 /// File system interface to the NCCH archive
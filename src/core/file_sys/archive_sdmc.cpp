@@ -9,7 +9,9 @@
 #include "core/file_sys/archive_sdmc.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/path_parser.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/settings.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -84,6 +86,7 @@ ResultVal<std::unique_ptr<FileBackend>> SDMCArchive::OpenFileBase(const Path& pa
         } else {
             // Create the file
             FileUtil::CreateEmptyFile(full_path);
+            HostMetadataCache::Invalidate(full_path);
         }
         break;
     case PathParser::FileFound:
@@ -97,7 +100,8 @@ ResultVal<std::unique_ptr<FileBackend>> SDMCArchive::OpenFileBase(const Path& pa
     }
 
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<SDMCDelayGenerator>();
-    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator));
+    auto disk_file = std::make_unique<DiskFile>(WriteBackCache::Open(full_path, std::move(file)),
+                                                mode, std::move(delay_generator));
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
@@ -128,6 +132,8 @@ ResultCode SDMCArchive::DeleteFile(const Path& path) const {
     }
 
     if (FileUtil::Delete(full_path)) {
+        WriteBackCache::Discard(full_path);
+        HostMetadataCache::Invalidate(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -155,6 +161,9 @@ ResultCode SDMCArchive::RenameFile(const Path& src_path, const Path& dest_path)
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        WriteBackCache::Rename(src_path_full, dest_path_full);
+        HostMetadataCache::Invalidate(src_path_full);
+        HostMetadataCache::Invalidate(dest_path_full);
         return RESULT_SUCCESS;
     }
 
@@ -195,7 +204,11 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
         break; // Expected 'success' case
     }
 
-    if (deleter(full_path)) {
+    const bool deleted = deleter(full_path);
+    // A recursive delete that failed may still have removed some of the contents
+    HostMetadataCache::Invalidate(full_path);
+    if (deleted) {
+        WriteBackCache::Discard(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -242,13 +255,17 @@ ResultCode SDMCArchive::CreateFile(const FileSys::Path& path, u64 size) const {
 
     if (size == 0) {
         FileUtil::CreateEmptyFile(full_path);
+        HostMetadataCache::Invalidate(full_path);
         return RESULT_SUCCESS;
     }
 
     FileUtil::IOFile file(full_path, "wb");
     // Creates a sparse file (or a normal file on filesystems without the concept of sparse files)
     // We do this by seeking to the right size, then writing a single null byte.
-    if (file.Seek(size - 1, SEEK_SET) && file.WriteBytes("", 1) == 1) {
+    const bool created = file.Seek(size - 1, SEEK_SET) && file.WriteBytes("", 1) == 1;
+    file.Close();
+    HostMetadataCache::Invalidate(full_path);
+    if (created) {
         return RESULT_SUCCESS;
     }
 
@@ -284,6 +301,7 @@ ResultCode SDMCArchive::CreateDirectory(const Path& path) const {
     }
 
     if (FileUtil::CreateDir(mount_point + path.AsString())) {
+        HostMetadataCache::Invalidate(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -312,6 +330,9 @@ ResultCode SDMCArchive::RenameDirectory(const Path& src_path, const Path& dest_p
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        WriteBackCache::Rename(src_path_full, dest_path_full);
+        HostMetadataCache::Invalidate(src_path_full);
+        HostMetadataCache::Invalidate(dest_path_full);
         return RESULT_SUCCESS;
     }
 
@@ -347,10 +368,23 @@ ResultVal<std::unique_ptr<DirectoryBackend>> SDMCArchive::OpenDirectory(const Pa
         break; // Expected 'success' case
     }
 
+    // The listing has the sizes of the files on the host
+    WriteBackCache::Commit(full_path);
     auto directory = std::make_unique<DiskDirectory>(full_path);
     return MakeResult<std::unique_ptr<DirectoryBackend>>(std::move(directory));
 }
 
+SDMCArchive::~SDMCArchive() {
+    WriteBackCache::Commit(mount_point);
+}
+
+ResultCode SDMCArchive::Commit() const {
+    if (WriteBackCache::Commit(mount_point))
+        return RESULT_SUCCESS;
+    // Running out of space is the likely reason for the host write to fail
+    return ERROR_INSUFFICIENT_SPACE;
+}
+
 u64 SDMCArchive::GetFreeBytes() const {
     // TODO: Stubbed to return 1GiB
     return 1024 * 1024 * 1024;
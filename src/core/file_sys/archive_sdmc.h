@@ -19,6 +19,9 @@ class SDMCArchive : public ArchiveBackend {
 public:
     explicit SDMCArchive(const std::string& mount_point_) : mount_point(mount_point_) {}
 
+    /// Commits the files of the archive that are still open.
+    ~SDMCArchive() override;
+
     std::string GetName() const override {
         return "SDMCArchive: " + mount_point;
     }
@@ -34,6 +37,7 @@ public:
     ResultCode RenameDirectory(const Path& src_path, const Path& dest_path) const override;
     ResultVal<std::unique_ptr<DirectoryBackend>> OpenDirectory(const Path& path) const override;
     u64 GetFreeBytes() const override;
+    ResultCode Commit() const override;
 
 protected:
     ResultVal<std::unique_ptr<FileBackend>> OpenFileBase(const Path& path, const Mode& mode) const;
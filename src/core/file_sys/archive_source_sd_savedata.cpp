@@ -7,7 +7,9 @@
 #include "common/string_util.h"
 #include "core/file_sys/archive_source_sd_savedata.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/savedata_archive.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/service/fs/archive.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -62,6 +64,8 @@ ResultCode ArchiveSource_SDSaveData::Format(u64 program_id,
     std::string concrete_mount_point = GetSaveDataPath(mount_point, program_id);
     FileUtil::DeleteDirRecursively(concrete_mount_point);
     FileUtil::CreateFullPath(concrete_mount_point);
+    WriteBackCache::Discard(concrete_mount_point);
+    HostMetadataCache::Invalidate(concrete_mount_point);
 
     // Write the format metadata
     std::string metadata_path = GetSaveDataMetadataPath(mount_point, program_id);
@@ -69,6 +73,8 @@ ResultCode ArchiveSource_SDSaveData::Format(u64 program_id,
 
     if (file.IsOpen()) {
         file.WriteBytes(&format_info, sizeof(format_info));
+        file.Close();
+        HostMetadataCache::Invalidate(metadata_path);
         return RESULT_SUCCESS;
     }
     return RESULT_SUCCESS;
@@ -11,7 +11,10 @@
 #include "common/string_util.h"
 #include "core/file_sys/archive_systemsavedata.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/savedata_archive.h"
+#include "core/file_sys/system_archive_cache.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/service/fs/archive.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -67,6 +70,9 @@ ResultCode ArchiveFactory_SystemSaveData::Format(const Path& path,
     std::string fullpath = GetSystemSaveDataPath(base_path, path);
     FileUtil::DeleteDirRecursively(fullpath);
     FileUtil::CreateFullPath(fullpath);
+    WriteBackCache::Discard(fullpath);
+    HostMetadataCache::Invalidate(fullpath);
+    SystemArchiveCache::Invalidate(fullpath);
     return RESULT_SUCCESS;
 }
 
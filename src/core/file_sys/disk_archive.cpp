@@ -10,6 +10,7 @@
 #include "common/logging/log.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
@@ -20,8 +21,7 @@ ResultVal<size_t> DiskFile::Read(const u64 offset, const size_t length, u8* buff
     if (!mode.read_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    return MakeResult<size_t>(file->ReadBytes(buffer, length));
+    return MakeResult<size_t>(file->Read(offset, length, buffer));
 }
 
 ResultVal<size_t> DiskFile::Write(const u64 offset, const size_t length, const bool flush,
@@ -29,11 +29,8 @@ ResultVal<size_t> DiskFile::Write(const u64 offset, const size_t length, const b
     if (!mode.write_flag)
         return ERROR_INVALID_OPEN_FLAGS;
 
-    file->Seek(offset, SEEK_SET);
-    size_t written = file->WriteBytes(buffer, length);
-    if (flush)
-        file->Flush();
-    return MakeResult<size_t>(written);
+    // The flush flag is not needed, as writes become durable when the archive is committed
+    return MakeResult<size_t>(file->Write(offset, length, buffer));
 }
 
 u64 DiskFile::GetSize() const {
@@ -41,28 +38,26 @@ u64 DiskFile::GetSize() const {
 }
 
 bool DiskFile::SetSize(const u64 size) const {
-    file->Resize(size);
-    file->Flush();
+    file->SetSize(size);
     return true;
 }
 
 bool DiskFile::Close() const {
-    return file->Close();
+    // The file is committed once all its handles are gone
+    return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-DiskDirectory::DiskDirectory(const std::string& path) {
-    unsigned size = FileUtil::ScanDirectoryTree(path, directory);
-    directory.size = size;
-    directory.isDirectory = true;
-    children_iterator = directory.children.begin();
+DiskDirectory::DiskDirectory(const std::string& path)
+    : directory(HostMetadataCache::ListDirectory(path)) {
+    children_iterator = directory->children.begin();
 }
 
 u32 DiskDirectory::Read(const u32 count, Entry* entries) {
     u32 entries_read = 0;
 
-    while (entries_read < count && children_iterator != directory.children.cend()) {
+    while (entries_read < count && children_iterator != directory->children.cend()) {
         const FileUtil::FSTEntry& file = *children_iterator;
         const std::string& filename = file.virtualName;
         Entry& entry = entries[entries_read];
@@ -13,6 +13,7 @@
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/result.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -20,11 +21,16 @@
 
 namespace FileSys {
 
+/**
+ * A file on the host. Writes go through the WriteBackCache, and reach the host file when it is
+ * committed: when the last handle to it is closed, when its archive is closed, or when the guest
+ * commits the archive with ControlArchive.
+ */
 class DiskFile : public FileBackend {
 public:
-    DiskFile(FileUtil::IOFile&& file_, const Mode& mode_,
+    DiskFile(std::shared_ptr<WriteBackFile> file_, const Mode& mode_,
              std::unique_ptr<DelayGenerator> delay_generator_)
-        : file(new FileUtil::IOFile(std::move(file_))) {
+        : file(std::move(file_)) {
         delay_generator = std::move(delay_generator_);
         mode.hex = mode_.hex;
     }
@@ -36,12 +42,12 @@ public:
     bool Close() const override;
 
     void Flush() const override {
-        file->Flush();
+        // Nothing to do, the data is safe once the archive is committed
     }
 
 protected:
     Mode mode;
-    std::unique_ptr<FileUtil::IOFile> file;
+    std::shared_ptr<WriteBackFile> file;
 };
 
 class DiskDirectory : public DirectoryBackend {
@@ -59,11 +65,12 @@ public:
     }
 
 protected:
-    FileUtil::FSTEntry directory{};
+    /// Listing of the directory, shared with the HostMetadataCache
+    std::shared_ptr<const FileUtil::FSTEntry> directory;
 
     // We need to remember the last entry we returned, so a subsequent call to Read will continue
     // from the next one.  This iterator will always point to the next unread entry.
-    std::vector<FileUtil::FSTEntry>::iterator children_iterator;
+    std::vector<FileUtil::FSTEntry>::const_iterator children_iterator;
 };
 
 } // namespace FileSys
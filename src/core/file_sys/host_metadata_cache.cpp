@@ -0,0 +1,390 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "core/file_sys/host_metadata_cache.h"
+#include "core/file_sys/write_back_cache.h"
+
+#ifdef __linux__
+#include <array>
+#include <thread>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+namespace HostMetadataCache {
+
+namespace {
+
+/// Past this many remembered paths, the cache starts over
+constexpr size_t max_entries = 0x10000;
+
+struct Listing {
+    std::shared_ptr<const FileUtil::FSTEntry> entry;
+    /// Whether each child is a directory, by name
+    std::unordered_map<std::string, bool> children;
+};
+
+std::mutex cache_mutex;
+std::map<std::string, Kind> kinds;
+std::map<std::string, Listing> listings;
+/// Changes on every invalidation, so that results of host queries that raced with one are dropped
+u64 generation = 0;
+Stats stats{};
+
+/// Hosts whose file systems usually ignore case
+#if defined(_WIN32) || defined(__APPLE__)
+constexpr bool ignores_case = true;
+#else
+constexpr bool ignores_case = false;
+#endif
+
+/// Returns the form of a file name that is used in the cache.
+std::string NameKey(std::string name) {
+    if (ignores_case)
+        name = Common::ToLower(std::move(name));
+    return name;
+}
+
+/**
+ * Puts a path in a single form, so that the different ways the archives spell a path find the same
+ * entry: no repeated or trailing separators, and no "." or ".." components.
+ */
+std::string Normalize(const std::string& path) {
+    std::vector<std::string> components;
+#ifdef _WIN32
+    std::string copy = path;
+    std::replace(copy.begin(), copy.end(), '\\', '/');
+    Common::SplitString(NameKey(std::move(copy)), '/', components);
+#else
+    Common::SplitString(NameKey(path), '/', components);
+#endif
+
+    std::vector<std::string> normalized;
+    for (const std::string& component : components) {
+        if (component.empty() || component == ".")
+            continue;
+        if (component == ".." && !normalized.empty() && normalized.back() != "..") {
+            normalized.pop_back();
+            continue;
+        }
+        normalized.push_back(component);
+    }
+
+    const bool absolute = !path.empty() && path[0] == '/';
+    std::string result = absolute ? "/" : "";
+    for (size_t i = 0; i < normalized.size(); ++i) {
+        if (i != 0)
+            result += '/';
+        result += normalized[i];
+    }
+    return result.empty() ? "." : result;
+}
+
+/// Splits a normalized path into its directory and its name.
+std::pair<std::string, std::string> SplitParent(const std::string& path) {
+    const size_t separator = path.rfind('/');
+    if (separator == std::string::npos)
+        return {".", path};
+    if (separator == 0)
+        return {"/", path.substr(1)};
+    return {path.substr(0, separator), path.substr(separator + 1)};
+}
+
+/// Whether path is the normalized path prefix, or is under it.
+bool IsAtOrUnder(const std::string& path, const std::string& prefix) {
+    if (path.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    return path.size() == prefix.size() || prefix.back() == '/' || path[prefix.size()] == '/';
+}
+
+template <typename Map>
+void EraseAtOrUnder(Map& map, const std::string& prefix) {
+    auto it = map.lower_bound(prefix);
+    while (it != map.end() && it->first.compare(0, prefix.size(), prefix) == 0) {
+        if (IsAtOrUnder(it->first, prefix))
+            it = map.erase(it);
+        else
+            ++it;
+    }
+}
+
+/// Forgets a normalized path, cache_mutex must be held.
+void InvalidateLocked(const std::string& path) {
+    ++generation;
+    EraseAtOrUnder(kinds, path);
+    EraseAtOrUnder(listings, path);
+    listings.erase(SplitParent(path).first);
+}
+
+/// Forgets everything, cache_mutex must be held.
+void ClearLocked() {
+    ++generation;
+    kinds.clear();
+    listings.clear();
+}
+
+#ifdef __linux__
+
+/**
+ * Watches the directories the cache has entries in with inotify, and invalidates what changes in
+ * them. Functions other than the constructor and destructor are called with cache_mutex held.
+ */
+class HostWatcher {
+public:
+    HostWatcher() {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (inotify_fd < 0 || wake_fd < 0) {
+            LOG_WARNING(Service_FS, "Could not watch the host file system for changes");
+            return;
+        }
+        thread = std::thread([this] { Run(); });
+    }
+
+    ~HostWatcher() {
+        if (thread.joinable()) {
+            const u64 one = 1;
+            if (write(wake_fd, &one, sizeof(one)) == sizeof(one))
+                thread.join();
+            else
+                thread.detach();
+        }
+        if (inotify_fd >= 0)
+            close(inotify_fd);
+        if (wake_fd >= 0)
+            close(wake_fd);
+    }
+
+    bool IsWorking() const {
+        return thread.joinable();
+    }
+
+    /// Makes sure changes in a directory are seen. Returns false if they can not be.
+    bool Watch(const std::string& directory) {
+        if (watched.count(directory))
+            return true;
+
+        constexpr u32 mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY |
+                             IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF;
+        const int wd = inotify_add_watch(inotify_fd, directory.c_str(), mask);
+        if (wd < 0) {
+            // Usually the limit on watches, fs.inotify.max_user_watches, has been reached
+            LOG_DEBUG(Service_FS, "Could not watch %s", directory.c_str());
+            return false;
+        }
+        watched[directory] = wd;
+        directories[wd] = directory;
+        return true;
+    }
+
+private:
+    void Run() {
+        std::array<pollfd, 2> fds{{{inotify_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}}};
+        alignas(inotify_event) std::array<char, 0x4000> buffer;
+
+        while (true) {
+            if (poll(fds.data(), fds.size(), -1) < 0)
+                continue;
+            if (fds[1].revents != 0)
+                return;
+
+            const ssize_t length = read(inotify_fd, buffer.data(), buffer.size());
+            if (length <= 0)
+                continue;
+
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(&buffer[offset]);
+                offset += sizeof(inotify_event) + event->len;
+                HandleEvent(*event);
+            }
+        }
+    }
+
+    void HandleEvent(const inotify_event& event) {
+        if (event.mask & IN_Q_OVERFLOW) {
+            // Events were lost, so anything may have changed
+            ClearLocked();
+            return;
+        }
+
+        const auto it = directories.find(event.wd);
+        if (it == directories.end())
+            return;
+        const std::string directory = it->second;
+
+        if (event.mask & IN_IGNORED) {
+            watched.erase(directory);
+            directories.erase(it);
+        }
+        if (event.mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+            InvalidateLocked(directory);
+        } else if (event.len != 0) {
+            InvalidateLocked(directory == "/" ? "/" + std::string(event.name)
+                                              : directory + "/" + event.name);
+        }
+    }
+
+    int inotify_fd = -1;
+    int wake_fd = -1;
+    std::thread thread;
+    std::unordered_map<std::string, int> watched;
+    std::unordered_map<int, std::string> directories;
+};
+
+std::unique_ptr<HostWatcher> watcher;
+
+#endif
+
+/**
+ * Makes sure changes in a directory reach the cache, before asking the host about it or about
+ * something in it. cache_mutex must be held. Returns false if the answer must not be cached.
+ */
+bool WatchLocked(const std::string& directory) {
+#ifdef __linux__
+    if (watcher)
+        return watcher->Watch(directory);
+#endif
+    return true;
+}
+
+/// Stores the result of a host query, unless the cache changed since it was made.
+template <typename Map, typename Value>
+void StoreLocked(Map& map, const std::string& path, Value&& value, u64 query_generation) {
+    if (generation != query_generation)
+        return;
+    if (kinds.size() + listings.size() >= max_entries)
+        ClearLocked();
+    map[path] = std::forward<Value>(value);
+}
+
+} // Anonymous namespace
+
+Kind Lookup(const std::string& path) {
+    const std::string key = Normalize(path);
+    const auto parent = SplitParent(key);
+
+    std::unique_lock<std::mutex> lock(cache_mutex);
+    const auto kind = kinds.find(key);
+    if (kind != kinds.end()) {
+        ++stats.lookup_hits;
+        return kind->second;
+    }
+    // A listing of the directory knows about everything in it
+    const auto listing = listings.find(parent.first);
+    if (listing != listings.end()) {
+        ++stats.lookup_hits;
+        const auto child = listing->second.children.find(parent.second);
+        if (child == listing->second.children.end())
+            return Kind::Missing;
+        return child->second ? Kind::Directory : Kind::File;
+    }
+    ++stats.lookup_misses;
+    const bool cacheable = WatchLocked(parent.first);
+    const u64 query_generation = generation;
+    lock.unlock();
+
+    Kind result = Kind::Missing;
+    if (FileUtil::Exists(path))
+        result = FileUtil::IsDirectory(path) ? Kind::Directory : Kind::File;
+
+    if (cacheable) {
+        lock.lock();
+        StoreLocked(kinds, key, result, query_generation);
+    }
+    return result;
+}
+
+std::shared_ptr<const FileUtil::FSTEntry> ListDirectory(const std::string& path) {
+    const std::string key = Normalize(path);
+
+    std::unique_lock<std::mutex> lock(cache_mutex);
+    const auto it = listings.find(key);
+    if (it != listings.end()) {
+        ++stats.listing_hits;
+        return it->second.entry;
+    }
+    ++stats.listing_misses;
+    const bool cacheable = WatchLocked(key);
+    const u64 query_generation = generation;
+    lock.unlock();
+
+    auto entry = std::make_shared<FileUtil::FSTEntry>();
+    FileUtil::ScanDirectoryTree(path, *entry);
+    // Temporary files of commits are not the guest's, a crash may have left some behind
+    auto& children = entry->children;
+    children.erase(std::remove_if(children.begin(), children.end(),
+                                  [](const FileUtil::FSTEntry& child) {
+                                      return WriteBackCache::IsCommitTempName(child.virtualName);
+                                  }),
+                   children.end());
+    entry->size = children.size();
+    entry->isDirectory = true;
+
+    if (cacheable) {
+        Listing listing{entry, {}};
+        for (const FileUtil::FSTEntry& child : entry->children)
+            listing.children.emplace(NameKey(child.virtualName), child.isDirectory);
+
+        lock.lock();
+        StoreLocked(listings, key, std::move(listing), query_generation);
+    }
+    return entry;
+}
+
+void Invalidate(const std::string& path) {
+    const std::string key = Normalize(path);
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    InvalidateLocked(key);
+}
+
+void Clear() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    ClearLocked();
+    stats = {};
+}
+
+void SetWatchHost(bool watch) {
+#ifdef __linux__
+    std::unique_ptr<HostWatcher> old_watcher;
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (watch == (watcher != nullptr))
+            return;
+
+        // What was cached before the watch started, or after it stopped, may be out of date
+        ClearLocked();
+        if (watch) {
+            watcher = std::make_unique<HostWatcher>();
+            if (!watcher->IsWorking())
+                watcher.reset();
+        } else {
+            old_watcher = std::move(watcher);
+        }
+    }
+    // Stopped outside the lock, as the watcher thread takes it
+    old_watcher.reset();
+#endif
+}
+
+Stats GetStats() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return stats;
+}
+
+} // namespace HostMetadataCache
+} // namespace FileSys
@@ -0,0 +1,67 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+/**
+ * Remembers what the host-backed archives found on the host file system: whether a path is a file,
+ * a directory or missing, and the contents of directories. Opening many files, or listing a
+ * directory again, then no longer asks the host each time.
+ *
+ * The archives invalidate the paths they change. Changes made by other programs are only noticed
+ * while the host is being watched, see SetWatchHost, on hosts that support it (Linux). Paths are
+ * host paths; the functions that take one also apply to everything under it. Thread-safe.
+ */
+namespace HostMetadataCache {
+
+enum class Kind {
+    Missing,
+    File,
+    Directory,
+};
+
+/// Returns what is at a path on the host.
+Kind Lookup(const std::string& path);
+
+/**
+ * Returns the contents of a directory, as listed by FileUtil::ScanDirectoryTree without recursion.
+ * The listing is shared, and is never changed after it is returned.
+ */
+std::shared_ptr<const FileUtil::FSTEntry> ListDirectory(const std::string& path);
+
+/// Forgets a path that has been changed, along with the listing of the directory it is in.
+void Invalidate(const std::string& path);
+
+/// Forgets everything.
+void Clear();
+
+/**
+ * Starts or stops watching the host for changes made by other programs. Where the host can not be
+ * watched, those changes are only seen once Clear is called.
+ */
+void SetWatchHost(bool watch);
+
+struct Stats {
+    u64 lookup_hits;
+    u64 lookup_misses;
+    u64 listing_hits;
+    u64 listing_misses;
+};
+
+/// Returns how often the cache answered without asking the host, since the last call to Clear.
+Stats GetStats();
+
+} // namespace HostMetadataCache
+
+} // namespace FileSys
@@ -0,0 +1,115 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "core/file_sys/lzss.h"
+
+namespace FileSys {
+namespace LZSS {
+
+namespace {
+
+/// Copies 8 bytes. Both ranges are read completely before anything is written.
+inline void CopyWord(u8* dest, const u8* src) {
+    u64 word;
+    std::memcpy(&word, src, sizeof(word));
+    std::memcpy(dest, &word, sizeof(word));
+}
+
+} // Anonymous namespace
+
+u32 GetDecompressedSize(const u8* buffer, u32 size) {
+    u32 offset_size;
+    std::memcpy(&offset_size, buffer + size - sizeof(u32), sizeof(u32));
+    return offset_size + size;
+}
+
+bool Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
+                u32 decompressed_size) {
+    if (compressed_size < 8 || decompressed_size < compressed_size ||
+        decompressed_size != GetDecompressedSize(compressed, compressed_size)) {
+        return false;
+    }
+
+    const u8* footer = compressed + compressed_size - 8;
+
+    u32 buffer_top_and_bottom;
+    std::memcpy(&buffer_top_and_bottom, footer, sizeof(u32));
+
+    const u32 footer_size = (buffer_top_and_bottom >> 24) & 0xFF;
+    const u32 compressed_region_size = buffer_top_and_bottom & 0xFFFFFF;
+    if (footer_size > compressed_size || compressed_region_size > compressed_size)
+        return false;
+
+    u32 out = decompressed_size;
+    u32 index = compressed_size - footer_size;
+    const u32 stop_index = compressed_size - compressed_region_size;
+
+    std::memcpy(decompressed, compressed, compressed_size);
+    std::memset(decompressed + compressed_size, 0, decompressed_size - compressed_size);
+
+    while (index > stop_index) {
+        u8 control = compressed[--index];
+
+        // A group of eight literals is a plain copy, which is common in code that compresses
+        // badly.
+        if (control == 0 && index - stop_index >= 8 && out >= 8) {
+            index -= 8;
+            out -= 8;
+            std::memcpy(decompressed + out, compressed + index, 8);
+            continue;
+        }
+
+        for (unsigned i = 0; i < 8; i++) {
+            if (index <= stop_index)
+                break;
+            if (out == 0)
+                break;
+
+            if (control & 0x80) {
+                // Check if compression is out of bounds
+                if (index < 2)
+                    return false;
+                index -= 2;
+
+                const u32 segment = compressed[index] | (compressed[index + 1] << 8);
+                const u32 segment_size = ((segment >> 12) & 15) + 3;
+                // Distance from the first byte written to the byte it is copied from
+                const u32 distance = (segment & 0x0FFF) + 3;
+
+                // Check if compression is out of bounds
+                if (out < segment_size || out + distance - 1 >= decompressed_size)
+                    return false;
+
+                out -= segment_size;
+                u8* dest = decompressed + out;
+                const u8* src = dest + distance;
+
+                // The copy runs from the end towards the start, so when the ranges overlap, a
+                // source byte may only be read once it has been written. That is guaranteed for
+                // whole words when they are at least a word apart.
+                if (distance >= 8 && segment_size >= 8) {
+                    u32 pos = segment_size;
+                    while (pos > 8) {
+                        pos -= 8;
+                        CopyWord(dest + pos, src + pos);
+                    }
+                    // May overlap the previous word, which then gets the same bytes again
+                    CopyWord(dest, src);
+                } else {
+                    for (u32 j = segment_size; j-- > 0;) {
+                        dest[j] = src[j];
+                    }
+                }
+            } else {
+                decompressed[--out] = compressed[--index];
+            }
+            control <<= 1;
+        }
+    }
+    return true;
+}
+
+} // namespace LZSS
+} // namespace FileSys
@@ -0,0 +1,37 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+namespace FileSys {
+
+/**
+ * The backwards LZSS variant that compresses the .code section of an ExeFS. The data is
+ * decompressed from the end towards the start, so that it can be done in place on hardware.
+ */
+namespace LZSS {
+
+/**
+ * Get the decompressed size of an LZSS compressed ExeFS file
+ * @param buffer Buffer of compressed file
+ * @param size Size of compressed buffer
+ * @return Size of decompressed buffer
+ */
+u32 GetDecompressedSize(const u8* buffer, u32 size);
+
+/**
+ * Decompress ExeFS file (compressed with LZSS)
+ * @param compressed Compressed buffer
+ * @param compressed_size Size of compressed buffer
+ * @param decompressed Decompressed buffer
+ * @param decompressed_size Size of decompressed buffer, which must match GetDecompressedSize
+ * @return True on success, otherwise false
+ */
+bool Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
+                u32 decompressed_size);
+
+} // namespace LZSS
+} // namespace FileSys
@@ -2,13 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
 #include <cinttypes>
 #include <cstring>
 #include <memory>
+#include "common/common_paths.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/string_util.h"
 #include "core/core.h"
+#include "core/file_sys/lzss.h"
 #include "core/file_sys/ncch_container.h"
+#include "core/hw/aes/key.h"
 #include "core/loader/loader.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -19,84 +25,56 @@ namespace FileSys {
 static const int kMaxSections = 8;   ///< Maximum number of sections (files) in an ExeFs
 static const int kBlockSize = 0x200; ///< Size of ExeFS blocks (in bytes)
 
+// Crypto settings in the NCCH header flags
+static const int kFlagSecondaryKeySlot = 3; ///< Index of the flag selecting the secondary key slot
+static const int kFlagCrypto = 7;           ///< Index of the flag holding the bits below
+static const u8 kFixedCryptoKey = 0x1;      ///< Content is encrypted with a zero key
+static const u8 kNoCrypto = 0x4;            ///< Content is not encrypted
+static const u8 kSeedCrypto = 0x20;         ///< Secondary KeyY is derived from a per-title seed
+
 /**
- * Get the decompressed size of an LZSS compressed ExeFS file
- * @param buffer Buffer of compressed file
- * @param size Size of compressed buffer
- * @return Size of decompressed buffer
+ * Gets the path a decompressed .code section is cached at. The cache is keyed by the hash of the
+ * compressed section from the ExeFS header, so identical code shared by several files or
+ * versions is only stored once.
+ * @param section_hash SHA-256 of the compressed section
+ * @return The path, or an empty string if the section has no hash to identify it by
  */
-static u32 LZSS_GetDecompressedSize(const u8* buffer, u32 size) {
-    u32 offset_size;
-    std::memcpy(&offset_size, buffer + size - sizeof(u32), sizeof(u32));
-    return offset_size + size;
+static std::string GetCodeCachePath(const u8* section_hash) {
+    if (std::all_of(section_hash, section_hash + 0x20, [](u8 byte) { return byte == 0; }))
+        return "";
+
+    std::string name;
+    for (size_t i = 0; i < 0x20; ++i) {
+        name += Common::StringFromFormat("%02x", section_hash[i]);
+    }
+    return FileUtil::GetUserPath(D_CACHE_IDX) + "exefs_code" DIR_SEP + name + ".bin";
 }
 
-/**
- * Decompress ExeFS file (compressed with LZSS)
- * @param compressed Compressed buffer
- * @param compressed_size Size of compressed buffer
- * @param decompressed Decompressed buffer
- * @param decompressed_size Size of decompressed buffer
- * @return True on success, otherwise false
- */
-static bool LZSS_Decompress(const u8* compressed, u32 compressed_size, u8* decompressed,
-                            u32 decompressed_size) {
-    const u8* footer = compressed + compressed_size - 8;
-
-    u32 buffer_top_and_bottom;
-    std::memcpy(&buffer_top_and_bottom, footer, sizeof(u32));
-
-    u32 out = decompressed_size;
-    u32 index = compressed_size - ((buffer_top_and_bottom >> 24) & 0xFF);
-    u32 stop_index = compressed_size - (buffer_top_and_bottom & 0xFFFFFF);
-
-    memset(decompressed, 0, decompressed_size);
-    memcpy(decompressed, compressed, compressed_size);
-
-    while (index > stop_index) {
-        u8 control = compressed[--index];
-
-        for (unsigned i = 0; i < 8; i++) {
-            if (index <= stop_index)
-                break;
-            if (index <= 0)
-                break;
-            if (out <= 0)
-                break;
-
-            if (control & 0x80) {
-                // Check if compression is out of bounds
-                if (index < 2)
-                    return false;
-                index -= 2;
-
-                u32 segment_offset = compressed[index] | (compressed[index + 1] << 8);
-                u32 segment_size = ((segment_offset >> 12) & 15) + 3;
-                segment_offset &= 0x0FFF;
-                segment_offset += 2;
-
-                // Check if compression is out of bounds
-                if (out < segment_size)
-                    return false;
-
-                for (unsigned j = 0; j < segment_size; j++) {
-                    // Check if compression is out of bounds
-                    if (out + segment_offset >= decompressed_size)
-                        return false;
-
-                    u8 data = decompressed[out + segment_offset];
-                    decompressed[--out] = data;
-                }
-            } else {
-                // Check if compression is out of bounds
-                if (out < 1)
-                    return false;
-                decompressed[--out] = compressed[--index];
-            }
-            control <<= 1;
+static bool LoadCachedCode(const std::string& path, std::vector<u8>& buffer) {
+    FileUtil::IOFile cache_file(path, "rb");
+    if (!cache_file.IsOpen() || cache_file.GetSize() == 0)
+        return false;
+
+    buffer.resize(cache_file.GetSize());
+    return cache_file.ReadBytes(buffer.data(), buffer.size()) == buffer.size();
+}
+
+static void SaveCachedCode(const std::string& path, const std::vector<u8>& buffer) {
+    // Written under a temporary name first, so that a crash cannot leave a truncated entry behind
+    const std::string temp_path = path + ".tmp";
+    FileUtil::CreateFullPath(path);
+    {
+        FileUtil::IOFile cache_file(temp_path, "wb");
+        if (!cache_file.IsOpen() ||
+            cache_file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
+            LOG_WARNING(Service_FS, "Could not write the decompressed .code to %s",
+                        temp_path.c_str());
+            cache_file.Close();
+            FileUtil::Delete(temp_path);
+            return;
         }
     }
-    return true;
+    FileUtil::Rename(temp_path, path);
 }
 
 NCCHContainer::NCCHContainer(const std::string& filepath, u32 ncch_offset)
@@ -108,6 +86,7 @@ Loader::ResultStatus NCCHContainer::OpenFile(const std::string& filepath, u32 nc
     this->filepath = filepath;
     this->ncch_offset = ncch_offset;
     file = FileUtil::IOFile(filepath, "rb");
+    mapped_file.reset();
 
     if (!file.IsOpen()) {
         LOG_WARNING(Service_FS, "Failed to open %s", filepath.c_str());
@@ -148,7 +127,22 @@ Loader::ResultStatus NCCHContainer::Load() {
             if (file.ReadBytes(&exheader_header, sizeof(ExHeader_Header)) !=
                 sizeof(ExHeader_Header))
                 return Loader::ResultStatus::Error;
+        }
 
+        // Some tools decrypt NCCHs without setting the NoCrypto flag, so also look at the content.
+        if (!(ncch_header.flags[kFlagCrypto] & kNoCrypto) && !IsContentPlaintext()) {
+            Loader::ResultStatus result = LoadCrypto();
+            if (result != Loader::ResultStatus::Success)
+                return result;
+
+            is_encrypted = true;
+            if (ncch_header.extended_header_size) {
+                HW::AES::DecryptCTR(reinterpret_cast<u8*>(&exheader_header),
+                                    sizeof(ExHeader_Header), primary_key, exheader_ctr, 0);
+            }
+        }
+
+        if (ncch_header.extended_header_size) {
             is_compressed = (exheader_header.codeset_info.flags.flag & 1) == 1;
             u32 entry_point = exheader_header.codeset_info.text.address;
             u32 code_size = exheader_header.codeset_info.text.code_size;
@@ -164,6 +158,7 @@ Loader::ResultStatus NCCHContainer::Load() {
             LOG_DEBUG(Service_FS, "Program ID:                  %016" PRIX64,
                       ncch_header.program_id);
             LOG_DEBUG(Service_FS, "Code compressed:             %s", is_compressed ? "yes" : "no");
+            LOG_DEBUG(Service_FS, "Content encrypted:           %s", is_encrypted ? "yes" : "no");
             LOG_DEBUG(Service_FS, "Entry point:                 0x%08X", entry_point);
             LOG_DEBUG(Service_FS, "Code size:                   0x%08X", code_size);
             LOG_DEBUG(Service_FS, "Stack size:                  0x%08X", stack_size);
@@ -175,8 +170,13 @@ Loader::ResultStatus NCCHContainer::Load() {
                       static_cast<int>(exheader_header.arm11_system_local_caps.system_mode));
 
             if (exheader_header.system_info.jump_id != ncch_header.program_id) {
-                LOG_ERROR(Service_FS,
-                          "ExHeader Program ID mismatch: the ROM is probably encrypted.");
+                if (is_encrypted) {
+                    LOG_ERROR(Service_FS, "ExHeader Program ID mismatch after decryption: the AES "
+                                          "keys are probably wrong.");
+                } else {
+                    LOG_ERROR(Service_FS,
+                              "ExHeader Program ID mismatch: the ROM is probably encrypted.");
+                }
                 return Loader::ResultStatus::ErrorEncrypted;
             }
 
@@ -194,8 +194,12 @@ Loader::ResultStatus NCCHContainer::Load() {
             file.Seek(exefs_offset + ncch_offset, SEEK_SET);
             if (file.ReadBytes(&exefs_header, sizeof(ExeFs_Header)) != sizeof(ExeFs_Header))
                 return Loader::ResultStatus::Error;
+            if (is_encrypted) {
+                HW::AES::DecryptCTR(reinterpret_cast<u8*>(&exefs_header), sizeof(ExeFs_Header),
+                                    primary_key, exefs_ctr, 0);
+            }
 
-            exefs_file = FileUtil::IOFile(filepath, "rb");
+            exefs_file = GetMappedFile();
             has_exefs = true;
         }
 
@@ -213,6 +217,111 @@ Loader::ResultStatus NCCHContainer::Load() {
     return Loader::ResultStatus::Success;
 }
 
+bool NCCHContainer::IsContentPlaintext() {
+    if (ncch_header.extended_header_size)
+        return exheader_header.system_info.jump_id == ncch_header.program_id;
+
+    // Without an ExHeader, look for the magic at the start of the RomFS
+    if (ncch_header.romfs_offset != 0 && ncch_header.romfs_size != 0) {
+        u32_le magic = 0;
+        GetMappedFile()->ReadAt(ncch_offset + ncch_header.romfs_offset * kBlockSize, sizeof(magic),
+                                &magic);
+        return magic == Loader::MakeMagic('I', 'V', 'F', 'C');
+    }
+    return false;
+}
+
+Loader::ResultStatus NCCHContainer::LoadCrypto() {
+    using namespace HW::AES;
+
+    if (ncch_header.flags[kFlagCrypto] & kFixedCryptoKey) {
+        LOG_DEBUG(Service_FS, "NCCH uses fixed-key crypto");
+        primary_key.fill(0);
+        secondary_key.fill(0);
+    } else {
+        if (ncch_header.flags[kFlagCrypto] & kSeedCrypto) {
+            LOG_ERROR(Service_FS, "NCCH uses seed crypto, which is not supported");
+            return Loader::ResultStatus::ErrorEncrypted;
+        }
+
+        size_t secondary_slot;
+        switch (ncch_header.flags[kFlagSecondaryKeySlot]) {
+        case 0x00:
+            secondary_slot = KeySlotID::NCCHSecure1;
+            break;
+        case 0x01:
+            secondary_slot = KeySlotID::NCCHSecure2;
+            break;
+        case 0x0A:
+            secondary_slot = KeySlotID::NCCHSecure3;
+            break;
+        case 0x0B:
+            secondary_slot = KeySlotID::NCCHSecure4;
+            break;
+        default:
+            LOG_ERROR(Service_FS, "Unknown NCCH secondary key slot 0x%02X",
+                      ncch_header.flags[kFlagSecondaryKeySlot]);
+            return Loader::ResultStatus::ErrorEncrypted;
+        }
+
+        // The keys are loaded when the emulated hardware starts, which may not have happened yet
+        // when the game list loads the NCCH.
+        LoadKeysIfNeeded();
+
+        // The KeyY is the start of the header signature. Each key is generated in one go, as the
+        // keys may be loaded again on the emulation thread meanwhile.
+        AESKey key_y;
+        std::memcpy(key_y.data(), ncch_header.signature, key_y.size());
+        const boost::optional<AESKey> primary = GenerateNormalKey(KeySlotID::NCCHSecure1, key_y);
+        const boost::optional<AESKey> secondary = GenerateNormalKey(secondary_slot, key_y);
+        if (!primary || !secondary) {
+            LOG_ERROR(Service_FS,
+                      "NCCH is encrypted, but the KeyX for slot 0x%02zX or 0x%02zX or the "
+                      "generator constant is missing from %s",
+                      static_cast<size_t>(KeySlotID::NCCHSecure1), secondary_slot, AES_KEYS);
+            return Loader::ResultStatus::ErrorEncrypted;
+        }
+        primary_key = *primary;
+        secondary_key = *secondary;
+    }
+
+    switch (ncch_header.version) {
+    case 0:
+    case 2: {
+        // Each section is a separate stream: the partition ID in reverse, then the section type
+        CTRCounter ctr{};
+        std::reverse_copy(ncch_header.partition_id, ncch_header.partition_id + 8, ctr.begin());
+        exheader_ctr = exefs_ctr = romfs_ctr = ctr;
+        exheader_ctr[8] = 1;
+        exefs_ctr[8] = 2;
+        romfs_ctr[8] = 3;
+        break;
+    }
+    case 1: {
+        // As if the whole NCCH was one stream: the partition ID, then the big endian offset of
+        // the section.
+        const auto make_ctr = [this](u32 section_offset) {
+            CTRCounter ctr{};
+            std::copy(ncch_header.partition_id, ncch_header.partition_id + 8, ctr.begin());
+            for (int i = 0; i < 4; ++i) {
+                ctr[12 + i] = static_cast<u8>(section_offset >> (24 - i * 8));
+            }
+            return ctr;
+        };
+        exheader_ctr = make_ctr(sizeof(NCCH_Header));
+        exefs_ctr = make_ctr(ncch_header.exefs_offset * kBlockSize);
+        romfs_ctr = make_ctr(ncch_header.romfs_offset * kBlockSize);
+        break;
+    }
+    default:
+        LOG_ERROR(Service_FS, "Unknown NCCH version %u, can not decrypt it",
+                  static_cast<u32>(ncch_header.version));
+        return Loader::ResultStatus::ErrorEncrypted;
+    }
+
+    return Loader::ResultStatus::Success;
+}
+
 Loader::ResultStatus NCCHContainer::LoadOverrides() {
     // Check for split-off files, mark the archive as tainted if we will use them
     std::string romfs_override = filepath + ".romfs";
@@ -224,15 +333,15 @@ Loader::ResultStatus NCCHContainer::LoadOverrides() {
     std::string exefs_override = filepath + ".exefs";
     std::string exefsdir_override = filepath + ".exefsdir/";
     if (FileUtil::Exists(exefs_override)) {
-        exefs_file = FileUtil::IOFile(exefs_override, "rb");
+        exefs_file = std::make_shared<FileUtil::MappedFile>(exefs_override);
 
-        if (exefs_file.ReadBytes(&exefs_header, sizeof(ExeFs_Header)) == sizeof(ExeFs_Header)) {
+        if (exefs_file->ReadAt(0, sizeof(ExeFs_Header), &exefs_header) == sizeof(ExeFs_Header)) {
             LOG_DEBUG(Service_FS, "Loading ExeFS section from %s", exefs_override.c_str());
             exefs_offset = 0;
             is_tainted = true;
             has_exefs = true;
         } else {
-            exefs_file = FileUtil::IOFile(filepath, "rb");
+            exefs_file = GetMappedFile();
         }
     } else if (FileUtil::Exists(exefsdir_override) && FileUtil::IsDirectory(exefsdir_override)) {
         is_tainted = true;
@@ -264,9 +373,8 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             size_t logo_size = ncch_header.logo_region_size * kBlockSize;
 
             buffer.resize(logo_size);
-            file.Seek(ncch_offset + logo_offset, SEEK_SET);
-
-            if (file.ReadBytes(buffer.data(), logo_size) != logo_size) {
+            if (GetMappedFile()->ReadAt(ncch_offset + logo_offset, logo_size, buffer.data()) !=
+                logo_size) {
                 LOG_ERROR(Service_FS, "Could not read NCCH logo");
                 return Loader::ResultStatus::Error;
             }
@@ -277,7 +385,7 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
     }
 
     // If we don't have any separate files, we'll need a full ExeFS
-    if (!exefs_file.IsOpen())
+    if (!exefs_file || !exefs_file->IsOpen())
         return Loader::ResultStatus::Error;
 
     LOG_DEBUG(Service_FS, "%d sections:", kMaxSections);
@@ -290,32 +398,75 @@ Loader::ResultStatus NCCHContainer::LoadSectionExeFS(const char* name, std::vect
             LOG_DEBUG(Service_FS, "%d - offset: 0x%08X, size: 0x%08X, name: %s", section_number,
                       section.offset, section.size, section.name);
 
-            s64 section_offset =
+            u64 section_offset =
                 (section.offset + exefs_offset + sizeof(ExeFs_Header) + ncch_offset);
-            exefs_file.Seek(section_offset, SEEK_SET);
+            if (section_offset + section.size > exefs_file->GetSize())
+                return Loader::ResultStatus::Error;
+
+            // Overrides are never encrypted. In the NCCH, only the icon and banner use the
+            // primary key.
+            const bool decrypt = is_encrypted && exefs_file == mapped_file;
+            const bool primary =
+                strcmp(section.name, "icon") == 0 || strcmp(section.name, "banner") == 0;
+            const auto decrypt_section = [&](u8* data) {
+                HW::AES::DecryptCTR(data, section.size, primary ? primary_key : secondary_key,
+                                    exefs_ctr, sizeof(ExeFs_Header) + section.offset);
+            };
 
             if (strcmp(section.name, ".code") == 0 && is_compressed) {
-                // Section is compressed, read compressed .code section...
-                std::unique_ptr<u8[]> temp_buffer;
-                try {
-                    temp_buffer.reset(new u8[section.size]);
-                } catch (std::bad_alloc&) {
-                    return Loader::ResultStatus::ErrorMemoryAllocationFailed;
+                const auto start_time = std::chrono::steady_clock::now();
+                const auto elapsed_ms = [&start_time] {
+                    return std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start_time)
+                        .count();
+                };
+
+                // The hashes are stored in reverse order of the sections
+                const std::string cache_path =
+                    GetCodeCachePath(exefs_header.hashes[kMaxSections - 1 - section_number]);
+                if (!cache_path.empty() && LoadCachedCode(cache_path, buffer)) {
+                    LOG_INFO(Service_FS, "Loaded .code (%zu bytes) from the cache in %.1f ms",
+                             buffer.size(), elapsed_ms());
+                    return Loader::ResultStatus::Success;
                 }
 
-                if (exefs_file.ReadBytes(&temp_buffer[0], section.size) != section.size)
-                    return Loader::ResultStatus::Error;
+                // Section is compressed, decompress straight out of the mapped file if possible...
+                const u8* compressed = nullptr;
+                std::unique_ptr<u8[]> temp_buffer;
+                if (exefs_file->IsMapped() && !decrypt) {
+                    compressed = exefs_file->GetPointer() + section_offset;
+                } else {
+                    try {
+                        temp_buffer.reset(new u8[section.size]);
+                    } catch (std::bad_alloc&) {
+                        return Loader::ResultStatus::ErrorMemoryAllocationFailed;
+                    }
+
+                    if (exefs_file->ReadAt(section_offset, section.size, &temp_buffer[0]) !=
+                        section.size)
+                        return Loader::ResultStatus::Error;
+                    if (decrypt)
+                        decrypt_section(&temp_buffer[0]);
+                    compressed = &temp_buffer[0];
+                }
 
                 // Decompress .code section...
-                u32 decompressed_size = LZSS_GetDecompressedSize(&temp_buffer[0], section.size);
+                u32 decompressed_size = LZSS::GetDecompressedSize(compressed, section.size);
                 buffer.resize(decompressed_size);
-                if (!LZSS_Decompress(&temp_buffer[0], section.size, &buffer[0], decompressed_size))
+                if (!LZSS::Decompress(compressed, section.size, &buffer[0], decompressed_size))
                     return Loader::ResultStatus::ErrorInvalidFormat;
+                LOG_INFO(Service_FS, "Decompressed .code (%u to %u bytes) in %.1f ms", section.size,
+                         decompressed_size, elapsed_ms());
+
+                if (!cache_path.empty())
+                    SaveCachedCode(cache_path, buffer);
             } else {
                 // Section is uncompressed...
                 buffer.resize(section.size);
-                if (exefs_file.ReadBytes(&buffer[0], section.size) != section.size)
+                if (exefs_file->ReadAt(section_offset, section.size, &buffer[0]) != section.size)
                     return Loader::ResultStatus::Error;
+                if (decrypt)
+                    decrypt_section(&buffer[0]);
             }
             return Loader::ResultStatus::Success;
         }
@@ -356,13 +507,12 @@ Loader::ResultStatus NCCHContainer::LoadOverrideExeFSSection(const char* name,
     return Loader::ResultStatus::ErrorNotUsed;
 }
 
-Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file,
-                                              u64& offset, u64& size) {
+Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<RomFSReader>& romfs_file) {
     Loader::ResultStatus result = Load();
     if (result != Loader::ResultStatus::Success)
         return result;
 
-    if (ReadOverrideRomFS(romfs_file, offset, size) == Loader::ResultStatus::Success)
+    if (ReadOverrideRomFS(romfs_file) == Loader::ResultStatus::Success)
         return Loader::ResultStatus::Success;
 
     if (!has_romfs) {
@@ -382,27 +532,32 @@ Loader::ResultStatus NCCHContainer::ReadRomFS(std::shared_ptr<FileUtil::IOFile>&
     if (file.GetSize() < romfs_offset + romfs_size)
         return Loader::ResultStatus::Error;
 
-    // We reopen the file, to allow its position to be independent from file's
-    romfs_file = std::make_shared<FileUtil::IOFile>(filepath, "rb");
-    if (!romfs_file->IsOpen())
+    // RomFS reads go through the mapping, which has no position shared with `file`
+    std::shared_ptr<FileUtil::MappedFile> romfs_mapping = GetMappedFile();
+    if (!romfs_mapping->IsOpen())
         return Loader::ResultStatus::Error;
 
-    offset = romfs_offset;
-    size = romfs_size;
+    if (is_encrypted) {
+        // The CTR stream starts at the RomFS section, 0x1000 bytes before the data we expose
+        romfs_file = std::make_shared<RomFSReader>(std::move(romfs_mapping), romfs_offset,
+                                                   romfs_size, secondary_key, romfs_ctr, 0x1000);
+    } else {
+        romfs_file =
+            std::make_shared<RomFSReader>(std::move(romfs_mapping), romfs_offset, romfs_size);
+    }
 
     return Loader::ResultStatus::Success;
 }
 
-Loader::ResultStatus NCCHContainer::ReadOverrideRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file,
-                                                      u64& offset, u64& size) {
+Loader::ResultStatus NCCHContainer::ReadOverrideRomFS(std::shared_ptr<RomFSReader>& romfs_file) {
     // Check for RomFS overrides
     std::string split_filepath = filepath + ".romfs";
     if (FileUtil::Exists(split_filepath)) {
-        romfs_file = std::make_shared<FileUtil::IOFile>(split_filepath, "rb");
-        if (romfs_file->IsOpen()) {
+        auto split_file = std::make_shared<FileUtil::MappedFile>(split_filepath);
+        if (split_file->IsOpen()) {
             LOG_WARNING(Service_FS, "File %s overriding built-in RomFS", split_filepath.c_str());
-            offset = 0;
-            size = romfs_file->GetSize();
+            const u64 size = split_file->GetSize();
+            romfs_file = std::make_shared<RomFSReader>(std::move(split_file), 0, size);
             return Loader::ResultStatus::Success;
         }
     }
@@ -410,6 +565,12 @@ Loader::ResultStatus NCCHContainer::ReadOverrideRomFS(std::shared_ptr<FileUtil::
     return Loader::ResultStatus::ErrorNotUsed;
 }
 
+std::shared_ptr<FileUtil::MappedFile> NCCHContainer::GetMappedFile() {
+    if (!mapped_file)
+        mapped_file = std::make_shared<FileUtil::MappedFile>(filepath);
+    return mapped_file;
+}
+
 Loader::ResultStatus NCCHContainer::ReadProgramId(u64_le& program_id) {
     Loader::ResultStatus result = Load();
     if (result != Loader::ResultStatus::Success)
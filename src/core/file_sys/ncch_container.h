@@ -13,6 +13,8 @@
 #include "common/file_util.h"
 #include "common/swap.h"
 #include "core/core.h"
+#include "core/file_sys/romfs_reader.h"
+#include "core/hw/aes/ctr.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 /// NCCH header (Note: "NCCH" appears to be a publicly unknown acronym)
@@ -205,25 +207,19 @@ public:
 
     /**
      * Get the RomFS of the NCCH container
-     * Since the RomFS can be huge, we return a file reference instead of copying to a buffer
-     * @param romfs_file The file containing the RomFS
-     * @param offset The offset the romfs begins on
-     * @param size The size of the romfs
+     * Since the RomFS can be huge, we return a reader for it instead of copying to a buffer
+     * @param romfs_file The reader for the RomFS, which decrypts it if needed
      * @return ResultStatus result of function
      */
-    Loader::ResultStatus ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
-                                   u64& size);
+    Loader::ResultStatus ReadRomFS(std::shared_ptr<RomFSReader>& romfs_file);
 
     /**
      * Get the override RomFS of the NCCH container
-     * Since the RomFS can be huge, we return a file reference instead of copying to a buffer
-     * @param romfs_file The file containing the RomFS
-     * @param offset The offset the romfs begins on
-     * @param size The size of the romfs
+     * Since the RomFS can be huge, we return a reader for it instead of copying to a buffer
+     * @param romfs_file The reader for the RomFS
      * @return ResultStatus result of function
      */
-    Loader::ResultStatus ReadOverrideRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file,
-                                           u64& offset, u64& size);
+    Loader::ResultStatus ReadOverrideRomFS(std::shared_ptr<RomFSReader>& romfs_file);
 
     /**
      * Get the Program ID of the NCCH container
@@ -262,13 +258,30 @@ private:
     bool is_tainted = false; // Are there parts of this container being overridden?
     bool is_loaded = false;
     bool is_compressed = false;
+    bool is_encrypted = false; // Is the content encrypted, and decrypted as it is read?
 
     u32 ncch_offset = 0; // Offset to NCCH header, can be 0 for NCCHs or non-zero for CIAs/NCSDs
     u32 exefs_offset = 0;
 
+    /// Returns true if the content is readable as is, even though the header says otherwise.
+    bool IsContentPlaintext();
+
+    /// Derives the keys and counters used to decrypt the content.
+    Loader::ResultStatus LoadCrypto();
+
+    /// Returns the mapping of the container file, creating it on first use.
+    std::shared_ptr<FileUtil::MappedFile> GetMappedFile();
+
+    HW::AES::AESKey primary_key{};   ///< ExHeader, ExeFS header, icon and banner
+    HW::AES::AESKey secondary_key{}; ///< The rest of the ExeFS, and the RomFS
+    HW::AES::CTRCounter exheader_ctr{};
+    HW::AES::CTRCounter exefs_ctr{};
+    HW::AES::CTRCounter romfs_ctr{};
+
     std::string filepath;
     FileUtil::IOFile file;
-    FileUtil::IOFile exefs_file;
+    std::shared_ptr<FileUtil::MappedFile> mapped_file; ///< Shared with the RomFS readers
+    std::shared_ptr<FileUtil::MappedFile> exefs_file;  ///< mapped_file, or the ExeFS override
 };
 
 } // namespace FileSys
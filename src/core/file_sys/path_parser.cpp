@@ -6,7 +6,9 @@
 #include <set>
 #include "common/file_util.h"
 #include "common/string_util.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/path_parser.h"
+#include "core/file_sys/write_back_cache.h"
 
 namespace FileSys {
 
@@ -39,6 +41,12 @@ PathParser::PathParser(const Path& path) {
     end = std::remove_if(begin, end, [](std::string& str) { return str == "" || str == "."; });
     path_sequence = std::vector<std::string>(begin, end);
 
+    // These names are taken by the write-back cache
+    if (std::any_of(path_sequence.begin(), path_sequence.end(), WriteBackCache::IsCommitTempName)) {
+        is_valid = false;
+        return;
+    }
+
     // checks if the path is out of bounds.
     int level = 0;
     for (auto& node : path_sequence) {
@@ -58,8 +66,10 @@ PathParser::PathParser(const Path& path) {
 }
 
 PathParser::HostStatus PathParser::GetHostStatus(const std::string& mount_point) const {
+    using HostMetadataCache::Kind;
+
     auto path = mount_point;
-    if (!FileUtil::IsDirectory(path))
+    if (HostMetadataCache::Lookup(path) != Kind::Directory)
         return InvalidMountPoint;
     if (path_sequence.empty()) {
         return DirectoryFound;
@@ -70,18 +80,27 @@ PathParser::HostStatus PathParser::GetHostStatus(const std::string& mount_point)
             path += '/';
         path += *iter;
 
-        if (!FileUtil::Exists(path))
+        switch (HostMetadataCache::Lookup(path)) {
+        case Kind::Missing:
             return PathNotFound;
-        if (FileUtil::IsDirectory(path))
+        case Kind::Directory:
             continue;
-        return FileInPath;
+        case Kind::File:
+            return FileInPath;
+        }
     }
 
-    path += "/" + path_sequence.back();
-    if (!FileUtil::Exists(path))
+    if (path.back() != '/')
+        path += '/';
+    path += path_sequence.back();
+    switch (HostMetadataCache::Lookup(path)) {
+    case Kind::Missing:
         return NotFound;
-    if (FileUtil::IsDirectory(path))
+    case Kind::Directory:
         return DirectoryFound;
+    case Kind::File:
+        break;
+    }
     return FileFound;
 }
 
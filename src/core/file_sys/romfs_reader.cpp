@@ -0,0 +1,21 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "core/file_sys/romfs_reader.h"
+
+namespace FileSys {
+
+size_t RomFSReader::Read(u64 offset, size_t length, u8* buffer) const {
+    if (offset >= size)
+        return 0;
+    length = static_cast<size_t>(std::min<u64>(length, size - offset));
+
+    const size_t read = file->ReadAt(file_offset + offset, length, buffer);
+    if (is_encrypted)
+        HW::AES::DecryptCTR(buffer, read, key, ctr, crypto_offset + offset);
+    return read;
+}
+
+} // namespace FileSys
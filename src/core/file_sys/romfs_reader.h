@@ -0,0 +1,60 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "core/hw/aes/ctr.h"
+
+namespace FileSys {
+
+/**
+ * Reads a RomFS image stored inside a larger file, such as an NCCH or a 3DSX. Encrypted images are
+ * decrypted as they are read. Reads may be issued from several threads at once.
+ */
+class RomFSReader {
+public:
+    RomFSReader(std::shared_ptr<FileUtil::MappedFile> file, u64 offset, u64 size)
+        : file(std::move(file)), file_offset(offset), size(size) {}
+
+    /**
+     * Creates a reader for an image encrypted with AES-CTR.
+     * @param crypto_offset Position of the image in the CTR stream that starts with `ctr`
+     */
+    RomFSReader(std::shared_ptr<FileUtil::MappedFile> file, u64 offset, u64 size,
+                const HW::AES::AESKey& key, const HW::AES::CTRCounter& ctr, u64 crypto_offset)
+        : file(std::move(file)), file_offset(offset), size(size), is_encrypted(true), key(key),
+          ctr(ctr), crypto_offset(crypto_offset) {}
+
+    u64 GetSize() const {
+        return size;
+    }
+
+    bool IsEncrypted() const {
+        return is_encrypted;
+    }
+
+    /**
+     * Reads from the image. Reads past the end of the image are truncated.
+     * @param offset Offset in the image to start reading from
+     * @param length Number of bytes to read
+     * @param buffer Buffer to read into
+     * @returns The number of bytes read
+     */
+    size_t Read(u64 offset, size_t length, u8* buffer) const;
+
+private:
+    std::shared_ptr<FileUtil::MappedFile> file;
+    u64 file_offset;
+    u64 size;
+
+    bool is_encrypted = false;
+    HW::AES::AESKey key{};
+    HW::AES::CTRCounter ctr{};
+    u64 crypto_offset = 0;
+};
+
+} // namespace FileSys
@@ -5,8 +5,10 @@
 #include "common/file_util.h"
 #include "core/file_sys/disk_archive.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/path_parser.h"
 #include "core/file_sys/savedata_archive.h"
+#include "core/file_sys/write_back_cache.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // FileSys namespace
@@ -69,6 +71,7 @@ ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& pa
         } else {
             // Create the file
             FileUtil::CreateEmptyFile(full_path);
+            HostMetadataCache::Invalidate(full_path);
         }
         break;
     case PathParser::FileFound:
@@ -82,7 +85,8 @@ ResultVal<std::unique_ptr<FileBackend>> SaveDataArchive::OpenFile(const Path& pa
     }
 
     std::unique_ptr<DelayGenerator> delay_generator = std::make_unique<SaveDataDelayGenerator>();
-    auto disk_file = std::make_unique<DiskFile>(std::move(file), mode, std::move(delay_generator));
+    auto disk_file = std::make_unique<DiskFile>(WriteBackCache::Open(full_path, std::move(file)),
+                                                mode, std::move(delay_generator));
     return MakeResult<std::unique_ptr<FileBackend>>(std::move(disk_file));
 }
 
@@ -113,6 +117,8 @@ ResultCode SaveDataArchive::DeleteFile(const Path& path) const {
     }
 
     if (FileUtil::Delete(full_path)) {
+        WriteBackCache::Discard(full_path);
+        HostMetadataCache::Invalidate(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -140,6 +146,9 @@ ResultCode SaveDataArchive::RenameFile(const Path& src_path, const Path& dest_pa
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        WriteBackCache::Rename(src_path_full, dest_path_full);
+        HostMetadataCache::Invalidate(src_path_full);
+        HostMetadataCache::Invalidate(dest_path_full);
         return RESULT_SUCCESS;
     }
 
@@ -180,7 +189,11 @@ static ResultCode DeleteDirectoryHelper(const Path& path, const std::string& mou
         break; // Expected 'success' case
     }
 
-    if (deleter(full_path)) {
+    const bool deleted = deleter(full_path);
+    // A recursive delete that failed may still have removed some of the contents
+    HostMetadataCache::Invalidate(full_path);
+    if (deleted) {
+        WriteBackCache::Discard(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -227,13 +240,17 @@ ResultCode SaveDataArchive::CreateFile(const FileSys::Path& path, u64 size) cons
 
     if (size == 0) {
         FileUtil::CreateEmptyFile(full_path);
+        HostMetadataCache::Invalidate(full_path);
         return RESULT_SUCCESS;
     }
 
     FileUtil::IOFile file(full_path, "wb");
     // Creates a sparse file (or a normal file on filesystems without the concept of sparse files)
     // We do this by seeking to the right size, then writing a single null byte.
-    if (file.Seek(size - 1, SEEK_SET) && file.WriteBytes("", 1) == 1) {
+    const bool created = file.Seek(size - 1, SEEK_SET) && file.WriteBytes("", 1) == 1;
+    file.Close();
+    HostMetadataCache::Invalidate(full_path);
+    if (created) {
         return RESULT_SUCCESS;
     }
 
@@ -271,6 +288,7 @@ ResultCode SaveDataArchive::CreateDirectory(const Path& path) const {
     }
 
     if (FileUtil::CreateDir(mount_point + path.AsString())) {
+        HostMetadataCache::Invalidate(full_path);
         return RESULT_SUCCESS;
     }
 
@@ -299,6 +317,9 @@ ResultCode SaveDataArchive::RenameDirectory(const Path& src_path, const Path& de
     const auto dest_path_full = path_parser_dest.BuildHostPath(mount_point);
 
     if (FileUtil::Rename(src_path_full, dest_path_full)) {
+        WriteBackCache::Rename(src_path_full, dest_path_full);
+        HostMetadataCache::Invalidate(src_path_full);
+        HostMetadataCache::Invalidate(dest_path_full);
         return RESULT_SUCCESS;
     }
 
@@ -335,10 +356,23 @@ ResultVal<std::unique_ptr<DirectoryBackend>> SaveDataArchive::OpenDirectory(
         break; // Expected 'success' case
     }
 
+    // The listing has the sizes of the files on the host
+    WriteBackCache::Commit(full_path);
     auto directory = std::make_unique<DiskDirectory>(full_path);
     return MakeResult<std::unique_ptr<DirectoryBackend>>(std::move(directory));
 }
 
+SaveDataArchive::~SaveDataArchive() {
+    WriteBackCache::Commit(mount_point);
+}
+
+ResultCode SaveDataArchive::Commit() const {
+    if (WriteBackCache::Commit(mount_point))
+        return RESULT_SUCCESS;
+    // Running out of space is the likely reason for the host write to fail
+    return ERROR_INSUFFICIENT_SPACE;
+}
+
 u64 SaveDataArchive::GetFreeBytes() const {
     // TODO: Stubbed to return 1GiB
     return 1024 * 1024 * 1024;
@@ -20,6 +20,9 @@ class SaveDataArchive : public ArchiveBackend {
 public:
     explicit SaveDataArchive(const std::string& mount_point_) : mount_point(mount_point_) {}
 
+    /// Commits the files of the archive that are still open.
+    ~SaveDataArchive() override;
+
     std::string GetName() const override {
         return "SaveDataArchive: " + mount_point;
     }
@@ -35,6 +38,7 @@ public:
     ResultCode RenameDirectory(const Path& src_path, const Path& dest_path) const override;
     ResultVal<std::unique_ptr<DirectoryBackend>> OpenDirectory(const Path& path) const override;
     u64 GetFreeBytes() const override;
+    ResultCode Commit() const override;
 
 protected:
     std::string mount_point;
@@ -0,0 +1,141 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/system_archive_cache.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+namespace SystemArchiveCache {
+
+namespace {
+
+/// Past this many bytes, the contents nobody is using any more are dropped
+constexpr u64 max_cached_bytes = 64 * 1024 * 1024;
+
+/// What identifies a version of a host file
+struct HostStamp {
+    u64 size;
+    s64 modification_time;
+
+    bool operator==(const HostStamp& other) const {
+        return size == other.size && modification_time == other.modification_time;
+    }
+};
+
+struct Entry {
+    std::string host_path;
+    HostStamp stamp;
+    Contents contents;
+};
+
+std::mutex cache_mutex;
+std::map<std::string, Entry> entries;
+u64 cached_bytes = 0;
+/// Changes on every invalidation, so that contents loaded while one happened are not cached
+u64 generation = 0;
+Stats stats{};
+
+HostStamp GetStamp(const std::string& host_path) {
+    if (!FileUtil::Exists(host_path))
+        return {0, 0};
+    return {FileUtil::GetSize(host_path), FileUtil::GetModificationTime(host_path)};
+}
+
+/// Whether path is the host path prefix, or is under it.
+bool IsAtOrUnder(const std::string& path, const std::string& prefix) {
+    if (path.compare(0, prefix.size(), prefix) != 0)
+        return false;
+    return path.size() == prefix.size() || prefix.back() == '/' || path[prefix.size()] == '/';
+}
+
+/// Removes an entry, cache_mutex must be held.
+std::map<std::string, Entry>::iterator EraseLocked(std::map<std::string, Entry>::iterator it) {
+    cached_bytes -= it->second.contents->size();
+    return entries.erase(it);
+}
+
+/// Drops the contents that are only held by the cache until it fits, cache_mutex must be held.
+void TrimLocked() {
+    for (auto it = entries.begin(); it != entries.end() && cached_bytes > max_cached_bytes;) {
+        if (it->second.contents.use_count() == 1)
+            it = EraseLocked(it);
+        else
+            ++it;
+    }
+}
+
+} // Anonymous namespace
+
+Contents Get(const std::string& key, const std::string& host_path,
+             const std::function<bool(std::vector<u8>&)>& load) {
+    const HostStamp stamp = GetStamp(host_path);
+
+    std::unique_lock<std::mutex> lock(cache_mutex);
+    const auto it = entries.find(key);
+    if (it != entries.end()) {
+        if (it->second.host_path == host_path && it->second.stamp == stamp) {
+            ++stats.hits;
+            return it->second.contents;
+        }
+        LOG_DEBUG(Service_FS, "%s changed on the host, loading %s again", host_path.c_str(),
+                  key.c_str());
+        EraseLocked(it);
+    }
+    ++stats.misses;
+    const u64 load_generation = generation;
+    lock.unlock();
+
+    // Loaded outside the lock, as loading may get other contents from the cache
+    auto buffer = std::make_shared<std::vector<u8>>();
+    if (!load(*buffer))
+        return nullptr;
+    Contents contents = std::move(buffer);
+
+    lock.lock();
+    if (generation == load_generation && GetStamp(host_path) == stamp) {
+        const auto existing = entries.find(key);
+        if (existing != entries.end())
+            EraseLocked(existing);
+        entries.emplace(key, Entry{host_path, stamp, contents});
+        cached_bytes += contents->size();
+        TrimLocked();
+    }
+    return contents;
+}
+
+void Invalidate(const std::string& host_path) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    ++generation;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (IsAtOrUnder(it->second.host_path, host_path))
+            it = EraseLocked(it);
+        else
+            ++it;
+    }
+}
+
+void Clear() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    ++generation;
+    entries.clear();
+    cached_bytes = 0;
+    stats = {};
+}
+
+Stats GetStats() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    Stats result = stats;
+    result.cached_bytes = cached_bytes;
+    return result;
+}
+
+} // namespace SystemArchiveCache
+} // namespace FileSys
@@ -0,0 +1,59 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+/**
+ * Keeps what the system modules load from system archives, such as the shared font, the Mii data
+ * and the CFG blocks, for the lifetime of the process. Booting again, or booting another title in
+ * the same process, then shares the contents loaded by the previous boot instead of reading and
+ * parsing them again.
+ *
+ * Contents are never changed once they are cached. A user that needs to change them makes its own
+ * copy first. Each entry remembers the host file it was loaded from, and is loaded again if that
+ * file was modified since. Thread-safe.
+ */
+namespace SystemArchiveCache {
+
+using Contents = std::shared_ptr<const std::vector<u8>>;
+
+/**
+ * Returns the contents cached under a key, loading them if they are not cached yet.
+ * @param key Identifies the contents, such as the archive and the file in it
+ * @param host_path The host file the contents are loaded from
+ * @param load Fills the buffer with the contents, and returns false if it could not
+ * @return the contents, or nullptr if they could not be loaded
+ */
+Contents Get(const std::string& key, const std::string& host_path,
+             const std::function<bool(std::vector<u8>&)>& load);
+
+/// Forgets the contents loaded from a host file, or from the files in a host directory.
+void Invalidate(const std::string& host_path);
+
+/// Forgets everything.
+void Clear();
+
+struct Stats {
+    u64 hits;
+    u64 misses;
+    u64 cached_bytes;
+};
+
+/// Returns how often contents were shared instead of loaded, since the last call to Clear.
+Stats GetStats();
+
+} // namespace SystemArchiveCache
+
+} // namespace FileSys
@@ -188,6 +188,10 @@ u64 TitleMetadata::GetContentSizeByIndex(u16 index) const {
     return tmd_chunks[index].size;
 }
 
+const std::array<u8, 0x20>& TitleMetadata::GetContentHashByIndex(u16 index) const {
+    return tmd_chunks[index].hash;
+}
+
 void TitleMetadata::SetTitleID(u64 title_id) {
     tmd_body.title_id = title_id;
 }
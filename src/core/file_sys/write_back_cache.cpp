@@ -0,0 +1,413 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include "common/logging/log.h"
+#include "core/file_sys/host_metadata_cache.h"
+#include "core/file_sys/system_archive_cache.h"
+#include "core/file_sys/write_back_cache.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+namespace {
+
+/// Size of the pieces a file is copied in during an atomic commit
+constexpr size_t copy_chunk_size = 1024 * 1024;
+
+/// Suffix of the file the new contents are written to before being renamed over the old ones
+constexpr char temp_suffix[] = ".citra_commit";
+
+} // Anonymous namespace
+
+WriteBackFile::WriteBackFile(std::string path_, FileUtil::IOFile&& file_)
+    : path(std::move(path_)), file(std::move(file_)) {
+    size = file.GetSize();
+    host_valid_size = size;
+}
+
+void WriteBackFile::ReadHost(u64 offset, size_t length, u8* buffer) {
+    size_t host_length = 0;
+    if (offset < host_valid_size)
+        host_length = static_cast<size_t>(std::min<u64>(length, host_valid_size - offset));
+
+    size_t read = 0;
+    if (host_length != 0) {
+        file.Clear();
+        file.Seek(offset, SEEK_SET);
+        read = file.ReadBytes(buffer, host_length);
+        if (read > host_length)
+            read = 0;
+    }
+    // Whatever the host file does not have was never written, or was cut off by SetSize
+    std::memset(buffer + read, 0, length - read);
+}
+
+size_t WriteBackFile::Read(u64 offset, size_t length, u8* buffer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (offset >= size)
+        return 0;
+    length = static_cast<size_t>(std::min<u64>(length, size - offset));
+
+    size_t done = 0;
+    while (done < length) {
+        const u64 position = offset + done;
+        const u64 block = position / block_size;
+        const size_t block_offset = static_cast<size_t>(position % block_size);
+
+        const auto it = dirty_blocks.find(block);
+        if (it != dirty_blocks.end()) {
+            const size_t piece = std::min(length - done, block_size - block_offset);
+            std::memcpy(buffer + done, it->second.data() + block_offset, piece);
+            done += piece;
+            continue;
+        }
+
+        // Read up to the next dirty block in one go
+        const auto next = dirty_blocks.upper_bound(block);
+        u64 piece = length - done;
+        if (next != dirty_blocks.end())
+            piece = std::min(piece, next->first * block_size - position);
+        ReadHost(position, static_cast<size_t>(piece), buffer + done);
+        done += static_cast<size_t>(piece);
+    }
+    return length;
+}
+
+size_t WriteBackFile::Write(u64 offset, size_t length, const u8* buffer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (discarded || length == 0)
+        return length;
+
+    size_t done = 0;
+    while (done < length) {
+        const u64 position = offset + done;
+        const u64 block = position / block_size;
+        const size_t block_offset = static_cast<size_t>(position % block_size);
+        const size_t piece = std::min(length - done, block_size - block_offset);
+
+        auto it = dirty_blocks.find(block);
+        if (it == dirty_blocks.end()) {
+            std::vector<u8> data(block_size);
+            // Blocks that are only partly overwritten keep the rest of their contents
+            if (piece != block_size)
+                ReadHost(block * block_size, block_size, data.data());
+            it = dirty_blocks.emplace(block, std::move(data)).first;
+        }
+        std::memcpy(it->second.data() + block_offset, buffer + done, piece);
+        done += piece;
+    }
+
+    size = std::max(size, offset + length);
+    dirty = true;
+
+    if (dirty_blocks.size() * block_size > max_dirty_size) {
+        LOG_DEBUG(Service_FS, "Too much uncommitted data in %s, committing", path.c_str());
+        if (size > max_atomic_commit_size ? CommitInPlace() : CommitAtomic())
+            dirty = false;
+    }
+    return length;
+}
+
+u64 WriteBackFile::GetSize() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+void WriteBackFile::SetSize(u64 new_size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (discarded || new_size == size)
+        return;
+
+    if (new_size < size) {
+        // Drop the blocks past the end, and clear the end of the last one, so that growing the
+        // file again reads zeroes
+        const u64 first_dropped = (new_size + block_size - 1) / block_size;
+        dirty_blocks.erase(dirty_blocks.lower_bound(first_dropped), dirty_blocks.end());
+        if (new_size % block_size != 0) {
+            const auto it = dirty_blocks.find(new_size / block_size);
+            if (it != dirty_blocks.end()) {
+                const size_t end = static_cast<size_t>(new_size % block_size);
+                std::fill(it->second.begin() + end, it->second.end(), 0);
+            }
+        }
+        host_valid_size = std::min(host_valid_size, new_size);
+    }
+
+    size = new_size;
+    dirty = true;
+}
+
+bool WriteBackFile::HasUncommittedData() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dirty;
+}
+
+bool WriteBackFile::CommitAll(const std::vector<WriteBackFile*>& files) {
+    // Callers pass the files in the same order, the order of their paths, so this can not deadlock
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(files.size());
+    for (WriteBackFile* file : files)
+        locks.emplace_back(file->mutex);
+
+    std::vector<WriteBackFile*> atomic_files;
+    std::vector<WriteBackFile*> in_place_files;
+    for (WriteBackFile* file : files) {
+        if (file->discarded || !file->dirty)
+            continue;
+        if (file->size > max_atomic_commit_size)
+            in_place_files.push_back(file);
+        else
+            atomic_files.push_back(file);
+    }
+
+    for (auto it = atomic_files.begin(); it != atomic_files.end(); ++it) {
+        if (!(*it)->WriteTempFile()) {
+            // Leave every file as it was
+            for (auto written = atomic_files.begin(); written != it; ++written)
+                FileUtil::Delete((*written)->path + temp_suffix);
+            return false;
+        }
+    }
+
+    bool committed = true;
+    for (WriteBackFile* file : atomic_files) {
+        if (file->ReplaceWithTempFile())
+            file->dirty = false;
+        else
+            committed = false;
+    }
+    // These can not be rolled back, so they go last
+    for (WriteBackFile* file : in_place_files) {
+        if (file->CommitInPlace())
+            file->dirty = false;
+        else
+            committed = false;
+    }
+    return committed;
+}
+
+bool WriteBackFile::CommitAtomic() {
+    return WriteTempFile() && ReplaceWithTempFile();
+}
+
+bool WriteBackFile::WriteTempFile() {
+    const std::string temp_path = path + temp_suffix;
+
+    FileUtil::IOFile temp(temp_path, "wb");
+    if (!temp.IsOpen()) {
+        LOG_ERROR(Service_FS, "Could not create %s", temp_path.c_str());
+        return false;
+    }
+
+    std::vector<u8> chunk(copy_chunk_size);
+    bool written = true;
+    for (u64 offset = 0; offset < size && written; offset += copy_chunk_size) {
+        const size_t length = static_cast<size_t>(std::min<u64>(copy_chunk_size, size - offset));
+        // Read takes the lock, so do its work here
+        size_t done = 0;
+        while (done < length) {
+            const u64 position = offset + done;
+            const u64 block = position / block_size;
+            const size_t piece = std::min(length - done, block_size);
+            const auto it = dirty_blocks.find(block);
+            if (it != dirty_blocks.end())
+                std::memcpy(chunk.data() + done, it->second.data(), piece);
+            else
+                ReadHost(position, piece, chunk.data() + done);
+            done += piece;
+        }
+        written = temp.WriteBytes(chunk.data(), length) == length;
+    }
+    written = written && temp.Close();
+
+    if (!written) {
+        LOG_ERROR(Service_FS, "Could not write %s", temp_path.c_str());
+        FileUtil::Delete(temp_path);
+        return false;
+    }
+    return true;
+}
+
+bool WriteBackFile::ReplaceWithTempFile() {
+    const std::string temp_path = path + temp_suffix;
+
+    // Some hosts can not replace a file that is open
+    file.Close();
+    const bool renamed = FileUtil::RenameReplacing(temp_path, path);
+    if (!renamed)
+        FileUtil::Delete(temp_path);
+
+    file.Open(path, "rb");
+    HostMetadataCache::Invalidate(path);
+    SystemArchiveCache::Invalidate(path);
+    if (!renamed)
+        return false;
+
+    dirty_blocks.clear();
+    host_valid_size = size;
+    return true;
+}
+
+bool WriteBackFile::CommitInPlace() {
+    FileUtil::IOFile out(path, "r+b");
+    if (!out.IsOpen()) {
+        LOG_ERROR(Service_FS, "Could not open %s for writing", path.c_str());
+        return false;
+    }
+
+    // Remove whatever SetSize cut off, so that it reads as zeroes if the file grew again
+    bool written = true;
+    if (out.GetSize() > host_valid_size)
+        written = out.Resize(host_valid_size);
+
+    for (auto it = dirty_blocks.begin(); it != dirty_blocks.end() && written; ++it) {
+        const u64 offset = it->first * block_size;
+        const size_t length = static_cast<size_t>(std::min<u64>(block_size, size - offset));
+        written = out.Seek(offset, SEEK_SET) && out.WriteBytes(it->second.data(), length) == length;
+    }
+    // Flush before resizing, as the file is truncated underneath the stdio buffer
+    written = written && out.Flush() && out.Resize(size) && out.Close();
+
+    // Reopen to drop any data the read handle has buffered
+    file.Close();
+    file.Open(path, "rb");
+    HostMetadataCache::Invalidate(path);
+    SystemArchiveCache::Invalidate(path);
+
+    if (!written) {
+        // The blocks that were written are still dirty, so the next commit writes them again
+        LOG_ERROR(Service_FS, "Could not write %s", path.c_str());
+        return false;
+    }
+
+    dirty_blocks.clear();
+    host_valid_size = size;
+    return true;
+}
+
+void WriteBackFile::Discard() {
+    std::lock_guard<std::mutex> lock(mutex);
+    discarded = true;
+    dirty = false;
+    dirty_blocks.clear();
+}
+
+void WriteBackFile::SetPath(std::string new_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    path = std::move(new_path);
+}
+
+namespace WriteBackCache {
+
+namespace {
+
+std::mutex registry_mutex;
+/// Files stay in here while they have handles or uncommitted data
+std::map<std::string, std::shared_ptr<WriteBackFile>> open_files;
+
+/// Whether file_path is path, or is in the directory path.
+bool IsAtOrUnder(const std::string& file_path, const std::string& path) {
+    if (file_path.compare(0, path.size(), path) != 0)
+        return false;
+    return file_path.size() == path.size() || path.back() == '/' || file_path[path.size()] == '/';
+}
+
+/// Returns the files at or under a path, in the order of their paths. registry_mutex must be held.
+std::vector<std::pair<std::string, std::shared_ptr<WriteBackFile>>> FindFiles(
+    const std::string& path) {
+    std::vector<std::pair<std::string, std::shared_ptr<WriteBackFile>>> files;
+    // The paths under a directory sort right after it
+    for (auto it = open_files.lower_bound(path);
+         it != open_files.end() && it->first.compare(0, path.size(), path) == 0; ++it) {
+        if (IsAtOrUnder(it->first, path))
+            files.emplace_back(*it);
+    }
+    return files;
+}
+
+/// Whether a file can be dropped from the registry. registry_mutex must be held, so that no new
+/// handle to the file can be made meanwhile.
+bool IsUnused(const std::shared_ptr<WriteBackFile>& file) {
+    return file.use_count() == 1 && !file->HasUncommittedData();
+}
+
+} // Anonymous namespace
+
+std::shared_ptr<WriteBackFile> Open(const std::string& path, FileUtil::IOFile&& file) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    auto& entry = open_files[path];
+    if (entry)
+        return entry;
+
+    // Forget the files that have been closed and committed since
+    for (auto it = open_files.begin(); it != open_files.end();) {
+        if (it->second && IsUnused(it->second))
+            it = open_files.erase(it);
+        else
+            ++it;
+    }
+
+    entry = std::make_shared<WriteBackFile>(path, std::move(file));
+    return entry;
+}
+
+bool Commit(const std::string& path) {
+    std::unique_lock<std::mutex> lock(registry_mutex);
+    auto found = FindFiles(path);
+    lock.unlock();
+
+    std::vector<WriteBackFile*> files;
+    files.reserve(found.size());
+    for (const auto& file : found)
+        files.push_back(file.second.get());
+    const bool committed = WriteBackFile::CommitAll(files);
+    found.clear();
+
+    // Forget the committed files that have no handles left
+    lock.lock();
+    for (auto it = open_files.lower_bound(path);
+         it != open_files.end() && it->first.compare(0, path.size(), path) == 0;) {
+        if (IsAtOrUnder(it->first, path) && IsUnused(it->second))
+            it = open_files.erase(it);
+        else
+            ++it;
+    }
+    return committed;
+}
+
+void Discard(const std::string& path) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto& file : FindFiles(path)) {
+        file.second->Discard();
+        // A file created at the same path later on is a new one
+        open_files.erase(file.first);
+    }
+}
+
+bool IsCommitTempName(const std::string& name) {
+    const size_t suffix_length = sizeof(temp_suffix) - 1;
+    return name.size() > suffix_length &&
+           name.compare(name.size() - suffix_length, suffix_length, temp_suffix) == 0;
+}
+
+void Rename(const std::string& src_path, const std::string& dest_path) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto& file : FindFiles(src_path)) {
+        std::string new_path = dest_path + file.first.substr(src_path.size());
+        file.second->SetPath(new_path);
+        open_files.erase(file.first);
+        open_files[std::move(new_path)] = file.second;
+    }
+}
+
+} // namespace WriteBackCache
+
+} // namespace FileSys
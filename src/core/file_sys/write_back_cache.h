@@ -0,0 +1,128 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// FileSys namespace
+
+namespace FileSys {
+
+/**
+ * A host file whose writes are kept in memory, in blocks, until they are committed. Many small
+ * writes then turn into a single host write, and flushes requested by the guest cost nothing.
+ *
+ * A commit writes the new contents under a temporary name and renames that over the file, so the
+ * file on the host always holds the contents of either the previous or the latest commit, even if
+ * the emulator crashes while committing. Files larger than max_atomic_commit_size are updated in
+ * place instead, because copying them would take too long.
+ *
+ * The files of an archive are committed together, when it is closed or the guest commits it, see
+ * CommitAll. All the handles to a host file share one WriteBackFile, see WriteBackCache.
+ * Thread-safe.
+ */
+class WriteBackFile {
+public:
+    static constexpr size_t block_size = 0x1000;
+    /// Files up to this size are committed atomically
+    static constexpr u64 max_atomic_commit_size = 32 * 1024 * 1024;
+    /// Uncommitted data is committed once it grows past this size
+    static constexpr size_t max_dirty_size = 16 * 1024 * 1024;
+
+    /**
+     * @param path Path of the file on the host
+     * @param file The file, opened for reading
+     */
+    WriteBackFile(std::string path, FileUtil::IOFile&& file);
+
+    size_t Read(u64 offset, size_t length, u8* buffer);
+    size_t Write(u64 offset, size_t length, const u8* buffer);
+    u64 GetSize();
+    void SetSize(u64 size);
+
+    /// Whether the file has changes that are not on the host yet.
+    bool HasUncommittedData();
+
+    /**
+     * Writes the uncommitted data of several files to the host. The new contents of every file are
+     * written under their temporary names before any of them is renamed into place, so a failure
+     * to write one leaves all the files as they were.
+     * @returns true on success, or if there was nothing to commit. The data is kept on failure.
+     */
+    static bool CommitAll(const std::vector<WriteBackFile*>& files);
+
+    /// Drops the uncommitted data and ignores all later writes, as the file has been deleted.
+    void Discard();
+
+    /// Follows the file to a new path, after it was renamed on the host.
+    void SetPath(std::string new_path);
+
+private:
+    /// Reads from the host file, returning zeroes past the part of it that is still valid.
+    void ReadHost(u64 offset, size_t length, u8* buffer);
+    bool CommitAtomic();
+    bool CommitInPlace();
+    /// First half of an atomic commit, writes the new contents to the temporary file.
+    bool WriteTempFile();
+    /// Second half of an atomic commit, renames the temporary file over the file.
+    bool ReplaceWithTempFile();
+
+    std::mutex mutex;
+    std::string path;
+    FileUtil::IOFile file;
+
+    /// Size of the file, including uncommitted changes
+    u64 size;
+    /// Size of the start of the host file that still holds valid data, which shrinks when the
+    /// file is truncated
+    u64 host_valid_size;
+    /// Uncommitted blocks, by index
+    std::map<u64, std::vector<u8>> dirty_blocks;
+    bool dirty = false;
+    bool discarded = false;
+};
+
+/**
+ * Keeps track of the WriteBackFiles, so that every handle to a host file uses the same one, no
+ * matter which archive object opened it. Files with uncommitted data are kept after their last
+ * handle is closed, until their archive commits them. Paths are host paths, and functions that
+ * take one also apply to every file under it if it is a directory.
+ */
+namespace WriteBackCache {
+
+/**
+ * Returns the WriteBackFile of a host file.
+ * @param file The file opened for reading, used if it is not open in the cache yet
+ */
+std::shared_ptr<WriteBackFile> Open(const std::string& path, FileUtil::IOFile&& file);
+
+/**
+ * Commits the files at or under a path, including the ones whose handles were all closed since
+ * they were last committed. Returns false if any of them failed.
+ */
+bool Commit(const std::string& path);
+
+/// Drops the uncommitted data of files that were deleted.
+void Discard(const std::string& path);
+
+/// Updates the paths of open files after they were renamed on the host.
+void Rename(const std::string& src_path, const std::string& dest_path);
+
+/**
+ * Whether a host file name is that of the temporary file of a commit. A crash while committing can
+ * leave one behind; they are hidden from the guest, which can not use such names either.
+ */
+bool IsCommitTempName(const std::string& name);
+
+} // namespace WriteBackCache
+
+} // namespace FileSys
@@ -0,0 +1,184 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <utility>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/hle/call_profiler.h"
+
+namespace HLE {
+namespace CallProfiler {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+/// Upper bound of the first latency bucket, as a power of two
+constexpr u32 first_bucket_bits = 8;
+
+struct CallEntry {
+    std::string name;
+    u64 count = 0;
+    u64 total_ns = 0;
+    u64 max_ns = 0;
+    std::array<u64, num_latency_buckets> histogram{};
+};
+
+/// Orders keys by group, then id, and allows looking them up without copying the group name.
+struct KeyLess {
+    using is_transparent = void;
+
+    template <typename A, typename B>
+    bool operator()(const A& a, const B& b) const {
+        return std::tie(a.first, a.second) < std::tie(b.first, b.second);
+    }
+};
+
+std::mutex stats_mutex;
+std::map<std::pair<std::string, u32>, CallEntry, KeyLess> call_entries;
+
+size_t GetBucket(u64 duration_ns) {
+    size_t bucket = 0;
+    for (u64 limit = u64(1) << first_bucket_bits;
+         duration_ns >= limit && bucket < num_latency_buckets - 1; limit <<= 1) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::string EscapeJson(const std::string& string) {
+    std::string escaped;
+    escaped.reserve(string.size());
+    for (char c : string) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += fmt::format("\\u{:04x}", c);
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/// Quotes a CSV field if it holds a separator, quote or line break.
+std::string EscapeCsv(const std::string& string) {
+    if (string.find_first_of(",\"\r\n") == std::string::npos)
+        return string;
+
+    std::string escaped = "\"";
+    for (char c : string) {
+        if (c == '"')
+            escaped += '"';
+        escaped += c;
+    }
+    escaped += '"';
+    return escaped;
+}
+
+} // Anonymous namespace
+
+u64 GetBucketLimitNs(size_t bucket) {
+    if (bucket >= num_latency_buckets - 1)
+        return UINT64_MAX;
+    return u64(1) << (first_bucket_bits + bucket);
+}
+
+void SetEnabled(bool enabled) {
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void RecordCall(const std::string& group, u32 id, const char* name, u64 duration_ns) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+
+    auto it = call_entries.find(std::pair<const std::string&, u32>(group, id));
+    if (it == call_entries.end()) {
+        it = call_entries.emplace(std::make_pair(group, id), CallEntry{}).first;
+        it->second.name = name;
+    }
+
+    CallEntry& entry = it->second;
+    entry.count++;
+    entry.total_ns += duration_ns;
+    entry.max_ns = std::max(entry.max_ns, duration_ns);
+    entry.histogram[GetBucket(duration_ns)]++;
+}
+
+std::vector<CallStats> GetStats() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+
+    std::vector<CallStats> stats;
+    stats.reserve(call_entries.size());
+    for (const auto& pair : call_entries) {
+        const CallEntry& entry = pair.second;
+        stats.push_back({pair.first.first, entry.name, pair.first.second, entry.count,
+                         entry.total_ns, entry.max_ns, entry.histogram});
+    }
+    return stats;
+}
+
+void Reset() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    call_entries.clear();
+}
+
+std::string FormatJson(const std::vector<CallStats>& stats) {
+    fmt::memory_buffer buf;
+    fmt::format_to(buf, "[");
+    for (size_t i = 0; i < stats.size(); ++i) {
+        const CallStats& call = stats[i];
+        fmt::format_to(buf,
+                       "{}\n  {{\"group\": \"{}\", \"name\": \"{}\", \"id\": {}, \"count\": {}, "
+                       "\"total_ns\": {}, \"max_ns\": {}, \"histogram\": [",
+                       i == 0 ? "" : ",", EscapeJson(call.group), EscapeJson(call.name), call.id,
+                       call.count, call.total_ns, call.max_ns);
+        for (size_t bucket = 0; bucket < num_latency_buckets; ++bucket) {
+            fmt::format_to(buf, "{}{}", bucket == 0 ? "" : ", ", call.histogram[bucket]);
+        }
+        fmt::format_to(buf, "]}}");
+    }
+    fmt::format_to(buf, "\n]\n");
+    return fmt::to_string(buf);
+}
+
+std::string FormatCsv(const std::vector<CallStats>& stats) {
+    fmt::memory_buffer buf;
+    fmt::format_to(buf, "group,name,id,count,total_ns,max_ns");
+    for (size_t bucket = 0; bucket < num_latency_buckets - 1; ++bucket) {
+        fmt::format_to(buf, ",lt_{}ns", GetBucketLimitNs(bucket));
+    }
+    fmt::format_to(buf, ",ge_{}ns\n", GetBucketLimitNs(num_latency_buckets - 2));
+
+    for (const CallStats& call : stats) {
+        fmt::format_to(buf, "{},{},{:#010x},{},{},{}", EscapeCsv(call.group),
+                       EscapeCsv(call.name), call.id, call.count, call.total_ns, call.max_ns);
+        for (u64 count : call.histogram) {
+            fmt::format_to(buf, ",{}", count);
+        }
+        fmt::format_to(buf, "\n");
+    }
+    return fmt::to_string(buf);
+}
+
+bool DumpToFile(const std::string& path) {
+    const std::vector<CallStats> stats = GetStats();
+    const bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    const std::string contents = csv ? FormatCsv(stats) : FormatJson(stats);
+
+    if (FileUtil::WriteStringToFile(true, contents, path.c_str()) != contents.size()) {
+        NGLOG_ERROR(Kernel, "Could not write the HLE call profile to {}", path);
+        return false;
+    }
+    NGLOG_INFO(Kernel, "Wrote the profile of {} HLE calls to {}", stats.size(), path);
+    return true;
+}
+
+} // namespace CallProfiler
+} // namespace HLE
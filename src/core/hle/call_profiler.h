@@ -0,0 +1,118 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace HLE {
+
+/**
+ * Counts and times the calls made into HLE code: IPC commands handled by HLE services, and SVCs.
+ * This shows which services dominate the CPU time spent in HLE for a given title.
+ *
+ * Profiling is off by default. While it is off, the cost of a call site is a single relaxed
+ * atomic load.
+ */
+namespace CallProfiler {
+
+/// Number of buckets in the latency histogram of each call
+constexpr size_t num_latency_buckets = 16;
+
+/**
+ * Returns the exclusive upper bound of a latency histogram bucket in nanoseconds. Bucket 0 holds
+ * calls shorter than 256 ns and each bucket after it is twice as wide. The last bucket has no
+ * upper bound.
+ */
+u64 GetBucketLimitNs(size_t bucket);
+
+struct CallStats {
+    /// Name of the service handling the command, or "SVC"
+    std::string group;
+    /// Name of the command or SVC
+    std::string name;
+    /// Command header code, or SVC number
+    u32 id;
+    /// Number of calls
+    u64 count;
+    /// Total time spent in the calls
+    u64 total_ns;
+    /// Time spent in the longest call
+    u64 max_ns;
+    /// Number of calls whose duration fell into each bucket, see GetBucketLimitNs
+    std::array<u64, num_latency_buckets> histogram;
+};
+
+extern std::atomic<bool> g_enabled;
+
+inline bool IsEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+/// Starts or stops recording calls. Collected statistics are kept when recording stops.
+void SetEnabled(bool enabled);
+
+/**
+ * Adds a call to the statistics.
+ * @param group Name of the service, or "SVC"
+ * @param id Command header code or SVC number
+ * @param name Name of the command or SVC
+ * @param duration_ns Duration of the call
+ */
+void RecordCall(const std::string& group, u32 id, const char* name, u64 duration_ns);
+
+/// Returns the statistics of all calls recorded so far, sorted by group and id.
+std::vector<CallStats> GetStats();
+
+/// Discards all statistics.
+void Reset();
+
+/// Formats the statistics as a JSON array with one object per call.
+std::string FormatJson(const std::vector<CallStats>& stats);
+
+/// Formats the statistics as CSV, with a header row and one row per call.
+std::string FormatCsv(const std::vector<CallStats>& stats);
+
+/**
+ * Writes the current statistics to a file, formatted as CSV if the path ends with ".csv" and as
+ * JSON otherwise.
+ * @returns true on success
+ */
+bool DumpToFile(const std::string& path);
+
+/// Times a call for the duration of the object, if profiling was enabled when it was created.
+class ScopedCall {
+public:
+    ScopedCall(const std::string& group, u32 id, const char* name)
+        : group(group), id(id), name(name), active(IsEnabled()) {
+        if (active)
+            start = std::chrono::steady_clock::now();
+    }
+
+    ~ScopedCall() {
+        if (active) {
+            const auto duration = std::chrono::steady_clock::now() - start;
+            RecordCall(group, id, name,
+                       std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        }
+    }
+
+    ScopedCall(const ScopedCall&) = delete;
+    ScopedCall& operator=(const ScopedCall&) = delete;
+
+private:
+    const std::string& group;
+    u32 id;
+    const char* name;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace CallProfiler
+} // namespace HLE
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <mutex>
 #include <vector>
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -11,9 +12,64 @@
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
+#include "core/memory.h"
 
 namespace Kernel {
 
+/// Number of buffers kept around for reuse
+constexpr size_t max_pooled_ipc_buffers = 8;
+/// Larger buffers are freed rather than pooled, so that a single huge request doesn't pin memory
+constexpr size_t max_pooled_ipc_buffer_size = 8 * 1024 * 1024;
+
+static std::mutex ipc_buffer_pool_mutex;
+static std::vector<std::vector<u8>> ipc_buffer_pool;
+
+std::vector<u8> AcquireIPCBuffer(size_t size) {
+    std::vector<u8> buffer;
+    {
+        std::lock_guard<std::mutex> lock(ipc_buffer_pool_mutex);
+
+        // Take the smallest buffer that fits, or if none does, the largest one to grow
+        auto best = ipc_buffer_pool.end();
+        for (auto it = ipc_buffer_pool.begin(); it != ipc_buffer_pool.end(); ++it) {
+            if (best == ipc_buffer_pool.end()) {
+                best = it;
+            } else if (it->capacity() >= size) {
+                if (best->capacity() < size || it->capacity() < best->capacity())
+                    best = it;
+            } else if (best->capacity() < size && it->capacity() > best->capacity()) {
+                best = it;
+            }
+        }
+        if (best != ipc_buffer_pool.end()) {
+            buffer = std::move(*best);
+            ipc_buffer_pool.erase(best);
+        }
+    }
+
+    buffer.resize(size);
+    return buffer;
+}
+
+void ReleaseIPCBuffer(std::vector<u8> buffer) {
+    if (buffer.capacity() == 0 || buffer.capacity() > max_pooled_ipc_buffer_size)
+        return;
+
+    std::lock_guard<std::mutex> lock(ipc_buffer_pool_mutex);
+    if (ipc_buffer_pool.size() < max_pooled_ipc_buffers) {
+        ipc_buffer_pool.push_back(std::move(buffer));
+        return;
+    }
+
+    // Keep the larger buffers, they are the expensive ones to allocate
+    auto smallest = std::min_element(
+        ipc_buffer_pool.begin(), ipc_buffer_pool.end(),
+        [](const auto& a, const auto& b) { return a.capacity() < b.capacity(); });
+    if (smallest->capacity() < buffer.capacity()) {
+        *smallest = std::move(buffer);
+    }
+}
+
 SessionRequestHandler::SessionInfo::SessionInfo(SharedPtr<ServerSession> session,
                                                 std::unique_ptr<SessionDataBase> data)
     : session(std::move(session)), data(std::move(data)) {}
@@ -71,7 +127,11 @@ HLERequestContext::HLERequestContext(SharedPtr<ServerSession> session)
     cmd_buf[0] = 0;
 }
 
-HLERequestContext::~HLERequestContext() = default;
+HLERequestContext::~HLERequestContext() {
+    for (auto& buffer : static_buffers) {
+        ReleaseIPCBuffer(std::move(buffer));
+    }
+}
 
 SharedPtr<Object> HLERequestContext::GetIncomingHandle(u32 id_from_cmdbuf) const {
     ASSERT(id_from_cmdbuf < request_handles.size());
@@ -92,6 +152,7 @@ const std::vector<u8>& HLERequestContext::GetStaticBuffer(u8 buffer_id) const {
 }
 
 void HLERequestContext::AddStaticBuffer(u8 buffer_id, std::vector<u8> data) {
+    ReleaseIPCBuffer(std::move(static_buffers[buffer_id]));
     static_buffers[buffer_id] = std::move(data);
 }
 
@@ -140,7 +201,7 @@ ResultCode HLERequestContext::PopulateFromIncomingCommandBuffer(const u32_le* sr
             IPC::StaticBufferDescInfo buffer_info{descriptor};
 
             // Copy the input buffer into our own vector and store it.
-            std::vector<u8> data(buffer_info.size);
+            std::vector<u8> data = AcquireIPCBuffer(buffer_info.size);
             Memory::ReadBlock(src_process, source_address, data.data(), data.size());
 
             AddStaticBuffer(buffer_info.buffer_id, std::move(data));
@@ -249,4 +310,10 @@ void MappedBuffer::Write(const void* src_buffer, size_t offset, size_t size) {
     Memory::WriteBlock(*process, address + offset, src_buffer, size);
 }
 
+const u8* MappedBuffer::GetDirectReadPointer(size_t offset, size_t size) const {
+    ASSERT(perms & IPC::R);
+    ASSERT(offset + size <= this->size);
+    return Memory::GetContiguousPointer(*process, address + static_cast<VAddr>(offset), size);
+}
+
 } // namespace Kernel
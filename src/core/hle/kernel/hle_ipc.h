@@ -93,6 +93,38 @@ protected:
     std::vector<SessionInfo> connected_sessions;
 };
 
+/**
+ * Returns a buffer of `size` bytes with unspecified contents, reusing the storage of a buffer
+ * previously released to the pool when possible. Used for data passing through HLE requests, so
+ * that streaming transfers don't allocate and fault in new memory on every request.
+ */
+std::vector<u8> AcquireIPCBuffer(size_t size);
+
+/// Returns the storage of a buffer to the pool used by AcquireIPCBuffer.
+void ReleaseIPCBuffer(std::vector<u8> buffer);
+
+/// Byte buffer borrowed from the IPC buffer pool for the lifetime of the object.
+class PooledIPCBuffer {
+public:
+    explicit PooledIPCBuffer(size_t size) : buffer(AcquireIPCBuffer(size)) {}
+    ~PooledIPCBuffer() {
+        ReleaseIPCBuffer(std::move(buffer));
+    }
+
+    PooledIPCBuffer(const PooledIPCBuffer&) = delete;
+    PooledIPCBuffer& operator=(const PooledIPCBuffer&) = delete;
+
+    u8* data() {
+        return buffer.data();
+    }
+    size_t size() const {
+        return buffer.size();
+    }
+
+private:
+    std::vector<u8> buffer;
+};
+
 class MappedBuffer {
 public:
     MappedBuffer(const Process& process, u32 descriptor, VAddr address, u32 id);
@@ -104,6 +136,13 @@ public:
         return size;
     }
 
+    /**
+     * Gets a pointer through which part of the buffer can be read directly, without copying it out
+     * first. Returns nullptr if that part isn't contiguous in host memory, in which case Read must
+     * be used.
+     */
+    const u8* GetDirectReadPointer(size_t offset, size_t size) const;
+
     // interface for ipc helper
     u32 GenerateDescriptor() const {
         return IPC::MappedBufferDesc(size, perms);
@@ -237,7 +276,8 @@ private:
     SharedPtr<ServerSession> session;
     // TODO(yuriks): Check common usage of this and optimize size accordingly
     boost::container::small_vector<SharedPtr<Object>, 8> request_handles;
-    // The static buffers will be created when the IPC request is translated.
+    // The static buffers will be created when the IPC request is translated. Their storage comes
+    // from the IPC buffer pool.
     std::array<std::vector<u8>, IPC::MAX_STATIC_BUFFERS> static_buffers;
     // The mapped buffers will be created when the IPC request is translated
     boost::container::small_vector<MappedBuffer, 8> request_mapped_buffers;
@@ -11,6 +11,7 @@
 #include "common/string_util.h"
 #include "core/arm/arm_interface.h"
 #include "core/core_timing.h"
+#include "core/hle/call_profiler.h"
 #include "core/hle/function_wrappers.h"
 #include "core/hle/kernel/address_arbiter.h"
 #include "core/hle/kernel/client_port.h"
@@ -1406,6 +1407,8 @@ void CallSVC(u32 immediate) {
     const FunctionDef* info = GetSVCInfo(immediate);
     if (info) {
         if (info->func) {
+            static const std::string profile_group = "SVC";
+            HLE::CallProfiler::ScopedCall profile(profile_group, immediate, info->name);
             info->func();
         } else {
             LOG_ERROR(Kernel_SVC, "unimplemented SVC function %s(..)", info->name);
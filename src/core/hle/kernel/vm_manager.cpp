@@ -58,6 +58,7 @@ void VMManager::Reset() {
 
     page_table.pointers.fill(nullptr);
     page_table.attributes.fill(Memory::PageType::Unmapped);
+    page_table.cached_page_counts.fill(0);
 
     UpdatePageTableForVMA(initial_vma);
 }
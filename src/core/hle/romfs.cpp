@@ -3,7 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <unordered_set>
+#include <utility>
+#include "common/logging/log.h"
+#include "common/string_util.h"
 #include "common/swap.h"
+#include "core/file_sys/file_backend.h"
 #include "core/hle/romfs.h"
 
 namespace RomFS {
@@ -47,6 +52,8 @@ struct FileMetadata {
 
 static_assert(sizeof(FileMetadata) == 0x20, "FileMetadata has incorrect size");
 
+constexpr u32 INVALID_FIELD = 0xFFFFFFFF;
+
 static bool MatchName(const u8* buffer, u32 name_length, const std::u16string& name) {
     std::vector<char16_t> name_buffer(name_length / sizeof(char16_t));
     std::memcpy(name_buffer.data(), buffer, name_length);
@@ -54,8 +61,6 @@ static bool MatchName(const u8* buffer, u32 name_length, const std::u16string& n
 }
 
 const u8* GetFilePointer(const u8* romfs, const std::vector<std::u16string>& path) {
-    constexpr u32 INVALID_FIELD = 0xFFFFFFFF;
-
     // Split path into directory names and file name
     std::vector<std::u16string> dir_names = path;
     dir_names.pop_back();
@@ -99,4 +104,185 @@ const u8* GetFilePointer(const u8* romfs, const std::vector<std::u16string>& pat
     return nullptr;
 }
 
+namespace {
+
+/// Reads an entry with its name from a metadata table, or returns false if it does not fit.
+template <typename Metadata>
+bool ReadEntry(const std::vector<u8>& table, u32 offset, Metadata& entry, std::u16string& name) {
+    if (offset > table.size() || table.size() - offset < sizeof(Metadata))
+        return false;
+    std::memcpy(&entry, table.data() + offset, sizeof(Metadata));
+    const size_t name_offset = offset + sizeof(Metadata);
+    if (entry.name_length % sizeof(char16_t) != 0 || table.size() - name_offset < entry.name_length)
+        return false;
+    name.resize(entry.name_length / sizeof(char16_t));
+    std::memcpy(&name[0], table.data() + name_offset, entry.name_length);
+    return true;
+}
+
+/// Splits a UTF-8 path with '/' separators into its UTF-16 components.
+std::vector<std::u16string> SplitPath(const std::string& path) {
+    std::vector<std::string> components;
+    Common::SplitString(path, '/', components);
+    std::vector<std::u16string> result;
+    for (const std::string& component : components) {
+        if (!component.empty())
+            result.push_back(Common::UTF8ToUTF16(component));
+    }
+    return result;
+}
+
+} // Anonymous namespace
+
+size_t Index::EntryKeyHash::operator()(const EntryKey& key) const {
+    // The hash the format uses for its own hash tables
+    u32 hash = key.parent ^ 123456789;
+    for (char16_t c : key.name)
+        hash = ((hash >> 5) | (hash << 27)) ^ c;
+    return hash;
+}
+
+bool Index::Load(const u8* image, size_t size) {
+    return Load(size, [image](u64 offset, size_t length, u8* buffer) {
+        std::memcpy(buffer, image + offset, length);
+        return true;
+    });
+}
+
+bool Index::Load(const FileSys::FileBackend& image) {
+    return Load(image.GetSize(), [&image](u64 offset, size_t length, u8* buffer) {
+        const auto read = image.Read(offset, length, buffer);
+        return read.Succeeded() && *read == length;
+    });
+}
+
+bool Index::Load(u64 size, const std::function<bool(u64, size_t, u8*)>& read) {
+    *this = Index();
+
+    Header header;
+    if (size < sizeof(header) || !read(0, sizeof(header), reinterpret_cast<u8*>(&header)))
+        return false;
+    if (header.header_length != sizeof(Header)) {
+        LOG_ERROR(Service_FS, "Invalid RomFS header");
+        return false;
+    }
+
+    // Only the two metadata tables are read, the hash tables are not needed
+    const auto read_table = [&](u32 offset, u32 length) {
+        std::vector<u8> table;
+        if (offset > size || size - offset < length)
+            return table;
+        table.resize(length);
+        if (!read(offset, length, table.data()))
+            table.clear();
+        return table;
+    };
+    if (!Parse(header.data_offset, read_table(header.dir_table_offset, header.dir_table_length),
+               read_table(header.file_table_offset, header.file_table_length)))
+        return false;
+
+    for (const File& file : files) {
+        if (file.data_offset > size || size - file.data_offset < file.data_length) {
+            LOG_ERROR(Service_FS, "RomFS file data is out of bounds");
+            *this = Index();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Index::Parse(u32 data_offset, const std::vector<u8>& dir_table,
+                  const std::vector<u8>& file_table) {
+    const auto fail = [this](const char* what) {
+        LOG_ERROR(Service_FS, "Invalid RomFS %s table", what);
+        *this = Index();
+        return false;
+    };
+
+    // Walk the tree from the root, which is the first directory of the table. Every entry is
+    // visited once; an offset seen twice means the image has a loop.
+    std::unordered_set<u32> directory_offsets{0};
+    std::unordered_set<u32> file_offsets;
+    std::vector<std::pair<u32, u32>> pending{{0, root}};
+    DirectoryMetadata dir;
+    std::u16string name;
+    if (!ReadEntry(dir_table, 0, dir, name))
+        return fail("directory");
+    directories.push_back({root, std::move(name), {}, {}});
+
+    while (!pending.empty()) {
+        const u32 offset = pending.back().first;
+        const u32 index = pending.back().second;
+        pending.pop_back();
+        if (!ReadEntry(dir_table, offset, dir, name))
+            return fail("directory");
+
+        for (u32 child = dir.first_child_dir_offset; child != INVALID_FIELD;) {
+            DirectoryMetadata child_dir;
+            if (!ReadEntry(dir_table, child, child_dir, name) ||
+                !directory_offsets.insert(child).second)
+                return fail("directory");
+            const u32 child_index = static_cast<u32>(directories.size());
+            directories[index].directories.push_back(child_index);
+            directory_lookup.emplace(EntryKey{index, name}, child_index);
+            directories.push_back({index, std::move(name), {}, {}});
+            pending.emplace_back(child, child_index);
+            child = child_dir.next_dir_offset;
+        }
+
+        for (u32 file_offset = dir.first_file_offset; file_offset != INVALID_FIELD;) {
+            FileMetadata file;
+            if (!ReadEntry(file_table, file_offset, file, name) ||
+                !file_offsets.insert(file_offset).second)
+                return fail("file");
+            const u64 file_data_offset = data_offset + file.data_offset;
+            if (file_data_offset < data_offset)
+                return fail("file");
+            const u32 file_index = static_cast<u32>(files.size());
+            directories[index].files.push_back(file_index);
+            file_lookup.emplace(EntryKey{index, name}, file_index);
+            files.push_back({index, std::move(name), file_data_offset, file.data_length});
+            file_offset = file.next_file_offset;
+        }
+    }
+    return true;
+}
+
+s64 Index::WalkDirectories(std::vector<std::u16string>::const_iterator begin,
+                           std::vector<std::u16string>::const_iterator end) const {
+    if (!IsLoaded())
+        return -1;
+    u32 current = root;
+    for (auto it = begin; it != end; ++it) {
+        const auto child = directory_lookup.find({current, *it});
+        if (child == directory_lookup.end())
+            return -1;
+        current = child->second;
+    }
+    return current;
+}
+
+const Index::File* Index::FindFile(const std::vector<std::u16string>& path) const {
+    if (path.empty())
+        return nullptr;
+    const s64 parent = WalkDirectories(path.begin(), path.end() - 1);
+    if (parent < 0)
+        return nullptr;
+    const auto file = file_lookup.find({static_cast<u32>(parent), path.back()});
+    return file == file_lookup.end() ? nullptr : &files[file->second];
+}
+
+const Index::Directory* Index::FindDirectory(const std::vector<std::u16string>& path) const {
+    const s64 index = WalkDirectories(path.begin(), path.end());
+    return index < 0 ? nullptr : &directories[index];
+}
+
+const Index::File* Index::FindFile(const std::string& path) const {
+    return FindFile(SplitPath(path));
+}
+
+const Index::Directory* Index::FindDirectory(const std::string& path) const {
+    return FindDirectory(SplitPath(path));
+}
+
 } // namespace RomFS
@@ -4,10 +4,16 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
 
+namespace FileSys {
+class FileBackend;
+} // namespace FileSys
+
 namespace RomFS {
 
 /**
@@ -15,8 +21,105 @@ namespace RomFS {
  * @param romfs The pointer to the RomFS image
  * @param path A vector containing the directory names and file name of the path to the file
  * @return the pointer to the file
- * @todo reimplement this with a full RomFS manager
+ * @note This walks the entries of every directory in the path. Use an Index to look up more than
+ *       one file in the same image.
  */
 const u8* GetFilePointer(const u8* romfs, const std::vector<std::u16string>& path);
 
+/**
+ * The directory tree of a RomFS level 3 image, parsed once so that paths are found with a hash
+ * lookup per path component instead of by walking the entries. Only the metadata is kept, file
+ * contents are still read from the image.
+ */
+class Index {
+public:
+    struct Directory {
+        u32 parent; ///< Index of the parent directory, the root is its own parent
+        std::u16string name;
+        std::vector<u32> directories; ///< Indices of the child directories, in image order
+        std::vector<u32> files;       ///< Indices of the files, in image order
+    };
+
+    struct File {
+        u32 parent;
+        std::u16string name;
+        u64 data_offset; ///< Offset of the contents from the start of the image
+        u64 data_length;
+    };
+
+    /// Index of the root directory
+    static constexpr u32 root = 0;
+
+    /**
+     * Parses the metadata of an image in memory.
+     * @return false if the image is not a valid RomFS level 3 image, leaving the index empty
+     */
+    bool Load(const u8* image, size_t size);
+
+    /// Parses the metadata of an image in a file, reading only the metadata tables.
+    bool Load(const FileSys::FileBackend& image);
+
+    bool IsLoaded() const {
+        return !directories.empty();
+    }
+
+    /**
+     * Finds a file or directory.
+     * @param path A vector containing the directory names and the file or directory name
+     * @return the file or directory, or nullptr if there is none at the path
+     */
+    const File* FindFile(const std::vector<std::u16string>& path) const;
+    const Directory* FindDirectory(const std::vector<std::u16string>& path) const;
+
+    /// Finds a file or directory by a UTF-8 path with '/' separators, such as "/dir/file.bin".
+    const File* FindFile(const std::string& path) const;
+    const Directory* FindDirectory(const std::string& path) const;
+
+    const Directory& GetDirectory(u32 index) const {
+        return directories[index];
+    }
+
+    const File& GetFile(u32 index) const {
+        return files[index];
+    }
+
+    size_t GetDirectoryCount() const {
+        return directories.size();
+    }
+
+    size_t GetFileCount() const {
+        return files.size();
+    }
+
+private:
+    struct EntryKey {
+        u32 parent;
+        std::u16string name;
+
+        bool operator==(const EntryKey& other) const {
+            return parent == other.parent && name == other.name;
+        }
+    };
+
+    struct EntryKeyHash {
+        size_t operator()(const EntryKey& key) const;
+    };
+
+    /// Loads an image of the given size through a function that reads part of it.
+    bool Load(u64 size, const std::function<bool(u64, size_t, u8*)>& read);
+
+    /// Builds the index from the directory and file metadata tables.
+    bool Parse(u32 data_offset, const std::vector<u8>& dir_table,
+               const std::vector<u8>& file_table);
+
+    /// Returns the index of the directory a path ends in, or -1 if there is none.
+    s64 WalkDirectories(std::vector<std::u16string>::const_iterator begin,
+                        std::vector<std::u16string>::const_iterator end) const;
+
+    std::vector<Directory> directories;
+    std::vector<File> files;
+    std::unordered_map<EntryKey, u32, EntryKeyHash> directory_lookup;
+    std::unordered_map<EntryKey, u32, EntryKeyHash> file_lookup;
+};
+
 } // namespace RomFS
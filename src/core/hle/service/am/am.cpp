@@ -3,14 +3,22 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include <cstddef>
 #include <cstring>
+#include <future>
+#include <thread>
+#include <cryptopp/sha.h>
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread_worker.h"
 #include "core/file_sys/errors.h"
+#include "core/file_sys/host_metadata_cache.h"
 #include "core/file_sys/ncch_container.h"
+#include "core/file_sys/system_archive_cache.h"
 #include "core/file_sys/title_metadata.h"
 #include "core/hle/ipc.h"
 #include "core/hle/ipc_helpers.h"
@@ -217,6 +225,15 @@ ResultVal<size_t> CIAFile::Write(u64 offset, size_t length, bool flush, const u8
     return MakeResult<size_t>(length);
 }
 
+std::string CIAFile::GetContentPath(u16 index) const {
+    return GetTitleContentPath(media_type, container.GetTitleMetadata().GetTitleID(), index,
+                               is_update);
+}
+
+void CIAFile::MarkContentWritten(u16 index) {
+    content_written[index] = container.GetContentSize(index);
+}
+
 u64 CIAFile::GetSize() const {
     return written;
 }
@@ -235,7 +252,39 @@ bool CIAFile::Close() const {
     // Install aborted
     if (!complete) {
         LOG_ERROR(Service_AM, "CIAFile closed prematurely, aborting install...");
-        FileUtil::DeleteDir(GetTitlePath(media_type, container.GetTitleMetadata().GetTitleID()));
+        // Only remove what this install wrote, the title folder may also hold save data in data/
+        // and, for an update, the contents of the installed title.
+        const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
+        const std::string title_path = GetTitlePath(media_type, tmd.GetTitleID());
+        if (install_state == CIAInstallState::TMDLoaded) {
+            FileSys::TitleMetadata old_tmd;
+            if (is_update)
+                old_tmd.Load(GetTitleMetadataPath(media_type, tmd.GetTitleID(), false));
+
+            std::string app_folder;
+            Common::SplitPath(GetContentPath(FileSys::TMDContentIndex::Main), &app_folder, nullptr,
+                              nullptr);
+            for (u16 index = 0; index < tmd.GetContentCount(); index++) {
+                bool shared = false;
+                for (u16 old_index = 0; is_update && old_index < old_tmd.GetContentCount();
+                     old_index++) {
+                    if (old_tmd.GetContentIDByIndex(old_index) == tmd.GetContentIDByIndex(index))
+                        shared = true;
+                }
+                if (!shared)
+                    FileUtil::Delete(GetContentPath(index));
+            }
+            FileUtil::Delete(GetTitleMetadataPath(media_type, tmd.GetTitleID(), is_update));
+
+            // These only go away once empty
+            const std::string content_folder = title_path + "content/";
+            if (app_folder != content_folder)
+                FileUtil::DeleteDir(app_folder);
+            FileUtil::DeleteDir(content_folder);
+            FileUtil::DeleteDir(title_path);
+        }
+        FileSys::HostMetadataCache::Invalidate(title_path);
+        FileSys::SystemArchiveCache::Invalidate(title_path);
         return true;
     }
 
@@ -270,13 +319,108 @@ bool CIAFile::Close() const {
 
         FileUtil::Delete(old_tmd_path);
     }
+    // The SDMC archive can see the installed title
+    const std::string title_path =
+        GetTitlePath(media_type, container.GetTitleMetadata().GetTitleID());
+    FileSys::HostMetadataCache::Invalidate(title_path);
+    FileSys::SystemArchiveCache::Invalidate(title_path);
     return true;
 }
 
 void CIAFile::Flush() const {}
 
-InstallStatus InstallCIA(const std::string& path,
-                         std::function<ProgressCallback>&& update_callback) {
+namespace {
+
+/// Size of the pieces that contents are read, verified and written out in
+constexpr size_t INSTALL_CHUNK_SIZE = 0x100000;
+
+/// Upper bound of the content data held in memory by an installation at once
+constexpr size_t INSTALL_MEMORY_BUDGET = 16 * INSTALL_CHUNK_SIZE;
+
+/// A content of the CIA being installed, and where it goes
+struct ContentJob {
+    u16 index;
+    u64 offset;
+    u64 size;
+    std::array<u8, 0x20> hash;
+    std::string path;
+};
+
+/// State shared by the threads of an installation
+struct InstallProgress {
+    std::atomic<u64> bytes_done{0};
+    std::atomic<u64> read_ns{0};
+    std::atomic<u64> verify_ns{0};
+    std::atomic<u64> write_ns{0};
+    std::atomic<bool> failed{false};
+};
+
+u64 GetNanosecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                start)
+        .count();
+}
+
+/**
+ * Copies a content out of the CIA chunk by chunk, hashing each chunk before it is written.
+ * Stops early if the installation has failed on another thread.
+ */
+InstallStatus InstallContent(const FileUtil::MappedFile& cia, const ContentJob& job,
+                             InstallProgress& progress) {
+    FileUtil::IOFile file(job.path, "wb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(Service_AM, "Could not open %s for writing", job.path.c_str());
+        return InstallStatus::ErrorAborted;
+    }
+
+    std::vector<u8> buffer(static_cast<size_t>(std::min<u64>(job.size, INSTALL_CHUNK_SIZE)));
+    CryptoPP::SHA256 sha;
+    for (u64 pos = 0; pos < job.size; pos += buffer.size()) {
+        if (progress.failed)
+            return InstallStatus::ErrorAborted;
+
+        const size_t length = static_cast<size_t>(std::min<u64>(job.size - pos, buffer.size()));
+
+        auto start = std::chrono::steady_clock::now();
+        const size_t read = cia.ReadAt(job.offset + pos, length, buffer.data());
+        progress.read_ns += GetNanosecondsSince(start);
+        if (read != length) {
+            LOG_ERROR(Service_AM, "CIA ends in the middle of content %u", job.index);
+            return InstallStatus::ErrorAborted;
+        }
+
+        start = std::chrono::steady_clock::now();
+        sha.Update(buffer.data(), length);
+        progress.verify_ns += GetNanosecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        const size_t written = file.WriteBytes(buffer.data(), length);
+        progress.write_ns += GetNanosecondsSince(start);
+        if (written != length) {
+            LOG_ERROR(Service_AM, "Could not write content %u to %s", job.index,
+                      job.path.c_str());
+            return InstallStatus::ErrorAborted;
+        }
+
+        progress.bytes_done += length;
+    }
+
+    std::array<u8, CryptoPP::SHA256::DIGESTSIZE> hash;
+    sha.Final(hash.data());
+    if (hash != job.hash) {
+        LOG_ERROR(Service_AM, "Content %u does not match the hash in the TMD", job.index);
+        return InstallStatus::ErrorHashMismatch;
+    }
+
+    if (!file.Close())
+        return InstallStatus::ErrorAborted;
+    return InstallStatus::Success;
+}
+
+} // Anonymous namespace
+
+InstallStatus InstallCIA(const std::string& path, std::function<ProgressCallback>&& update_callback,
+                         InstallStats* stats) {
     LOG_INFO(Service_AM, "Installing %s...", path.c_str());
 
     if (!FileUtil::Exists(path)) {
@@ -284,47 +428,119 @@ InstallStatus InstallCIA(const std::string& path,
         return InstallStatus::ErrorFileNotFound;
     }
 
+    const auto install_start = std::chrono::steady_clock::now();
+
     FileSys::CIAContainer container;
-    if (container.Load(path) == Loader::ResultStatus::Success) {
-        Service::AM::CIAFile installFile(
-            Service::AM::GetTitleMediaType(container.GetTitleMetadata().GetTitleID()));
-
-        for (size_t i = 0; i < container.GetTitleMetadata().GetContentCount(); i++) {
-            if (container.GetTitleMetadata().GetContentTypeByIndex(i) &
-                FileSys::TMDContentTypeFlag::Encrypted) {
-                LOG_ERROR(Service_AM, "File %s is encrypted! Aborting...", path.c_str());
-                return InstallStatus::ErrorEncrypted;
-            }
+    if (container.Load(path) != Loader::ResultStatus::Success) {
+        LOG_ERROR(Service_AM, "CIA file %s is invalid!", path.c_str());
+        return InstallStatus::ErrorInvalid;
+    }
+
+    const FileSys::TitleMetadata& tmd = container.GetTitleMetadata();
+    for (size_t i = 0; i < tmd.GetContentCount(); i++) {
+        if (tmd.GetContentTypeByIndex(i) & FileSys::TMDContentTypeFlag::Encrypted) {
+            LOG_ERROR(Service_AM, "File %s is encrypted! Aborting...", path.c_str());
+            return InstallStatus::ErrorEncrypted;
+        }
+    }
+
+    FileUtil::MappedFile file(path);
+    if (!file.IsOpen())
+        return InstallStatus::ErrorFailedToOpenFile;
+
+    Service::AM::CIAFile install_file(Service::AM::GetTitleMediaType(tmd.GetTitleID()));
+
+    // Everything before the contents is small, and goes through CIAFile so that the TMD gets
+    // parsed and saved. The contents are then written out directly, next to the saved TMD.
+    std::vector<u8> header(static_cast<size_t>(container.GetContentOffset()));
+    if (file.ReadAt(0, header.size(), header.data()) != header.size()) {
+        LOG_ERROR(Service_AM, "CIA file %s is invalid!", path.c_str());
+        return InstallStatus::ErrorInvalid;
+    }
+    auto result = install_file.Write(0, header.size(), true, header.data());
+    if (result.Failed()) {
+        LOG_ERROR(Service_AM, "CIA file installation aborted with error code %08x",
+                  result.Code().raw);
+        return InstallStatus::ErrorAborted;
+    }
+
+    std::vector<ContentJob> jobs;
+    u64 total_bytes = 0;
+    for (u16 i = 0; i < tmd.GetContentCount(); i++) {
+        const u64 size = container.GetContentSize(i);
+        if (size == 0)
+            continue;
+        jobs.push_back({i, container.GetContentOffset(i), size, tmd.GetContentHashByIndex(i),
+                        install_file.GetContentPath(i)});
+        total_bytes += size;
+    }
+
+    // Each thread holds a single chunk, so the thread count is what keeps memory use bounded.
+    const size_t num_threads =
+        std::max<size_t>(1, std::min({static_cast<size_t>(std::thread::hardware_concurrency()),
+                                      INSTALL_MEMORY_BUDGET / INSTALL_CHUNK_SIZE, jobs.size()}));
+
+    InstallProgress progress;
+    const auto report_progress = [&] {
+        if (update_callback && total_bytes != 0)
+            update_callback(progress.bytes_done, total_bytes);
+    };
+
+    std::vector<std::future<InstallStatus>> results;
+    {
+        Common::ThreadWorker workers(num_threads, "CIA install");
+        for (const ContentJob& job : jobs) {
+            results.push_back(workers.Submit([&file, &job, &progress] {
+                const InstallStatus status = InstallContent(file, job, progress);
+                if (status != InstallStatus::Success)
+                    progress.failed = true;
+                return status;
+            }));
         }
 
-        FileUtil::IOFile file(path, "rb");
-        if (!file.IsOpen())
-            return InstallStatus::ErrorFailedToOpenFile;
-
-        std::array<u8, 0x10000> buffer;
-        size_t total_bytes_read = 0;
-        while (total_bytes_read != file.GetSize()) {
-            size_t bytes_read = file.ReadBytes(buffer.data(), buffer.size());
-            auto result = installFile.Write(static_cast<u64>(total_bytes_read), bytes_read, true,
-                                            static_cast<u8*>(buffer.data()));
-
-            if (update_callback)
-                update_callback(total_bytes_read, file.GetSize());
-            if (result.Failed()) {
-                LOG_ERROR(Service_AM, "CIA file installation aborted with error code %08x",
-                          result.Code().raw);
-                return InstallStatus::ErrorAborted;
+        for (auto& future : results) {
+            while (future.wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+                report_progress();
             }
-            total_bytes_read += bytes_read;
         }
-        installFile.Close();
+    }
+    report_progress();
+
+    // Contents that were stopped because another one failed report ErrorAborted, so prefer any
+    // more specific error.
+    InstallStatus status = InstallStatus::Success;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const InstallStatus content_status = results[i].get();
+        if (content_status == InstallStatus::Success)
+            install_file.MarkContentWritten(jobs[i].index);
+        else if (status == InstallStatus::Success || status == InstallStatus::ErrorAborted)
+            status = content_status;
+    }
 
-        LOG_INFO(Service_AM, "Installed %s successfully.", path.c_str());
-        return InstallStatus::Success;
+    // Finishes the installation, or removes the title again if a content failed
+    install_file.Close();
+
+    InstallStats install_stats;
+    install_stats.bytes = progress.bytes_done;
+    install_stats.total_ns = GetNanosecondsSince(install_start);
+    install_stats.read_ns = progress.read_ns;
+    install_stats.verify_ns = progress.verify_ns;
+    install_stats.write_ns = progress.write_ns;
+    if (stats)
+        *stats = install_stats;
+
+    if (status != InstallStatus::Success) {
+        LOG_ERROR(Service_AM, "CIA file installation of %s aborted", path.c_str());
+        return status;
     }
 
-    LOG_ERROR(Service_AM, "CIA file %s is invalid!", path.c_str());
-    return InstallStatus::ErrorInvalid;
+    LOG_INFO(Service_AM,
+             "Installed %s successfully: %.1f MB/s on %zu threads, read %" PRIu64
+             " ms, verify %" PRIu64 " ms, write %" PRIu64 " ms",
+             path.c_str(), install_stats.GetMegabytesPerSecond(), num_threads,
+             install_stats.read_ns / 1000000, install_stats.verify_ns / 1000000,
+             install_stats.write_ns / 1000000);
+    return InstallStatus::Success;
 }
 
 Service::FS::MediaType GetTitleMediaType(u64 titleId) {
@@ -518,12 +734,10 @@ void Module::Interface::FindDLCContentInfos(Kernel::HLERequestContext& ctx) {
         std::size_t write_offset = 0;
         // Get info for each content index requested
         for (size_t i = 0; i < content_count; i++) {
-            std::shared_ptr<FileUtil::IOFile> romfs_file;
-            u64 romfs_offset = 0;
-            u64 romfs_size = 0;
-
+            std::shared_ptr<FileSys::RomFSReader> romfs_file;
             FileSys::NCCHContainer ncch_container(GetTitleContentPath(media_type, title_id, i));
-            ncch_container.ReadRomFS(romfs_file, romfs_offset, romfs_size);
+            ncch_container.ReadRomFS(romfs_file);
+            const u64 romfs_size = romfs_file ? romfs_file->GetSize() : 0;
 
             ContentInfo content_info = {};
             content_info.index = static_cast<u16>(i);
@@ -572,12 +786,10 @@ void Module::Interface::ListDLCContentInfos(Kernel::HLERequestContext& ctx) {
         copied = std::min(content_count, static_cast<u32>(tmd.GetContentCount()));
         std::size_t write_offset = 0;
         for (u32 i = start_index; i < copied; i++) {
-            std::shared_ptr<FileUtil::IOFile> romfs_file;
-            u64 romfs_offset = 0;
-            u64 romfs_size = 0;
-
+            std::shared_ptr<FileSys::RomFSReader> romfs_file;
             FileSys::NCCHContainer ncch_container(GetTitleContentPath(media_type, title_id, i));
-            ncch_container.ReadRomFS(romfs_file, romfs_offset, romfs_size);
+            ncch_container.ReadRomFS(romfs_file);
+            const u64 romfs_size = romfs_file ? romfs_file->GetSize() : 0;
 
             ContentInfo content_info = {};
             content_info.index = static_cast<u16>(i);
@@ -706,6 +918,8 @@ void Module::Interface::DeleteUserProgram(Kernel::HLERequestContext& ctx) {
         return;
     }
     bool success = FileUtil::DeleteDirRecursively(path);
+    FileSys::HostMetadataCache::Invalidate(path);
+    FileSys::SystemArchiveCache::Invalidate(path);
     am->ScanForAllTitles();
     rb.Push(RESULT_SUCCESS);
     if (!success)
@@ -1211,6 +1425,8 @@ void Module::Interface::DeleteProgram(Kernel::HLERequestContext& ctx) {
         return;
     }
     bool success = FileUtil::DeleteDirRecursively(path);
+    FileSys::HostMetadataCache::Invalidate(path);
+    FileSys::SystemArchiveCache::Invalidate(path);
     am->ScanForAllTitles();
     rb.Push(RESULT_SUCCESS);
     if (!success)
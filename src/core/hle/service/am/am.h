@@ -50,6 +50,26 @@ enum class InstallStatus : u32 {
     ErrorAborted,
     ErrorInvalid,
     ErrorEncrypted,
+    ErrorHashMismatch,
+};
+
+/// Amount of content data moved by a CIA installation and the time spent in each of its stages
+struct InstallStats {
+    /// Number of content bytes installed
+    u64 bytes = 0;
+    /// Wall-clock duration of the installation
+    u64 total_ns = 0;
+    /// Time spent reading content from the CIA, summed over all installer threads
+    u64 read_ns = 0;
+    /// Time spent hashing content, summed over all installer threads
+    u64 verify_ns = 0;
+    /// Time spent writing content to the emulated media, summed over all installer threads
+    u64 write_ns = 0;
+
+    /// Returns the throughput of the installation in MB/s.
+    double GetMegabytesPerSecond() const {
+        return total_ns ? bytes * 1000.0 / total_ns : 0.0;
+    }
 };
 
 // Title ID valid length
@@ -69,6 +89,20 @@ public:
     ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
     ResultVal<size_t> WriteTitleMetadata(u64 offset, size_t length, const u8* buffer);
     ResultVal<size_t> WriteContentData(u64 offset, size_t length, const u8* buffer);
+
+    /**
+     * Gets the path a content of the CIA is installed to. Only valid once the TMD has been
+     * written, which lets contents be written out directly instead of through Write.
+     * @param index the content index to get
+     * @returns string path to the .app file
+     */
+    std::string GetContentPath(u16 index) const;
+
+    /**
+     * Records that a content was written out completely without going through Write.
+     * @param index the content index that was written
+     */
+    void MarkContentWritten(u16 index);
     ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) override;
     u64 GetSize() const override;
     bool SetSize(u64 size) const override;
@@ -91,13 +125,17 @@ private:
 };
 
 /**
- * Installs a CIA file from a specified file path.
+ * Installs a CIA file from a specified file path. Contents are read, verified against the hashes
+ * in the TMD and written out on several threads at once, and only a bounded amount of content
+ * data is held in memory at any time.
  * @param path file path of the CIA file to install
- * @param update_callback callback function called during filesystem write
+ * @param update_callback callback function called during filesystem write, on the calling thread
+ * @param stats if not null, receives the throughput and per-stage timings of the installation
  * @returns bool whether the install was successful
  */
 InstallStatus InstallCIA(const std::string& path,
-                         std::function<ProgressCallback>&& update_callback = nullptr);
+                         std::function<ProgressCallback>&& update_callback = nullptr,
+                         InstallStats* stats = nullptr);
 
 /**
  * Get the mediatype for an installed title
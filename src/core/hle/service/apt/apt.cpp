@@ -5,12 +5,15 @@
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "core/boot_profiler.h"
 #include "core/core.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/system_archive_cache.h"
 #include "core/hle/applets/applet.h"
 #include "core/hle/kernel/mutex.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/romfs.h"
+#include "core/hle/service/am/am.h"
 #include "core/hle/service/apt/applet_manager.h"
 #include "core/hle/service/apt/apt.h"
 #include "core/hle/service/apt/apt_a.h"
@@ -47,19 +50,34 @@ void Module::Interface::Initialize(Kernel::HLERequestContext& ctx) {
     }
 }
 
-static u32 DecompressLZ11(const u8* in, u8* out) {
+/**
+ * Decompresses LZ11 data.
+ * @param in The compressed data, starting with its header
+ * @param in_size Size of the compressed data
+ * @param out Buffer for the decompressed data, of the size given in the header
+ * @param out_size Size of the output buffer
+ * @returns false if the data is not valid LZ11, or does not fit in the buffer
+ */
+static bool DecompressLZ11(const u8* in, size_t in_size, u8* out, size_t out_size) {
+    if (in_size < sizeof(u32))
+        return false;
+
     u32_le decompressed_size;
     memcpy(&decompressed_size, in, sizeof(u32));
+    const u8* const in_end = in + in_size;
     in += 4;
 
     u8 type = decompressed_size & 0xFF;
-    ASSERT(type == 0x11);
     decompressed_size >>= 8;
+    if (type != 0x11 || decompressed_size > out_size)
+        return false;
 
     u32 current_out_size = 0;
     u8 flags = 0, mask = 1;
     while (current_out_size < decompressed_size) {
         if (mask == 1) {
+            if (in == in_end)
+                return false;
             flags = *(in++);
             mask = 0x80;
         } else {
@@ -67,8 +85,15 @@ static u32 DecompressLZ11(const u8* in, u8* out) {
         }
 
         if (flags & mask) {
+            if (in == in_end)
+                return false;
             u8 byte1 = *(in++);
             u32 length = byte1 >> 4;
+            // Bytes after byte1
+            const ptrdiff_t extra_bytes = length == 0 ? 2 : length == 1 ? 3 : 1;
+            if (in_end - in < extra_bytes)
+                return false;
+
             u32 offset;
             if (length == 0) {
                 u8 byte2 = *(in++);
@@ -87,6 +112,10 @@ static u32 DecompressLZ11(const u8* in, u8* out) {
                 offset = (((byte1 & 0x0F) << 8) | byte2) + 0x1;
             }
 
+            // The copy can neither start before the output nor run past its end
+            if (offset > current_out_size || length > decompressed_size - current_out_size)
+                return false;
+
             for (u32 i = 0; i < length; i++) {
                 *out = *(out - offset);
                 ++out;
@@ -94,31 +123,23 @@ static u32 DecompressLZ11(const u8* in, u8* out) {
 
             current_out_size += length;
         } else {
+            if (in == in_end)
+                return false;
             *(out++) = *(in++);
             current_out_size++;
         }
     }
-    return decompressed_size;
+    return true;
 }
 
-bool Module::LoadSharedFont() {
-    u8 font_region_code;
-    switch (CFG::GetCurrentModule()->GetRegionValue()) {
-    case 4: // CHN
-        font_region_code = 2;
-        break;
-    case 5: // KOR
-        font_region_code = 3;
-        break;
-    case 6: // TWN
-        font_region_code = 4;
-        break;
-    default: // JPN/EUR/USA
-        font_region_code = 1;
-        break;
-    }
-
-    const u64_le shared_font_archive_id_low = 0x0004009b00014002 | ((font_region_code - 1) << 8);
+/**
+ * Reads a font from a shared font archive, and decompresses it.
+ * @param title_id Title ID of the archive
+ * @param file_name Name of the compressed font in the RomFS of the archive
+ * @param font Buffer to decompress the font into
+ */
+static bool ReadSharedFont(u64 title_id, const char16_t* file_name, std::vector<u8>& font) {
+    const u64_le shared_font_archive_id_low = title_id;
     const u64_le shared_font_archive_id_high = 0x00000001ffffff00;
     std::vector<u8> shared_font_archive_id(16);
     std::memcpy(&shared_font_archive_id[0], &shared_font_archive_id_low, sizeof(u64));
@@ -136,16 +157,69 @@ bool Module::LoadSharedFont() {
     if (file_result.Failed())
         return false;
 
+    // Only the metadata and the font of the region are read, not the whole archive
     auto romfs = std::move(file_result).Unwrap();
-    std::vector<u8> romfs_buffer(romfs->backend->GetSize());
-    romfs->backend->Read(0, romfs_buffer.size(), romfs_buffer.data());
+    RomFS::Index romfs_index;
+    if (!romfs_index.Load(*romfs->backend)) {
+        romfs->backend->Close();
+        return false;
+    }
+
+    const RomFS::Index::File* font_entry =
+        romfs_index.FindFile(std::vector<std::u16string>{file_name});
+    if (font_entry == nullptr || font_entry->data_length < sizeof(u32)) {
+        romfs->backend->Close();
+        return false;
+    }
+
+    std::vector<u8> font_file(static_cast<size_t>(font_entry->data_length));
+    const auto read =
+        romfs->backend->Read(font_entry->data_offset, font_file.size(), font_file.data());
     romfs->backend->Close();
+    if (read.Failed() || *read != font_file.size())
+        return false;
+
+    u32_le compression_header;
+    std::memcpy(&compression_header, font_file.data(), sizeof(u32));
+    font.resize(compression_header >> 8);
+    if (!DecompressLZ11(font_file.data(), font_file.size(), font.data(), font.size())) {
+        NGLOG_ERROR(Service_APT, "shared font is corrupted");
+        return false;
+    }
+    return true;
+}
+
+bool Module::LoadSharedFont() {
+    u8 font_region_code;
+    switch (CFG::GetCurrentModule()->GetRegionValue()) {
+    case 4: // CHN
+        font_region_code = 2;
+        break;
+    case 5: // KOR
+        font_region_code = 3;
+        break;
+    case 6: // TWN
+        font_region_code = 4;
+        break;
+    default: // JPN/EUR/USA
+        font_region_code = 1;
+        break;
+    }
 
+    const u64 title_id = 0x0004009b00014002 | ((font_region_code - 1) << 8);
     const char16_t* file_name[4] = {u"cbf_std.bcfnt.lz", u"cbf_zh-Hans-CN.bcfnt.lz",
                                     u"cbf_ko-Hang-KR.bcfnt.lz", u"cbf_zh-Hant-TW.bcfnt.lz"};
-    const u8* font_file =
-        RomFS::GetFilePointer(romfs_buffer.data(), {file_name[font_region_code - 1]});
-    if (font_file == nullptr)
+
+    // The decompressed font is shared by every boot in the process. The copy in the shared memory
+    // is the one that gets relocated.
+    const std::string content_path =
+        Service::AM::GetTitleContentPath(Service::FS::MediaType::NAND, title_id);
+    const auto font = FileSys::SystemArchiveCache::Get(
+        fmt::format("shared font {:016X}", title_id), content_path,
+        [&](std::vector<u8>& buffer) {
+            return ReadSharedFont(title_id, file_name[font_region_code - 1], buffer);
+        });
+    if (font == nullptr)
         return false;
 
     struct {
@@ -156,10 +230,15 @@ bool Module::LoadSharedFont() {
     } shared_font_header{};
     static_assert(sizeof(shared_font_header) == 0x80, "shared_font_header has incorrect size");
 
+    if (font->size() > shared_font_mem->size - sizeof(shared_font_header)) {
+        NGLOG_ERROR(Service_APT, "shared font is too large");
+        return false;
+    }
+
     shared_font_header.status = 2; // successfully loaded
     shared_font_header.region = font_region_code;
-    shared_font_header.decompressed_size =
-        DecompressLZ11(font_file, shared_font_mem->GetPointer(0x80));
+    shared_font_header.decompressed_size = static_cast<u32>(font->size());
+    std::memcpy(shared_font_mem->GetPointer(0x80), font->data(), font->size());
     std::memcpy(shared_font_mem->GetPointer(), &shared_font_header, sizeof(shared_font_header));
     *shared_font_mem->GetPointer(0x83) = 'U'; // Change the magic from "CFNT" to "CFNU"
 
@@ -194,6 +273,7 @@ void Module::Interface::GetSharedFont(Kernel::HLERequestContext& ctx) {
     if (!apt->shared_font_loaded) {
         // On real 3DS, font loading happens on booting. However, we load it on demand to coordinate
         // with CFG region auto configuration, which happens later than APT initialization.
+        Core::BootProfiler::ScopedPhase phase("APT: load the shared font");
         if (apt->LoadSharedFont()) {
             apt->shared_font_loaded = true;
         } else if (apt->LoadLegacySharedFont()) {
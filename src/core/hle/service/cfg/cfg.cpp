@@ -12,6 +12,7 @@
 #include "core/file_sys/archive_systemsavedata.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/system_archive_cache.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/result.h"
 #include "core/hle/service/cfg/cfg.h"
@@ -114,6 +115,14 @@ static const std::vector<u8> cfg_system_savedata_id = {
 
 static std::weak_ptr<Module> current_cfg;
 
+/// Returns the host path of the config save file, by which the system archive cache knows it.
+static std::string GetConfigHostPath() {
+    const std::string nand_directory = FileUtil::GetUserPath(D_NAND_IDX);
+    const std::string base_path = FileSys::GetSystemSaveDataContainerPath(nand_directory);
+    return FileSys::GetSystemSaveDataPath(base_path, FileSys::Path(cfg_system_savedata_id)) +
+           "config";
+}
+
 std::shared_ptr<Module> GetCurrentModule() {
     auto cfg = current_cfg.lock();
     ASSERT_MSG(cfg, "No CFG module running!");
@@ -389,6 +398,7 @@ ResultCode Module::CreateConfigInfoBlk(u32 block_id, u16 size, u16 flags, const
 
 ResultCode Module::DeleteConfigNANDSaveFile() {
     FileSys::Path path("/config");
+    FileSys::SystemArchiveCache::Invalidate(GetConfigHostPath());
     return Service::FS::DeleteFileFromArchive(cfg_system_save_data_archive, path);
 }
 
@@ -404,6 +414,7 @@ ResultCode Module::UpdateConfigNANDSavegame() {
 
     auto config = std::move(config_result).Unwrap();
     config->backend->Write(0, CONFIG_SAVEFILE_SIZE, 1, cfg_config_file_buffer.data());
+    FileSys::SystemArchiveCache::Invalidate(GetConfigHostPath());
 
     return RESULT_SUCCESS;
 }
@@ -548,16 +559,27 @@ ResultCode Module::LoadConfigNANDSaveFile() {
 
     cfg_system_save_data_archive = *archive_result;
 
-    FileSys::Path config_path("/config");
-    FileSys::Mode open_mode = {};
-    open_mode.read_flag.Assign(1);
-
-    auto config_result = Service::FS::OpenFileFromArchive(*archive_result, config_path, open_mode);
-
-    // Read the file if it already exists
-    if (config_result.Succeeded()) {
-        auto config = std::move(config_result).Unwrap();
-        config->backend->Read(0, CONFIG_SAVEFILE_SIZE, cfg_config_file_buffer.data());
+    // The blocks read by a previous boot of the process are shared, this module changes a copy
+    const auto config_data = FileSys::SystemArchiveCache::Get(
+        "cfg config", GetConfigHostPath(), [&](std::vector<u8>& buffer) {
+            FileSys::Path config_path("/config");
+            FileSys::Mode open_mode = {};
+            open_mode.read_flag.Assign(1);
+
+            auto config_result =
+                Service::FS::OpenFileFromArchive(*archive_result, config_path, open_mode);
+            if (config_result.Failed())
+                return false;
+
+            buffer.resize(CONFIG_SAVEFILE_SIZE);
+            auto config = std::move(config_result).Unwrap();
+            config->backend->Read(0, CONFIG_SAVEFILE_SIZE, buffer.data());
+            return true;
+        });
+
+    // Use the file if it already exists
+    if (config_data != nullptr) {
+        std::copy(config_data->begin(), config_data->end(), cfg_config_file_buffer.begin());
         return RESULT_SUCCESS;
     }
 
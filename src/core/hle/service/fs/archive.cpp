@@ -15,6 +15,7 @@
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/thread_worker.h"
 #include "core/file_sys/archive_backend.h"
 #include "core/file_sys/archive_extsavedata.h"
 #include "core/file_sys/archive_ncch.h"
@@ -27,6 +28,9 @@
 #include "core/file_sys/directory_backend.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/file_backend.h"
+#include "core/file_sys/host_metadata_cache.h"
+#include "core/file_sys/system_archive_cache.h"
+#include "core/file_sys/write_back_cache.h"
 #include "core/hle/ipc.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/client_port.h"
@@ -38,6 +42,7 @@
 #include "core/hle/service/fs/archive.h"
 #include "core/hle/service/fs/fs_user.h"
 #include "core/hle/service/service.h"
+#include "core/settings.h"
 #include "core/memory.h"
 
 namespace Service {
@@ -51,8 +56,12 @@ enum class DirectoryCommand : u32 {
     Close = 0x08020000,
 };
 
+/// Runs the host side of file reads, see File::Read. The file backends share host file handles
+/// and are not thread-safe, so a single thread serves all of them.
+static std::unique_ptr<Common::ThreadWorker> io_worker;
+
 File::File(std::unique_ptr<FileSys::FileBackend>&& backend, const FileSys::Path& path)
-    : ServiceFramework("", 1), path(path), backend(std::move(backend)) {
+    : ServiceFramework("fs:File", 1), path(path), backend(std::move(backend)) {
     static const FunctionInfo functions[] = {
         {0x08010100, &File::OpenSubFile, "OpenSubFile"},
         {0x080200C2, &File::Read, "Read"},
@@ -72,7 +81,6 @@ void File::Read(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x0802, 3, 2);
     u64 offset = rp.Pop<u64>();
     u32 length = rp.Pop<u32>();
-    auto& buffer = rp.PopMappedBuffer();
     LOG_TRACE(Service_FS, "Read %s: offset=0x%" PRIx64 " length=0x%08X", GetName().c_str(), offset,
               length);
 
@@ -86,35 +94,68 @@ void File::Read(Kernel::HLERequestContext& ctx) {
     // This file session might have a specific offset from where to start reading, apply it.
     offset += file->offset;
 
-    if (offset + length > backend->GetSize()) {
+    // The backend is not thread-safe, and the previous read may still be using it
+    WaitForPendingRead();
+
+    const u64 file_size = backend->GetSize();
+    if (offset + length > file_size) {
         LOG_ERROR(Service_FS,
                   "Reading from out of bounds offset=0x%" PRIx64
                   " length=0x%08X file_size=0x%" PRIx64,
-                  offset, length, backend->GetSize());
+                  offset, length, file_size);
     }
 
-    IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
-
-    std::vector<u8> data(length);
-    ResultVal<size_t> read = backend->Read(offset, data.size(), data.data());
-    if (read.Failed()) {
-        rb.Push(read.Code());
-        rb.Push<u32>(0);
-    } else {
-        buffer.Write(data.data(), 0, *read);
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u32>(*read);
-    }
-    rb.PushMappedBuffer(buffer);
+    // Start the host read right away and let it run while the client thread waits out the
+    // emulated read delay. The reply is only built once the thread wakes up, so the guest never
+    // sees the data before the delay has passed.
+    auto pending = std::make_shared<PendingRead>();
+    pending->data = Kernel::AcquireIPCBuffer(length);
+    std::shared_future<void> done = StartRead(offset, pending);
 
     std::chrono::nanoseconds read_timeout_ns{backend->GetReadDelayNs(length)};
     ctx.SleepClientThread(Kernel::GetCurrentThread(), "file::read", read_timeout_ns,
-                          [](Kernel::SharedPtr<Kernel::Thread> thread,
-                             Kernel::HLERequestContext& ctx, ThreadWakeupReason reason) {
-                              // Nothing to do here
+                          [pending, done](Kernel::SharedPtr<Kernel::Thread> thread,
+                                          Kernel::HLERequestContext& ctx,
+                                          ThreadWakeupReason reason) {
+                              // Only blocks if the host is slower than the emulated medium.
+                              done.wait();
+
+                              IPC::RequestParser rp(ctx, 0x0802, 3, 2);
+                              rp.Skip(3, false);
+                              auto& buffer = rp.PopMappedBuffer();
+                              IPC::RequestBuilder rb = rp.MakeBuilder(2, 2);
+                              if (pending->result.Failed()) {
+                                  rb.Push(pending->result.Code());
+                                  rb.Push<u32>(0);
+                              } else {
+                                  buffer.Write(pending->data.data(), 0, *pending->result);
+                                  rb.Push(RESULT_SUCCESS);
+                                  rb.Push<u32>(*pending->result);
+                              }
+                              rb.PushMappedBuffer(buffer);
+                              Kernel::ReleaseIPCBuffer(std::move(pending->data));
                           });
 }
 
+std::shared_future<void> File::StartRead(u64 offset, std::shared_ptr<PendingRead> read) {
+    WaitForPendingRead();
+
+    // The data is staged in a host buffer rather than read straight into guest memory, since the
+    // guest can change its memory mappings while the I/O thread is still writing.
+    auto read_task = [backend = backend, read = std::move(read), offset] {
+        read->result = backend->Read(offset, read->data.size(), read->data.data());
+    };
+    pending_read = io_worker->Submit(std::move(read_task)).share();
+    return pending_read;
+}
+
+void File::WaitForPendingRead() {
+    if (pending_read.valid()) {
+        pending_read.wait();
+        pending_read = {};
+    }
+}
+
 void File::Write(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x0803, 4, 2);
     u64 offset = rp.Pop<u64>();
@@ -136,9 +177,15 @@ void File::Write(Kernel::HLERequestContext& ctx) {
         return;
     }
 
-    std::vector<u8> data(length);
-    buffer.Read(data.data(), 0, data.size());
-    ResultVal<size_t> written = backend->Write(offset, data.size(), flush != 0, data.data());
+    WaitForPendingRead();
+    ResultVal<size_t> written = ResultCode(-1);
+    if (const u8* direct_pointer = buffer.GetDirectReadPointer(0, length)) {
+        written = backend->Write(offset, length, flush != 0, direct_pointer);
+    } else {
+        Kernel::PooledIPCBuffer data(length);
+        buffer.Read(data.data(), 0, data.size());
+        written = backend->Write(offset, data.size(), flush != 0, data.data());
+    }
     if (written.Failed()) {
         rb.Push(written.Code());
         rb.Push<u32>(0);
@@ -174,6 +221,7 @@ void File::SetSize(Kernel::HLERequestContext& ctx) {
     }
 
     file->size = size;
+    WaitForPendingRead();
     backend->SetSize(size);
     rb.Push(RESULT_SUCCESS);
 }
@@ -186,6 +234,7 @@ void File::Close(Kernel::HLERequestContext& ctx) {
         LOG_WARNING(Service_FS, "Closing File backend but %zu clients still connected",
                     connected_sessions.size());
 
+    WaitForPendingRead();
     backend->Close();
     IPC::RequestBuilder rb = rp.MakeBuilder(1, 0);
     rb.Push(RESULT_SUCCESS);
@@ -204,6 +253,7 @@ void File::Flush(Kernel::HLERequestContext& ctx) {
         return;
     }
 
+    WaitForPendingRead();
     backend->Flush();
     rb.Push(RESULT_SUCCESS);
 }
@@ -243,6 +293,7 @@ void File::OpenLinkFile(Kernel::HLERequestContext& ctx) {
 
     slot->priority = original_file->priority;
     slot->offset = 0;
+    WaitForPendingRead();
     slot->size = backend->GetSize();
     slot->subfile = false;
 
@@ -304,6 +355,7 @@ Kernel::SharedPtr<Kernel::ClientSession> File::Connect() {
     FileSessionSlot* slot = GetSessionData(server);
     slot->priority = 0;
     slot->offset = 0;
+    WaitForPendingRead();
     slot->size = backend->GetSize();
     slot->subfile = false;
 
@@ -312,7 +364,7 @@ Kernel::SharedPtr<Kernel::ClientSession> File::Connect() {
 
 Directory::Directory(std::unique_ptr<FileSys::DirectoryBackend>&& backend,
                      const FileSys::Path& path)
-    : ServiceFramework("", 1), path(path), backend(std::move(backend)) {
+    : ServiceFramework("fs:Directory", 1), path(path), backend(std::move(backend)) {
     static const FunctionInfo functions[] = {
         // clang-format off
         {0x08010042, &Directory::Read, "Read"},
@@ -396,6 +448,13 @@ ResultCode CloseArchive(ArchiveHandle handle) {
         return RESULT_SUCCESS;
 }
 
+ResultCode CommitArchive(ArchiveHandle handle) {
+    ArchiveBackend* archive = GetArchive(handle);
+    if (archive == nullptr)
+        return FileSys::ERR_INVALID_ARCHIVE_HANDLE;
+    return archive->Commit();
+}
+
 // TODO(yuriks): This might be what the fs:REG service is for. See the Register/Unregister calls in
 // http://3dbrew.org/wiki/Filesystem_services#ProgramRegistry_service_.22fs:REG.22
 ResultCode RegisterArchiveType(std::unique_ptr<FileSys::ArchiveFactory>&& factory,
@@ -586,7 +645,12 @@ ResultCode DeleteExtSaveData(MediaType media_type, u32 high, u32 low) {
     std::string base_path =
         FileSys::GetExtDataContainerPath(media_type_directory, media_type == MediaType::NAND);
     std::string extsavedata_path = FileSys::GetExtSaveDataPath(base_path, path);
-    if (FileUtil::Exists(extsavedata_path) && !FileUtil::DeleteDirRecursively(extsavedata_path))
+    if (!FileUtil::Exists(extsavedata_path))
+        return RESULT_SUCCESS;
+    const bool deleted = FileUtil::DeleteDirRecursively(extsavedata_path);
+    FileSys::WriteBackCache::Discard(extsavedata_path);
+    FileSys::HostMetadataCache::Invalidate(extsavedata_path);
+    if (!deleted)
         return ResultCode(-1); // TODO(Subv): Find the right error code
     return RESULT_SUCCESS;
 }
@@ -598,7 +662,11 @@ ResultCode DeleteSystemSaveData(u32 high, u32 low) {
     std::string nand_directory = FileUtil::GetUserPath(D_NAND_IDX);
     std::string base_path = FileSys::GetSystemSaveDataContainerPath(nand_directory);
     std::string systemsavedata_path = FileSys::GetSystemSaveDataPath(base_path, path);
-    if (!FileUtil::DeleteDirRecursively(systemsavedata_path))
+    const bool deleted = FileUtil::DeleteDirRecursively(systemsavedata_path);
+    FileSys::WriteBackCache::Discard(systemsavedata_path);
+    FileSys::HostMetadataCache::Invalidate(systemsavedata_path);
+    FileSys::SystemArchiveCache::Invalidate(systemsavedata_path);
+    if (!deleted)
         return ResultCode(-1); // TODO(Subv): Find the right error code
     return RESULT_SUCCESS;
 }
@@ -610,7 +678,9 @@ ResultCode CreateSystemSaveData(u32 high, u32 low) {
     std::string nand_directory = FileUtil::GetUserPath(D_NAND_IDX);
     std::string base_path = FileSys::GetSystemSaveDataContainerPath(nand_directory);
     std::string systemsavedata_path = FileSys::GetSystemSaveDataPath(base_path, path);
-    if (!FileUtil::CreateFullPath(systemsavedata_path))
+    const bool created = FileUtil::CreateFullPath(systemsavedata_path);
+    FileSys::HostMetadataCache::Invalidate(systemsavedata_path);
+    if (!created)
         return ResultCode(-1); // TODO(Subv): Find the right error code
     return RESULT_SUCCESS;
 }
@@ -695,13 +765,34 @@ void UnregisterArchiveTypes() {
 /// Initialize archives
 void ArchiveInit() {
     next_handle = 1;
+    FileSys::HostMetadataCache::Clear();
+    FileSys::HostMetadataCache::SetWatchHost(Settings::values.watch_host_files);
+    io_worker = std::make_unique<Common::ThreadWorker>(1, "FS I/O");
     RegisterArchiveTypes();
 }
 
 /// Shutdown archives
 void ArchiveShutdown() {
+    io_worker.reset();
     handle_map.clear();
     UnregisterArchiveTypes();
+
+    const auto stats = FileSys::HostMetadataCache::GetStats();
+    LOG_INFO(Service_FS,
+             "Host metadata cache: %" PRIu64 " of %" PRIu64 " lookups and %" PRIu64 " of %" PRIu64
+             " directory listings were cached",
+             stats.lookup_hits, stats.lookup_hits + stats.lookup_misses, stats.listing_hits,
+             stats.listing_hits + stats.listing_misses);
+    FileSys::HostMetadataCache::SetWatchHost(false);
+    FileSys::HostMetadataCache::Clear();
+
+    // The system archive cache is kept for the next boot
+    const auto system_stats = FileSys::SystemArchiveCache::GetStats();
+    LOG_INFO(Service_FS,
+             "System archive cache: %" PRIu64 " of %" PRIu64 " loads were shared, %" PRIu64
+             " KiB cached",
+             system_stats.hits, system_stats.hits + system_stats.misses,
+             system_stats.cached_bytes / 1024);
 }
 
 } // namespace FS
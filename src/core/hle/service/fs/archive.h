@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
 #include <string>
 #include <vector>
@@ -69,11 +70,25 @@ public:
     }
 
     FileSys::Path path;                            ///< Path of the file
-    std::unique_ptr<FileSys::FileBackend> backend; ///< File backend interface
+    std::shared_ptr<FileSys::FileBackend> backend; ///< File backend interface
 
     /// Creates a new session to this File and returns the ClientSession part of the connection.
     Kernel::SharedPtr<Kernel::ClientSession> Connect();
 
+    /// The host side of a read, which the FS I/O thread fills in, see Read.
+    struct PendingRead {
+        std::vector<u8> data;
+        ResultVal<size_t> result = ResultCode(-1);
+    };
+
+    /**
+     * Starts reading from the backend on the FS I/O thread, once any earlier read is done with it.
+     * @param offset Offset in the backend to start reading from
+     * @param read Read to fill in, as many bytes as its data holds are read
+     * @returns A future that becomes ready once the read has been filled in
+     */
+    std::shared_future<void> StartRead(u64 offset, std::shared_ptr<PendingRead> read);
+
 private:
     void Read(Kernel::HLERequestContext& ctx);
     void Write(Kernel::HLERequestContext& ctx);
@@ -85,6 +100,12 @@ private:
     void GetPriority(Kernel::HLERequestContext& ctx);
     void OpenLinkFile(Kernel::HLERequestContext& ctx);
     void OpenSubFile(Kernel::HLERequestContext& ctx);
+
+    /// Waits until the host side of the reads started by Read is done with the backend.
+    void WaitForPendingRead();
+
+    /// Completes once the most recently started read, and so every earlier one, has finished.
+    std::shared_future<void> pending_read;
 };
 
 class Directory final : public ServiceFramework<Directory> {
@@ -118,6 +139,13 @@ ResultVal<ArchiveHandle> OpenArchive(ArchiveIdCode id_code, FileSys::Path& archi
  */
 ResultCode CloseArchive(ArchiveHandle handle);
 
+/**
+ * Writes the changes made to an archive to the host
+ * @param handle Handle to an open Archive object
+ * @return ResultCode 0 on success or the corresponding code on error
+ */
+ResultCode CommitArchive(ArchiveHandle handle);
+
 /**
  * Registers an Archive type, instances of which can later be opened using its IdCode.
  * @param factory File system backend interface to the archive
@@ -331,6 +331,35 @@ void FS_USER::CloseArchive(Kernel::HLERequestContext& ctx) {
     rb.Push(Service::FS::CloseArchive(archive_handle));
 }
 
+void FS_USER::ControlArchive(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp(ctx, 0x80D, 5, 4);
+    auto archive_handle = rp.PopRaw<ArchiveHandle>();
+    u32 action = rp.Pop<u32>();
+    u32 input_size = rp.Pop<u32>();
+    u32 output_size = rp.Pop<u32>();
+    auto input = rp.PopMappedBuffer();
+    auto output = rp.PopMappedBuffer();
+
+    ResultCode result = RESULT_SUCCESS;
+    switch (action) {
+    case 0: // CommitSaveData
+        result = CommitArchive(archive_handle);
+        break;
+    default:
+        LOG_ERROR(Service_FS, "Unimplemented action=%u input_size=%u output_size=%u", action,
+                  input_size, output_size);
+        result = UnimplementedFunction(ErrorModule::FS);
+        break;
+    }
+
+    IPC::RequestBuilder rb = rp.MakeBuilder(1, 4);
+    rb.Push(result);
+    rb.PushMappedBuffer(input);
+    rb.PushMappedBuffer(output);
+
+    LOG_TRACE(Service_FS, "called action=%u", action);
+}
+
 void FS_USER::IsSdmcDetected(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp(ctx, 0x817, 0, 0);
     IPC::RequestBuilder rb = rp.MakeBuilder(2, 0);
@@ -711,7 +740,7 @@ FS_USER::FS_USER() : ServiceFramework("fs:USER", 30) {
         {0x080A0244, &FS_USER::RenameDirectory, "RenameDirectory"},
         {0x080B0102, &FS_USER::OpenDirectory, "OpenDirectory"},
         {0x080C00C2, &FS_USER::OpenArchive, "OpenArchive"},
-        {0x080D0144, nullptr, "ControlArchive"},
+        {0x080D0144, &FS_USER::ControlArchive, "ControlArchive"},
         {0x080E0080, &FS_USER::CloseArchive, "CloseArchive"},
         {0x080F0180, &FS_USER::FormatThisUserSaveData, "FormatThisUserSaveData"},
         {0x08100200, &FS_USER::CreateLegacySystemSaveData, "CreateLegacySystemSaveData"},
@@ -211,6 +211,24 @@ private:
      */
     void CloseArchive(Kernel::HLERequestContext& ctx);
 
+    /**
+     * FS_User::ControlArchive service function
+     *  Inputs:
+     *      0 : 0x080D0144
+     *      1 : Archive handle low word
+     *      2 : Archive handle high word
+     *      3 : Action
+     *      4 : Input buffer size
+     *      5 : Output buffer size
+     *      6 : (InputSize << 4) | 0xA
+     *      7 : Input buffer pointer
+     *      8 : (OutputSize << 4) | 0xC
+     *      9 : Output buffer pointer
+     *  Outputs:
+     *      1 : Result of function, 0 on success, otherwise error code
+     */
+    void ControlArchive(Kernel::HLERequestContext& ctx);
+
     /*
      * FS_User::IsSdmcDetected service function
      *  Outputs:
@@ -6,6 +6,7 @@
 #include "common/bit_field.h"
 #include "common/microprofile.h"
 #include "common/swap.h"
+#include "core/boot_profiler.h"
 #include "core/core.h"
 #include "core/hle/ipc.h"
 #include "core/hle/ipc_helpers.h"
@@ -292,6 +293,7 @@ ResultCode SetBufferSwap(u32 screen_id, const FrameBufferInfo& info) {
     if (screen_id == 0) {
         MicroProfileFlip();
         Core::System::GetInstance().perf_stats.EndGameFrame();
+        Core::BootProfiler::MarkFirstFrame();
     }
 
     return RESULT_SUCCESS;
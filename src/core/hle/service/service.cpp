@@ -7,7 +7,9 @@
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "core/boot_profiler.h"
 #include "core/core.h"
+#include "core/hle/call_profiler.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/handle_table.h"
@@ -105,7 +107,13 @@ void Interface::HandleSyncRequest(SharedPtr<ServerSession> server_session) {
     LOG_TRACE(Service, "%s",
               MakeFunctionString(itr->second.name, GetPortName().c_str(), cmd_buff).c_str());
 
-    itr->second.func(this);
+    if (HLE::CallProfiler::IsEnabled()) {
+        const std::string port_name = GetPortName();
+        HLE::CallProfiler::ScopedCall profile(port_name, itr->first, itr->second.name);
+        itr->second.func(this);
+    } else {
+        itr->second.func(this);
+    }
 }
 
 void Interface::Register(const FunctionInfo* functions, size_t n) {
@@ -175,6 +183,8 @@ void ServiceFrameworkBase::HandleSyncRequest(SharedPtr<ServerSession> server_ses
         return ReportUnimplementedFunction(cmd_buf, info);
     }
 
+    HLE::CallProfiler::ScopedCall profile(service_name, header_code, info->name);
+
     // TODO(yuriks): The kernel should be the one handling this as part of translation after
     // everything else is migrated
     Kernel::HLERequestContext context(std::move(server_session));
@@ -236,14 +246,25 @@ void Init(std::shared_ptr<SM::ServiceManager>& sm) {
     NWM::InstallInterfaces(*sm);
 
     FS::InstallInterfaces(*sm);
-    FS::ArchiveInit();
+    {
+        Core::BootProfiler::ScopedPhase phase("FS::ArchiveInit");
+        FS::ArchiveInit();
+    }
     ACT::InstallInterfaces(*sm);
-    AM::InstallInterfaces(*sm);
+    {
+        // Scans for installed titles
+        Core::BootProfiler::ScopedPhase phase("AM::InstallInterfaces");
+        AM::InstallInterfaces(*sm);
+    }
     APT::InstallInterfaces(*sm);
     BOSS::Init();
     CAM::InstallInterfaces(*sm);
     CECD::Init();
-    CFG::InstallInterfaces(*sm);
+    {
+        // Loads the config save data
+        Core::BootProfiler::ScopedPhase phase("CFG::InstallInterfaces");
+        CFG::InstallInterfaces(*sm);
+    }
     DLP::Init();
     FRD::InstallInterfaces(*sm);
     GSP::InstallInterfaces(*sm);
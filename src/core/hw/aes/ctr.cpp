@@ -0,0 +1,24 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include "core/hw/aes/ctr.h"
+
+namespace HW {
+namespace AES {
+
+void DecryptCTR(u8* data, size_t size, const AESKey& key, const CTRCounter& ctr, u64 offset) {
+    if (size == 0)
+        return;
+
+    // Crypto++ picks the AES-NI implementation by itself when the host CPU supports it.
+    CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption aes;
+    aes.SetKeyWithIV(key.data(), key.size(), ctr.data(), ctr.size());
+    aes.Seek(offset);
+    aes.ProcessData(data, data, size);
+}
+
+} // namespace AES
+} // namespace HW
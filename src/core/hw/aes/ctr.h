@@ -0,0 +1,29 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+#include "core/hw/aes/key.h"
+
+namespace HW {
+namespace AES {
+
+using CTRCounter = std::array<u8, AES_BLOCK_SIZE>;
+
+/**
+ * Decrypts data in place using the AES-CTR algorithm. Encryption is the same operation. The data
+ * may start anywhere in the key stream, which allows decrypting a part of a large encrypted image
+ * without processing the data before it.
+ * @param data The data to decrypt
+ * @param size The size of the data
+ * @param key The normal key to use
+ * @param ctr The initial counter of the stream, incremented as a 128-bit big endian number
+ * @param offset The position of the data in the stream, in bytes. It need not be block aligned.
+ */
+void DecryptCTR(u8* data, size_t size, const AESKey& key, const CTRCounter& ctr, u64 offset);
+
+} // namespace AES
+} // namespace HW
@@ -4,8 +4,10 @@
 
 #include <algorithm>
 #include <exception>
+#include <mutex>
 #include <sstream>
 #include <boost/optional.hpp>
+#include "common/assert.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -18,8 +20,18 @@ namespace AES {
 
 namespace {
 
+/// Guards the key slots and the generator constant, as NCCHs are loaded on other threads too
+std::mutex key_mutex;
+
 boost::optional<AESKey> generator_constant;
 
+/// Whether the keys from the user's aes_keys.txt were loaded since the process started
+bool preset_keys_loaded = false;
+
+AESKey ScrambleKey(const AESKey& x, const AESKey& y) {
+    return Lrot128(Add128(Xor128(Lrot128(x, 2), y), *generator_constant), 87);
+}
+
 struct KeySlot {
     boost::optional<AESKey> x;
     boost::optional<AESKey> y;
@@ -44,7 +56,7 @@ struct KeySlot {
     }
 
     void GenerateNormalKey() {
-        normal = Lrot128(Add128(Xor128(Lrot128(*x, 2), *y), *generator_constant), 87);
+        normal = ScrambleKey(*x, *y);
     }
 
     void Clear() {
@@ -77,6 +89,7 @@ AESKey HexToKey(const std::string& hex) {
 }
 
 void LoadPresetKeys() {
+    preset_keys_loaded = true;
     const std::string filepath = FileUtil::GetUserPath(D_SYSDATA_IDX) + AES_KEYS;
     FileUtil::CreateFullPath(filepath); // Create path if not already created
     std::ifstream file;
@@ -141,33 +154,54 @@ void LoadPresetKeys() {
 } // namespace
 
 void InitKeys() {
+    std::lock_guard<std::mutex> lock(key_mutex);
     ClearAllKeys();
     LoadPresetKeys();
 }
 
+void LoadKeysIfNeeded() {
+    std::lock_guard<std::mutex> lock(key_mutex);
+    if (!preset_keys_loaded)
+        LoadPresetKeys();
+}
+
 void SetGeneratorConstant(const AESKey& key) {
+    std::lock_guard<std::mutex> lock(key_mutex);
     generator_constant = key;
 }
 
 void SetKeyX(size_t slot_id, const AESKey& key) {
+    std::lock_guard<std::mutex> lock(key_mutex);
     key_slots.at(slot_id).SetKeyX(key);
 }
 
 void SetKeyY(size_t slot_id, const AESKey& key) {
+    std::lock_guard<std::mutex> lock(key_mutex);
     key_slots.at(slot_id).SetKeyY(key);
 }
 
 void SetNormalKey(size_t slot_id, const AESKey& key) {
+    std::lock_guard<std::mutex> lock(key_mutex);
     key_slots.at(slot_id).SetNormalKey(key);
 }
 
 bool IsNormalKeyAvailable(size_t slot_id) {
+    std::lock_guard<std::mutex> lock(key_mutex);
     return key_slots.at(slot_id).normal.is_initialized();
 }
 
 AESKey GetNormalKey(size_t slot_id) {
+    std::lock_guard<std::mutex> lock(key_mutex);
     return key_slots.at(slot_id).normal.value_or(AESKey{});
 }
 
+boost::optional<AESKey> GenerateNormalKey(size_t slot_id, const AESKey& key_y) {
+    std::lock_guard<std::mutex> lock(key_mutex);
+    const KeySlot& slot = key_slots.at(slot_id);
+    if (!generator_constant || !slot.x)
+        return boost::none;
+    return ScrambleKey(*slot.x, key_y);
+}
+
 } // namespace AES
 } // namespace HW
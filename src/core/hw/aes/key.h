@@ -6,12 +6,21 @@
 
 #include <array>
 #include <cstddef>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 
 namespace HW {
 namespace AES {
 
 enum KeySlotID : size_t {
+    // AES Keyslots used to decrypt NCCH content, selected by the secondary key slot of the header
+    NCCHSecure3 = 0x18,
+    NCCHSecure4 = 0x1B,
+    NCCHSecure2 = 0x25,
+
+    // AES Keyslot used to decrypt the NCCH ExHeader, ExeFS header and icon, and original crypto
+    NCCHSecure1 = 0x2C,
+
     // AES Keyslot used to generate the UDS data frame CCMP key.
     UDSDataKey = 0x2D,
     APTWrap = 0x31,
@@ -25,6 +34,12 @@ using AESKey = std::array<u8, AES_BLOCK_SIZE>;
 
 void InitKeys();
 
+/**
+ * Loads the keys from the user's key file if neither this nor InitKeys loaded them yet. Unlike
+ * InitKeys, this never clears a key slot, so it may be called at any time from any thread.
+ */
+void LoadKeysIfNeeded();
+
 void SetGeneratorConstant(const AESKey& key);
 void SetKeyX(size_t slot_id, const AESKey& key);
 void SetKeyY(size_t slot_id, const AESKey& key);
@@ -33,5 +48,12 @@ void SetNormalKey(size_t slot_id, const AESKey& key);
 bool IsNormalKeyAvailable(size_t slot_id);
 AESKey GetNormalKey(size_t slot_id);
 
+/**
+ * Generates the normal key the slot would hold with the given KeyY, without changing the slot.
+ * This lets several titles use the same slot at once.
+ * @return the normal key, or none if the KeyX of the slot or the generator constant is missing
+ */
+boost::optional<AESKey> GenerateNormalKey(size_t slot_id, const AESKey& key_y);
+
 } // namespace AES
 } // namespace HW
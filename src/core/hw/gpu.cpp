@@ -19,6 +19,7 @@
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/morton.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -194,6 +195,30 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
+    // Unscaled transfers that only change the layout of the image don't need to decode and
+    // encode every pixel and can use the Morton copy routines instead
+    if (config.scaling == config.NoScale && !config.dont_swizzle &&
+        config.input_format == config.output_format && config.input_width == output_width &&
+        output_width % 8 == 0 && output_height % 8 == 0) {
+        const int bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
+        const VideoCore::MortonFormat format =
+            bytes_per_pixel == 2 ? VideoCore::MortonFormat::Bytes2
+                                 : bytes_per_pixel == 3 ? VideoCore::MortonFormat::Bytes3
+                                                        : VideoCore::MortonFormat::Bytes4;
+
+        u8* tiled = config.input_linear ? dst_pointer : src_pointer;
+        u8* linear = config.input_linear ? src_pointer : dst_pointer;
+        std::ptrdiff_t linear_pitch = output_width * bytes_per_pixel;
+        if (config.flip_vertically) {
+            linear += (output_height - 1) * linear_pitch;
+            linear_pitch = -linear_pitch;
+        }
+
+        VideoCore::MortonCopyTiles(!config.input_linear, format, output_width, 0,
+                                   output_width * output_height / 64, tiled, linear, linear_pitch);
+        return;
+    }
+
     for (u32 y = 0; y < output_height; ++y) {
         for (u32 x = 0; x < output_width; ++x) {
             Math::Vec4<u8> src_color;
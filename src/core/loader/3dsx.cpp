@@ -6,6 +6,7 @@
 #include <vector>
 #include "common/logging/log.h"
 #include "core/file_sys/archive_selfncch.h"
+#include "core/file_sys/romfs_reader.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
 #include "core/hle/service/fs/archive.h"
@@ -283,8 +284,7 @@ ResultStatus AppLoader_THREEDSX::Load(Kernel::SharedPtr<Kernel::Process>& proces
     return ResultStatus::Success;
 }
 
-ResultStatus AppLoader_THREEDSX::ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file,
-                                           u64& offset, u64& size) {
+ResultStatus AppLoader_THREEDSX::ReadRomFS(std::shared_ptr<FileSys::RomFSReader>& romfs_file) {
     if (!file.IsOpen())
         return ResultStatus::Error;
 
@@ -306,13 +306,13 @@ ResultStatus AppLoader_THREEDSX::ReadRomFS(std::shared_ptr<FileUtil::IOFile>& ro
         NGLOG_DEBUG(Loader, "RomFS offset:           {:#010X}", romfs_offset);
         NGLOG_DEBUG(Loader, "RomFS size:             {:#010X}", romfs_size);
 
-        // We reopen the file, to allow its position to be independent from file's
-        romfs_file = std::make_shared<FileUtil::IOFile>(filepath, "rb");
-        if (!romfs_file->IsOpen())
+        // Map the file separately, so that RomFS reads do not move the position of `file`
+        auto mapped_file = std::make_shared<FileUtil::MappedFile>(filepath);
+        if (!mapped_file->IsOpen())
             return ResultStatus::Error;
 
-        offset = romfs_offset;
-        size = romfs_size;
+        romfs_file = std::make_shared<FileSys::RomFSReader>(std::move(mapped_file), romfs_offset,
+                                                            romfs_size);
 
         return ResultStatus::Success;
     }
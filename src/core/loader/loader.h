@@ -15,6 +15,10 @@
 #include "common/file_util.h"
 #include "core/hle/kernel/kernel.h"
 
+namespace FileSys {
+class RomFSReader;
+}
+
 namespace Kernel {
 struct AddressMapping;
 class Process;
@@ -111,6 +115,13 @@ public:
         return std::make_pair(2, ResultStatus::Success);
     }
 
+    /**
+     * Starts reading the parts of the application that Load needs and that do not depend on the
+     * emulated system, so that this can happen while the system is initialized. Called before
+     * Load, which waits for anything still in progress. Does nothing by default.
+     */
+    virtual void Preload() {}
+
     /**
      * Get the code (typically .code section) of the application
      * @param buffer Reference to buffer to store data
@@ -158,27 +169,21 @@ public:
 
     /**
      * Get the RomFS of the application
-     * Since the RomFS can be huge, we return a file reference instead of copying to a buffer
-     * @param romfs_file The file containing the RomFS
-     * @param offset The offset the romfs begins on
-     * @param size The size of the romfs
+     * Since the RomFS can be huge, we return a reader for it instead of copying to a buffer
+     * @param romfs_file The reader for the RomFS
      * @return ResultStatus result of function
      */
-    virtual ResultStatus ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
-                                   u64& size) {
+    virtual ResultStatus ReadRomFS(std::shared_ptr<FileSys::RomFSReader>& romfs_file) {
         return ResultStatus::ErrorNotImplemented;
     }
 
     /**
      * Get the update RomFS of the application
-     * Since the RomFS can be huge, we return a file reference instead of copying to a buffer
-     * @param romfs_file The file containing the RomFS
-     * @param offset The offset the romfs begins on
-     * @param size The size of the romfs
+     * Since the RomFS can be huge, we return a reader for it instead of copying to a buffer
+     * @param romfs_file The reader for the RomFS
      * @return ResultStatus result of function
      */
-    virtual ResultStatus ReadUpdateRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
-                                         u64& size) {
+    virtual ResultStatus ReadUpdateRomFS(std::shared_ptr<FileSys::RomFSReader>& romfs_file) {
         return ResultStatus::ErrorNotImplemented;
     }
 
@@ -8,9 +8,11 @@
 #include <cstring>
 #include <locale>
 #include <memory>
+#include <tuple>
 #include "common/logging/log.h"
 #include "common/string_util.h"
 #include "common/swap.h"
+#include "core/boot_profiler.h"
 #include "core/core.h"
 #include "core/file_sys/archive_selfncch.h"
 #include "core/file_sys/ncch_container.h"
@@ -60,6 +62,34 @@ std::pair<boost::optional<u32>, ResultStatus> AppLoader_NCCH::LoadKernelSystemMo
                           ResultStatus::Success);
 }
 
+void AppLoader_NCCH::Preload() {
+    if (is_loaded || preloaded_code.valid() || base_ncch.Load() != ResultStatus::Success)
+        return;
+
+    OpenUpdate();
+    // Only reads files, and Load does not touch the containers until it has the result
+    preloaded_code = std::async(std::launch::async, [this] {
+        Core::BootProfiler::ScopedPhase phase("Read .code");
+        std::vector<u8> code;
+        const ResultStatus result = ReadCode(code);
+        return std::make_pair(result, std::move(code));
+    });
+}
+
+void AppLoader_NCCH::OpenUpdate() {
+    if (update_opened)
+        return;
+    update_opened = true;
+
+    u64_le ncch_program_id;
+    ReadProgramId(ncch_program_id);
+    update_ncch.OpenFile(Service::AM::GetTitleContentPath(Service::FS::MediaType::SDMC,
+                                                          ncch_program_id | UPDATE_MASK));
+    if (update_ncch.Load() == ResultStatus::Success) {
+        overlay_ncch = &update_ncch;
+    }
+}
+
 ResultStatus AppLoader_NCCH::LoadExec(Kernel::SharedPtr<Kernel::Process>& process) {
     using Kernel::CodeSet;
     using Kernel::SharedPtr;
@@ -68,8 +98,15 @@ ResultStatus AppLoader_NCCH::LoadExec(Kernel::SharedPtr<Kernel::Process>& proces
         return ResultStatus::ErrorNotLoaded;
 
     std::vector<u8> code;
+    ResultStatus code_result;
+    if (preloaded_code.valid()) {
+        std::tie(code_result, code) = preloaded_code.get();
+    } else {
+        code_result = ReadCode(code);
+    }
+
     u64_le program_id;
-    if (ResultStatus::Success == ReadCode(code) &&
+    if (ResultStatus::Success == code_result &&
         ResultStatus::Success == ReadProgramId(program_id)) {
         std::string process_name = Common::StringFromFixedZeroTerminatedBuffer(
             (const char*)overlay_ncch->exheader_header.codeset_info.name, 8);
@@ -158,12 +195,7 @@ ResultStatus AppLoader_NCCH::Load(Kernel::SharedPtr<Kernel::Process>& process) {
 
     NGLOG_INFO(Loader, "Program ID: {}", program_id);
 
-    update_ncch.OpenFile(Service::AM::GetTitleContentPath(Service::FS::MediaType::SDMC,
-                                                          ncch_program_id | UPDATE_MASK));
-    result = update_ncch.Load();
-    if (result == ResultStatus::Success) {
-        overlay_ncch = &update_ncch;
-    }
+    OpenUpdate();
 
     Core::Telemetry().AddField(Telemetry::FieldType::Session, "ProgramId", program_id);
 
@@ -211,17 +243,15 @@ ResultStatus AppLoader_NCCH::ReadProgramId(u64& out_program_id) {
     return ResultStatus::Success;
 }
 
-ResultStatus AppLoader_NCCH::ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
-                                       u64& size) {
-    return base_ncch.ReadRomFS(romfs_file, offset, size);
+ResultStatus AppLoader_NCCH::ReadRomFS(std::shared_ptr<FileSys::RomFSReader>& romfs_file) {
+    return base_ncch.ReadRomFS(romfs_file);
 }
 
-ResultStatus AppLoader_NCCH::ReadUpdateRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file,
-                                             u64& offset, u64& size) {
-    ResultStatus result = update_ncch.ReadRomFS(romfs_file, offset, size);
+ResultStatus AppLoader_NCCH::ReadUpdateRomFS(std::shared_ptr<FileSys::RomFSReader>& romfs_file) {
+    ResultStatus result = update_ncch.ReadRomFS(romfs_file);
 
     if (result != ResultStatus::Success)
-        return base_ncch.ReadRomFS(romfs_file, offset, size);
+        return base_ncch.ReadRomFS(romfs_file);
 
     return ResultStatus::Success;
 }
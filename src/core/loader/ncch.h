@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <future>
 #include <memory>
+#include <utility>
+#include <vector>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/file_sys/ncch_container.h"
@@ -41,6 +44,9 @@ public:
      */
     std::pair<boost::optional<u32>, ResultStatus> LoadKernelSystemMode() override;
 
+    /// Picks the update of the title, if there is one, and starts reading its .code.
+    void Preload() override;
+
     ResultStatus ReadCode(std::vector<u8>& buffer) override;
 
     ResultStatus ReadIcon(std::vector<u8>& buffer) override;
@@ -51,11 +57,9 @@ public:
 
     ResultStatus ReadProgramId(u64& out_program_id) override;
 
-    ResultStatus ReadRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
-                           u64& size) override;
+    ResultStatus ReadRomFS(std::shared_ptr<FileSys::RomFSReader>& romfs_file) override;
 
-    ResultStatus ReadUpdateRomFS(std::shared_ptr<FileUtil::IOFile>& romfs_file, u64& offset,
-                                 u64& size) override;
+    ResultStatus ReadUpdateRomFS(std::shared_ptr<FileSys::RomFSReader>& romfs_file) override;
 
     ResultStatus ReadTitle(std::string& title) override;
 
@@ -70,11 +74,18 @@ private:
     /// Reads the region lockout info in the SMDH and send it to CFG service
     void ParseRegionLockoutInfo();
 
+    /// Uses the ExeFS of the installed update of the title in place of its own, if there is one.
+    void OpenUpdate();
+
     FileSys::NCCHContainer base_ncch;
     FileSys::NCCHContainer update_ncch;
     FileSys::NCCHContainer* overlay_ncch;
+    bool update_opened = false;
 
     std::string filepath;
+
+    /// Result of reading the .code started by Preload, which LoadExec waits for
+    std::future<std::pair<ResultStatus, std::vector<u8>>> preloaded_code;
 };
 
 } // namespace Loader
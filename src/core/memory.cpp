@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 #include "audio_core/dsp_interface.h"
@@ -37,6 +38,29 @@ PageTable* GetCurrentPageTable() {
     return current_page_table;
 }
 
+/**
+ * Calls visit with each page of type `RasterizerCachedMemory` in [first_page, end_page), until it
+ * returns false. Groups of pages without any cached page are skipped as a whole.
+ */
+template <typename Visitor>
+static void VisitCachedPages(const PageTable& page_table, u32 first_page, u32 end_page,
+                             Visitor visit) {
+    u32 page = first_page;
+    while (page != end_page) {
+        const u32 group = page >> PAGE_GROUP_BITS;
+        const u32 group_end = std::min<u32>((group + 1) << PAGE_GROUP_BITS, end_page);
+        if (page_table.cached_page_counts[group] != 0) {
+            for (; page != group_end; ++page) {
+                if (page_table.attributes[page] == PageType::RasterizerCachedMemory &&
+                    !visit(page)) {
+                    return;
+                }
+            }
+        }
+        page = group_end;
+    }
+}
+
 static void MapPages(PageTable& page_table, u32 base, u32 size, u8* memory, PageType type) {
     LOG_DEBUG(HW_Memory, "Mapping %p onto %08X-%08X", memory, base * PAGE_SIZE,
               (base + size) * PAGE_SIZE);
@@ -44,16 +68,22 @@ static void MapPages(PageTable& page_table, u32 base, u32 size, u8* memory, Page
     RasterizerFlushVirtualRegion(base << PAGE_BITS, size * PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
-    u32 end = base + size;
-    while (base != end) {
-        ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
-
-        page_table.attributes[base] = type;
-        page_table.pointers[base] = memory;
+    const u32 end = base + size;
+    ASSERT_MSG(base <= end && end <= PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}",
+               base);
 
-        base += 1;
-        if (memory != nullptr)
-            memory += PAGE_SIZE;
+    // Pages still marked as cached are replaced by the new mapping
+    VisitCachedPages(page_table, base, end, [&page_table](u32 page) {
+        --page_table.cached_page_counts[page >> PAGE_GROUP_BITS];
+        return true;
+    });
+
+    std::fill(page_table.attributes.begin() + base, page_table.attributes.begin() + end, type);
+    if (memory == nullptr) {
+        std::fill(page_table.pointers.begin() + base, page_table.pointers.begin() + end, nullptr);
+    } else {
+        for (u32 page = base; page != end; ++page, memory += PAGE_SIZE)
+            page_table.pointers[page] = memory;
     }
 }
 
@@ -79,17 +109,11 @@ void UnmapRegion(PageTable& page_table, VAddr base, u32 size) {
 
 /**
  * Gets a pointer to the exact memory at the virtual address (i.e. not page aligned)
- * using a VMA from the current process
+ * using the VMA containing it
  */
-static u8* GetPointerFromVMA(const Kernel::Process& process, VAddr vaddr) {
+static u8* GetPointerFromVMA(const Kernel::VirtualMemoryArea& vma, VAddr vaddr) {
     u8* direct_pointer = nullptr;
 
-    auto& vm_manager = process.vm_manager;
-
-    auto it = vm_manager.FindVMA(vaddr);
-    ASSERT(it != vm_manager.vma_map.end());
-
-    auto& vma = it->second;
     switch (vma.type) {
     case Kernel::VMAType::AllocatedMemoryBlock:
         direct_pointer = vma.backing_block->data() + vma.offset;
@@ -106,6 +130,19 @@ static u8* GetPointerFromVMA(const Kernel::Process& process, VAddr vaddr) {
     return direct_pointer + (vaddr - vma.base);
 }
 
+/**
+ * Gets a pointer to the exact memory at the virtual address (i.e. not page aligned)
+ * using a VMA from the current process
+ */
+static u8* GetPointerFromVMA(const Kernel::Process& process, VAddr vaddr) {
+    auto& vm_manager = process.vm_manager;
+
+    auto it = vm_manager.FindVMA(vaddr);
+    ASSERT(it != vm_manager.vma_map.end());
+
+    return GetPointerFromVMA(it->second, vaddr);
+}
+
 /**
  * Gets a pointer to the exact memory at the virtual address (i.e. not page aligned)
  * using a VMA from the current process.
@@ -250,6 +287,27 @@ u8* GetPointer(const VAddr vaddr) {
     return nullptr;
 }
 
+u8* GetContiguousPointer(const Kernel::Process& process, const VAddr vaddr, const size_t size) {
+    const auto& page_table = process.vm_manager.page_table;
+    const size_t first_page = vaddr >> PAGE_BITS;
+    if (size == 0 || page_table.attributes[first_page] != PageType::Memory)
+        return nullptr;
+
+    u8* const block_pointer = page_table.pointers[first_page] + (vaddr & PAGE_MASK);
+    const size_t last_page = (vaddr + size - 1) >> PAGE_BITS;
+    if (last_page >= PAGE_TABLE_NUM_ENTRIES)
+        return nullptr;
+
+    for (size_t page = first_page + 1; page <= last_page; ++page) {
+        const u8* expected_pointer = block_pointer + ((page << PAGE_BITS) - vaddr);
+        if (page_table.attributes[page] != PageType::Memory ||
+            page_table.pointers[page] != expected_pointer) {
+            return nullptr;
+        }
+    }
+    return block_pointer;
+}
+
 std::string ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -324,6 +382,62 @@ u8* GetPhysicalPointer(PAddr address) {
     return target_pointer;
 }
 
+static void MarkPagesCached(PageTable& page_table, u32 first_page, u32 count) {
+    for (u32 page = first_page; page != first_page + count; ++page) {
+        PageType& page_type = page_table.attributes[page];
+        switch (page_type) {
+        case PageType::Unmapped:
+            // It is not necessary for a process to have this region mapped into its address
+            // space, for example, a system module need not have a VRAM mapping.
+            break;
+        case PageType::Memory:
+            page_type = PageType::RasterizerCachedMemory;
+            page_table.pointers[page] = nullptr;
+            ++page_table.cached_page_counts[page >> PAGE_GROUP_BITS];
+            break;
+        default:
+            UNREACHABLE();
+        }
+    }
+}
+
+static void MarkPagesUncached(PageTable& page_table, u32 first_page, u32 count) {
+    // Only the cached pages are visited below, the others must be unmapped. It is not necessary
+    // for a process to have the region mapped, for example, a system module need not have a VRAM
+    // mapping.
+    for (u32 page = first_page; page != first_page + count; ++page) {
+        DEBUG_ASSERT_MSG(page_table.attributes[page] == PageType::Unmapped ||
+                             page_table.attributes[page] == PageType::RasterizerCachedMemory,
+                         "uncaching page {:08X} which is not cached", page << PAGE_BITS);
+    }
+
+    const auto& vm_manager = Kernel::g_current_process->vm_manager;
+    auto vma = vm_manager.vma_map.end();
+
+    VisitCachedPages(page_table, first_page, first_page + count, [&](u32 page) {
+        const VAddr vaddr = page << PAGE_BITS;
+        // Consecutive pages are usually backed by the same VMA, so it is only looked up again
+        // once a page is past it
+        if (vma == vm_manager.vma_map.end() || vaddr - vma->second.base >= vma->second.size) {
+            vma = vm_manager.FindVMA(vaddr);
+            ASSERT(vma != vm_manager.vma_map.end());
+        }
+
+        u8* pointer = GetPointerFromVMA(vma->second, vaddr);
+        if (pointer == nullptr) {
+            // It's possible that this function has been called while updating the pagetable
+            // after unmapping a VMA. In that case the underlying VMA will no longer exist,
+            // and we should just leave the pagetable entry blank.
+            page_table.attributes[page] = PageType::Unmapped;
+        } else {
+            page_table.attributes[page] = PageType::Memory;
+            page_table.pointers[page] = pointer;
+        }
+        --page_table.cached_page_counts[page >> PAGE_GROUP_BITS];
+        return true;
+    });
+}
+
 void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached) {
     if (start == 0) {
         return;
@@ -332,7 +446,7 @@ void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached) {
     u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
     PAddr paddr = start;
 
-    for (unsigned i = 0; i < num_pages; ++i, paddr += PAGE_SIZE) {
+    for (u32 i = 0; i < num_pages;) {
         boost::optional<VAddr> maybe_vaddr = PhysicalToVirtualAddress(paddr);
         // While the physical <-> virtual mapping is 1:1 for the regions supported by the cache,
         // some games (like Pokemon Super Mystery Dungeon) will try to use textures that go beyond
@@ -341,51 +455,46 @@ void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached) {
         if (!maybe_vaddr) {
             LOG_ERROR(HW_Memory,
                       "Trying to flush a cached region to an invalid physical address %08X", paddr);
+            ++i;
+            paddr += PAGE_SIZE;
             continue;
         }
-        VAddr vaddr = *maybe_vaddr;
 
-        PageType& page_type = current_page_table->attributes[vaddr >> PAGE_BITS];
+        // Update the whole run of pages that is mapped linearly at once
+        const u32 first_page = *maybe_vaddr >> PAGE_BITS;
+        u32 count = 1;
+        while (i + count < num_pages) {
+            boost::optional<VAddr> next = PhysicalToVirtualAddress(paddr + count * PAGE_SIZE);
+            if (!next || (*next >> PAGE_BITS) != first_page + count)
+                break;
+            ++count;
+        }
 
         if (cached) {
-            // Switch page type to cached if now cached
-            switch (page_type) {
-            case PageType::Unmapped:
-                // It is not necessary for a process to have this region mapped into its address
-                // space, for example, a system module need not have a VRAM mapping.
-                break;
-            case PageType::Memory:
-                page_type = PageType::RasterizerCachedMemory;
-                current_page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
-                break;
-            default:
-                UNREACHABLE();
-            }
+            MarkPagesCached(*current_page_table, first_page, count);
         } else {
-            // Switch page type to uncached if now uncached
-            switch (page_type) {
-            case PageType::Unmapped:
-                // It is not necessary for a process to have this region mapped into its address
-                // space, for example, a system module need not have a VRAM mapping.
-                break;
-            case PageType::RasterizerCachedMemory: {
-                u8* pointer = GetPointerFromVMA(vaddr & ~PAGE_MASK);
-                if (pointer == nullptr) {
-                    // It's possible that this function has been called while updating the pagetable
-                    // after unmapping a VMA. In that case the underlying VMA will no longer exist,
-                    // and we should just leave the pagetable entry blank.
-                    page_type = PageType::Unmapped;
-                } else {
-                    page_type = PageType::Memory;
-                    current_page_table->pointers[vaddr >> PAGE_BITS] = pointer;
-                }
-                break;
-            }
-            default:
-                UNREACHABLE();
-            }
+            MarkPagesUncached(*current_page_table, first_page, count);
         }
+
+        i += count;
+        paddr += count * PAGE_SIZE;
+    }
+}
+
+bool IsRegionRasterizerCached(const PageTable& page_table, VAddr start, u32 size) {
+    if (size == 0) {
+        return false;
     }
+
+    const u32 first_page = start >> PAGE_BITS;
+    const u32 end_page = static_cast<u32>((static_cast<u64>(start) + size - 1) >> PAGE_BITS) + 1;
+    bool cached = false;
+    VisitCachedPages(page_table, first_page, std::min<u32>(end_page, PAGE_TABLE_NUM_ENTRIES),
+                     [&cached](u32) {
+                         cached = true;
+                         return false;
+                     });
+    return cached;
 }
 
 void RasterizerFlushRegion(PAddr start, u32 size) {
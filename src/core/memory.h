@@ -27,6 +27,10 @@ const u32 PAGE_MASK = PAGE_SIZE - 1;
 const int PAGE_BITS = 12;
 const size_t PAGE_TABLE_NUM_ENTRIES = 1 << (32 - PAGE_BITS);
 
+/// Pages are summarized in groups of 1 << PAGE_GROUP_BITS pages (1MB) in a PageTable
+const int PAGE_GROUP_BITS = 8;
+const size_t PAGE_GROUP_NUM_ENTRIES = PAGE_TABLE_NUM_ENTRIES >> PAGE_GROUP_BITS;
+
 enum class PageType {
     /// Page is unmapped and should cause an access error.
     Unmapped,
@@ -69,6 +73,12 @@ struct PageTable {
      * the corresponding entry in `pointers` MUST be set to null.
      */
     std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
+
+    /**
+     * Number of pages of type `RasterizerCachedMemory` in each group of pages. Lets range queries
+     * and updates skip the groups without any cached page instead of looking at all their pages.
+     */
+    std::array<u16, PAGE_GROUP_NUM_ENTRIES> cached_page_counts;
 };
 
 /// Physical memory regions as seen from the ARM11
@@ -209,6 +219,15 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, size_t size);
 
 u8* GetPointer(VAddr virtual_address);
 
+/**
+ * Gets a pointer through which a block of the process' memory can be accessed directly. This is
+ * only possible if the whole block is regular memory (see PageType::Memory) and lies contiguously
+ * in host memory.
+ * @returns Host pointer to the start of the block, or nullptr if the block can't be accessed
+ * directly, in which case ReadBlock/WriteBlock must be used instead.
+ */
+u8* GetContiguousPointer(const Kernel::Process& process, VAddr vaddr, size_t size);
+
 std::string ReadCString(VAddr virtual_address, std::size_t max_length);
 
 /**
@@ -240,6 +259,11 @@ u8* GetPhysicalPointer(PAddr address);
  */
 void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached);
 
+/**
+ * Determines if any page touching the virtual region is marked as cached in the page table.
+ */
+bool IsRegionRasterizerCached(const PageTable& page_table, VAddr start, u32 size);
+
 /**
  * Flushes any externally cached rasterizer resources touching the given region.
  */
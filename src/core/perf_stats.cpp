@@ -5,7 +5,10 @@
 #include <chrono>
 #include <mutex>
 #include <thread>
+#include "audio_core/dsp_interface.h"
+#include "audio_core/sink.h"
 #include "common/math_util.h"
+#include "core/core.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
 #include "core/settings.h"
@@ -56,6 +59,13 @@ PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
     results.frametime = duration_cast<DoubleSecs>(accumulated_frametime).count() /
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second / 1'000'000.0;
+    if (audio_pacing_samples > 0) {
+        results.audio_queue_ms = accumulated_audio_queue_ms / audio_pacing_samples;
+        results.audio_speed_correction = accumulated_audio_speed_correction / audio_pacing_samples;
+    } else {
+        results.audio_speed_correction = 1.0;
+    }
+    results.dropped_audio_frames = dropped_audio_frames;
 
     // Reset counters
     reset_point = now;
@@ -63,10 +73,24 @@ PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
     accumulated_frametime = Clock::duration::zero();
     system_frames = 0;
     game_frames = 0;
+    accumulated_audio_queue_ms = 0.0;
+    accumulated_audio_speed_correction = 0.0;
+    audio_pacing_samples = 0;
+    dropped_audio_frames = 0;
 
     return results;
 }
 
+void PerfStats::AddAudioPacingSample(double queue_ms, double speed_correction,
+                                     u32 dropped_frames) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    accumulated_audio_queue_ms += queue_ms;
+    accumulated_audio_speed_correction += speed_correction;
+    audio_pacing_samples += 1;
+    dropped_audio_frames += dropped_frames;
+}
+
 double PerfStats::GetLastFrameTimeScale() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -74,13 +98,52 @@ double PerfStats::GetLastFrameTimeScale() {
     return duration_cast<DoubleSecs>(previous_frame_length).count() / FRAME_LENGTH;
 }
 
+/// Audio queue depth, in samples, that audio pacing aims for. The sinks consume audio in blocks of
+/// 512 samples, so this leaves about one block of headroom. About 31 milliseconds.
+constexpr double audio_pacing_target_depth = 1024.0;
+/// Weight of the newest measurement in the smoothed audio queue depth
+constexpr double audio_queue_smoothing = 0.05;
+/// Speed correction per target depth of queue error
+constexpr double audio_pacing_gain = 0.05;
+/// Largest speed correction audio pacing may apply. Small enough that the change in pitch of the
+/// audio, and in speed of the game, goes unnoticed.
+constexpr double audio_pacing_max_correction = 0.05;
+
+double FrameLimiter::UpdateAudioPacing() {
+    Core::System& system = Core::System::GetInstance();
+    AudioCore::DspInterface& dsp = system.DSP();
+    const AudioCore::Sink& sink = dsp.GetSink();
+
+    const size_t queued_samples = sink.SamplesInQueue();
+    smoothed_queue_depth += (queued_samples - smoothed_queue_depth) * audio_queue_smoothing;
+
+    // An empty queue means either that the sink doesn't consume audio (the null sink) or that
+    // emulation is running behind. Walltime is the better reference in both cases.
+    double speed_correction = 1.0;
+    if (Settings::values.enable_audio_pacing && Settings::values.use_frame_limit &&
+        Settings::values.frame_limit == 100 && queued_samples > 0) {
+        const double error =
+            (smoothed_queue_depth - audio_pacing_target_depth) / audio_pacing_target_depth;
+        speed_correction = MathUtil::Clamp(1.0 - error * audio_pacing_gain,
+                                           1.0 - audio_pacing_max_correction,
+                                           1.0 + audio_pacing_max_correction);
+    }
+
+    system.perf_stats.AddAudioPacingSample(queued_samples * 1000.0 / sink.GetNativeSampleRate(),
+                                           speed_correction, dsp.GetAndResetDroppedFrameCount());
+    return speed_correction;
+}
+
 void FrameLimiter::DoFrameLimiting(u64 current_system_time_us) {
+    const double speed_correction = UpdateAudioPacing();
+
     if (!Settings::values.use_frame_limit) {
         return;
     }
 
     auto now = Clock::now();
-    double sleep_scale = Settings::values.frame_limit / 100.0;
+    // Running slower than the audio device plays lets its queue drain, and the other way around
+    double sleep_scale = Settings::values.frame_limit / 100.0 * speed_correction;
 
     // Max lag caused by slow frames. Shouldn't be more than the length of a frame at the current
     // speed percent or it will clamp too much and prevent this from properly limiting to that
@@ -27,12 +27,27 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Average amount of audio queued for the output device, in milliseconds
+        double audio_queue_ms;
+        /// Average factor the frame limiter scaled the emulation speed by to pace it by the audio
+        /// output. 1.0 when audio pacing is not active.
+        double audio_speed_correction;
+        /// Audio frames dropped because the output queue was full
+        u32 dropped_audio_frames;
     };
 
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
 
+    /**
+     * Records the audio output state at the end of a system frame.
+     * @param queue_ms Amount of audio queued for the output device, in milliseconds
+     * @param speed_correction Speed factor applied by audio pacing, 1.0 if inactive
+     * @param dropped_frames Audio frames dropped since the previous call
+     */
+    void AddAudioPacingSample(double queue_ms, double speed_correction, u32 dropped_frames);
+
     Results GetAndResetStats(u64 current_system_time_us);
 
     /**
@@ -62,6 +77,15 @@ private:
     Clock::time_point frame_begin = reset_point;
     /// Total visible duration (including frame-limiting, etc.) of the previous system frame
     Clock::duration previous_frame_length = Clock::duration::zero();
+
+    /// Cumulative audio queue depth, in milliseconds, of the samples since last reset
+    double accumulated_audio_queue_ms = 0.0;
+    /// Cumulative audio pacing speed correction of the samples since last reset
+    double accumulated_audio_speed_correction = 0.0;
+    /// Number of audio pacing samples since last reset
+    u32 audio_pacing_samples = 0;
+    /// Cumulative number of dropped audio frames since last reset
+    u32 dropped_audio_frames = 0;
 };
 
 class FrameLimiter {
@@ -71,6 +95,13 @@ public:
     void DoFrameLimiting(u64 current_system_time_us);
 
 private:
+    /**
+     * Measures the audio output queue and, when audio pacing is active, works out how much to
+     * speed up or slow down emulation to keep the queue at its target depth.
+     * @return Factor to scale the emulation speed by
+     */
+    double UpdateAudioPacing();
+
     /// Emulated system time (in microseconds) at the last limiter invocation
     u64 previous_system_time_us = 0;
     /// Walltime at the last limiter invocation
@@ -78,6 +109,9 @@ private:
 
     /// Accumulated difference between walltime and emulated time
     std::chrono::microseconds frame_limiting_delta_err{0};
+
+    /// Audio output queue depth in samples, low-pass filtered to remove the sink's block jitter
+    double smoothed_queue_depth = 0.0;
 };
 
 } // namespace Core
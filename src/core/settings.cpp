@@ -33,7 +33,7 @@ void Apply() {
 
     if (Core::System::GetInstance().IsPoweredOn()) {
         Core::DSP().SetSink(values.sink_id);
-        Core::DSP().EnableStretching(values.enable_audio_stretching);
+        Core::DSP().EnableStretching(values.enable_audio_stretching && !values.enable_audio_pacing);
     }
 
     Service::HID::ReloadInputDevices();
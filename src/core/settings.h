@@ -101,6 +101,7 @@ struct Values {
 
     // Data Storage
     bool use_virtual_sd;
+    bool watch_host_files;
 
     // System Region
     int region_value;
@@ -138,6 +139,8 @@ struct Values {
     // Audio
     std::string sink_id;
     bool enable_audio_stretching;
+    bool enable_dsp_thread;
+    bool enable_audio_pacing;
     std::string audio_device_id;
 
     // Camera
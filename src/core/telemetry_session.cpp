@@ -164,6 +164,10 @@ TelemetrySession::TelemetrySession() {
     // Log user configuration information
     AddField(Telemetry::FieldType::UserConfig, "Audio_EnableAudioStretching",
              Settings::values.enable_audio_stretching);
+    AddField(Telemetry::FieldType::UserConfig, "Audio_EnableDspThread",
+             Settings::values.enable_dsp_thread);
+    AddField(Telemetry::FieldType::UserConfig, "Audio_EnableAudioPacing",
+             Settings::values.enable_audio_pacing);
     AddField(Telemetry::FieldType::UserConfig, "Core_UseCpuJit", Settings::values.use_cpu_jit);
     AddField(Telemetry::FieldType::UserConfig, "Renderer_ResolutionFactor",
              Settings::values.resolution_factor);
@@ -0,0 +1,137 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "audio_core/audio_types.h"
+#include "audio_core/codec.h"
+
+using AudioCore::StereoBuffer16;
+
+static std::vector<u8> RandomBytes(size_t size, u32 seed) {
+    std::mt19937 rng(seed);
+    std::vector<u8> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<u8>(rng());
+    }
+    return data;
+}
+
+static std::vector<StereoBuffer16::Sample> Drain(StereoBuffer16& buffer) {
+    std::vector<StereoBuffer16::Sample> samples(buffer.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = buffer[i];
+    }
+    buffer.pop_front(samples.size());
+    return samples;
+}
+
+// Decodes sample_count samples in chunks of varying size, draining the output in between so that
+// the ring buffer wraps around.
+template <typename DecodeFunc>
+static std::vector<StereoBuffer16::Sample> DecodeInChunks(size_t sample_count, DecodeFunc decode) {
+    static constexpr size_t chunk_sizes[] = {1, 13, 160, 2, 7, 900, 64};
+    StereoBuffer16 buffer;
+    std::vector<StereoBuffer16::Sample> result;
+    size_t position = 0;
+    for (size_t i = 0; position < sample_count; ++i) {
+        const size_t count = std::min(chunk_sizes[i % 7], sample_count - position);
+        decode(position, count, buffer);
+        position += count;
+        const auto samples = Drain(buffer);
+        result.insert(result.end(), samples.begin(), samples.end());
+    }
+    return result;
+}
+
+TEST_CASE("StereoBuffer16 wraps around", "[audio_core]") {
+    StereoBuffer16 buffer;
+    REQUIRE(buffer.empty());
+    REQUIRE(buffer.free_space() == StereoBuffer16::capacity);
+
+    s16 next = 0;
+    s16 expected = 0;
+    for (int round = 0; round < 10; ++round) {
+        while (buffer.free_space() > 100) {
+            buffer.push_back({next, static_cast<s16>(-next)});
+            ++next;
+        }
+        REQUIRE(buffer.size() == StereoBuffer16::capacity - 100);
+        for (size_t i = 0; i < 700; ++i) {
+            REQUIRE(buffer[i][0] == static_cast<s16>(expected + i));
+            REQUIRE(buffer[i][1] == static_cast<s16>(-(expected + i)));
+        }
+        buffer.pop_front(700);
+        expected += 700;
+    }
+    buffer.clear();
+    REQUIRE(buffer.empty());
+}
+
+TEST_CASE("Codec decodes buffers incrementally", "[audio_core][codec]") {
+    constexpr size_t sample_count = 3001;
+    const std::vector<u8> data = RandomBytes(sample_count * 4, 3);
+
+    SECTION("PCM8") {
+        for (unsigned num_channels : {1u, 2u}) {
+            StereoBuffer16 whole;
+            AudioCore::Codec::DecodePCM8(num_channels, data.data(), 0, 1000, whole);
+            const auto expected = Drain(whole);
+            const auto chunked = DecodeInChunks(1000, [&](size_t first, size_t count,
+                                                          StereoBuffer16& output) {
+                AudioCore::Codec::DecodePCM8(num_channels, data.data(), first, count, output);
+            });
+            REQUIRE(chunked == expected);
+            for (size_t i = 0; i < 1000; ++i) {
+                const u8* sample = &data[i * num_channels];
+                REQUIRE(expected[i][0] == static_cast<s16>(static_cast<s8>(sample[0]) << 8));
+                REQUIRE(expected[i][1] ==
+                        static_cast<s16>(static_cast<s8>(sample[num_channels - 1]) << 8));
+            }
+        }
+    }
+
+    SECTION("PCM16") {
+        for (unsigned num_channels : {1u, 2u}) {
+            StereoBuffer16 whole;
+            AudioCore::Codec::DecodePCM16(num_channels, data.data(), 0, 1000, whole);
+            const auto expected = Drain(whole);
+            const auto chunked = DecodeInChunks(1000, [&](size_t first, size_t count,
+                                                          StereoBuffer16& output) {
+                AudioCore::Codec::DecodePCM16(num_channels, data.data(), first, count, output);
+            });
+            REQUIRE(chunked == expected);
+        }
+    }
+
+    SECTION("ADPCM") {
+        std::array<s16, 16> coeff;
+        std::mt19937 rng(7);
+        for (auto& c : coeff) {
+            c = static_cast<s16>(rng() % 4096) - 2048;
+        }
+
+        // Decoding the whole buffer at once in several calls, each from a fresh state
+        std::vector<StereoBuffer16::Sample> expected;
+        {
+            AudioCore::Codec::ADPCMState state{};
+            StereoBuffer16 whole;
+            for (size_t first = 0; first < sample_count; first += 1000) {
+                const size_t count = std::min<size_t>(1000, sample_count - first);
+                AudioCore::Codec::DecodeADPCM(data.data(), first, count, coeff, state, whole);
+                const auto samples = Drain(whole);
+                expected.insert(expected.end(), samples.begin(), samples.end());
+            }
+        }
+
+        AudioCore::Codec::ADPCMState state{};
+        const auto chunked = DecodeInChunks(sample_count, [&](size_t first, size_t count,
+                                                              StereoBuffer16& output) {
+            AudioCore::Codec::DecodeADPCM(data.data(), first, count, coeff, state, output);
+        });
+        REQUIRE(chunked == expected);
+    }
+}
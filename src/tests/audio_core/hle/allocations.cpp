@@ -0,0 +1,115 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// This file is built into its own test executable, tests-allocations, as it replaces the global
+// allocation functions to count the allocations made by the code under test.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+#include <catch.hpp>
+#include "audio_core/hle/mixers.h"
+#include "audio_core/hle/shared_memory.h"
+#include "audio_core/hle/source.h"
+#include "core/memory.h"
+#include "tests/audio_core/hle/source_test_common.h"
+
+using AudioCore::HLE::Source;
+using AudioTests::Configuration;
+using AudioTests::MakeConfig;
+using AudioTests::no_adpcm_coeffs;
+
+// Counts heap allocations made by the test thread while counting is enabled
+static thread_local bool count_allocations = false;
+static std::atomic<size_t> allocation_count{0};
+
+void* operator new(size_t size) {
+    if (count_allocations)
+        ++allocation_count;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+static void RunSources(int num_frames, bool print_stats) {
+    constexpr size_t num_sources = AudioCore::HLE::num_sources;
+    constexpr u32 length = 4000;
+    constexpr Configuration::Format formats[] = {
+        Configuration::Format::PCM8, Configuration::Format::PCM16, Configuration::Format::ADPCM};
+    constexpr Configuration::InterpolationMode modes[] = {
+        Configuration::InterpolationMode::Polyphase, Configuration::InterpolationMode::Linear,
+        Configuration::InterpolationMode::None};
+
+    u8* memory = Memory::GetPhysicalPointer(Memory::VRAM_PADDR);
+    for (u32 i = 0; i < length * 2; ++i) {
+        memory[i] = static_cast<u8>(i * 31);
+    }
+
+    std::vector<std::unique_ptr<Source>> sources;
+    std::vector<Configuration> configs;
+    for (size_t i = 0; i < num_sources; ++i) {
+        sources.emplace_back(std::make_unique<Source>(i));
+        configs.emplace_back(MakeConfig(Memory::VRAM_PADDR, length, formats[i % 3],
+                                        modes[i / 3 % 2], 0.75f + 0.05f * i, true));
+    }
+    auto mixers = std::make_unique<AudioCore::HLE::Mixers>();
+    auto dsp_config = std::make_unique<AudioCore::HLE::DspConfiguration>();
+    auto read_samples = std::make_unique<AudioCore::HLE::IntermediateMixSamples>();
+    auto write_samples = std::make_unique<AudioCore::HLE::IntermediateMixSamples>();
+    std::array<AudioCore::QuadFrame32, 3> intermediate_mixes{};
+
+    // Let every source allocate its buffer queue before counting
+    for (size_t i = 0; i < num_sources; ++i) {
+        sources[i]->Tick(configs[i], no_adpcm_coeffs);
+    }
+
+    allocation_count = 0;
+    count_allocations = true;
+    const auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < num_frames; ++frame) {
+        for (auto& mix : intermediate_mixes) {
+            mix.fill({});
+        }
+        for (size_t i = 0; i < num_sources; ++i) {
+            sources[i]->Tick(configs[i], no_adpcm_coeffs);
+            for (size_t mix = 0; mix < intermediate_mixes.size(); ++mix) {
+                sources[i]->MixInto(intermediate_mixes[mix], mix);
+            }
+        }
+        mixers->Tick(*dsp_config, *read_samples, *write_samples, intermediate_mixes);
+    }
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    count_allocations = false;
+
+    if (print_stats) {
+        std::printf("%d frames, %zu sources: %zu allocations, %.0f ns/frame\n", num_frames,
+                    num_sources, allocation_count.load(), elapsed.count() / num_frames);
+    }
+    REQUIRE(allocation_count == 0);
+
+    std::memset(memory, 0, length * 2);
+}
+
+TEST_CASE("HLE Source and Mixers do not allocate per frame", "[audio_core][hle]") {
+    RunSources(1000, false);
+}
+
+TEST_CASE("HLE Source and Mixers benchmark", "[.][benchmark][audio_core][hle]") {
+    RunSources(10000, true);
+}
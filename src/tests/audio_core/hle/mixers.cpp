@@ -0,0 +1,104 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <catch.hpp>
+#include "audio_core/hle/filter.h"
+#include "audio_core/hle/mixers.h"
+#include "audio_core/hle/shared_memory.h"
+
+using namespace AudioCore;
+
+static s16 Clamp16(s32 value) {
+    return static_cast<s16>(std::clamp(value, -32768, 32767));
+}
+
+TEST_CASE("Mixers downmix intermediate mixes to stereo", "[audio_core][hle]") {
+    constexpr std::array<float, 3> volumes = {1.0f, 0.5f, 0.3f};
+
+    auto mixers = std::make_unique<HLE::Mixers>();
+    auto config = std::make_unique<HLE::DspConfiguration>();
+    auto read_samples = std::make_unique<HLE::IntermediateMixSamples>();
+    auto write_samples = std::make_unique<HLE::IntermediateMixSamples>();
+    for (size_t i = 0; i < 3; i++) {
+        config->volume[i] = volumes[i];
+    }
+    config->volume_0_dirty.Assign(1);
+    config->volume_1_dirty.Assign(1);
+    config->volume_2_dirty.Assign(1);
+
+    // Large enough to hit the clamping of both the downmix and the accumulation
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<s32> distribution(-40000, 40000);
+    std::array<QuadFrame32, 3> input;
+    for (auto& mix : input) {
+        for (auto& sample : mix) {
+            for (auto& channel : sample) {
+                channel = distribution(rng);
+            }
+        }
+    }
+
+    mixers->Tick(*config, *read_samples, *write_samples, input);
+    const StereoFrame16& output = mixers->GetOutput();
+
+    for (size_t samplei = 0; samplei < samples_per_frame; samplei++) {
+        std::array<s16, 2> expected = {};
+        for (size_t mix = 0; mix < 3; mix++) {
+            const float gain = volumes[mix];
+            const auto& sample = input[mix][samplei];
+            const s16 left = Clamp16(static_cast<s32>(gain * sample[0] + gain * sample[2]));
+            const s16 right = Clamp16(static_cast<s32>(gain * sample[1] + gain * sample[3]));
+            expected = {Clamp16(expected[0] + left), Clamp16(expected[1] + right)};
+        }
+        REQUIRE(output[samplei] == expected);
+    }
+}
+
+TEST_CASE("SourceFilters applies the simple and biquad filters", "[audio_core][hle]") {
+    HLE::SourceConfiguration::Configuration::SimpleFilter simple;
+    simple.b0 = 0x5000;
+    simple.a1 = -0x2000;
+    HLE::SourceConfiguration::Configuration::BiquadFilter biquad;
+    biquad.b0 = 0x2000;
+    biquad.b1 = 0x1800;
+    biquad.b2 = -0x0800;
+    biquad.a1 = 0x3000;
+    biquad.a2 = -0x1400;
+
+    HLE::SourceFilters filters;
+    filters.Enable(true, true);
+    filters.Configure(simple);
+    filters.Configure(biquad);
+
+    std::mt19937 rng(9);
+    std::array<s32, 2> simple_y1{}, x1{}, x2{}, y1{}, y2{};
+    // Several frames, so that state carried across frames is covered
+    for (int frame_index = 0; frame_index < 3; frame_index++) {
+        StereoFrame16 frame;
+        for (auto& sample : frame) {
+            sample = {static_cast<s16>(rng()), static_cast<s16>(rng())};
+        }
+        StereoFrame16 expected = frame;
+        for (auto& sample : expected) {
+            for (size_t i = 0; i < 2; i++) {
+                const s32 s = Clamp16((simple.b0 * sample[i] + simple.a1 * simple_y1[i]) >> 15);
+                simple_y1[i] = s;
+                const s32 b = Clamp16((biquad.b0 * s + biquad.b1 * x1[i] + biquad.b2 * x2[i] +
+                                       biquad.a1 * y1[i] + biquad.a2 * y2[i]) >>
+                                      14);
+                x2[i] = x1[i];
+                x1[i] = s;
+                y2[i] = y1[i];
+                y1[i] = b;
+                sample[i] = static_cast<s16>(b);
+            }
+        }
+
+        filters.ProcessFrame(frame);
+        REQUIRE(frame == expected);
+    }
+}
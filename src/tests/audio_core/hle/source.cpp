@@ -0,0 +1,94 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <catch.hpp>
+#include "audio_core/hle/source.h"
+#include "core/memory.h"
+#include "tests/audio_core/hle/source_test_common.h"
+
+using AudioCore::HLE::Source;
+using AudioTests::Configuration;
+using AudioTests::MakeConfig;
+using AudioTests::no_adpcm_coeffs;
+
+TEST_CASE("HLE Source plays back a PCM16 buffer", "[audio_core][hle]") {
+    // Longer than the decoding ring buffer, so the buffer is decoded over several frames
+    constexpr u32 length = 3000;
+    u8* memory = Memory::GetPhysicalPointer(Memory::VRAM_PADDR);
+    std::vector<s16> input(length);
+    for (u32 i = 0; i < length; ++i) {
+        input[i] = static_cast<s16>(i * 7 - 10000);
+    }
+    std::memcpy(memory, input.data(), length * sizeof(s16));
+
+    auto source = std::make_unique<Source>(0);
+    Configuration config = MakeConfig(Memory::VRAM_PADDR, length, Configuration::Format::PCM16,
+                                      Configuration::InterpolationMode::None, 1.0f, false);
+
+    std::vector<s32> output;
+    for (int frame = 0; frame < 20; ++frame) {
+        const auto status = source->Tick(config, no_adpcm_coeffs);
+        AudioCore::QuadFrame32 mix{};
+        source->MixInto(mix, 0);
+        for (const auto& sample : mix) {
+            output.push_back(sample[0]);
+        }
+        if (!status.is_enabled)
+            break;
+    }
+
+    // The interpolator delays its output by two samples, and keeps the last two samples of the
+    // buffer as history for the next one.
+    REQUIRE(output.size() >= length);
+    REQUIRE(output[0] == 0);
+    REQUIRE(output[1] == 0);
+    for (u32 i = 0; i < length - 2; ++i) {
+        REQUIRE(output[i + 2] == input[i]);
+    }
+
+    std::memset(memory, 0, length * sizeof(s16));
+}
+
+TEST_CASE("HLE Source applies per-channel gains", "[audio_core][hle]") {
+    constexpr u32 length = 500;
+    u8* memory = Memory::GetPhysicalPointer(Memory::VRAM_PADDR);
+    std::vector<s16> input(length * 2);
+    for (u32 i = 0; i < length * 2; ++i) {
+        input[i] = static_cast<s16>(i * 131 - 30000);
+    }
+    std::memcpy(memory, input.data(), input.size() * sizeof(s16));
+
+    constexpr std::array<float, 4> gains = {0.5f, -1.25f, 0.0f, 3.0f};
+    auto source = std::make_unique<Source>(0);
+    Configuration config = MakeConfig(Memory::VRAM_PADDR, length, Configuration::Format::PCM16,
+                                      Configuration::InterpolationMode::None, 1.0f, false);
+    config.mono_or_stereo.Assign(Configuration::MonoOrStereo::Stereo);
+    for (size_t i = 0; i < 4; ++i) {
+        config.gain[1][i] = gains[i];
+    }
+    config.gain_1_dirty.Assign(1);
+
+    source->Tick(config, no_adpcm_coeffs);
+    AudioCore::QuadFrame32 mix;
+    for (auto& sample : mix) {
+        sample = {1, 2, 3, 4};
+    }
+    source->MixInto(mix, 1);
+
+    // Skip the two samples of interpolator delay
+    for (size_t i = 2; i < mix.size(); ++i) {
+        const s16 left = input[(i - 2) * 2];
+        const s16 right = input[(i - 2) * 2 + 1];
+        REQUIRE(mix[i][0] == 1 + static_cast<s32>(gains[0] * left));
+        REQUIRE(mix[i][1] == 2 + static_cast<s32>(gains[1] * right));
+        REQUIRE(mix[i][2] == 3 + static_cast<s32>(gains[2] * left));
+        REQUIRE(mix[i][3] == 4 + static_cast<s32>(gains[3] * right));
+    }
+
+    std::memset(memory, 0, input.size() * sizeof(s16));
+}
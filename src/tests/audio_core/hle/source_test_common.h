@@ -0,0 +1,40 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "audio_core/hle/shared_memory.h"
+#include "common/common_types.h"
+
+namespace AudioTests {
+
+using Configuration = AudioCore::HLE::SourceConfiguration::Configuration;
+
+constexpr s16_le no_adpcm_coeffs[16] = {};
+
+/// Returns a configuration that plays a single buffer from physical memory, with a gain of 1.0 on
+/// both channels of the first mix
+inline Configuration MakeConfig(PAddr address, u32 length, Configuration::Format format,
+                                Configuration::InterpolationMode interpolation, float rate,
+                                bool looping) {
+    Configuration config{};
+    config.enable = 1;
+    config.enable_dirty.Assign(1);
+    config.physical_address = address;
+    config.length = length;
+    config.format.Assign(format);
+    config.mono_or_stereo.Assign(Configuration::MonoOrStereo::Mono);
+    config.is_looping.Assign(looping ? 1 : 0);
+    config.embedded_buffer_dirty.Assign(1);
+    config.interpolation_mode = interpolation;
+    config.interpolation_dirty.Assign(1);
+    config.rate_multiplier = rate;
+    config.rate_multiplier_dirty.Assign(1);
+    config.gain[0][0] = 1.0f;
+    config.gain[0][1] = 1.0f;
+    config.gain_0_dirty.Assign(1);
+    return config;
+}
+
+} // namespace AudioTests
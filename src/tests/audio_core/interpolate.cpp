@@ -0,0 +1,142 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <catch.hpp>
+#include "audio_core/audio_types.h"
+#include "audio_core/interpolate.h"
+
+using namespace AudioCore;
+
+using InterpFunction = void (*)(AudioInterp::State&, StereoBuffer16&, float, StereoFrame16&,
+                                size_t&);
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+constexpr double amplitude = 16000.0;
+constexpr double scale_factor = 1 << 24;
+
+/// Linear chirp from f0 to f1 (in cycles per input sample) over duration input samples
+struct Sweep {
+    double f0;
+    double f1;
+    double duration;
+
+    double operator()(double t) const {
+        if (t < 0)
+            return 0.0;
+        return amplitude * std::sin(2 * pi * (f0 * t + (f1 - f0) * t * t / (2 * duration)));
+    }
+};
+
+/**
+ * Resamples the signal the way Source does, refilling the input whenever it runs dry, and returns
+ * the signal-to-(noise + distortion) ratio of the left channel in dB.
+ */
+double MeasureSnr(InterpFunction interp, double delay, float rate, const Sweep& signal) {
+    AudioInterp::State state;
+    StereoBuffer16 input;
+    size_t next_input = 0;
+    const size_t num_inputs = static_cast<size_t>(signal.duration);
+    const u64 step_size = static_cast<u64>(rate * scale_factor);
+
+    double signal_power = 0.0;
+    double error_power = 0.0;
+    u64 output_count = 0;
+    bool channels_match = true;
+    while (next_input < num_inputs) {
+        StereoFrame16 frame{};
+        size_t outputi = 0;
+        while (outputi < frame.size() && next_input < num_inputs) {
+            if (input.empty()) {
+                for (size_t i = 0; i < 100 && next_input < num_inputs; i++, next_input++) {
+                    const s16 sample = static_cast<s16>(std::lround(signal(next_input)));
+                    input.push_back({sample, static_cast<s16>(-sample)});
+                }
+            }
+            interp(state, input, rate, frame, outputi);
+        }
+
+        for (size_t i = 0; i < outputi; i++, output_count++) {
+            // Skip the start, while the filters are still filling with history
+            const double position = output_count * static_cast<double>(step_size) / scale_factor;
+            if (position < 64 || position + 64 > num_inputs)
+                continue;
+            const double expected = signal(position - delay);
+            signal_power += expected * expected;
+            error_power += (frame[i][0] - expected) * (frame[i][0] - expected);
+            channels_match &= std::abs(frame[i][1] + frame[i][0]) <= 1;
+        }
+    }
+    REQUIRE(channels_match);
+    REQUIRE(signal_power > 0.0);
+    return 10.0 * std::log10(signal_power / std::max(error_power, 1e-9));
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Polyphase interpolation quality", "[audio_core][interp]") {
+    // Up to 40% of the Nyquist frequency, where a typical game's audio content ends
+    const Sweep sweep{0.002, 0.2, 20000};
+    const double polyphase_delay = AudioInterp::polyphase_taps / 2;
+
+    for (float rate : {0.5f, 0.77f, 1.3f}) {
+        const double linear = MeasureSnr(&AudioInterp::Linear, 2, rate, sweep);
+        const double polyphase = MeasureSnr(&AudioInterp::Polyphase, polyphase_delay, rate, sweep);
+        INFO("rate " << rate << ": linear " << linear << " dB, polyphase " << polyphase << " dB");
+        REQUIRE(polyphase > 45.0);
+        REQUIRE(polyphase > linear + 20.0);
+    }
+
+    // At unit rate the polyphase filter is a pure delay, leaving only the 16-bit quantisation noise
+    REQUIRE(MeasureSnr(&AudioInterp::Polyphase, polyphase_delay, 1.0f, sweep) > 90.0);
+}
+
+TEST_CASE("Interpolation benchmark", "[.][benchmark][interp]") {
+    const struct {
+        const char* name;
+        InterpFunction function;
+    } modes[] = {{"None", &AudioInterp::None},
+                 {"Linear", &AudioInterp::Linear},
+                 {"Polyphase", &AudioInterp::Polyphase}};
+    constexpr int num_frames = 20000;
+    const Sweep sweep{0.002, 0.2, 20000};
+
+    for (const auto& mode : modes) {
+        for (float rate : {0.77f, 1.3f}) {
+            AudioInterp::State state;
+            StereoBuffer16 input;
+            size_t t = 0;
+            std::chrono::nanoseconds elapsed{};
+            for (int frame_index = 0; frame_index < num_frames; frame_index++) {
+                StereoFrame16 frame;
+                size_t outputi = 0;
+                while (outputi < frame.size()) {
+                    if (input.empty()) {
+                        while (input.free_space() > 0) {
+                            const s16 sample = static_cast<s16>(sweep(t++ % 20000));
+                            input.push_back({sample, sample});
+                        }
+                    }
+                    const auto start = std::chrono::steady_clock::now();
+                    mode.function(state, input, rate, frame, outputi);
+                    elapsed += std::chrono::steady_clock::now() - start;
+                }
+            }
+            std::printf("%-9s rate %.2f: %6.1f ns per output sample, SNR %5.1f dB\n", mode.name,
+                        rate, static_cast<double>(elapsed.count()) / (num_frames * 160.0),
+                        MeasureSnr(mode.function,
+                                   mode.function == &AudioInterp::Polyphase
+                                       ? AudioInterp::polyphase_taps / 2
+                                       : 2,
+                                   rate, sweep));
+        }
+    }
+}
@@ -0,0 +1,113 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "audio_core/sample_ring.h"
+
+using AudioCore::SampleRing;
+
+TEST_CASE("SampleRing queues samples in order", "[audio_core]") {
+    SampleRing ring(6);
+    REQUIRE(ring.Capacity() == 8);
+    REQUIRE(ring.Size() == 0);
+
+    std::array<s16, 2 * 8> output{};
+    s16 next = 0;
+    s16 expected = 0;
+    for (int round = 0; round < 10; ++round) {
+        // Push five samples and pop them back, so that reads and writes wrap around
+        std::array<s16, 2 * 5> input;
+        for (size_t i = 0; i < 5; ++i) {
+            input[i * 2] = next;
+            input[i * 2 + 1] = static_cast<s16>(-next);
+            ++next;
+        }
+        REQUIRE(ring.Push(input.data(), 5) == 5);
+        REQUIRE(ring.Size() == 5);
+        REQUIRE(ring.Pop(output.data(), 5) == 5);
+        for (size_t i = 0; i < 5; ++i) {
+            REQUIRE(output[i * 2] == static_cast<s16>(expected + i));
+            REQUIRE(output[i * 2 + 1] == static_cast<s16>(-(expected + i)));
+        }
+        expected += 5;
+    }
+    REQUIRE(ring.Size() == 0);
+}
+
+TEST_CASE("SampleRing counts dropped samples and underruns", "[audio_core]") {
+    SampleRing ring(4);
+    const std::array<s16, 2 * 6> input{};
+    std::array<s16, 2 * 6> output;
+
+    // Running dry before anything was played, e.g. while paused, is not an underrun
+    REQUIRE(ring.Pop(output.data(), 3) == 0);
+    REQUIRE(ring.GetStats().underruns == 0);
+
+    REQUIRE(ring.Push(input.data(), 6) == 4);
+    REQUIRE(ring.GetStats().dropped_samples == 2);
+    REQUIRE(ring.GetStats().queued_samples == 4);
+
+    // Each period without enough samples counts once
+    REQUIRE(ring.Pop(output.data(), 3) == 3);
+    REQUIRE(ring.Pop(output.data(), 3) == 1);
+    REQUIRE(ring.Pop(output.data(), 3) == 0);
+    REQUIRE(ring.GetStats().underruns == 1);
+
+    REQUIRE(ring.Push(input.data(), 2) == 2);
+    REQUIRE(ring.Pop(output.data(), 1) == 1);
+    REQUIRE(ring.Pop(output.data(), 2) == 1);
+    REQUIRE(ring.GetStats().underruns == 2);
+    REQUIRE(ring.GetStats().queued_samples == 0);
+}
+
+TEST_CASE("SampleRing passes samples between threads", "[audio_core]") {
+    constexpr size_t total_samples = 1 << 20;
+    SampleRing ring(512);
+
+    std::thread producer([&ring] {
+        std::mt19937 rng(1);
+        std::vector<s16> chunk;
+        size_t next = 0;
+        while (next < total_samples) {
+            const size_t count = std::min<size_t>(rng() % 300 + 1, total_samples - next);
+            chunk.resize(count * 2);
+            for (size_t i = 0; i < count; ++i) {
+                chunk[i * 2] = static_cast<s16>(next + i);
+                chunk[i * 2 + 1] = static_cast<s16>((next + i) >> 16);
+            }
+            size_t pushed = 0;
+            while (pushed < count) {
+                const size_t result = ring.Push(chunk.data() + pushed * 2, count - pushed);
+                if (result == 0)
+                    std::this_thread::yield();
+                pushed += result;
+            }
+            next += count;
+        }
+    });
+
+    std::mt19937 rng(2);
+    std::vector<s16> chunk(2 * 300);
+    size_t next = 0;
+    bool in_order = true;
+    while (next < total_samples) {
+        const size_t count = ring.Pop(chunk.data(), rng() % 300 + 1);
+        if (count == 0)
+            std::this_thread::yield();
+        for (size_t i = 0; i < count; ++i) {
+            in_order &= chunk[i * 2] == static_cast<s16>(next + i);
+            in_order &= chunk[i * 2 + 1] == static_cast<s16>((next + i) >> 16);
+        }
+        next += count;
+    }
+    producer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(next == total_samples);
+    REQUIRE(ring.Size() == 0);
+}
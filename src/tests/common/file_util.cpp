@@ -0,0 +1,152 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+
+namespace FileUtil {
+
+namespace {
+
+/// Creates a file in the working directory filled with a known pattern, deleted on destruction.
+class TestFile {
+public:
+    TestFile(const std::string& name, size_t size)
+        : path(GetCurrentDir() + DIR_SEP + name), contents(size) {
+        std::mt19937 rng(size);
+        for (u8& byte : contents) {
+            byte = static_cast<u8>(rng());
+        }
+        IOFile file(path, "wb");
+        file.WriteBytes(contents.data(), contents.size());
+    }
+
+    ~TestFile() {
+        Delete(path);
+    }
+
+    const std::string path;
+    std::vector<u8> contents;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("MappedFile::ReadAt", "[common]") {
+    TestFile test_file("citra_mapped_file_test.bin", 0x12345);
+    const std::vector<u8>& contents = test_file.contents;
+
+    MappedFile file(test_file.path);
+    REQUIRE(file.IsOpen());
+    REQUIRE(file.GetSize() == contents.size());
+
+    std::vector<u8> buffer(0x1000);
+    REQUIRE(file.ReadAt(0x100, buffer.size(), buffer.data()) == buffer.size());
+    REQUIRE(std::equal(buffer.begin(), buffer.end(), contents.begin() + 0x100));
+
+    // Reads past the end are truncated
+    REQUIRE(file.ReadAt(contents.size() - 0x10, buffer.size(), buffer.data()) == 0x10);
+    REQUIRE(std::equal(buffer.begin(), buffer.begin() + 0x10, contents.end() - 0x10));
+    REQUIRE(file.ReadAt(contents.size() + 1, buffer.size(), buffer.data()) == 0);
+
+    if (file.IsMapped()) {
+        REQUIRE(std::equal(contents.begin(), contents.end(), file.GetPointer()));
+    }
+
+    MappedFile moved = std::move(file);
+    REQUIRE(!file.IsOpen());
+    REQUIRE(moved.ReadAt(0, 4, buffer.data()) == 4);
+    REQUIRE(std::equal(buffer.begin(), buffer.begin() + 4, contents.begin()));
+
+    REQUIRE(!MappedFile(test_file.path + ".missing").IsOpen());
+}
+
+TEST_CASE("MappedFile concurrent reads", "[common]") {
+    TestFile test_file("citra_mapped_file_test.bin", 0x40000);
+    const std::vector<u8>& contents = test_file.contents;
+    const MappedFile file(test_file.path);
+    REQUIRE(file.IsOpen());
+
+    std::vector<int> mismatches(4);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < mismatches.size(); ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(t);
+            std::vector<u8> buffer(0x800);
+            for (int i = 0; i < 1000; ++i) {
+                const size_t offset = rng() % (contents.size() - buffer.size());
+                file.ReadAt(offset, buffer.size(), buffer.data());
+                if (!std::equal(buffer.begin(), buffer.end(), contents.begin() + offset))
+                    ++mismatches[t];
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int count : mismatches) {
+        REQUIRE(count == 0);
+    }
+}
+
+TEST_CASE("MappedFile read benchmark", "[.][benchmark][common]") {
+    // Compares the old Seek + ReadBytes path with MappedFile::ReadAt on a file the size of a small
+    // game image, once the file is in the page cache.
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t image_size = 128 * 1024 * 1024;
+    TestFile test_file("citra_mapped_file_bench.bin", image_size);
+
+    IOFile io_file(test_file.path, "rb");
+    MappedFile mapped_file(test_file.path);
+    REQUIRE(mapped_file.IsMapped());
+
+    struct Pattern {
+        const char* name;
+        size_t chunk_size;
+        bool random;
+    };
+    for (const Pattern& pattern : {Pattern{"sequential 64 KiB", 0x10000, false},
+                                   Pattern{"random 4 KiB", 0x1000, true},
+                                   Pattern{"random 512 B", 0x200, true}}) {
+        const size_t num_reads = pattern.random ? 100000 : image_size / pattern.chunk_size;
+        std::vector<u64> offsets(num_reads);
+        std::mt19937_64 rng(0);
+        for (size_t i = 0; i < num_reads; ++i) {
+            offsets[i] = pattern.random ? rng() % (image_size - pattern.chunk_size)
+                                        : i * pattern.chunk_size;
+        }
+        std::vector<u8> buffer(pattern.chunk_size);
+
+        // Warm the page cache
+        for (u64 offset : offsets) {
+            mapped_file.ReadAt(offset, buffer.size(), buffer.data());
+        }
+
+        auto start = Clock::now();
+        for (u64 offset : offsets) {
+            io_file.Seek(offset, SEEK_SET);
+            io_file.ReadBytes(buffer.data(), buffer.size());
+        }
+        const double io_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        start = Clock::now();
+        for (u64 offset : offsets) {
+            mapped_file.ReadAt(offset, buffer.size(), buffer.data());
+        }
+        const double mapped_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        const double megabytes = num_reads * pattern.chunk_size / (1024.0 * 1024.0);
+        std::printf("%-18s IOFile %8.1f MiB/s, MappedFile %8.1f MiB/s\n", pattern.name,
+                    megabytes / io_seconds, megabytes / mapped_seconds);
+    }
+}
+
+} // namespace FileUtil
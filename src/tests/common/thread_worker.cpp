@@ -0,0 +1,59 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "common/thread_worker.h"
+
+namespace Common {
+
+TEST_CASE("ThreadWorker returns task results", "[common]") {
+    ThreadWorker worker(2, "Test worker");
+
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 64; ++i) {
+        results.push_back(worker.Submit([i] { return i * i; }));
+    }
+    for (int i = 0; i < 64; ++i) {
+        REQUIRE(results[i].get() == i * i);
+    }
+}
+
+TEST_CASE("ThreadWorker with one thread runs tasks in order", "[common]") {
+    std::vector<int> order;
+    std::future<void> last;
+    {
+        ThreadWorker worker(1, "Test worker");
+        for (int i = 0; i < 100; ++i) {
+            last = worker.Submit([&order, i] { order.push_back(i); });
+        }
+        last.wait();
+        REQUIRE(worker.GetPendingTaskCount() == 0);
+    }
+
+    REQUIRE(order.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(order[i] == i);
+    }
+}
+
+TEST_CASE("ThreadWorker finishes queued tasks on destruction", "[common]") {
+    std::atomic<int> count{0};
+    {
+        ThreadWorker worker(1, "Test worker");
+        for (int i = 0; i < 16; ++i) {
+            worker.Submit([&count] {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                ++count;
+            });
+        }
+    }
+    REQUIRE(count == 16);
+}
+
+} // namespace Common
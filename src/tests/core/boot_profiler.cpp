@@ -0,0 +1,50 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <thread>
+#include <catch.hpp>
+#include "core/boot_profiler.h"
+
+namespace Core {
+
+TEST_CASE("BootProfiler records the steps of a boot", "[core]") {
+    BootProfiler::BeginBoot();
+    const auto start = BootProfiler::Clock::now();
+
+    { BootProfiler::ScopedPhase phase("Init"); }
+    std::thread([] { BootProfiler::ScopedPhase phase("Worker"); }).join();
+    BootProfiler::RecordPhase("Fixed", start + std::chrono::microseconds(100),
+                              start + std::chrono::microseconds(350));
+    BootProfiler::MarkFirstFrame(); // Ignored, loading has not finished yet
+
+    REQUIRE(BootProfiler::GetPhases().size() == 3);
+
+    BootProfiler::EndLoad();
+    BootProfiler::MarkFirstFrame();
+    BootProfiler::MarkFirstFrame();
+
+    const auto phases = BootProfiler::GetPhases();
+    REQUIRE(phases.size() == 5);
+    REQUIRE(std::string(phases[0].name) == "Init");
+    REQUIRE(phases[0].thread == 0);
+    REQUIRE(std::string(phases[1].name) == "Worker");
+    REQUIRE(phases[1].thread == 1);
+    REQUIRE(phases[2].duration_us == 250);
+    REQUIRE(std::string(phases[3].name) == "System::Load");
+    REQUIRE(phases[3].start_us == 0);
+    REQUIRE(std::string(phases[4].name) == "Run until the first frame");
+    REQUIRE(phases[4].start_us == phases[3].duration_us);
+
+    const std::string trace = BootProfiler::FormatChromeTrace(
+        {{"Init", 0, 10, 20}, {"Worker", 1, 15, 5}});
+    REQUIRE(trace == "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+                     "  {\"name\": \"Init\", \"cat\": \"boot\", \"ph\": \"X\", \"pid\": 0, "
+                     "\"tid\": 0, \"ts\": 10, \"dur\": 20},\n"
+                     "  {\"name\": \"Worker\", \"cat\": \"boot\", \"ph\": \"X\", \"pid\": 0, "
+                     "\"tid\": 1, \"ts\": 15, \"dur\": 5}\n"
+                     "]}\n");
+}
+
+} // namespace Core
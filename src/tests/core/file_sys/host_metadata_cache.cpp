@@ -0,0 +1,157 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/host_metadata_cache.h"
+#include "core/file_sys/path_parser.h"
+#include "core/file_sys/savedata_archive.h"
+
+namespace FileSys {
+
+namespace {
+
+const std::string test_dir = "./citra_metadata_test/";
+
+void ResetTestDir() {
+    FileUtil::DeleteDirRecursively(test_dir);
+    FileUtil::CreateFullPath(test_dir + "dir/");
+    FileUtil::WriteStringToFile(false, "data", (test_dir + "file").c_str());
+    HostMetadataCache::Clear();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("HostMetadataCache remembers what is on the host", "[core][file_sys]") {
+    using HostMetadataCache::Kind;
+    ResetTestDir();
+
+    REQUIRE(HostMetadataCache::Lookup(test_dir + "file") == Kind::File);
+    REQUIRE(HostMetadataCache::Lookup(test_dir + "dir") == Kind::Directory);
+    REQUIRE(HostMetadataCache::Lookup(test_dir + "missing") == Kind::Missing);
+    auto stats = HostMetadataCache::GetStats();
+    REQUIRE(stats.lookup_hits == 0);
+    REQUIRE(stats.lookup_misses == 3);
+
+    // Other spellings of the same paths are hits
+    REQUIRE(HostMetadataCache::Lookup(test_dir + "dir/../file") == Kind::File);
+    REQUIRE(HostMetadataCache::Lookup(test_dir + "./dir/") == Kind::Directory);
+    REQUIRE(HostMetadataCache::GetStats().lookup_hits == 2);
+
+    // A listing answers for everything in the directory
+    const auto listing = HostMetadataCache::ListDirectory(test_dir);
+    REQUIRE(listing->children.size() == 2);
+    REQUIRE(HostMetadataCache::ListDirectory(test_dir) == listing);
+    REQUIRE(HostMetadataCache::Lookup(test_dir + "other") == Kind::Missing);
+    stats = HostMetadataCache::GetStats();
+    REQUIRE(stats.lookup_hits == 3);
+    REQUIRE(stats.listing_hits == 1);
+    REQUIRE(stats.listing_misses == 1);
+
+    // Changes are seen once they are invalidated
+    FileUtil::CreateDir(test_dir + "other");
+    HostMetadataCache::Invalidate(test_dir + "other");
+    REQUIRE(HostMetadataCache::Lookup(test_dir + "other") == Kind::Directory);
+    REQUIRE(HostMetadataCache::ListDirectory(test_dir)->children.size() == 3);
+
+    // Invalidating a directory forgets what is in it
+    FileUtil::DeleteDirRecursively(test_dir + "dir");
+    HostMetadataCache::Invalidate(test_dir + "dir");
+    REQUIRE(HostMetadataCache::Lookup(test_dir + "dir") == Kind::Missing);
+
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+TEST_CASE("HostMetadataCache is kept up to date by the archives", "[core][file_sys]") {
+    ResetTestDir();
+    const SaveDataArchive archive(test_dir);
+
+    REQUIRE(PathParser(Path("/new")).GetHostStatus(test_dir) == PathParser::NotFound);
+    REQUIRE(archive.CreateFile(Path("/new"), 0x10) == RESULT_SUCCESS);
+    REQUIRE(PathParser(Path("/new")).GetHostStatus(test_dir) == PathParser::FileFound);
+
+    REQUIRE(archive.RenameFile(Path("/new"), Path("/dir/moved")) == RESULT_SUCCESS);
+    REQUIRE(PathParser(Path("/new")).GetHostStatus(test_dir) == PathParser::NotFound);
+    REQUIRE(PathParser(Path("/dir/moved")).GetHostStatus(test_dir) == PathParser::FileFound);
+    REQUIRE(PathParser(Path("/dir/moved/x")).GetHostStatus(test_dir) == PathParser::FileInPath);
+
+    REQUIRE(archive.DeleteDirectoryRecursively(Path("/dir")) == RESULT_SUCCESS);
+    REQUIRE(PathParser(Path("/dir/moved")).GetHostStatus(test_dir) == PathParser::PathNotFound);
+
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+#ifdef __linux__
+TEST_CASE("HostMetadataCache sees changes made by other programs", "[core][file_sys]") {
+    using HostMetadataCache::Kind;
+    ResetTestDir();
+    HostMetadataCache::SetWatchHost(true);
+
+    REQUIRE(HostMetadataCache::Lookup(test_dir + "external") == Kind::Missing);
+    REQUIRE(HostMetadataCache::ListDirectory(test_dir + "dir")->children.empty());
+    FileUtil::CreateEmptyFile(test_dir + "external");
+    FileUtil::CreateEmptyFile(test_dir + "dir/inside");
+
+    // The change arrives on the watching thread
+    Kind kind = Kind::Missing;
+    for (int i = 0; i < 100 && kind == Kind::Missing; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        kind = HostMetadataCache::Lookup(test_dir + "external");
+    }
+    REQUIRE(kind == Kind::File);
+    REQUIRE(HostMetadataCache::ListDirectory(test_dir + "dir")->children.size() == 1);
+
+    HostMetadataCache::SetWatchHost(false);
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+#endif
+
+TEST_CASE("Archive path lookup benchmark", "[.][benchmark][core][file_sys]") {
+    // Opening every file of a directory with many small files, as homebrew loading its data does
+    constexpr int file_count = 1000;
+    constexpr int passes = 10;
+    ResetTestDir();
+    for (int i = 0; i < file_count; ++i)
+        FileUtil::CreateEmptyFile(test_dir + "dir/" + std::to_string(i));
+
+    const SaveDataArchive archive(test_dir);
+    Mode mode{};
+    mode.read_flag.Assign(1);
+    const auto open_all = [&] {
+        for (int i = 0; i < file_count; ++i) {
+            const std::string path = "/dir/" + std::to_string(i);
+            REQUIRE(archive.OpenFile(Path(path.c_str()), mode).Succeeded());
+        }
+    };
+
+    // Forgetting everything before each pass asks the host every time, like before the cache
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        HostMetadataCache::Clear();
+        open_all();
+    }
+    const std::chrono::duration<double, std::milli> uncached =
+        std::chrono::steady_clock::now() - start;
+
+    HostMetadataCache::Clear();
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass)
+        open_all();
+    const std::chrono::duration<double, std::milli> cached =
+        std::chrono::steady_clock::now() - start;
+
+    const auto stats = HostMetadataCache::GetStats();
+    FileUtil::DeleteDirRecursively(test_dir);
+
+    std::printf("Opening %d files %d times: %.1f ms uncached, %.1f ms cached, %.1f%% of "
+                "lookups hit\n",
+                file_count, passes, uncached.count(), cached.count(),
+                100.0 * stats.lookup_hits / (stats.lookup_hits + stats.lookup_misses));
+}
+
+} // namespace FileSys
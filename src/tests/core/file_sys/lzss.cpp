@@ -0,0 +1,172 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "common/alignment.h"
+#include "core/file_sys/lzss.h"
+
+namespace {
+
+/**
+ * Greedy compressor for the format read by FileSys::LZSS::Decompress. Like the decompressor, it
+ * works from the end of the data towards the start.
+ */
+std::vector<u8> Compress(const std::vector<u8>& data) {
+    const size_t size = data.size();
+
+    // Tokens in the order the decompressor reads them, each preceded by a control byte every 8
+    std::vector<u8> stream;
+    size_t control_pos = 0;
+    unsigned token = 0;
+
+    size_t pos = size;
+    while (pos > 0) {
+        if (token % 8 == 0) {
+            control_pos = stream.size();
+            stream.push_back(0);
+        }
+
+        // Find the longest match: the bytes before pos repeat the ones `distance` further on
+        size_t best_length = 0, best_distance = 0;
+        const size_t max_distance = std::min<size_t>(0xFFF + 3, size - pos);
+        for (size_t distance = 3; distance <= max_distance; ++distance) {
+            size_t length = 0;
+            while (length < 18 && length < pos &&
+                   data[pos - 1 - length] == data[pos - 1 - length + distance]) {
+                ++length;
+            }
+            if (length > best_length) {
+                best_length = length;
+                best_distance = distance;
+            }
+        }
+
+        if (best_length >= 3) {
+            const u16 segment =
+                static_cast<u16>(((best_length - 3) << 12) | (best_distance - 3));
+            stream[control_pos] |= 0x80 >> (token % 8);
+            stream.push_back(static_cast<u8>(segment >> 8));
+            stream.push_back(static_cast<u8>(segment));
+            pos -= best_length;
+        } else {
+            stream.push_back(data[--pos]);
+        }
+        ++token;
+    }
+
+    std::vector<u8> compressed(stream.rbegin(), stream.rend());
+    compressed.resize(Common::AlignUp(compressed.size(), 4) + 8);
+
+    const u32 compressed_size = static_cast<u32>(compressed.size());
+    const u32 footer_size = static_cast<u32>(compressed_size - stream.size());
+    const u32 buffer_top_and_bottom = (footer_size << 24) | compressed_size;
+    const u32 extra_size = static_cast<u32>(size - compressed_size);
+    std::memcpy(&compressed[compressed_size - 8], &buffer_top_and_bottom, 4);
+    std::memcpy(&compressed[compressed_size - 4], &extra_size, 4);
+    return compressed;
+}
+
+/// Code-like data: random words, with runs and repeats at various distances
+std::vector<u8> MakeTestData(size_t size, u32 seed) {
+    std::mt19937 rng(seed);
+    std::vector<u8> data;
+    data.reserve(size);
+    while (data.size() < size) {
+        const u32 kind = rng() % 4;
+        if (kind == 0 || data.size() < 32) {
+            for (int i = 0; i < 4; ++i)
+                data.push_back(static_cast<u8>(rng()));
+        } else if (kind == 1) {
+            data.insert(data.end(), 3 + rng() % 30, static_cast<u8>(rng()));
+        } else {
+            const size_t distance = 1 + rng() % std::min<size_t>(data.size(), 0x1000);
+            const size_t length = 3 + rng() % 40;
+            for (size_t i = 0; i < length; ++i)
+                data.push_back(data[data.size() - distance]);
+        }
+    }
+    data.resize(size);
+    return data;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("LZSS::Decompress round trips", "[core][file_sys]") {
+    for (size_t size : {64, 1000, 0x10000}) {
+        const std::vector<u8> data = MakeTestData(size, static_cast<u32>(size));
+        const std::vector<u8> compressed = Compress(data);
+        REQUIRE(compressed.size() < data.size());
+
+        const u32 compressed_size = static_cast<u32>(compressed.size());
+        REQUIRE(FileSys::LZSS::GetDecompressedSize(compressed.data(), compressed_size) == size);
+
+        std::vector<u8> decompressed(size);
+        REQUIRE(FileSys::LZSS::Decompress(compressed.data(), compressed_size, decompressed.data(),
+                                          static_cast<u32>(size)));
+        REQUIRE(decompressed == data);
+    }
+}
+
+TEST_CASE("LZSS::Decompress rejects malformed data", "[core][file_sys]") {
+    const std::vector<u8> data = MakeTestData(0x1000, 1);
+    const std::vector<u8> compressed = Compress(data);
+    const u32 compressed_size = static_cast<u32>(compressed.size());
+    std::vector<u8> decompressed(data.size());
+
+    SECTION("too small for the footer") {
+        REQUIRE_FALSE(FileSys::LZSS::Decompress(compressed.data(), 4, decompressed.data(),
+                                                static_cast<u32>(decompressed.size())));
+    }
+
+    SECTION("output buffer too small") {
+        REQUIRE_FALSE(FileSys::LZSS::Decompress(compressed.data(), compressed_size,
+                                                decompressed.data(),
+                                                static_cast<u32>(decompressed.size() - 1)));
+    }
+
+    SECTION("compressed size larger than the buffer") {
+        std::vector<u8> bad = compressed;
+        const u32 buffer_top_and_bottom = (bad[compressed_size - 5] << 24) | 0xFFFFFF;
+        std::memcpy(&bad[compressed_size - 8], &buffer_top_and_bottom, 4);
+        REQUIRE_FALSE(FileSys::LZSS::Decompress(bad.data(), compressed_size, decompressed.data(),
+                                                static_cast<u32>(decompressed.size())));
+    }
+
+    SECTION("back-reference past the end of the output") {
+        std::vector<u8> bad = compressed;
+        // Nothing has been written yet when the first token is read, so it can not be a copy
+        const u32 footer_size = bad[compressed_size - 5];
+        const size_t control = compressed_size - footer_size - 1;
+        bad[control] = 0xFF;
+        bad[control - 1] = 0xFF;
+        bad[control - 2] = 0xFF;
+        REQUIRE_FALSE(FileSys::LZSS::Decompress(bad.data(), compressed_size, decompressed.data(),
+                                                static_cast<u32>(decompressed.size())));
+    }
+}
+
+TEST_CASE("LZSS decompression benchmark", "[.][benchmark][core][file_sys]") {
+    const std::vector<u8> data = MakeTestData(512 * 1024, 0);
+    const std::vector<u8> compressed = Compress(data);
+    std::vector<u8> decompressed(data.size());
+
+    constexpr int iterations = 100;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        REQUIRE(FileSys::LZSS::Decompress(compressed.data(), static_cast<u32>(compressed.size()),
+                                          decompressed.data(),
+                                          static_cast<u32>(decompressed.size())));
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    REQUIRE(decompressed == data);
+
+    std::printf("LZSS: %.1f MB/s of decompressed output\n",
+                iterations * data.size() / elapsed.count() / (1024 * 1024));
+}
@@ -0,0 +1,239 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include <cryptopp/sha.h>
+#include "common/alignment.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/file_sys/ncch_container.h"
+#include "core/file_sys/romfs_reader.h"
+#include "core/hw/aes/ctr.h"
+#include "core/loader/loader.h"
+
+namespace FileSys {
+
+namespace {
+
+constexpr u64 program_id = 0x0004000000123400;
+constexpr u32 block_size = 0x200;
+constexpr u32 romfs_block = 6;          // After the header and the ExHeader
+constexpr u32 romfs_hash_size = 0x1000; // Skipped by ReadRomFS
+
+/**
+ * Compresses a repeating 8-byte pattern: eight literals for the end of the code, then copies of
+ * the maximum length from 8 bytes further on.
+ * @param code Receives the decompressed code, which is 8 + 144 * groups bytes
+ */
+std::vector<u8> CompressPattern(const std::array<u8, 8>& pattern, size_t groups,
+                                std::vector<u8>& code) {
+    code.clear();
+    for (size_t i = 0; i < 8 + 144 * groups; ++i) {
+        code.push_back(pattern[i % 8]);
+    }
+
+    // The stream is read from the end, so build it back to front
+    std::vector<u8> stream{0x00};
+    for (size_t i = 0; i < 8; ++i) {
+        stream.push_back(code[code.size() - 1 - i]);
+    }
+    for (size_t group = 0; group < groups; ++group) {
+        stream.push_back(0xFF);
+        for (size_t i = 0; i < 8; ++i) {
+            stream.push_back(0xF0); // 18 bytes...
+            stream.push_back(0x05); // ...from 8 bytes further on
+        }
+    }
+    std::vector<u8> compressed(stream.rbegin(), stream.rend());
+    compressed.resize(Common::AlignUp(compressed.size(), 4));
+
+    const u32 footer_size = static_cast<u32>(compressed.size() - stream.size() + 8);
+    const u32 compressed_size = static_cast<u32>(compressed.size() + 8);
+    const u32 extra_size = static_cast<u32>(code.size() - compressed_size);
+    const u32 buffer_top_and_bottom = (footer_size << 24) | compressed_size;
+    compressed.resize(compressed_size);
+    std::memcpy(&compressed[compressed_size - 8], &buffer_top_and_bottom, 4);
+    std::memcpy(&compressed[compressed_size - 4], &extra_size, 4);
+    return compressed;
+}
+
+/**
+ * Writes an NCCH with an ExHeader, a RomFS and an ExeFS with a compressed .code, optionally
+ * encrypted with the fixed (zero) key.
+ */
+class TestNCCH {
+public:
+    TestNCCH(const std::string& name, size_t romfs_data_size, bool encrypt, bool crypto_flag,
+             const std::array<u8, 8>& code_pattern = {{1, 2, 3, 4, 5, 6, 7, 8}})
+        : path(FileUtil::GetCurrentDir() + DIR_SEP + name), romfs_data(romfs_data_size) {
+        std::mt19937 rng(static_cast<u32>(romfs_data_size));
+        for (u8& byte : romfs_data) {
+            byte = static_cast<u8>(rng());
+        }
+        std::memcpy(romfs_data.data(), "IVFC", 4);
+
+        const std::vector<u8> compressed_code = CompressPattern(code_pattern, 100, code);
+
+        NCCH_Header header{};
+        header.magic = Loader::MakeMagic('N', 'C', 'C', 'H');
+        header.version = 2;
+        header.program_id = program_id;
+        for (u8 i = 0; i < 8; ++i) {
+            header.partition_id[i] = 0x10 + i;
+        }
+        header.extended_header_size = 0x400;
+        header.flags[7] = crypto_flag ? 0x1 : 0x4; // FixedCryptoKey or NoCrypto
+        header.romfs_offset = romfs_block;
+        header.romfs_size = static_cast<u32>((romfs_hash_size + romfs_data_size) / block_size);
+        header.exefs_offset = header.romfs_offset + header.romfs_size;
+
+        ExHeader_Header exheader{};
+        std::memcpy(exheader.codeset_info.name, "test", 4);
+        exheader.codeset_info.flags.flag = 1; // Compressed .code
+        exheader.system_info.jump_id = program_id;
+
+        std::vector<u8> romfs(romfs_hash_size);
+        romfs.insert(romfs.end(), romfs_data.begin(), romfs_data.end());
+
+        ExeFs_Header exefs_header{};
+        std::strcpy(exefs_header.section[0].name, ".code");
+        exefs_header.section[0].size = static_cast<u32>(compressed_code.size());
+        CryptoPP::SHA256().CalculateDigest(exefs_header.hashes[7], compressed_code.data(),
+                                           compressed_code.size());
+        std::vector<u8> exefs(sizeof(exefs_header));
+        std::memcpy(exefs.data(), &exefs_header, sizeof(exefs_header));
+        exefs.insert(exefs.end(), compressed_code.begin(), compressed_code.end());
+        exefs.resize(Common::AlignUp(exefs.size(), block_size));
+        header.exefs_size = static_cast<u32>(exefs.size() / block_size);
+
+        if (encrypt) {
+            // Version 2 counters: the partition ID in reverse, then the section type
+            HW::AES::CTRCounter ctr{};
+            std::reverse_copy(header.partition_id, header.partition_id + 8, ctr.begin());
+            const HW::AES::AESKey zero_key{};
+            ctr[8] = 1;
+            HW::AES::DecryptCTR(reinterpret_cast<u8*>(&exheader), sizeof(exheader), zero_key, ctr,
+                                0);
+            ctr[8] = 2;
+            HW::AES::DecryptCTR(exefs.data(), exefs.size(), zero_key, ctr, 0);
+            ctr[8] = 3;
+            HW::AES::DecryptCTR(romfs.data(), romfs.size(), zero_key, ctr, 0);
+        }
+
+        FileUtil::IOFile file(path, "wb");
+        file.WriteObject(header);
+        file.WriteObject(exheader);
+        file.Seek(romfs_block * block_size, SEEK_SET);
+        file.WriteBytes(romfs.data(), romfs.size());
+        file.WriteBytes(exefs.data(), exefs.size());
+    }
+
+    ~TestNCCH() {
+        FileUtil::Delete(path);
+    }
+
+    const std::string path;
+    std::vector<u8> romfs_data;
+    std::vector<u8> code;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("NCCHContainer decrypts fixed-key content", "[core][file_sys]") {
+    for (bool encrypt : {true, false}) {
+        // Content that was decrypted without clearing the crypto flag is read as is
+        TestNCCH test_ncch("citra_ncch_test.cxi", 0x3000, encrypt, true);
+        NCCHContainer container(test_ncch.path);
+        REQUIRE(container.Load() == Loader::ResultStatus::Success);
+        REQUIRE(container.exheader_header.system_info.jump_id == program_id);
+
+        std::shared_ptr<RomFSReader> romfs;
+        REQUIRE(container.ReadRomFS(romfs) == Loader::ResultStatus::Success);
+        REQUIRE(romfs->IsEncrypted() == encrypt);
+        REQUIRE(romfs->GetSize() == test_ncch.romfs_data.size());
+
+        std::vector<u8> buffer(0x123);
+        for (u64 offset : {0x0, 0x1, 0x10, 0x7FF, 0x2000}) {
+            REQUIRE(romfs->Read(offset, buffer.size(), buffer.data()) == buffer.size());
+            REQUIRE(std::equal(buffer.begin(), buffer.end(),
+                               test_ncch.romfs_data.begin() + offset));
+        }
+    }
+}
+
+TEST_CASE("NCCHContainer caches the decompressed .code", "[core][file_sys]") {
+    const std::string cache_dir = FileUtil::GetCurrentDir() + DIR_SEP "citra_code_cache" DIR_SEP;
+    FileUtil::DeleteDirRecursively(cache_dir);
+    FileUtil::CreateFullPath(cache_dir);
+    const std::string old_cache_dir = FileUtil::GetUserPath(D_CACHE_IDX);
+    FileUtil::GetUserPath(D_CACHE_IDX, cache_dir);
+
+    for (bool encrypt : {false, true}) {
+        TestNCCH test_ncch("citra_ncch_test.cxi", 0x1000, encrypt, encrypt,
+                           {{encrypt, 9, 8, 7, 6, 5, 4, 3}});
+
+        std::vector<u8> code;
+        REQUIRE(NCCHContainer(test_ncch.path).LoadSectionExeFS(".code", code) ==
+                Loader::ResultStatus::Success);
+        REQUIRE(code == test_ncch.code);
+
+        // Change the cached copy, to tell whether the next load decompresses again
+        FileUtil::FSTEntry entries;
+        REQUIRE(FileUtil::ScanDirectoryTree(cache_dir + "exefs_code", entries) == 1);
+        const std::string cached_path = entries.children[0].physicalName;
+        code[0] ^= 0xFF;
+        REQUIRE(FileUtil::IOFile(cached_path, "wb").WriteBytes(code.data(), code.size()) ==
+                code.size());
+
+        std::vector<u8> cached_code;
+        REQUIRE(NCCHContainer(test_ncch.path).LoadSectionExeFS(".code", cached_code) ==
+                Loader::ResultStatus::Success);
+        REQUIRE(cached_code == code);
+        FileUtil::Delete(cached_path);
+    }
+
+    FileUtil::GetUserPath(D_CACHE_IDX, old_cache_dir);
+    FileUtil::DeleteDirRecursively(cache_dir);
+}
+
+TEST_CASE("RomFS decrypted read benchmark", "[.][benchmark][core][file_sys]") {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t romfs_size = 64 * 1024 * 1024;
+    TestNCCH plain_ncch("citra_ncch_bench_plain.cxi", romfs_size, false, false);
+    TestNCCH encrypted_ncch("citra_ncch_bench_encrypted.cxi", romfs_size, true, true);
+
+    std::shared_ptr<RomFSReader> plain, encrypted;
+    NCCHContainer plain_container(plain_ncch.path);
+    NCCHContainer encrypted_container(encrypted_ncch.path);
+    REQUIRE(plain_container.ReadRomFS(plain) == Loader::ResultStatus::Success);
+    REQUIRE(encrypted_container.ReadRomFS(encrypted) == Loader::ResultStatus::Success);
+    REQUIRE(encrypted->IsEncrypted());
+
+    for (size_t chunk_size : {0x200, 0x1000, 0x10000, 0x100000}) {
+        std::vector<u8> buffer(chunk_size);
+        for (const auto& reader : {plain, encrypted}) {
+            // Warm the page cache, then time a full sequential pass
+            for (u64 offset = 0; offset < romfs_size; offset += chunk_size) {
+                reader->Read(offset, chunk_size, buffer.data());
+            }
+            const auto start = Clock::now();
+            for (u64 offset = 0; offset < romfs_size; offset += chunk_size) {
+                reader->Read(offset, chunk_size, buffer.data());
+            }
+            const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            std::printf("%-9s reads of %7zu bytes: %8.1f MiB/s\n",
+                        reader->IsEncrypted() ? "encrypted" : "plaintext", chunk_size,
+                        romfs_size / (1024.0 * 1024.0) / seconds);
+        }
+    }
+}
+
+} // namespace FileSys
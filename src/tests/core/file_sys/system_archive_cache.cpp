@@ -0,0 +1,112 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/system_archive_cache.h"
+
+namespace FileSys {
+
+namespace {
+
+const std::string test_dir = "./citra_system_archive_test/";
+
+/// Loads a host file the way the system modules load their archives, counting the loads.
+std::function<bool(std::vector<u8>&)> Loader(const std::string& path, int& loads) {
+    return [path, &loads](std::vector<u8>& buffer) {
+        ++loads;
+        std::string contents;
+        if (!FileUtil::ReadFileToString(true, path.c_str(), contents))
+            return false;
+        buffer.assign(contents.begin(), contents.end());
+        return true;
+    };
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SystemArchiveCache shares contents until they change", "[core][file_sys]") {
+    FileUtil::DeleteDirRecursively(test_dir);
+    FileUtil::CreateFullPath(test_dir);
+    SystemArchiveCache::Clear();
+    const std::string path = test_dir + "archive";
+    FileUtil::WriteStringToFile(true, "font", path.c_str());
+
+    int loads = 0;
+    const auto first = SystemArchiveCache::Get("font", path, Loader(path, loads));
+    REQUIRE(first != nullptr);
+    REQUIRE(std::string(first->begin(), first->end()) == "font");
+    REQUIRE(SystemArchiveCache::Get("font", path, Loader(path, loads)) == first);
+    REQUIRE(loads == 1);
+
+    // A key is loaded on its own, even from the same host file
+    REQUIRE(SystemArchiveCache::Get("other", path, Loader(path, loads)) != first);
+    REQUIRE(loads == 2);
+
+    // Changing the host file loads it again, while the old contents stay valid for their users
+    FileUtil::WriteStringToFile(true, "new font", path.c_str());
+    const auto second = SystemArchiveCache::Get("font", path, Loader(path, loads));
+    REQUIRE(std::string(second->begin(), second->end()) == "new font");
+    REQUIRE(std::string(first->begin(), first->end()) == "font");
+    REQUIRE(loads == 3);
+
+    // Invalidating a directory forgets what was loaded from it
+    SystemArchiveCache::Invalidate(test_dir);
+    REQUIRE(SystemArchiveCache::Get("font", path, Loader(path, loads)) != second);
+    REQUIRE(loads == 4);
+
+    // Failed loads are not cached
+    const std::string missing = test_dir + "missing";
+    REQUIRE(SystemArchiveCache::Get("missing", missing, Loader(missing, loads)) == nullptr);
+    REQUIRE(SystemArchiveCache::Get("missing", missing, Loader(missing, loads)) == nullptr);
+    REQUIRE(loads == 6);
+
+    const auto stats = SystemArchiveCache::GetStats();
+    REQUIRE(stats.hits == 1);
+    REQUIRE(stats.misses == 6);
+    REQUIRE(stats.cached_bytes == 8);
+
+    SystemArchiveCache::Clear();
+    FileUtil::DeleteDirRecursively(test_dir);
+}
+
+TEST_CASE("System archive boot benchmark", "[.][benchmark][core][file_sys]") {
+    // A batch run booting many titles, each loading a shared font sized system archive
+    constexpr int boots = 200;
+    constexpr size_t archive_size = 3 * 1024 * 1024;
+    FileUtil::DeleteDirRecursively(test_dir);
+    FileUtil::CreateFullPath(test_dir);
+    SystemArchiveCache::Clear();
+    const std::string path = test_dir + "archive";
+    FileUtil::WriteStringToFile(true, std::string(archive_size, 'f'), path.c_str());
+
+    int loads = 0;
+    const auto loader = Loader(path, loads);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < boots; ++i) {
+        std::vector<u8> buffer;
+        REQUIRE(loader(buffer));
+    }
+    const std::chrono::duration<double, std::milli> loaded =
+        std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < boots; ++i)
+        REQUIRE(SystemArchiveCache::Get("archive", path, loader) != nullptr);
+    const std::chrono::duration<double, std::milli> cached =
+        std::chrono::steady_clock::now() - start;
+
+    SystemArchiveCache::Clear();
+    FileUtil::DeleteDirRecursively(test_dir);
+
+    std::printf("Loading a %zu MiB system archive on %d boots: %.1f ms each time, %.1f ms "
+                "through the cache\n",
+                archive_size / (1024 * 1024), boots, loaded.count(), cached.count());
+}
+
+} // namespace FileSys
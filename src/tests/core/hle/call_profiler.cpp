@@ -0,0 +1,80 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <catch.hpp>
+#include "core/hle/call_profiler.h"
+
+namespace HLE {
+
+TEST_CASE("CallProfiler aggregates calls", "[core][hle]") {
+    CallProfiler::Reset();
+    const std::string fs = "fs:USER";
+    const std::string svc = "SVC";
+
+    CallProfiler::RecordCall(fs, 0x080201C2, "OpenFile", 100);
+    CallProfiler::RecordCall(fs, 0x080201C2, "OpenFile", 1000);
+    CallProfiler::RecordCall(svc, 0x32, "SendSyncRequest", 300);
+    CallProfiler::RecordCall(fs, 0x08030204, "OpenFileDirectly", 1'000'000'000);
+
+    const auto stats = CallProfiler::GetStats();
+    REQUIRE(stats.size() == 3);
+
+    // Sorted by group, then id
+    REQUIRE(stats[0].group == "SVC");
+    REQUIRE(stats[1].name == "OpenFile");
+    REQUIRE(stats[1].id == 0x080201C2);
+    REQUIRE(stats[1].count == 2);
+    REQUIRE(stats[1].total_ns == 1100);
+    REQUIRE(stats[1].max_ns == 1000);
+    REQUIRE(stats[1].histogram[0] == 1); // < 256 ns
+    REQUIRE(stats[1].histogram[2] == 1); // 512 to 1024 ns
+    REQUIRE(stats[2].histogram[CallProfiler::num_latency_buckets - 1] == 1);
+    REQUIRE(stats[0].histogram[1] == 1); // 256 to 512 ns
+
+    const std::string csv = CallProfiler::FormatCsv(stats);
+    REQUIRE(csv.find("fs:USER,OpenFile,0x080201c2,2,1100,1000,1,0,1,") != std::string::npos);
+    const std::string json = CallProfiler::FormatJson(stats);
+    REQUIRE(json.find("{\"group\": \"fs:USER\", \"name\": \"OpenFile\", \"id\": 134349250, "
+                      "\"count\": 2, \"total_ns\": 1100, \"max_ns\": 1000, \"histogram\": [1, 0, "
+                      "1, 0") != std::string::npos);
+
+    CallProfiler::Reset();
+    REQUIRE(CallProfiler::GetStats().empty());
+}
+
+TEST_CASE("CallProfiler only times calls while enabled", "[core][hle]") {
+    CallProfiler::Reset();
+    const std::string group = "test";
+
+    {
+        CallProfiler::ScopedCall call(group, 1, "Disabled");
+    }
+    REQUIRE(CallProfiler::GetStats().empty());
+
+    CallProfiler::SetEnabled(true);
+    {
+        CallProfiler::ScopedCall call(group, 2, "Enabled");
+    }
+    CallProfiler::SetEnabled(false);
+
+    const auto stats = CallProfiler::GetStats();
+    REQUIRE(stats.size() == 1);
+    REQUIRE(stats[0].name == "Enabled");
+    REQUIRE(stats[0].count == 1);
+    CallProfiler::Reset();
+}
+
+TEST_CASE("CallProfiler quotes CSV fields that need it", "[core][hle]") {
+    CallProfiler::Reset();
+    CallProfiler::RecordCall("fs:File", 0x080200C2, "Read", 100);
+    CallProfiler::RecordCall("a,b", 1, "say \"hi\"", 100);
+
+    const std::string csv = CallProfiler::FormatCsv(CallProfiler::GetStats());
+    REQUIRE(csv.find("\n\"a,b\",\"say \"\"hi\"\"\",0x00000001,1,") != std::string::npos);
+    REQUIRE(csv.find("\nfs:File,Read,0x080200c2,1,") != std::string::npos);
+    CallProfiler::Reset();
+}
+
+} // namespace HLE
@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <catch.hpp>
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
@@ -363,4 +366,135 @@ TEST_CASE("HLERequestContext::WriteToOutgoingCommandBuffer", "[core][kernel]") {
     }
 }
 
+TEST_CASE("MappedBuffer direct access", "[core][kernel]") {
+    auto session = std::get<SharedPtr<ServerSession>>(ServerSession::CreateSessionPair());
+    HLERequestContext context(std::move(session));
+
+    auto process = Process::Create(CodeSet::Create("", 0));
+    HandleTable handle_table;
+
+    auto block = std::make_shared<std::vector<u8>>(Memory::PAGE_SIZE * 4);
+    const VAddr target_address = 0x10000000;
+    REQUIRE(process->vm_manager
+                .MapMemoryBlock(target_address, block, 0, block->size(), MemoryState::Private)
+                .Code() == RESULT_SUCCESS);
+
+    SECTION("gives access to contiguous memory") {
+        const u32_le input[]{
+            IPC::MakeHeader(0, 0, 2),
+            IPC::MappedBufferDesc(block->size(), IPC::RW),
+            target_address,
+        };
+        context.PopulateFromIncomingCommandBuffer(input, *process, handle_table);
+
+        auto& buffer = context.GetMappedBuffer(0);
+        CHECK(buffer.GetDirectReadPointer(0, block->size()) == block->data());
+        CHECK(buffer.GetDirectReadPointer(Memory::PAGE_SIZE + 3, Memory::PAGE_SIZE) ==
+              block->data() + Memory::PAGE_SIZE + 3);
+    }
+
+    SECTION("refuses memory that isn't contiguous on the host") {
+        auto other_block = std::make_shared<std::vector<u8>>(Memory::PAGE_SIZE);
+        const VAddr other_address = target_address + static_cast<VAddr>(block->size());
+        REQUIRE(process->vm_manager
+                    .MapMemoryBlock(other_address, other_block, 0, other_block->size(),
+                                    MemoryState::Private)
+                    .Code() == RESULT_SUCCESS);
+
+        const u32_le input[]{
+            IPC::MakeHeader(0, 0, 2),
+            IPC::MappedBufferDesc(block->size() + other_block->size(), IPC::RW),
+            target_address,
+        };
+        context.PopulateFromIncomingCommandBuffer(input, *process, handle_table);
+
+        auto& buffer = context.GetMappedBuffer(0);
+        CHECK(buffer.GetDirectReadPointer(0, block->size() + 1) == nullptr);
+        CHECK(buffer.GetDirectReadPointer(block->size() - 1, 2) == nullptr);
+        CHECK(buffer.GetDirectReadPointer(block->size(), other_block->size()) ==
+              other_block->data());
+
+        REQUIRE(process->vm_manager.UnmapRange(other_address, other_block->size()) ==
+                RESULT_SUCCESS);
+    }
+
+    REQUIRE(process->vm_manager.UnmapRange(target_address, block->size()) == RESULT_SUCCESS);
+}
+
+TEST_CASE("IPC buffer pool reuses storage", "[core][kernel]") {
+    // Larger than anything else the tests put in the pool
+    constexpr size_t size = 3 * 1024 * 1024;
+
+    std::vector<u8> buffer = AcquireIPCBuffer(size);
+    REQUIRE(buffer.size() == size);
+    const u8* storage = buffer.data();
+    ReleaseIPCBuffer(std::move(buffer));
+
+    {
+        PooledIPCBuffer reused(size - 1);
+        REQUIRE(reused.size() == size - 1);
+        REQUIRE(reused.data() == storage);
+    }
+
+    std::vector<u8> returned = AcquireIPCBuffer(size);
+    REQUIRE(returned.data() == storage);
+    ReleaseIPCBuffer(std::move(returned));
+}
+
+TEST_CASE("File::Read data path benchmark", "[.][benchmark][kernel]") {
+    // Models the data movement of FS::File::Read, with a memcpy from a cached file standing in for
+    // the backend's read.
+    constexpr size_t file_size = 64 * 1024 * 1024;
+    constexpr size_t max_read_size = 4 * 1024 * 1024;
+    const std::vector<u8> file(file_size, 0x5A);
+
+    auto session = std::get<SharedPtr<ServerSession>>(ServerSession::CreateSessionPair());
+    HLERequestContext context(std::move(session));
+    auto process = Process::Create(CodeSet::Create("", 0));
+    HandleTable handle_table;
+
+    auto block = std::make_shared<std::vector<u8>>(max_read_size);
+    const VAddr target_address = 0x10000000;
+    process->vm_manager.MapMemoryBlock(target_address, block, 0, block->size(),
+                                       MemoryState::Private);
+    const u32_le input[]{
+        IPC::MakeHeader(0, 0, 2),
+        IPC::MappedBufferDesc(block->size(), IPC::W),
+        target_address,
+    };
+    context.PopulateFromIncomingCommandBuffer(input, *process, handle_table);
+    auto& buffer = context.GetMappedBuffer(0);
+
+    const auto read_file = [&](size_t offset, size_t size, u8* dest) {
+        std::memcpy(dest, file.data() + offset, size);
+    };
+    const auto allocate_and_copy = [&](size_t offset, size_t size) {
+        std::vector<u8> data(size);
+        read_file(offset, size, data.data());
+        buffer.Write(data.data(), 0, size);
+    };
+    const auto pooled_and_copy = [&](size_t offset, size_t size) {
+        PooledIPCBuffer data(size);
+        read_file(offset, size, data.data());
+        buffer.Write(data.data(), 0, size);
+    };
+
+    for (size_t read_size = 64 * 1024; read_size <= max_read_size; read_size *= 4) {
+        std::printf("%4zu KiB reads:", read_size / 1024);
+        const auto run = [&](const char* name, const auto& path) {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t offset = 0; offset + read_size <= file_size; offset += read_size) {
+                path(offset, read_size);
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::printf("  %s %6.0f MB/s", name, file_size / 1e6 / elapsed.count());
+        };
+        run("allocate", allocate_and_copy);
+        run("pooled", pooled_and_copy);
+        std::printf("\n");
+    }
+
+    process->vm_manager.UnmapRange(target_address, block->size());
+}
+
 } // namespace Kernel
@@ -0,0 +1,244 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/string_util.h"
+#include "core/hle/romfs.h"
+
+namespace RomFS {
+
+namespace {
+
+constexpr u32 invalid = 0xFFFFFFFF;
+
+/// Builds a RomFS level 3 image holding files given by their paths, such as "/dir/file".
+class ImageBuilder {
+public:
+    ImageBuilder() : directories(1) {}
+
+    void AddFile(const std::string& path, const std::string& contents) {
+        std::vector<std::string> components;
+        Common::SplitString(path.substr(1), '/', components);
+        size_t dir = 0;
+        for (size_t i = 0; i + 1 < components.size(); ++i)
+            dir = GetChild(dir, Common::UTF8ToUTF16(components[i]));
+        directories[dir].files.push_back(files.size());
+        files.push_back({Common::UTF8ToUTF16(components.back()), contents, 0});
+    }
+
+    std::vector<u8> Build() {
+        // Entries are laid out in the order they were added, children after their parent
+        u32 dir_table_length = 0;
+        for (Directory& dir : directories) {
+            dir.offset = dir_table_length;
+            dir_table_length += 0x18 + NameSize(dir.name);
+        }
+        u32 file_table_length = 0;
+        for (File& file : files) {
+            file.offset = file_table_length;
+            file_table_length += 0x20 + NameSize(file.name);
+        }
+
+        const u32 dir_table_offset = 0x28 + 4; // after the header and a one-bucket hash table
+        const u32 file_table_offset = dir_table_offset + dir_table_length + 4;
+        const u32 data_offset = file_table_offset + file_table_length;
+        image.assign(data_offset, 0);
+        Put(0, {0x28, 0x28, 4, dir_table_offset, dir_table_length,
+                dir_table_offset + dir_table_length, 4, file_table_offset, file_table_length,
+                data_offset});
+        Put(0x28, {invalid});
+        Put(dir_table_offset + dir_table_length, {invalid});
+
+        for (const Directory& dir : directories) {
+            const auto first = [](const std::vector<size_t>& list, auto get) {
+                return list.empty() ? invalid : get(list.front());
+            };
+            const u32 parent_offset = directories[dir.parent].offset;
+            const u32 next = Next(directories[dir.parent].directories, &dir - &directories[0],
+                                  [this](size_t i) { return directories[i].offset; });
+            const u32 first_child =
+                first(dir.directories, [this](size_t i) { return directories[i].offset; });
+            const u32 first_file = first(dir.files, [this](size_t i) { return files[i].offset; });
+            const u32 at = dir_table_offset + dir.offset;
+            Put(at, {parent_offset, next, first_child, first_file, invalid,
+                     static_cast<u32>(dir.name.size() * 2)});
+            std::memcpy(&image[at + 0x18], dir.name.data(), dir.name.size() * 2);
+        }
+
+        for (size_t dir = 0; dir < directories.size(); ++dir) {
+            for (size_t i : directories[dir].files) {
+                const File& file = files[i];
+                const u32 at = file_table_offset + file.offset;
+                const u64 file_data_offset = image.size() - data_offset;
+                const u32 next = Next(directories[dir].files, i,
+                                      [this](size_t j) { return files[j].offset; });
+                Put(at, {directories[dir].offset, next, static_cast<u32>(file_data_offset), 0,
+                         static_cast<u32>(file.contents.size()), 0, invalid,
+                         static_cast<u32>(file.name.size() * 2)});
+                std::memcpy(&image[at + 0x20], file.name.data(), file.name.size() * 2);
+                image.insert(image.end(), file.contents.begin(), file.contents.end());
+            }
+        }
+        return image;
+    }
+
+private:
+    struct Directory {
+        size_t parent;
+        std::u16string name;
+        std::vector<size_t> directories;
+        std::vector<size_t> files;
+        u32 offset;
+    };
+
+    struct File {
+        std::u16string name;
+        std::string contents;
+        u32 offset;
+    };
+
+    static u32 NameSize(const std::u16string& name) {
+        return static_cast<u32>((name.size() * 2 + 3) & ~3);
+    }
+
+    template <typename GetOffset>
+    static u32 Next(const std::vector<size_t>& list, size_t item, GetOffset get) {
+        for (size_t i = 0; i + 1 < list.size(); ++i) {
+            if (list[i] == item)
+                return get(list[i + 1]);
+        }
+        return invalid;
+    }
+
+    size_t GetChild(size_t parent, const std::u16string& name) {
+        for (size_t child : directories[parent].directories) {
+            if (directories[child].name == name)
+                return child;
+        }
+        directories[parent].directories.push_back(directories.size());
+        directories.push_back({parent, name, {}, {}, 0});
+        return directories.size() - 1;
+    }
+
+    void Put(size_t offset, std::initializer_list<u32> words) {
+        for (u32 word : words) {
+            std::memcpy(&image[offset], &word, sizeof(word));
+            offset += sizeof(word);
+        }
+    }
+
+    std::vector<Directory> directories;
+    std::vector<File> files;
+    std::vector<u8> image;
+};
+
+std::string Contents(const std::vector<u8>& image, const Index::File& file) {
+    return std::string(image.begin() + file.data_offset,
+                       image.begin() + file.data_offset + file.data_length);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RomFS::Index finds files and lists directories", "[core][hle]") {
+    ImageBuilder builder;
+    builder.AddFile("/a.bin", "first");
+    builder.AddFile("/dir/b.bin", "second");
+    builder.AddFile("/dir/sub/c.bin", "third");
+    builder.AddFile("/dir/d.bin", "fourth");
+    const std::vector<u8> image = builder.Build();
+
+    Index index;
+    REQUIRE(index.Load(image.data(), image.size()));
+    REQUIRE(index.GetDirectoryCount() == 3);
+    REQUIRE(index.GetFileCount() == 4);
+
+    const Index::File* file = index.FindFile("/dir/sub/c.bin");
+    REQUIRE(file != nullptr);
+    REQUIRE(Contents(image, *file) == "third");
+    REQUIRE(Contents(image, *index.FindFile(std::vector<std::u16string>{u"a.bin"})) == "first");
+    REQUIRE(index.FindFile("/dir/missing") == nullptr);
+    REQUIRE(index.FindFile("/dir/sub") == nullptr);
+    REQUIRE(index.FindFile("/a.bin/x") == nullptr);
+
+    // The index agrees with the walk over the entries
+    REQUIRE(GetFilePointer(image.data(), {u"dir", u"d.bin"}) ==
+            image.data() + index.FindFile("dir/d.bin")->data_offset);
+
+    const Index::Directory* dir = index.FindDirectory("/dir");
+    REQUIRE(dir != nullptr);
+    REQUIRE(dir->directories.size() == 1);
+    REQUIRE(index.GetDirectory(dir->directories[0]).name == u"sub");
+    REQUIRE(dir->files.size() == 2);
+    REQUIRE(index.GetFile(dir->files[0]).name == u"b.bin");
+    REQUIRE(index.GetFile(dir->files[1]).name == u"d.bin");
+    REQUIRE(index.FindDirectory("/") == &index.GetDirectory(Index::root));
+    REQUIRE(index.FindDirectory("/a.bin") == nullptr);
+}
+
+TEST_CASE("RomFS::Index rejects broken images", "[core][hle]") {
+    ImageBuilder builder;
+    builder.AddFile("/dir/file", "contents");
+    std::vector<u8> image = builder.Build();
+    Index index;
+
+    // Cut off in the middle of the file data
+    REQUIRE_FALSE(index.Load(image.data(), image.size() - 1));
+    REQUIRE_FALSE(index.IsLoaded());
+    REQUIRE(index.FindFile("/dir/file") == nullptr);
+
+    // A directory that is its own sibling
+    u32 dir_table_offset;
+    std::memcpy(&dir_table_offset, &image[0xC], sizeof(u32));
+    const u32 sub_offset = 0x18; // right after the root, which has no name
+    std::memcpy(&image[dir_table_offset + sub_offset + 4], &sub_offset, sizeof(u32));
+    REQUIRE_FALSE(index.Load(image.data(), image.size()));
+}
+
+TEST_CASE("RomFS lookup benchmark", "[.][benchmark][core][hle]") {
+    // A large game RomFS: many directories of many files, all of which are looked up once
+    constexpr int dir_count = 100;
+    constexpr int files_per_dir = 200;
+    ImageBuilder builder;
+    std::vector<std::vector<std::u16string>> paths;
+    for (int i = 0; i < dir_count; ++i) {
+        for (int j = 0; j < files_per_dir; ++j) {
+            const std::string dir = "dir" + std::to_string(i);
+            const std::string name = "file" + std::to_string(j) + ".bin";
+            builder.AddFile("/" + dir + "/" + name, "x");
+            paths.push_back({Common::UTF8ToUTF16(dir), Common::UTF8ToUTF16(name)});
+        }
+    }
+    const std::vector<u8> image = builder.Build();
+
+    auto start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (const auto& path : paths)
+        found += GetFilePointer(image.data(), path) != nullptr;
+    const std::chrono::duration<double, std::milli> walked =
+        std::chrono::steady_clock::now() - start;
+    REQUIRE(found == paths.size());
+
+    start = std::chrono::steady_clock::now();
+    Index index;
+    REQUIRE(index.Load(image.data(), image.size()));
+    const std::chrono::duration<double, std::milli> loaded =
+        std::chrono::steady_clock::now() - start;
+    found = 0;
+    for (const auto& path : paths)
+        found += index.FindFile(path) != nullptr;
+    const std::chrono::duration<double, std::milli> indexed =
+        std::chrono::steady_clock::now() - start;
+    REQUIRE(found == paths.size());
+
+    std::printf("Looking up %zu RomFS files: %.1f ms walking the entries, %.1f ms with an index "
+                "(%.1f ms of which building it)\n",
+                paths.size(), walked.count(), indexed.count(), loaded.count());
+}
+
+} // namespace RomFS
@@ -0,0 +1,169 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include <cryptopp/sha.h>
+#include "common/alignment.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/file_sys/title_metadata.h"
+#include "core/hle/service/am/am.h"
+#include "core/hle/service/fs/archive.h"
+
+namespace Service {
+namespace AM {
+
+namespace {
+
+constexpr u64 title_id = 0x0004000000123400;
+constexpr u32 cia_header_size = 0x2020;
+constexpr u32 tmd_offset = 0x2040;
+
+template <typename T>
+void WriteAt(std::vector<u8>& data, size_t offset, const T& value) {
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+/// Builds an unencrypted CIA without certificates or a ticket, holding the given contents.
+std::vector<u8> BuildCIA(const std::vector<std::vector<u8>>& contents) {
+    using FileSys::TitleMetadata;
+
+    TitleMetadata::Body body{};
+    body.title_id = title_id;
+    body.content_count = static_cast<u16>(contents.size());
+
+    std::vector<TitleMetadata::ContentChunk> chunks(contents.size());
+    u64 content_size = 0;
+    for (size_t i = 0; i < contents.size(); i++) {
+        chunks[i].id = static_cast<u32>(i);
+        chunks[i].index = static_cast<u16>(i);
+        chunks[i].type = 0;
+        chunks[i].size = contents[i].size();
+        CryptoPP::SHA256().CalculateDigest(chunks[i].hash.data(), contents[i].data(),
+                                           contents[i].size());
+        content_size += contents[i].size();
+    }
+
+    // RSA-2048 signature, then the body aligned to 0x40
+    constexpr u32 body_offset = 0x140;
+    const u32 tmd_size = static_cast<u32>(body_offset + sizeof(body) +
+                                          chunks.size() * sizeof(TitleMetadata::ContentChunk));
+    const u64 content_offset = Common::AlignUp(tmd_offset + tmd_size, 0x40);
+
+    std::vector<u8> cia(content_offset);
+    WriteAt(cia, 0x00, u32_le(cia_header_size));
+    WriteAt(cia, 0x10, u32_le(tmd_size));
+    WriteAt(cia, 0x18, u64_le(content_size));
+    for (size_t i = 0; i < contents.size(); i++) {
+        cia[0x20 + i / 8] |= 0x80 >> (i % 8);
+    }
+
+    WriteAt(cia, tmd_offset, u32_be(FileSys::Rsa2048Sha256));
+    WriteAt(cia, tmd_offset + body_offset, body);
+    std::memcpy(cia.data() + tmd_offset + body_offset + sizeof(body), chunks.data(),
+                chunks.size() * sizeof(TitleMetadata::ContentChunk));
+
+    for (const auto& content : contents) {
+        cia.insert(cia.end(), content.begin(), content.end());
+    }
+    return cia;
+}
+
+std::vector<std::vector<u8>> MakeContents(const std::vector<size_t>& sizes) {
+    std::mt19937 rng(static_cast<u32>(sizes.size()));
+    std::vector<std::vector<u8>> contents;
+    for (size_t size : sizes) {
+        std::vector<u8> content(size);
+        for (u8& byte : content) {
+            byte = static_cast<u8>(rng());
+        }
+        contents.push_back(std::move(content));
+    }
+    return contents;
+}
+
+/// Points the emulated SD card at an empty directory for the duration of a test.
+class TestSDMC {
+public:
+    TestSDMC() : path(FileUtil::GetCurrentDir() + DIR_SEP "am_test_sdmc" DIR_SEP) {
+        FileUtil::DeleteDirRecursively(path);
+        FileUtil::CreateFullPath(path);
+        old_path = FileUtil::GetUserPath(D_SDMC_IDX);
+        FileUtil::GetUserPath(D_SDMC_IDX, path);
+    }
+
+    ~TestSDMC() {
+        FileUtil::GetUserPath(D_SDMC_IDX, old_path);
+        FileUtil::DeleteDirRecursively(path);
+    }
+
+private:
+    std::string path;
+    std::string old_path;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("InstallCIA writes and verifies every content", "[core][am]") {
+    TestSDMC sdmc;
+    const auto contents = MakeContents({0x280000, 0x1234, 0x100001});
+    const std::string cia_path = FileUtil::GetCurrentDir() + DIR_SEP "am_test.cia";
+    const std::vector<u8> cia = BuildCIA(contents);
+    REQUIRE(FileUtil::IOFile(cia_path, "wb").WriteBytes(cia.data(), cia.size()) == cia.size());
+
+    size_t last_written = 0;
+    size_t last_total = 0;
+    InstallStats stats;
+    REQUIRE(InstallCIA(cia_path,
+                       [&](size_t written, size_t total) {
+                           last_written = written;
+                           last_total = total;
+                       },
+                       &stats) == InstallStatus::Success);
+
+    const u64 total_size = 0x280000 + 0x1234 + 0x100001;
+    REQUIRE(last_written == total_size);
+    REQUIRE(last_total == total_size);
+    REQUIRE(stats.bytes == total_size);
+    REQUIRE(stats.total_ns > 0);
+
+    for (u16 i = 0; i < contents.size(); i++) {
+        FileUtil::IOFile file(GetTitleContentPath(FS::MediaType::SDMC, title_id, i), "rb");
+        std::vector<u8> installed(file.GetSize());
+        file.ReadBytes(installed.data(), installed.size());
+        REQUIRE(installed == contents[i]);
+    }
+
+    FileUtil::Delete(cia_path);
+}
+
+TEST_CASE("InstallCIA rejects contents that do not match the TMD", "[core][am]") {
+    TestSDMC sdmc;
+    const auto contents = MakeContents({0x180000, 0x2000});
+    const std::string cia_path = FileUtil::GetCurrentDir() + DIR_SEP "am_test.cia";
+    std::vector<u8> cia = BuildCIA(contents);
+    cia[cia.size() - 0x1000] ^= 0xFF;
+    REQUIRE(FileUtil::IOFile(cia_path, "wb").WriteBytes(cia.data(), cia.size()) == cia.size());
+
+    // Save data lives in the same title folder and must outlive the failed install
+    const std::string title_path = GetTitlePath(FS::MediaType::SDMC, title_id);
+    const std::string save_path = title_path + "data/00000001.sav";
+    const std::vector<u8> save{1, 2, 3, 4};
+    REQUIRE(FileUtil::CreateFullPath(save_path));
+    REQUIRE(FileUtil::IOFile(save_path, "wb").WriteBytes(save.data(), save.size()) == save.size());
+
+    REQUIRE(InstallCIA(cia_path) == InstallStatus::ErrorHashMismatch);
+    REQUIRE(FileUtil::Exists(save_path));
+    REQUIRE(FileUtil::GetSize(save_path) == save.size());
+    REQUIRE(!FileUtil::Exists(title_path + "content/"));
+
+    FileUtil::Delete(cia_path);
+}
+
+} // namespace AM
+} // namespace Service
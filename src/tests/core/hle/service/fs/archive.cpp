@@ -0,0 +1,112 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "core/file_sys/ivfc_archive.h"
+#include "core/file_sys/romfs_reader.h"
+#include "core/hle/service/fs/archive.h"
+
+namespace Service {
+namespace FS {
+
+namespace {
+
+/// A RomFS file whose reads take at least `host_delay` on the host, like a slow disk would.
+class SlowIVFCFile : public FileSys::IVFCFile {
+public:
+    SlowIVFCFile(std::shared_ptr<FileSys::RomFSReader> file, std::chrono::microseconds host_delay)
+        : IVFCFile(std::move(file), std::make_unique<FileSys::RomFSDelayGenerator>()),
+          host_delay(host_delay) {}
+
+    ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override {
+        std::this_thread::sleep_for(host_delay);
+        return IVFCFile::Read(offset, length, buffer);
+    }
+
+private:
+    std::chrono::microseconds host_delay;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("File::Read emulation thread blocking benchmark", "[.][benchmark][core][fs]") {
+    // File::Read starts the host read, then the emulation thread runs other guest threads for the
+    // emulated read delay, and only waits for the host read once the client thread wakes up.
+    // Measures how long the emulation thread is blocked in total, against reading right away.
+    using Clock = std::chrono::steady_clock;
+    using std::chrono::microseconds;
+    constexpr size_t image_size = 1024 * 1024;
+    constexpr size_t read_size = 64 * 1024;
+
+    const auto spin_for = [](Clock::duration duration) {
+        const auto end = Clock::now() + duration;
+        while (Clock::now() < end) {
+        }
+    };
+    const auto to_ms = [](Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+
+    const std::string image_path = FileUtil::GetCurrentDir() + DIR_SEP "fs_read_benchmark.romfs";
+    {
+        const std::vector<u8> image(image_size, 0x5A);
+        REQUIRE(FileUtil::IOFile(image_path, "wb").WriteBytes(image.data(), image.size()) ==
+                image.size());
+    }
+    auto image = std::make_shared<FileUtil::MappedFile>(image_path);
+    REQUIRE(image->IsOpen());
+    auto romfs = std::make_shared<FileSys::RomFSReader>(image, 0, image_size);
+
+    ArchiveInit();
+    for (microseconds host_delay : {microseconds(10000), microseconds(2000), microseconds(200)}) {
+        File file(std::make_unique<SlowIVFCFile>(romfs, host_delay), "");
+        const std::chrono::nanoseconds emulated_delay{file.backend->GetReadDelayNs(read_size)};
+
+        Clock::duration sync_blocked{};
+        Clock::duration async_blocked{};
+        std::vector<u8> data(read_size);
+        for (u64 offset = 0; offset + read_size <= image_size; offset += read_size) {
+            auto start = Clock::now();
+            REQUIRE(file.backend->Read(offset, data.size(), data.data()).Succeeded());
+            sync_blocked += Clock::now() - start;
+            spin_for(emulated_delay);
+
+            auto read = std::make_shared<File::PendingRead>();
+            read->data.resize(read_size);
+            start = Clock::now();
+            std::shared_future<void> done = file.StartRead(offset, read);
+            async_blocked += Clock::now() - start;
+            spin_for(emulated_delay);
+            start = Clock::now();
+            done.wait();
+            async_blocked += Clock::now() - start;
+            REQUIRE(read->result.Succeeded());
+            REQUIRE(*read->result == read_size);
+        }
+
+        std::printf("host %5lld us, emulated delay %5lld us: blocked %8.2f ms on read, %8.2f ms "
+                    "with File::Read over %zu reads\n",
+                    static_cast<long long>(host_delay.count()),
+                    static_cast<long long>(
+                        std::chrono::duration_cast<microseconds>(emulated_delay).count()),
+                    to_ms(sync_blocked), to_ms(async_blocked), image_size / read_size);
+        CHECK(async_blocked < sync_blocked);
+    }
+    ArchiveShutdown();
+
+    image.reset();
+    romfs.reset();
+    FileUtil::Delete(image_path);
+}
+
+} // namespace FS
+} // namespace Service
@@ -0,0 +1,65 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <vector>
+#include <catch.hpp>
+#include "core/hw/aes/ctr.h"
+
+namespace HW {
+namespace AES {
+
+TEST_CASE("DecryptCTR matches the NIST test vector", "[core][aes]") {
+    // NIST SP 800-38A, F.5.1 CTR-AES128.Encrypt
+    const AESKey key{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                     0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+    const CTRCounter ctr{0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                         0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+    const std::vector<u8> plain{
+        0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73,
+        0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7,
+        0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51, 0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4,
+        0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef, 0xf6, 0x9f, 0x24, 0x45,
+        0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+    const std::vector<u8> cipher{
+        0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99,
+        0x0d, 0xb6, 0xce, 0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17,
+        0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff, 0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3,
+        0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab, 0x1e, 0x03, 0x1d, 0xda,
+        0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee};
+
+    std::vector<u8> data = cipher;
+    DecryptCTR(data.data(), data.size(), key, ctr, 0);
+    REQUIRE(data == plain);
+
+    // Decrypting any part of the stream on its own gives the same result
+    for (size_t offset : {1, 15, 16, 17, 33, 63}) {
+        for (size_t size : {1, 7, 16, 31}) {
+            size = std::min(size, cipher.size() - offset);
+            std::vector<u8> part(cipher.begin() + offset, cipher.begin() + offset + size);
+            DecryptCTR(part.data(), part.size(), key, ctr, offset);
+            REQUIRE(std::equal(part.begin(), part.end(), plain.begin() + offset));
+        }
+    }
+}
+
+TEST_CASE("DecryptCTR carries the counter across all 128 bits", "[core][aes]") {
+    const AESKey key{};
+    CTRCounter ctr{};
+    std::fill(ctr.begin() + 4, ctr.end(), 0xFF);
+
+    std::vector<u8> stream(4 * AES_BLOCK_SIZE);
+    DecryptCTR(stream.data(), stream.size(), key, ctr, 0);
+
+    // The third block uses the counter that overflowed into the fourth byte
+    CTRCounter carried{};
+    carried[3] = 1;
+    carried[15] = 1;
+    std::vector<u8> block(AES_BLOCK_SIZE);
+    DecryptCTR(block.data(), block.size(), key, carried, 0);
+    REQUIRE(std::equal(block.begin(), block.end(), stream.begin() + 2 * AES_BLOCK_SIZE));
+}
+
+} // namespace AES
+} // namespace HW
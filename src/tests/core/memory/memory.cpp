@@ -2,9 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
 #include <catch.hpp>
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
+#include "core/hle/kernel/vm_manager.h"
 #include "core/memory.h"
 
 TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
@@ -48,3 +53,89 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+TEST_CASE("Memory::RasterizerMarkRegionCached", "[core][memory]") {
+    auto process = Kernel::Process::Create(Kernel::CodeSet::Create("", 0));
+    Kernel::HandleSpecialMapping(process->vm_manager,
+                                 {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+    Kernel::g_current_process = process;
+    Memory::PageTable& page_table = process->vm_manager.page_table;
+    Memory::SetCurrentPageTable(&page_table);
+
+    // Two pages on both sides of a 1MB boundary, where the page table groups its pages
+    const u32 first_page = (Memory::VRAM_VADDR >> Memory::PAGE_BITS) + 0xFF;
+    u8* const backing = Memory::GetPhysicalPointer(Memory::VRAM_PADDR + 0xFF000);
+    Memory::RasterizerMarkRegionCached(Memory::VRAM_PADDR + 0xFF800, Memory::PAGE_SIZE, true);
+    CHECK(page_table.attributes[first_page - 1] == Memory::PageType::Memory);
+    CHECK(page_table.attributes[first_page] == Memory::PageType::RasterizerCachedMemory);
+    CHECK(page_table.attributes[first_page + 1] == Memory::PageType::RasterizerCachedMemory);
+    CHECK(page_table.attributes[first_page + 2] == Memory::PageType::Memory);
+    CHECK(page_table.pointers[first_page] == nullptr);
+
+    CHECK(Memory::IsRegionRasterizerCached(page_table, Memory::VRAM_VADDR, Memory::VRAM_SIZE));
+    CHECK(Memory::IsRegionRasterizerCached(page_table, Memory::VRAM_VADDR + 0x100FFF, 1));
+    CHECK_FALSE(Memory::IsRegionRasterizerCached(page_table, Memory::VRAM_VADDR, 0xFF000));
+    CHECK_FALSE(Memory::IsRegionRasterizerCached(page_table, Memory::VRAM_VADDR + 0x101000,
+                                                 Memory::VRAM_SIZE - 0x101000));
+
+    SECTION("uncaching the pages maps their memory again") {
+        Memory::RasterizerMarkRegionCached(Memory::VRAM_PADDR + 0xFF000, 0x2000, false);
+        CHECK(page_table.attributes[first_page] == Memory::PageType::Memory);
+        CHECK(page_table.pointers[first_page] == backing);
+        CHECK(page_table.pointers[first_page + 1] == backing + Memory::PAGE_SIZE);
+        CHECK_FALSE(
+            Memory::IsRegionRasterizerCached(page_table, Memory::VRAM_VADDR, Memory::VRAM_SIZE));
+    }
+
+    SECTION("unmapping the pages forgets that they were cached") {
+        process->vm_manager.UnmapRange(Memory::VRAM_VADDR, Memory::VRAM_SIZE);
+        CHECK(page_table.attributes[first_page] == Memory::PageType::Unmapped);
+        CHECK_FALSE(
+            Memory::IsRegionRasterizerCached(page_table, Memory::VRAM_VADDR, Memory::VRAM_SIZE));
+    }
+
+    Memory::SetCurrentPageTable(nullptr);
+    Kernel::g_current_process = nullptr;
+}
+
+TEST_CASE("Page table update benchmark", "[.][benchmark][core][memory]") {
+    constexpr int passes = 100;
+    constexpr u32 heap_size = 0x02000000;
+    constexpr u32 surface_size = 0x10000;
+
+    auto process = Kernel::Process::Create(Kernel::CodeSet::Create("", 0));
+    Kernel::HandleSpecialMapping(process->vm_manager,
+                                 {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+    Kernel::g_current_process = process;
+    Memory::SetCurrentPageTable(&process->vm_manager.page_table);
+    auto block = std::make_shared<std::vector<u8>>(heap_size);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        REQUIRE(process->vm_manager
+                    .MapMemoryBlock(Memory::HEAP_VADDR, block, 0, heap_size,
+                                    Kernel::MemoryState::Private)
+                    .Succeeded());
+        REQUIRE(process->vm_manager.UnmapRange(Memory::HEAP_VADDR, heap_size) == RESULT_SUCCESS);
+    }
+    const std::chrono::duration<double, std::milli> mapped =
+        std::chrono::steady_clock::now() - start;
+
+    // Registering and unregistering every surface of a VRAM full of 64KB surfaces
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (u32 offset = 0; offset < Memory::VRAM_SIZE; offset += surface_size)
+            Memory::RasterizerMarkRegionCached(Memory::VRAM_PADDR + offset, surface_size, true);
+        for (u32 offset = 0; offset < Memory::VRAM_SIZE; offset += surface_size)
+            Memory::RasterizerMarkRegionCached(Memory::VRAM_PADDR + offset, surface_size, false);
+    }
+    const std::chrono::duration<double, std::milli> marked =
+        std::chrono::steady_clock::now() - start;
+
+    Memory::SetCurrentPageTable(nullptr);
+    Kernel::g_current_process = nullptr;
+
+    std::printf("%d passes: %.1f ms mapping and unmapping %u MB, %.1f ms marking and unmarking %u "
+                "MB of surfaces as cached\n",
+                passes, mapped.count(), heap_size >> 20, marked.count(), Memory::VRAM_SIZE >> 20);
+}
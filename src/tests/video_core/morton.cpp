@@ -0,0 +1,167 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "video_core/morton.h"
+#include "video_core/utils.h"
+
+using VideoCore::MortonFormat;
+
+static constexpr MortonFormat all_formats[] = {MortonFormat::Bytes2, MortonFormat::Bytes3,
+                                               MortonFormat::Bytes4, MortonFormat::D24X8,
+                                               MortonFormat::D24S8};
+
+static const char* GetFormatName(MortonFormat format) {
+    switch (format) {
+    case MortonFormat::Bytes2:
+        return "Bytes2";
+    case MortonFormat::Bytes3:
+        return "Bytes3";
+    case MortonFormat::Bytes4:
+        return "Bytes4";
+    case MortonFormat::D24X8:
+        return "D24X8";
+    case MortonFormat::D24S8:
+        return "D24S8";
+    }
+    return "";
+}
+
+static std::vector<u8> RandomBytes(size_t size, u32 seed) {
+    std::mt19937 rng(seed);
+    std::vector<u8> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<u8>(rng());
+    }
+    return data;
+}
+
+/// Per-pixel reference conversion of a whole image, written after GetMortonOffset
+static void ReferenceCopy(bool morton_to_linear, MortonFormat format, u32 width, u32 height,
+                          u8* tiled, u8* linear_row0, std::ptrdiff_t pitch) {
+    const u32 bpp = VideoCore::MortonTiledBytesPerPixel(format);
+    const u32 linear_bpp = VideoCore::MortonLinearBytesPerPixel(format);
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            u8* tiled_pixel =
+                tiled + VideoCore::GetMortonOffset(x, y, bpp) + (y & ~7) * width * bpp;
+            u8* linear_pixel = linear_row0 + static_cast<std::ptrdiff_t>(y) * pitch + x * linear_bpp;
+            if (morton_to_linear) {
+                if (format == MortonFormat::D24X8) {
+                    linear_pixel[0] = 0;
+                    std::memcpy(linear_pixel + 1, tiled_pixel, 3);
+                } else if (format == MortonFormat::D24S8) {
+                    linear_pixel[0] = tiled_pixel[3];
+                    std::memcpy(linear_pixel + 1, tiled_pixel, 3);
+                } else {
+                    std::memcpy(linear_pixel, tiled_pixel, bpp);
+                }
+            } else {
+                if (format == MortonFormat::D24X8) {
+                    std::memcpy(tiled_pixel, linear_pixel + 1, 3);
+                } else if (format == MortonFormat::D24S8) {
+                    std::memcpy(tiled_pixel, linear_pixel + 1, 3);
+                    tiled_pixel[3] = linear_pixel[0];
+                } else {
+                    std::memcpy(tiled_pixel, linear_pixel, bpp);
+                }
+            }
+        }
+    }
+}
+
+static void CheckImage(MortonFormat format, u32 width, u32 height, bool bottom_up) {
+    const u32 bpp = VideoCore::MortonTiledBytesPerPixel(format);
+    const u32 linear_bpp = VideoCore::MortonLinearBytesPerPixel(format);
+    const u32 num_tiles = width * height / 64;
+    const std::ptrdiff_t row_size = width * linear_bpp;
+    const std::ptrdiff_t pitch = bottom_up ? -row_size : row_size;
+    const std::ptrdiff_t row0_offset = bottom_up ? (height - 1) * row_size : 0;
+
+    INFO("format " << GetFormatName(format) << ", " << width << "x" << height
+                   << (bottom_up ? ", bottom-up" : ""));
+
+    // Tiled to linear
+    std::vector<u8> tiled = RandomBytes(width * height * bpp, width + height);
+    std::vector<u8> linear(height * row_size);
+    std::vector<u8> expected_linear(height * row_size);
+    VideoCore::MortonCopyTiles(true, format, width, 0, num_tiles, tiled.data(),
+                               linear.data() + row0_offset, pitch);
+    ReferenceCopy(true, format, width, height, tiled.data(), expected_linear.data() + row0_offset,
+                  pitch);
+    REQUIRE(linear == expected_linear);
+
+    // Linear to tiled
+    linear = RandomBytes(height * row_size, width * height);
+    std::vector<u8> expected_tiled(tiled.size());
+    VideoCore::MortonCopyTiles(false, format, width, 0, num_tiles, tiled.data(),
+                               linear.data() + row0_offset, pitch);
+    ReferenceCopy(false, format, width, height, expected_tiled.data(),
+                  linear.data() + row0_offset, pitch);
+    REQUIRE(tiled == expected_tiled);
+}
+
+TEST_CASE("MortonCopyTiles matches the per-pixel conversion", "[video_core][morton]") {
+    for (MortonFormat format : all_formats) {
+        CheckImage(format, 8, 8, false);
+        CheckImage(format, 64, 24, false);
+        CheckImage(format, 40, 16, true);
+        // Large enough to be split across threads
+        CheckImage(format, 1024, 512, true);
+    }
+}
+
+TEST_CASE("MortonCopyTiles copies partial tile ranges", "[video_core][morton]") {
+    constexpr u32 width = 32;
+    constexpr u32 height = 32;
+    constexpr MortonFormat format = MortonFormat::Bytes4;
+    constexpr u32 tile_size = 64 * 4;
+
+    const std::vector<u8> tiled = RandomBytes(width * height * 4, 1);
+    std::vector<u8> expected(width * height * 4);
+    std::vector<u8> tiled_copy = tiled;
+    ReferenceCopy(true, format, width, height, tiled_copy.data(), expected.data(), width * 4);
+
+    // Copy the image in a few uneven pieces, each starting at an arbitrary tile
+    std::vector<u8> linear(width * height * 4);
+    const u32 pieces[][2] = {{0, 3}, {3, 1}, {4, 7}, {11, 5}};
+    for (const auto& piece : pieces) {
+        VideoCore::MortonCopyTiles(true, format, width, piece[0], piece[1],
+                                   tiled_copy.data() + piece[0] * tile_size, linear.data(),
+                                   width * 4);
+    }
+    REQUIRE(linear == expected);
+}
+
+TEST_CASE("MortonCopyTiles benchmark", "[.][benchmark][morton]") {
+    constexpr u32 width = 1024;
+    constexpr u32 height = 1024;
+    constexpr int iterations = 50;
+
+    for (MortonFormat format : all_formats) {
+        const u32 bpp = VideoCore::MortonTiledBytesPerPixel(format);
+        const u32 linear_bpp = VideoCore::MortonLinearBytesPerPixel(format);
+        std::vector<u8> tiled = RandomBytes(width * height * bpp, 0);
+        std::vector<u8> linear(width * height * linear_bpp);
+
+        for (bool morton_to_linear : {true, false}) {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                VideoCore::MortonCopyTiles(morton_to_linear, format, width, 0,
+                                           width * height / 64, tiled.data(), linear.data(),
+                                           width * linear_bpp);
+            }
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            const double gigabytes = static_cast<double>(tiled.size()) * iterations / 1e9;
+            std::printf("%-6s %-16s %6.2f GB/s\n", GetFormatName(format),
+                        morton_to_linear ? "tiled to linear" : "linear to tiled",
+                        gigabytes / elapsed.count());
+        }
+    }
+}
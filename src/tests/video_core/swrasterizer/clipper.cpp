@@ -0,0 +1,218 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+#include <catch.hpp>
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/regs.h"
+#include "video_core/shader/shader.h"
+#include "video_core/swrasterizer/clipper.h"
+#include "video_core/swrasterizer/rasterizer.h"
+
+namespace Pica {
+namespace Clipper {
+
+namespace {
+
+using Rasterizer::Vertex;
+
+/// Encodes a normal float as a raw float24 register value
+u32 ToFloat24Raw(float value) {
+    u32 hex;
+    std::memcpy(&hex, &value, sizeof(hex));
+    const u32 sign = hex >> 31;
+    const u32 exponent = ((hex >> 23) & 0xFF) - 64;
+    const u32 mantissa = (hex & 0x7FFFFF) >> 7;
+    return (sign << 23) | (exponent << 16) | mantissa;
+}
+
+/// Sets up a 64x64 viewport at the screen origin
+class TestViewport {
+public:
+    TestViewport() {
+        std::memset(&g_state.regs, 0, sizeof(g_state.regs));
+        g_state.regs.rasterizer.viewport_size_x.Assign(ToFloat24Raw(32.0f));
+        g_state.regs.rasterizer.viewport_size_y.Assign(ToFloat24Raw(32.0f));
+    }
+
+    ~TestViewport() {
+        std::memset(&g_state.regs, 0, sizeof(g_state.regs));
+    }
+};
+
+OutputVertex MakeVertex(float x, float y, float z, float w = 1.0f) {
+    OutputVertex vertex{};
+    vertex.pos = Math::MakeVec(float24::FromFloat32(x), float24::FromFloat32(y),
+                               float24::FromFloat32(z), float24::FromFloat32(w));
+    return vertex;
+}
+
+/// Clips the triangles and collects the emitted vertices, three per triangle
+ClipStats Clip(const std::vector<OutputVertex>& vertices, std::vector<Vertex>& output) {
+    return ProcessTriangles(vertices, [&](const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+        output.push_back(v0);
+        output.push_back(v1);
+        output.push_back(v2);
+    });
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Clipper passes triangles inside the view volume through", "[video_core][swrasterizer]") {
+    TestViewport viewport;
+    std::vector<Vertex> output;
+
+    const ClipStats stats = Clip({MakeVertex(-0.5f, -0.5f, -0.5f), MakeVertex(0.5f, -0.5f, -0.5f),
+                                  MakeVertex(0.0f, 0.5f, -0.5f)},
+                                 output);
+    REQUIRE(stats.accepted == 1);
+    REQUIRE(stats.rejected == 0);
+    REQUIRE(stats.clipped == 0);
+
+    REQUIRE(output.size() == 3);
+    REQUIRE(output[0].screenpos.x.ToFloat32() == 16.0f);
+    REQUIRE(output[0].screenpos.y.ToFloat32() == 16.0f);
+    REQUIRE(output[1].screenpos.x.ToFloat32() == 48.0f);
+    REQUIRE(output[1].screenpos.y.ToFloat32() == 16.0f);
+    REQUIRE(output[2].screenpos.x.ToFloat32() == 32.0f);
+    REQUIRE(output[2].screenpos.y.ToFloat32() == 48.0f);
+    for (const Vertex& vertex : output) {
+        REQUIRE(vertex.screenpos.z.ToFloat32() == -0.5f);
+    }
+}
+
+TEST_CASE("Clipper rejects triangles outside of a clipping plane", "[video_core][swrasterizer]") {
+    TestViewport viewport;
+    std::vector<Vertex> output;
+
+    // All vertices are beyond x = +w, although the triangle crosses the other planes
+    const ClipStats stats = Clip({MakeVertex(2.0f, -2.0f, -0.5f), MakeVertex(3.0f, 2.0f, -0.5f),
+                                  MakeVertex(2.5f, 0.0f, 0.5f)},
+                                 output);
+    REQUIRE(stats.accepted == 0);
+    REQUIRE(stats.rejected == 1);
+    REQUIRE(stats.clipped == 0);
+    REQUIRE(output.empty());
+}
+
+TEST_CASE("Clipper does not clip triangles inside the guard band", "[video_core][swrasterizer]") {
+    TestViewport viewport;
+    std::vector<Vertex> output;
+
+    SECTION("crossing the right and top viewport edges") {
+        const ClipStats stats =
+            Clip({MakeVertex(-0.5f, -0.5f, -0.5f), MakeVertex(1.5f, -0.5f, -0.5f),
+                  MakeVertex(0.0f, 1.5f, -0.5f)},
+                 output);
+        REQUIRE(stats.accepted == 1);
+        REQUIRE(stats.rejected == 0);
+        REQUIRE(stats.clipped == 0);
+
+        REQUIRE(output.size() == 3);
+        REQUIRE(output[1].screenpos.x.ToFloat32() == 80.0f);
+        REQUIRE(output[2].screenpos.y.ToFloat32() == 80.0f);
+    }
+
+    SECTION("crossing the left viewport edge") {
+        // The guard band starts at the screen origin
+        const ClipStats stats =
+            Clip({MakeVertex(-1.5f, -0.5f, -0.5f), MakeVertex(0.5f, -0.5f, -0.5f),
+                  MakeVertex(0.0f, 0.5f, -0.5f)},
+                 output);
+        REQUIRE(stats.accepted == 0);
+        REQUIRE(stats.rejected == 0);
+        REQUIRE(stats.clipped == 1);
+
+        REQUIRE(!output.empty());
+        for (const Vertex& vertex : output) {
+            REQUIRE(vertex.screenpos.x.ToFloat32() >= 0.0f);
+        }
+    }
+
+    SECTION("leaving the guard band") {
+        const ClipStats stats =
+            Clip({MakeVertex(-0.5f, -0.5f, -0.5f), MakeVertex(40.0f, -0.5f, -0.5f),
+                  MakeVertex(0.0f, 0.5f, -0.5f)},
+                 output);
+        REQUIRE(stats.accepted == 0);
+        REQUIRE(stats.rejected == 0);
+        REQUIRE(stats.clipped == 1);
+
+        REQUIRE(!output.empty());
+        for (const Vertex& vertex : output) {
+            REQUIRE(vertex.screenpos.x.ToFloat32() <= 64.0f);
+        }
+    }
+}
+
+TEST_CASE("Clipper clips triangles crossing the depth and w planes",
+          "[video_core][swrasterizer]") {
+    TestViewport viewport;
+    std::vector<Vertex> output;
+
+    SECTION("z = 0") {
+        const ClipStats stats =
+            Clip({MakeVertex(-0.5f, -0.5f, -0.5f), MakeVertex(0.5f, -0.5f, -0.5f),
+                  MakeVertex(0.0f, 0.5f, 0.5f)},
+                 output);
+        REQUIRE(stats.accepted == 0);
+        REQUIRE(stats.rejected == 0);
+        REQUIRE(stats.clipped == 1);
+
+        // The clipped polygon is a quad
+        REQUIRE(output.size() == 6);
+        for (const Vertex& vertex : output) {
+            REQUIRE(vertex.screenpos.z.ToFloat32() <= 0.0f);
+            REQUIRE(vertex.screenpos.y.ToFloat32() <= 32.0f);
+        }
+    }
+
+    SECTION("w = epsilon") {
+        // The last vertex is behind the camera
+        const ClipStats stats =
+            Clip({MakeVertex(-0.5f, -0.5f, -0.5f), MakeVertex(0.5f, -0.5f, -0.5f),
+                  MakeVertex(0.0f, 0.5f, 0.5f, -1.0f)},
+                 output);
+        REQUIRE(stats.accepted == 0);
+        REQUIRE(stats.rejected == 0);
+        REQUIRE(stats.clipped == 1);
+
+        REQUIRE(!output.empty());
+        for (const Vertex& vertex : output) {
+            // pos.w holds 1 / w after clipping
+            REQUIRE(vertex.pos.w.ToFloat32() > 0.0f);
+            REQUIRE(vertex.screenpos.z.ToFloat32() >= -1.0f);
+            REQUIRE(vertex.screenpos.z.ToFloat32() <= 0.0f);
+        }
+    }
+}
+
+TEST_CASE("Clipper counts the triangles of a batch", "[video_core][swrasterizer]") {
+    TestViewport viewport;
+    std::vector<Vertex> output;
+
+    const ClipStats stats =
+        Clip({// Inside
+              MakeVertex(-0.5f, -0.5f, -0.5f), MakeVertex(0.5f, -0.5f, -0.5f),
+              MakeVertex(0.0f, 0.5f, -0.5f),
+              // Outside of z = -w
+              MakeVertex(-0.5f, -0.5f, -2.0f), MakeVertex(0.5f, -0.5f, -2.0f),
+              MakeVertex(0.0f, 0.5f, -2.0f),
+              // Crossing z = 0
+              MakeVertex(-0.5f, -0.5f, -0.5f), MakeVertex(0.5f, -0.5f, -0.5f),
+              MakeVertex(0.0f, 0.5f, 0.5f),
+              // Inside the guard band
+              MakeVertex(-0.5f, -0.5f, -0.5f), MakeVertex(1.5f, -0.5f, -0.5f),
+              MakeVertex(0.0f, 0.5f, -0.5f)},
+             output);
+    REQUIRE(stats.accepted == 2);
+    REQUIRE(stats.rejected == 1);
+    REQUIRE(stats.clipped == 1);
+    REQUIRE(output.size() == 3 + 6 + 3);
+}
+
+} // namespace Clipper
+} // namespace Pica
@@ -0,0 +1,571 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <catch.hpp>
+#include "common/math_util.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/lighting.h"
+using Pica::LightingBatch;
+
+using Pica::LightingRegs;
+using Pica::LightingSetup;
+using Pica::State;
+
+namespace {
+
+// Reference implementation reading the lighting registers and LUTs directly for every fragment.
+// The setup-based implementation is expected to produce bit-identical results.
+namespace Reference {
+
+using namespace Pica;
+
+float LookupLightingLut(const Pica::State::Lighting& lighting, size_t lut_index, u8 index,
+                               float delta) {
+    ASSERT_MSG(lut_index < lighting.luts.size(), "Out of range lut");
+    ASSERT_MSG(index < lighting.luts[lut_index].size(), "Out of range index");
+
+    const auto& lut = lighting.luts[lut_index][index];
+
+    float lut_value = lut.ToFloat();
+    float lut_diff = lut.DiffToFloat();
+
+    return lut_value + lut_diff * delta;
+}
+
+std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
+    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
+    const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view,
+    const Math::Vec4<u8> (&texture_color)[4]) {
+
+    Math::Vec4<float> shadow;
+    if (lighting.config0.enable_shadow) {
+        shadow = texture_color[lighting.config0.shadow_selector].Cast<float>() / 255.0f;
+        if (lighting.config0.shadow_invert) {
+            shadow = Math::MakeVec(1.0f, 1.0f, 1.0f, 1.0f) - shadow;
+        }
+    } else {
+        shadow = Math::MakeVec(1.0f, 1.0f, 1.0f, 1.0f);
+    }
+
+    Math::Vec3<float> surface_normal;
+    Math::Vec3<float> surface_tangent;
+
+    if (lighting.config0.bump_mode != LightingRegs::LightingBumpMode::None) {
+        Math::Vec3<float> perturbation =
+            texture_color[lighting.config0.bump_selector].xyz().Cast<float>() / 127.5f -
+            Math::MakeVec(1.0f, 1.0f, 1.0f);
+        if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::NormalMap) {
+            if (!lighting.config0.disable_bump_renorm) {
+                const float z_square = 1 - perturbation.xy().Length2();
+                perturbation.z = std::sqrt(std::max(z_square, 0.0f));
+            }
+            surface_normal = perturbation;
+            surface_tangent = Math::MakeVec(1.0f, 0.0f, 0.0f);
+        } else if (lighting.config0.bump_mode == LightingRegs::LightingBumpMode::TangentMap) {
+            surface_normal = Math::MakeVec(0.0f, 0.0f, 1.0f);
+            surface_tangent = perturbation;
+        } else {
+            LOG_ERROR(HW_GPU, "Unknown bump mode %u",
+                      static_cast<u32>(lighting.config0.bump_mode.Value()));
+        }
+    } else {
+        surface_normal = Math::MakeVec(0.0f, 0.0f, 1.0f);
+        surface_tangent = Math::MakeVec(1.0f, 0.0f, 0.0f);
+    }
+
+    // Use the normalized the quaternion when performing the rotation
+    auto normal = Math::QuaternionRotate(normquat, surface_normal);
+    auto tangent = Math::QuaternionRotate(normquat, surface_tangent);
+
+    Math::Vec4<float> diffuse_sum = {0.0f, 0.0f, 0.0f, 1.0f};
+    Math::Vec4<float> specular_sum = {0.0f, 0.0f, 0.0f, 1.0f};
+
+    for (unsigned light_index = 0; light_index <= lighting.max_light_index; ++light_index) {
+        unsigned num = lighting.light_enable.GetNum(light_index);
+        const auto& light_config = lighting.light[num];
+
+        Math::Vec3<float> refl_value = {};
+        Math::Vec3<float> position = {float16::FromRaw(light_config.x).ToFloat32(),
+                                      float16::FromRaw(light_config.y).ToFloat32(),
+                                      float16::FromRaw(light_config.z).ToFloat32()};
+        Math::Vec3<float> light_vector;
+
+        if (light_config.config.directional)
+            light_vector = position;
+        else
+            light_vector = position + view;
+
+        light_vector.Normalize();
+
+        Math::Vec3<float> norm_view = view.Normalized();
+        Math::Vec3<float> half_vector = norm_view + light_vector;
+
+        float dist_atten = 1.0f;
+        if (!lighting.IsDistAttenDisabled(num)) {
+            auto distance = (-view - position).Length();
+            float scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
+            float bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+            size_t lut =
+                static_cast<size_t>(LightingRegs::LightingSampler::DistanceAttenuation) + num;
+
+            float sample_loc = MathUtil::Clamp(scale * distance + bias, 0.0f, 1.0f);
+
+            u8 lutindex =
+                static_cast<u8>(MathUtil::Clamp(std::floor(sample_loc * 256.0f), 0.0f, 255.0f));
+            float delta = sample_loc * 256 - lutindex;
+            dist_atten = LookupLightingLut(lighting_state, lut, lutindex, delta);
+        }
+
+        auto GetLutValue = [&](LightingRegs::LightingLutInput input, bool abs,
+                               LightingRegs::LightingScale scale_enum,
+                               LightingRegs::LightingSampler sampler) {
+            float result = 0.0f;
+
+            switch (input) {
+            case LightingRegs::LightingLutInput::NH:
+                result = Math::Dot(normal, half_vector.Normalized());
+                break;
+
+            case LightingRegs::LightingLutInput::VH:
+                result = Math::Dot(norm_view, half_vector.Normalized());
+                break;
+
+            case LightingRegs::LightingLutInput::NV:
+                result = Math::Dot(normal, norm_view);
+                break;
+
+            case LightingRegs::LightingLutInput::LN:
+                result = Math::Dot(light_vector, normal);
+                break;
+
+            case LightingRegs::LightingLutInput::SP: {
+                Math::Vec3<s32> spot_dir{light_config.spot_x.Value(), light_config.spot_y.Value(),
+                                         light_config.spot_z.Value()};
+                result = Math::Dot(light_vector, spot_dir.Cast<float>() / 2047.0f);
+                break;
+            }
+            case LightingRegs::LightingLutInput::CP:
+                if (lighting.config0.config == LightingRegs::LightingConfig::Config7) {
+                    const Math::Vec3<float> norm_half_vector = half_vector.Normalized();
+                    const Math::Vec3<float> half_vector_proj =
+                        norm_half_vector - normal * Math::Dot(normal, norm_half_vector);
+                    result = Math::Dot(half_vector_proj, tangent);
+                } else {
+                    result = 0.0f;
+                }
+                break;
+            default:
+                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input %u\n", static_cast<u32>(input));
+                UNIMPLEMENTED();
+                result = 0.0f;
+            }
+
+            u8 index;
+            float delta;
+
+            if (abs) {
+                if (light_config.config.two_sided_diffuse)
+                    result = std::abs(result);
+                else
+                    result = std::max(result, 0.0f);
+
+                float flr = std::floor(result * 256.0f);
+                index = static_cast<u8>(MathUtil::Clamp(flr, 0.0f, 255.0f));
+                delta = result * 256 - index;
+            } else {
+                float flr = std::floor(result * 128.0f);
+                s8 signed_index = static_cast<s8>(MathUtil::Clamp(flr, -128.0f, 127.0f));
+                delta = result * 128.0f - signed_index;
+                index = static_cast<u8>(signed_index);
+            }
+
+            float scale = lighting.lut_scale.GetScale(scale_enum);
+            return scale *
+                   LookupLightingLut(lighting_state, static_cast<size_t>(sampler), index, delta);
+        };
+
+        // If enabled, compute spot light attenuation value
+        float spot_atten = 1.0f;
+        if (!lighting.IsSpotAttenDisabled(num) &&
+            LightingRegs::IsLightingSamplerSupported(
+                lighting.config0.config, LightingRegs::LightingSampler::SpotlightAttenuation)) {
+            auto lut = LightingRegs::SpotlightAttenuationSampler(num);
+            spot_atten = GetLutValue(lighting.lut_input.sp, lighting.abs_lut_input.disable_sp == 0,
+                                     lighting.lut_scale.sp, lut);
+        }
+
+        // Specular 0 component
+        float d0_lut_value = 1.0f;
+        if (lighting.config1.disable_lut_d0 == 0 &&
+            LightingRegs::IsLightingSamplerSupported(
+                lighting.config0.config, LightingRegs::LightingSampler::Distribution0)) {
+            d0_lut_value =
+                GetLutValue(lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
+                            lighting.lut_scale.d0, LightingRegs::LightingSampler::Distribution0);
+        }
+
+        Math::Vec3<float> specular_0 = d0_lut_value * light_config.specular_0.ToVec3f();
+
+        // If enabled, lookup ReflectRed value, otherwise, 1.0 is used
+        if (lighting.config1.disable_lut_rr == 0 &&
+            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
+                                                     LightingRegs::LightingSampler::ReflectRed)) {
+            refl_value.x =
+                GetLutValue(lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
+                            lighting.lut_scale.rr, LightingRegs::LightingSampler::ReflectRed);
+        } else {
+            refl_value.x = 1.0f;
+        }
+
+        // If enabled, lookup ReflectGreen value, otherwise, ReflectRed value is used
+        if (lighting.config1.disable_lut_rg == 0 &&
+            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
+                                                     LightingRegs::LightingSampler::ReflectGreen)) {
+            refl_value.y =
+                GetLutValue(lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
+                            lighting.lut_scale.rg, LightingRegs::LightingSampler::ReflectGreen);
+        } else {
+            refl_value.y = refl_value.x;
+        }
+
+        // If enabled, lookup ReflectBlue value, otherwise, ReflectRed value is used
+        if (lighting.config1.disable_lut_rb == 0 &&
+            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
+                                                     LightingRegs::LightingSampler::ReflectBlue)) {
+            refl_value.z =
+                GetLutValue(lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
+                            lighting.lut_scale.rb, LightingRegs::LightingSampler::ReflectBlue);
+        } else {
+            refl_value.z = refl_value.x;
+        }
+
+        // Specular 1 component
+        float d1_lut_value = 1.0f;
+        if (lighting.config1.disable_lut_d1 == 0 &&
+            LightingRegs::IsLightingSamplerSupported(
+                lighting.config0.config, LightingRegs::LightingSampler::Distribution1)) {
+            d1_lut_value =
+                GetLutValue(lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
+                            lighting.lut_scale.d1, LightingRegs::LightingSampler::Distribution1);
+        }
+
+        Math::Vec3<float> specular_1 =
+            d1_lut_value * refl_value * light_config.specular_1.ToVec3f();
+
+        // Fresnel
+        // Note: only the last entry in the light slots applies the Fresnel factor
+        if (light_index == lighting.max_light_index && lighting.config1.disable_lut_fr == 0 &&
+            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
+                                                     LightingRegs::LightingSampler::Fresnel)) {
+
+            float lut_value =
+                GetLutValue(lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
+                            lighting.lut_scale.fr, LightingRegs::LightingSampler::Fresnel);
+
+            // Enabled for diffuse lighting alpha component
+            if (lighting.config0.enable_primary_alpha) {
+                diffuse_sum.a() = lut_value;
+            }
+
+            // Enabled for the specular lighting alpha component
+            if (lighting.config0.enable_secondary_alpha) {
+                specular_sum.a() = lut_value;
+            }
+        }
+
+        auto dot_product = Math::Dot(light_vector, normal);
+        if (light_config.config.two_sided_diffuse)
+            dot_product = std::abs(dot_product);
+        else
+            dot_product = std::max(dot_product, 0.0f);
+
+        float clamp_highlights = 1.0f;
+        if (lighting.config0.clamp_highlights) {
+            clamp_highlights = dot_product == 0.0f ? 0.0f : 1.0f;
+        }
+
+        if (light_config.config.geometric_factor_0 || light_config.config.geometric_factor_1) {
+            float geo_factor = half_vector.Length2();
+            geo_factor = geo_factor == 0.0f ? 0.0f : std::min(dot_product / geo_factor, 1.0f);
+            if (light_config.config.geometric_factor_0) {
+                specular_0 *= geo_factor;
+            }
+            if (light_config.config.geometric_factor_1) {
+                specular_1 *= geo_factor;
+            }
+        }
+
+        auto diffuse =
+            (light_config.diffuse.ToVec3f() * dot_product + light_config.ambient.ToVec3f()) *
+            dist_atten * spot_atten;
+        auto specular = (specular_0 + specular_1) * clamp_highlights * dist_atten * spot_atten;
+
+        if (!lighting.IsShadowDisabled(num)) {
+            if (lighting.config0.shadow_primary) {
+                diffuse = diffuse * shadow.xyz();
+            }
+            if (lighting.config0.shadow_secondary) {
+                specular = specular * shadow.xyz();
+            }
+        }
+
+        diffuse_sum += Math::MakeVec(diffuse, 0.0f);
+        specular_sum += Math::MakeVec(specular, 0.0f);
+    }
+
+    if (lighting.config0.shadow_alpha) {
+        // Alpha shadow also uses the Fresnel selecotr to determine which alpha to apply
+        // Enabled for diffuse lighting alpha component
+        if (lighting.config0.enable_primary_alpha) {
+            diffuse_sum.a() *= shadow.w;
+        }
+
+        // Enabled for the specular lighting alpha component
+        if (lighting.config0.enable_secondary_alpha) {
+            specular_sum.a() *= shadow.w;
+        }
+    }
+
+    diffuse_sum += Math::MakeVec(lighting.global_ambient.ToVec3f(), 0.0f);
+
+    auto diffuse = Math::MakeVec<float>(MathUtil::Clamp(diffuse_sum.x, 0.0f, 1.0f) * 255,
+                                        MathUtil::Clamp(diffuse_sum.y, 0.0f, 1.0f) * 255,
+                                        MathUtil::Clamp(diffuse_sum.z, 0.0f, 1.0f) * 255,
+                                        MathUtil::Clamp(diffuse_sum.w, 0.0f, 1.0f) * 255)
+                       .Cast<u8>();
+    auto specular = Math::MakeVec<float>(MathUtil::Clamp(specular_sum.x, 0.0f, 1.0f) * 255,
+                                         MathUtil::Clamp(specular_sum.y, 0.0f, 1.0f) * 255,
+                                         MathUtil::Clamp(specular_sum.z, 0.0f, 1.0f) * 255,
+                                         MathUtil::Clamp(specular_sum.w, 0.0f, 1.0f) * 255)
+                        .Cast<u8>();
+    return std::make_tuple(diffuse, specular);
+}
+
+
+} // namespace Reference
+
+u32 Pack(const Math::Vec4<u8>& color) {
+    return color.r() | color.g() << 8 | color.b() << 16 | color.a() << 24;
+}
+
+void RandomizeLighting(LightingRegs& regs, State::Lighting& state, std::mt19937& rng) {
+    std::uniform_int_distribution<u32> word_dist;
+    std::uniform_int_distribution<u32> config_dist(0, 7);
+    // float16 values with exponents roughly covering [1/8, 4)
+    std::uniform_int_distribution<u32> half_dist(12 << 10, (17 << 10) - 1);
+    // float20 values with exponents roughly covering [1/8, 2)
+    std::uniform_int_distribution<u32> float20_dist(60 << 13, (64 << 13) - 1);
+    std::uniform_int_distribution<u32> bool_dist(0, 1);
+    std::uniform_int_distribution<u32> input_dist(0, 5);
+    std::uniform_int_distribution<u32> scale_dist(0, 5);
+
+    for (auto& lut : state.luts) {
+        for (auto& entry : lut) {
+            entry.raw = word_dist(rng);
+        }
+    }
+
+    for (auto& light : regs.light) {
+        light.specular_0.r.Assign(word_dist(rng) % 256);
+        light.specular_0.g.Assign(word_dist(rng) % 256);
+        light.specular_0.b.Assign(word_dist(rng) % 256);
+        light.specular_1.r.Assign(word_dist(rng) % 256);
+        light.specular_1.g.Assign(word_dist(rng) % 256);
+        light.specular_1.b.Assign(word_dist(rng) % 256);
+        light.diffuse.r.Assign(word_dist(rng) % 256);
+        light.diffuse.g.Assign(word_dist(rng) % 256);
+        light.diffuse.b.Assign(word_dist(rng) % 256);
+        light.ambient.r.Assign(word_dist(rng) % 256);
+        light.ambient.g.Assign(word_dist(rng) % 256);
+        light.ambient.b.Assign(word_dist(rng) % 256);
+        light.x.Assign(half_dist(rng) | bool_dist(rng) << 15);
+        light.y.Assign(half_dist(rng) | bool_dist(rng) << 15);
+        light.z.Assign(half_dist(rng) | bool_dist(rng) << 15);
+        light.spot_x.Assign(static_cast<s32>(word_dist(rng) % 4096) - 2048);
+        light.spot_y.Assign(static_cast<s32>(word_dist(rng) % 4096) - 2048);
+        light.spot_z.Assign(static_cast<s32>(word_dist(rng) % 4096) - 2048);
+        light.config.directional.Assign(bool_dist(rng));
+        light.config.two_sided_diffuse.Assign(bool_dist(rng));
+        light.config.geometric_factor_0.Assign(bool_dist(rng));
+        light.config.geometric_factor_1.Assign(bool_dist(rng));
+        light.dist_atten_bias.Assign(float20_dist(rng));
+        light.dist_atten_scale.Assign(float20_dist(rng));
+    }
+
+    regs.global_ambient.r.Assign(word_dist(rng) % 256);
+    regs.global_ambient.g.Assign(word_dist(rng) % 256);
+    regs.global_ambient.b.Assign(word_dist(rng) % 256);
+    regs.max_light_index.Assign(word_dist(rng) % 8);
+
+    constexpr std::array<LightingRegs::LightingConfig, 8> configs{{
+        LightingRegs::LightingConfig::Config0,
+        LightingRegs::LightingConfig::Config1,
+        LightingRegs::LightingConfig::Config2,
+        LightingRegs::LightingConfig::Config3,
+        LightingRegs::LightingConfig::Config4,
+        LightingRegs::LightingConfig::Config5,
+        LightingRegs::LightingConfig::Config6,
+        LightingRegs::LightingConfig::Config7,
+    }};
+    regs.config0.enable_shadow.Assign(bool_dist(rng));
+    regs.config0.enable_primary_alpha.Assign(bool_dist(rng));
+    regs.config0.enable_secondary_alpha.Assign(bool_dist(rng));
+    regs.config0.config.Assign(configs[config_dist(rng)]);
+    regs.config0.shadow_primary.Assign(bool_dist(rng));
+    regs.config0.shadow_secondary.Assign(bool_dist(rng));
+    regs.config0.shadow_invert.Assign(bool_dist(rng));
+    regs.config0.shadow_alpha.Assign(bool_dist(rng));
+    regs.config0.bump_selector.Assign(word_dist(rng) % 3);
+    regs.config0.shadow_selector.Assign(word_dist(rng) % 4);
+    regs.config0.clamp_highlights.Assign(bool_dist(rng));
+    regs.config0.bump_mode.Assign(
+        static_cast<LightingRegs::LightingBumpMode>(word_dist(rng) % 3));
+    regs.config0.disable_bump_renorm.Assign(bool_dist(rng));
+
+    regs.config1.raw = word_dist(rng);
+
+    constexpr std::array<LightingRegs::LightingScale, 6> scales{{
+        LightingRegs::LightingScale::Scale1,
+        LightingRegs::LightingScale::Scale2,
+        LightingRegs::LightingScale::Scale4,
+        LightingRegs::LightingScale::Scale8,
+        LightingRegs::LightingScale::Scale1_4,
+        LightingRegs::LightingScale::Scale1_2,
+    }};
+    const auto random_input = [&] {
+        return static_cast<LightingRegs::LightingLutInput>(input_dist(rng));
+    };
+    const auto random_scale = [&] { return scales[scale_dist(rng)]; };
+
+    regs.abs_lut_input.disable_d0.Assign(bool_dist(rng));
+    regs.abs_lut_input.disable_d1.Assign(bool_dist(rng));
+    regs.abs_lut_input.disable_sp.Assign(bool_dist(rng));
+    regs.abs_lut_input.disable_fr.Assign(bool_dist(rng));
+    regs.abs_lut_input.disable_rb.Assign(bool_dist(rng));
+    regs.abs_lut_input.disable_rg.Assign(bool_dist(rng));
+    regs.abs_lut_input.disable_rr.Assign(bool_dist(rng));
+    regs.lut_input.d0.Assign(random_input());
+    regs.lut_input.d1.Assign(random_input());
+    regs.lut_input.sp.Assign(random_input());
+    regs.lut_input.fr.Assign(random_input());
+    regs.lut_input.rb.Assign(random_input());
+    regs.lut_input.rg.Assign(random_input());
+    regs.lut_input.rr.Assign(random_input());
+    regs.lut_scale.d0.Assign(random_scale());
+    regs.lut_scale.d1.Assign(random_scale());
+    regs.lut_scale.sp.Assign(random_scale());
+    regs.lut_scale.fr.Assign(random_scale());
+    regs.lut_scale.rb.Assign(random_scale());
+    regs.lut_scale.rg.Assign(random_scale());
+    regs.lut_scale.rr.Assign(random_scale());
+
+    regs.light_enable.slot_0.Assign(word_dist(rng) % 8);
+    regs.light_enable.slot_1.Assign(word_dist(rng) % 8);
+    regs.light_enable.slot_2.Assign(word_dist(rng) % 8);
+    regs.light_enable.slot_3.Assign(word_dist(rng) % 8);
+    regs.light_enable.slot_4.Assign(word_dist(rng) % 8);
+    regs.light_enable.slot_5.Assign(word_dist(rng) % 8);
+    regs.light_enable.slot_6.Assign(word_dist(rng) % 8);
+    regs.light_enable.slot_7.Assign(word_dist(rng) % 8);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ComputeFragmentsColors matches the reference implementation",
+          "[video_core][swrasterizer]") {
+    std::mt19937 rng(0x1157);
+    std::uniform_real_distribution<float> unit_dist(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> view_dist(-8.0f, 8.0f);
+    std::uniform_int_distribution<u32> byte_dist(0, 255);
+
+    // Both structures are large, keep them off the stack
+    auto regs = std::make_unique<LightingRegs>();
+    auto state = std::make_unique<State::Lighting>();
+    auto setup = std::make_unique<LightingSetup>();
+
+    for (int configuration = 0; configuration < 200; ++configuration) {
+        std::memset(regs.get(), 0, sizeof(LightingRegs));
+        RandomizeLighting(*regs, *state, rng);
+        setup->Update(*regs, *state);
+
+        for (int sample = 0; sample < 200; ++sample) {
+            const auto normquat =
+                Math::Quaternion<float>{
+                    {unit_dist(rng), unit_dist(rng), unit_dist(rng)}, unit_dist(rng)}
+                    .Normalized();
+            const Math::Vec3<float> view{view_dist(rng), view_dist(rng), view_dist(rng)};
+            Math::Vec4<u8> texture_color[4];
+            for (auto& color : texture_color) {
+                color = Math::MakeVec(byte_dist(rng), byte_dist(rng), byte_dist(rng),
+                                      byte_dist(rng))
+                            .Cast<u8>();
+            }
+
+            const auto expected =
+                Reference::ComputeFragmentsColors(*regs, *state, normquat, view, texture_color);
+            const auto result =
+                Pica::ComputeFragmentsColors(*regs, *setup, normquat, view, texture_color);
+            INFO("configuration " << configuration << ", sample " << sample);
+            REQUIRE(Pack(std::get<0>(result)) == Pack(std::get<0>(expected)));
+            REQUIRE(Pack(std::get<1>(result)) == Pack(std::get<1>(expected)));
+        }
+    }
+}
+
+TEST_CASE("Batched ComputeFragmentsColors matches the reference implementation",
+          "[video_core][swrasterizer]") {
+    std::mt19937 rng(0x8a7c);
+    std::uniform_real_distribution<float> unit_dist(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> view_dist(-8.0f, 8.0f);
+    std::uniform_int_distribution<u32> byte_dist(0, 255);
+    std::uniform_int_distribution<size_t> count_dist(1, LightingBatch::size);
+
+    auto regs = std::make_unique<LightingRegs>();
+    auto state = std::make_unique<State::Lighting>();
+    auto setup = std::make_unique<LightingSetup>();
+
+    for (int configuration = 0; configuration < 200; ++configuration) {
+        std::memset(regs.get(), 0, sizeof(LightingRegs));
+        RandomizeLighting(*regs, *state, rng);
+        setup->Update(*regs, *state);
+
+        for (int sample = 0; sample < 50; ++sample) {
+            // Partial batches leave stale values in the unused lanes, which must not matter
+            LightingBatch batch;
+            const size_t count = count_dist(rng);
+            Math::Quaternion<float> normquats[LightingBatch::size];
+            Math::Vec3<float> views[LightingBatch::size];
+            Math::Vec4<u8> texture_colors[LightingBatch::size][4];
+            for (size_t i = 0; i < count; ++i) {
+                normquats[i] = Math::Quaternion<float>{
+                    {unit_dist(rng), unit_dist(rng), unit_dist(rng)}, unit_dist(rng)}
+                                   .Normalized();
+                views[i] = {view_dist(rng), view_dist(rng), view_dist(rng)};
+                for (auto& color : texture_colors[i]) {
+                    color = Math::MakeVec(byte_dist(rng), byte_dist(rng), byte_dist(rng),
+                                          byte_dist(rng))
+                                .Cast<u8>();
+                }
+                REQUIRE(batch.Add(normquats[i], views[i], texture_colors[i]) == i);
+            }
+
+            Pica::ComputeFragmentsColors(*regs, *setup, batch);
+
+            for (size_t i = 0; i < count; ++i) {
+                const auto expected = Reference::ComputeFragmentsColors(
+                    *regs, *state, normquats[i], views[i], texture_colors[i]);
+                INFO("configuration " << configuration << ", sample " << sample << ", fragment "
+                                      << i << " of " << count);
+                REQUIRE(Pack(batch.primary_color[i]) == Pack(std::get<0>(expected)));
+                REQUIRE(Pack(batch.secondary_color[i]) == Pack(std::get<1>(expected)));
+            }
+        }
+    }
+}
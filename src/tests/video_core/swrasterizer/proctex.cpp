@@ -0,0 +1,324 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <catch.hpp>
+#include "common/math_util.h"
+#include "video_core/pica_state.h"
+#include "video_core/swrasterizer/proctex.h"
+
+using Pica::State;
+using Pica::TexturingRegs;
+using Pica::Rasterizer::ProcTexTables;
+
+namespace {
+
+// Reference implementation evaluating the proctex registers and LUTs directly for every fragment.
+// The table-based implementation is expected to produce bit-identical results.
+namespace Reference {
+
+using ProcTexClamp = TexturingRegs::ProcTexClamp;
+using ProcTexShift = TexturingRegs::ProcTexShift;
+using ProcTexCombiner = TexturingRegs::ProcTexCombiner;
+using ProcTexFilter = TexturingRegs::ProcTexFilter;
+
+float LookupLUT(const std::array<State::ProcTex::ValueEntry, 128>& lut, float coord) {
+    coord *= 128;
+    const int index_int = std::min(static_cast<int>(coord), 127);
+    const float frac = coord - index_int;
+    return lut[index_int].ToFloat() + frac * lut[index_int].DiffToFloat();
+}
+
+unsigned int NoiseRand1D(unsigned int v) {
+    static constexpr std::array<unsigned int, 16> table{
+        {0, 4, 10, 8, 4, 9, 7, 12, 5, 15, 13, 14, 11, 15, 2, 11}};
+    return ((v % 9 + 2) * 3 & 0xF) ^ table[(v / 9) & 0xF];
+}
+
+float NoiseRand2D(unsigned int x, unsigned int y) {
+    static constexpr std::array<unsigned int, 16> table{
+        {10, 2, 15, 8, 0, 7, 4, 5, 5, 13, 2, 6, 13, 9, 3, 14}};
+    unsigned int u2 = NoiseRand1D(x);
+    unsigned int v2 = NoiseRand1D(y);
+    v2 += ((u2 & 3) == 1) ? 4 : 0;
+    v2 ^= (u2 & 1) * 6;
+    v2 += 10 + u2;
+    v2 &= 0xF;
+    v2 ^= table[u2];
+    return -1.0f + v2 * 2.0f / 15.0f;
+}
+
+float NoiseCoef(float u, float v, const TexturingRegs& regs, const State::ProcTex& state) {
+    const float freq_u = Pica::float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32();
+    const float freq_v = Pica::float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32();
+    const float phase_u = Pica::float16::FromRaw(regs.proctex_noise_u.phase).ToFloat32();
+    const float phase_v = Pica::float16::FromRaw(regs.proctex_noise_v.phase).ToFloat32();
+    const float x = 9 * freq_u * std::abs(u + phase_u);
+    const float y = 9 * freq_v * std::abs(v + phase_v);
+    const int x_int = static_cast<int>(x);
+    const int y_int = static_cast<int>(y);
+    const float x_frac = x - x_int;
+    const float y_frac = y - y_int;
+
+    const float g0 = NoiseRand2D(x_int, y_int) * (x_frac + y_frac);
+    const float g1 = NoiseRand2D(x_int + 1, y_int) * (x_frac + y_frac - 1);
+    const float g2 = NoiseRand2D(x_int, y_int + 1) * (x_frac + y_frac - 1);
+    const float g3 = NoiseRand2D(x_int + 1, y_int + 1) * (x_frac + y_frac - 2);
+    const float x_noise = LookupLUT(state.noise_table, x_frac);
+    const float y_noise = LookupLUT(state.noise_table, y_frac);
+    return Math::BilinearInterp(g0, g1, g2, g3, x_noise, y_noise);
+}
+
+float GetShiftOffset(float v, ProcTexShift mode, ProcTexClamp clamp_mode) {
+    const float offset = (clamp_mode == ProcTexClamp::MirroredRepeat) ? 1 : 0.5f;
+    switch (mode) {
+    case ProcTexShift::Odd:
+        return offset * (((int)v / 2) % 2);
+    case ProcTexShift::Even:
+        return offset * ((((int)v + 1) / 2) % 2);
+    default:
+        return 0;
+    }
+}
+
+void ClampCoord(float& coord, ProcTexClamp mode) {
+    switch (mode) {
+    case ProcTexClamp::ToZero:
+        if (coord > 1.0f)
+            coord = 0.0f;
+        break;
+    case ProcTexClamp::ToEdge:
+        coord = std::min(coord, 1.0f);
+        break;
+    case ProcTexClamp::SymmetricalRepeat:
+        coord = coord - std::floor(coord);
+        break;
+    case ProcTexClamp::MirroredRepeat: {
+        int integer = static_cast<int>(coord);
+        float frac = coord - integer;
+        coord = (integer % 2) == 0 ? frac : (1.0f - frac);
+        break;
+    }
+    case ProcTexClamp::Pulse:
+        coord = coord <= 0.5f ? 0.0f : 1.0f;
+        break;
+    default:
+        coord = std::min(coord, 1.0f);
+        break;
+    }
+}
+
+float CombineAndMap(float u, float v, ProcTexCombiner combiner,
+                    const std::array<State::ProcTex::ValueEntry, 128>& map_table) {
+    float f;
+    switch (combiner) {
+    case ProcTexCombiner::U:
+        f = u;
+        break;
+    case ProcTexCombiner::U2:
+        f = u * u;
+        break;
+    case ProcTexCombiner::V:
+        f = v;
+        break;
+    case ProcTexCombiner::V2:
+        f = v * v;
+        break;
+    case ProcTexCombiner::Add:
+        f = (u + v) * 0.5f;
+        break;
+    case ProcTexCombiner::Add2:
+        f = (u * u + v * v) * 0.5f;
+        break;
+    case ProcTexCombiner::SqrtAdd2:
+        f = std::min(std::sqrt(u * u + v * v), 1.0f);
+        break;
+    case ProcTexCombiner::Min:
+        f = std::min(u, v);
+        break;
+    case ProcTexCombiner::Max:
+        f = std::max(u, v);
+        break;
+    case ProcTexCombiner::RMax:
+        f = std::min(((u + v) * 0.5f + std::sqrt(u * u + v * v)) * 0.5f, 1.0f);
+        break;
+    default:
+        f = 0.0f;
+        break;
+    }
+    return LookupLUT(map_table, f);
+}
+
+Math::Vec4<u8> ProcTex(float u, float v, const TexturingRegs& regs, const State::ProcTex& state) {
+    u = std::abs(u);
+    v = std::abs(v);
+
+    const float u_shift = GetShiftOffset(v, regs.proctex.u_shift, regs.proctex.u_clamp);
+    const float v_shift = GetShiftOffset(u, regs.proctex.v_shift, regs.proctex.v_clamp);
+
+    if (regs.proctex.noise_enable) {
+        float noise = NoiseCoef(u, v, regs, state);
+        u += noise * regs.proctex_noise_u.amplitude / 4095.0f;
+        v += noise * regs.proctex_noise_v.amplitude / 4095.0f;
+        u = std::abs(u);
+        v = std::abs(v);
+    }
+
+    u += u_shift;
+    v += v_shift;
+
+    ClampCoord(u, regs.proctex.u_clamp);
+    ClampCoord(v, regs.proctex.v_clamp);
+
+    const float lut_coord = CombineAndMap(u, v, regs.proctex.color_combiner, state.color_map_table);
+
+    const u32 offset = regs.proctex_lut_offset;
+    const u32 width = regs.proctex_lut.width;
+    const float index = offset + (lut_coord * (width - 1));
+    Math::Vec4<u8> final_color;
+    switch (regs.proctex_lut.filter) {
+    case ProcTexFilter::Linear:
+    case ProcTexFilter::LinearMipmapLinear:
+    case ProcTexFilter::LinearMipmapNearest: {
+        const int index_int = static_cast<int>(index);
+        const float frac = index - index_int;
+        const auto color_value = state.color_table[index_int].ToVector().Cast<float>();
+        const auto color_diff = state.color_diff_table[index_int].ToVector().Cast<float>();
+        final_color = (color_value + frac * color_diff).Cast<u8>();
+        break;
+    }
+    default:
+        final_color = state.color_table[static_cast<int>(std::round(index))].ToVector();
+        break;
+    }
+
+    if (regs.proctex.separate_alpha) {
+        const float final_alpha =
+            CombineAndMap(u, v, regs.proctex.alpha_combiner, state.alpha_map_table);
+        return Math::MakeVec<u8>(final_color.rgb(), static_cast<u8>(final_alpha * 255));
+    }
+    return final_color;
+}
+
+} // namespace Reference
+
+/// Fills the LUTs with data shaped like what games upload: map tables stay within [0, 1]
+void RandomizeLUTs(State::ProcTex& state, std::mt19937& rng) {
+    std::uniform_int_distribution<u32> value_dist(0, 4063);
+    std::uniform_int_distribution<s32> diff_dist(0, 31);
+    std::uniform_int_distribution<s32> noise_diff_dist(-2048, 2047);
+    std::uniform_int_distribution<u32> byte_dist(0, 255);
+
+    for (std::size_t i = 0; i < 128; ++i) {
+        state.noise_table[i].value.Assign(value_dist(rng));
+        state.noise_table[i].difference.Assign(noise_diff_dist(rng));
+        state.color_map_table[i].value.Assign(value_dist(rng));
+        state.color_map_table[i].difference.Assign(diff_dist(rng));
+        state.alpha_map_table[i].value.Assign(value_dist(rng));
+        state.alpha_map_table[i].difference.Assign(diff_dist(rng));
+    }
+
+    for (auto& entry : state.color_table) {
+        entry.raw = byte_dist(rng) | byte_dist(rng) << 8 | byte_dist(rng) << 16 |
+                    byte_dist(rng) << 24;
+    }
+    for (std::size_t i = 0; i < 255; ++i) {
+        const auto current = state.color_table[i].ToVector().Cast<s32>();
+        const auto next = state.color_table[i + 1].ToVector().Cast<s32>();
+        const auto diff = (next - current) / 2;
+        state.color_diff_table[i].r.Assign(diff.r());
+        state.color_diff_table[i].g.Assign(diff.g());
+        state.color_diff_table[i].b.Assign(diff.b());
+        state.color_diff_table[i].a.Assign(diff.a());
+    }
+    state.color_diff_table[255].raw = 0;
+}
+
+void RandomizeRegs(TexturingRegs& regs, std::mt19937& rng) {
+    std::uniform_int_distribution<u32> clamp_dist(0, 4);
+    std::uniform_int_distribution<u32> combiner_dist(0, 9);
+    std::uniform_int_distribution<u32> shift_dist(0, 2);
+    std::uniform_int_distribution<u32> filter_dist(0, 5);
+    std::uniform_int_distribution<u32> bool_dist(0, 1);
+    std::uniform_int_distribution<u32> width_dist(1, 128);
+    std::uniform_int_distribution<u32> offset_dist(0, 127);
+    std::uniform_int_distribution<s32> amplitude_dist(-0x8000, 0x7FFF);
+    // float16 values with exponents roughly covering [1/8, 4)
+    std::uniform_int_distribution<u32> half_dist(12 << 10, (17 << 10) - 1);
+
+    regs.proctex.u_clamp.Assign(static_cast<TexturingRegs::ProcTexClamp>(clamp_dist(rng)));
+    regs.proctex.v_clamp.Assign(static_cast<TexturingRegs::ProcTexClamp>(clamp_dist(rng)));
+    regs.proctex.color_combiner.Assign(
+        static_cast<TexturingRegs::ProcTexCombiner>(combiner_dist(rng)));
+    regs.proctex.alpha_combiner.Assign(
+        static_cast<TexturingRegs::ProcTexCombiner>(combiner_dist(rng)));
+    regs.proctex.separate_alpha.Assign(bool_dist(rng));
+    regs.proctex.noise_enable.Assign(bool_dist(rng));
+    regs.proctex.u_shift.Assign(static_cast<TexturingRegs::ProcTexShift>(shift_dist(rng)));
+    regs.proctex.v_shift.Assign(static_cast<TexturingRegs::ProcTexShift>(shift_dist(rng)));
+    regs.proctex_noise_u.amplitude.Assign(amplitude_dist(rng));
+    regs.proctex_noise_u.phase.Assign(half_dist(rng) | bool_dist(rng) << 15);
+    regs.proctex_noise_v.amplitude.Assign(amplitude_dist(rng));
+    regs.proctex_noise_v.phase.Assign(half_dist(rng) | bool_dist(rng) << 15);
+    regs.proctex_noise_frequency.u.Assign(half_dist(rng));
+    regs.proctex_noise_frequency.v.Assign(half_dist(rng));
+    regs.proctex_lut.filter.Assign(static_cast<TexturingRegs::ProcTexFilter>(filter_dist(rng)));
+    regs.proctex_lut.width.Assign(width_dist(rng));
+    regs.proctex_lut_offset.Assign(offset_dist(rng));
+}
+
+u32 Pack(const Math::Vec4<u8>& color) {
+    return color.r() | color.g() << 8 | color.b() << 16 | color.a() << 24;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ProcTex matches the reference implementation", "[video_core][swrasterizer]") {
+    std::mt19937 rng(0x3D5);
+    std::uniform_real_distribution<float> coord_dist(-4.0f, 4.0f);
+
+    // Both structures are large, keep them off the stack
+    auto regs = std::make_unique<TexturingRegs>();
+    auto state = std::make_unique<State::ProcTex>();
+    auto tables = std::make_unique<ProcTexTables>();
+
+    for (int configuration = 0; configuration < 200; ++configuration) {
+        std::memset(regs.get(), 0, sizeof(TexturingRegs));
+        RandomizeRegs(*regs, rng);
+        RandomizeLUTs(*state, rng);
+        tables->Update(*regs, *state);
+
+        for (int sample = 0; sample < 500; ++sample) {
+            const float u = coord_dist(rng);
+            const float v = coord_dist(rng);
+            const auto expected = Reference::ProcTex(u, v, *regs, *state);
+            const auto result = Pica::Rasterizer::ProcTex(u, v, *regs, *tables);
+            INFO("configuration " << configuration << ", u=" << u << ", v=" << v);
+            REQUIRE(Pack(result) == Pack(expected));
+        }
+    }
+}
+
+TEST_CASE("ProcTexTables reflect LUT updates", "[video_core][swrasterizer]") {
+    auto regs = std::make_unique<TexturingRegs>();
+    auto state = std::make_unique<State::ProcTex>();
+    auto tables = std::make_unique<ProcTexTables>();
+    std::memset(regs.get(), 0, sizeof(TexturingRegs));
+    std::memset(state.get(), 0, sizeof(State::ProcTex));
+
+    regs->proctex_lut.filter.Assign(TexturingRegs::ProcTexFilter::Nearest);
+    regs->proctex_lut.width.Assign(1);
+    state->color_table[0].raw = 0x11223344;
+    tables->Update(*regs, *state);
+    REQUIRE(Pack(Pica::Rasterizer::ProcTex(0.5f, 0.5f, *regs, *tables)) == 0x11223344);
+
+    state->color_table[0].raw = 0x55667788;
+    tables->Update(*regs, *state);
+    REQUIRE(Pack(Pica::Rasterizer::ProcTex(0.5f, 0.5f, *regs, *tables)) == 0x55667788);
+}
@@ -0,0 +1,211 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <catch.hpp>
+#include "common/color.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/regs.h"
+#include "video_core/swrasterizer/framebuffer.h"
+#include "video_core/swrasterizer/rasterizer.h"
+#include "video_core/utils.h"
+
+namespace Pica {
+namespace Rasterizer {
+
+namespace {
+
+constexpr u32 width = 64;
+constexpr u32 height = 64;
+constexpr PAddr color_addr = Memory::VRAM_PADDR;
+constexpr PAddr depth_addr = Memory::VRAM_PADDR + width * height * 4;
+constexpr u32 depth_size = width * height * 3;
+constexpr u32 max_depth = 0xFFFFFF;
+
+/// Encodes a normal float as a raw float24 register value
+u32 ToFloat24Raw(float value) {
+    u32 hex;
+    std::memcpy(&hex, &value, sizeof(hex));
+    const u32 sign = hex >> 31;
+    const u32 exponent = ((hex >> 23) & 0xFF) - 64;
+    const u32 mantissa = (hex & 0x7FFFFF) >> 7;
+    return (sign << 23) | (exponent << 16) | mantissa;
+}
+
+/**
+ * Sets up an RGBA8 color buffer and a D24 depth buffer in VRAM, with a depth test that passes
+ * fragments nearer than the stored depth and writes their depth back.
+ */
+class TestFramebuffer {
+public:
+    TestFramebuffer() {
+        process = Kernel::Process::Create(Kernel::CodeSet::Create("", 0));
+        Kernel::HandleSpecialMapping(process->vm_manager,
+                                     {Memory::VRAM_VADDR, Memory::VRAM_SIZE, false, false});
+        Kernel::g_current_process = process;
+        Memory::SetCurrentPageTable(&process->vm_manager.page_table);
+
+        std::memset(&g_state.regs, 0, sizeof(g_state.regs));
+        auto& regs = g_state.regs;
+        auto& framebuffer = regs.framebuffer.framebuffer;
+        framebuffer.allow_depth_stencil_write.Assign(1);
+        framebuffer.depth_format.Assign(FramebufferRegs::DepthFormat::D24);
+        framebuffer.color_format.Assign(FramebufferRegs::ColorFormat::RGBA8);
+        framebuffer.depth_buffer_address.Assign(depth_addr / 8);
+        framebuffer.color_buffer_address.Assign(color_addr / 8);
+        framebuffer.width.Assign(width);
+        framebuffer.height.Assign(height - 1);
+
+        auto& output_merger = regs.framebuffer.output_merger;
+        output_merger.depth_test_enable.Assign(1);
+        output_merger.depth_test_func.Assign(FramebufferRegs::CompareFunc::LessThan);
+        output_merger.depth_write_enable.Assign(1);
+
+        regs.rasterizer.viewport_size_x.Assign(ToFloat24Raw(width / 2.0f));
+        regs.rasterizer.viewport_size_y.Assign(ToFloat24Raw(height / 2.0f));
+        regs.rasterizer.viewport_depth_range.Assign(ToFloat24Raw(1.0f));
+        regs.rasterizer.depthmap_enable.Assign(RasterizerRegs::DepthBuffering::ZBuffering);
+        regs.lighting.disable.Assign(1);
+
+        FillDepth(max_depth);
+    }
+
+    ~TestFramebuffer() {
+        ResetDepthTiles();
+        std::memset(&g_state.regs, 0, sizeof(g_state.regs));
+        Memory::SetCurrentPageTable(nullptr);
+        Kernel::g_current_process = nullptr;
+    }
+
+    /// Writes to the depth buffer memory directly, as a memory fill would
+    void FillDepth(u32 value) {
+        u8* depth_buffer = Memory::GetPhysicalPointer(depth_addr);
+        for (u32 offset = 0; offset < depth_size; offset += 3) {
+            Color::EncodeD24(value, depth_buffer + offset);
+        }
+    }
+
+    /// Returns the physical address of a pixel of the depth buffer, see SetDepth
+    static PAddr GetDepthAddress(u32 x, u32 y) {
+        // The height register holds the height minus one
+        const u32 flipped_y = height - 1 - y;
+        return depth_addr + VideoCore::GetMortonOffset(x, flipped_y, 3) +
+               (flipped_y & ~7) * width * 3;
+    }
+
+    /// Draws a rectangle covering the whole framebuffer at the given depth
+    static void DrawRectangle(float depth) {
+        const auto MakeVertex = [depth](float x, float y) {
+            Vertex vertex(Shader::OutputVertex{});
+            vertex.pos.w = float24::FromFloat32(1.0f);
+            vertex.screenpos = Math::MakeVec(float24::FromFloat32(x), float24::FromFloat32(y),
+                                             float24::FromFloat32(depth));
+            return vertex;
+        };
+        const Vertex top_left = MakeVertex(0, 0);
+        const Vertex top_right = MakeVertex(width, 0);
+        const Vertex bottom_left = MakeVertex(0, height);
+        const Vertex bottom_right = MakeVertex(width, height);
+        ProcessTriangle(top_left, bottom_left, bottom_right);
+        ProcessTriangle(top_left, bottom_right, top_right);
+    }
+
+private:
+    Kernel::SharedPtr<Kernel::Process> process;
+};
+
+// Depth of a fragment drawn at 0.5, see PerformDepthStencilTest
+constexpr u32 half_depth = static_cast<u32>(0.5f * max_depth);
+
+} // Anonymous namespace
+
+TEST_CASE("SetDepth widens the coarse depth tile", "[video_core][swrasterizer]") {
+    TestFramebuffer framebuffer;
+    REQUIRE(SyncDepthTiles());
+
+    DepthTileRange range = GetDepthTileRange(20, 30);
+    REQUIRE(range.min == max_depth);
+    REQUIRE(range.max == max_depth);
+
+    SetDepth(21, 29, 0x1234);
+    REQUIRE(GetDepth(21, 29) == 0x1234);
+    range = GetDepthTileRange(20, 30);
+    REQUIRE(range.min == 0x1234);
+    REQUIRE(range.max == max_depth);
+
+    // Other tiles are not affected
+    range = GetDepthTileRange(30, 30);
+    REQUIRE(range.min == max_depth);
+}
+
+TEST_CASE("Writes outside the rasterizer invalidate the coarse depth tiles",
+          "[video_core][swrasterizer]") {
+    TestFramebuffer framebuffer;
+
+    // Nothing passes, and the tiles now say that the whole buffer is at the near plane
+    framebuffer.FillDepth(0);
+    TestFramebuffer::DrawRectangle(0.5f);
+    REQUIRE(GetDepth(20, 30) == 0);
+    REQUIRE(GetDepthTileRange(20, 30).max == 0);
+
+    SECTION("memory fill") {
+        framebuffer.FillDepth(max_depth);
+        InvalidateDepthTiles(depth_addr, depth_size);
+
+        TestFramebuffer::DrawRectangle(0.5f);
+        REQUIRE(GetDepth(20, 30) == half_depth);
+        REQUIRE(GetDepth(50, 10) == half_depth);
+    }
+
+    SECTION("CPU write") {
+        const PAddr pixel_addr = TestFramebuffer::GetDepthAddress(20, 30);
+        Color::EncodeD24(max_depth, Memory::GetPhysicalPointer(pixel_addr));
+        InvalidateDepthTiles(pixel_addr, 3);
+
+        TestFramebuffer::DrawRectangle(0.5f);
+        REQUIRE(GetDepth(20, 30) == half_depth);
+        REQUIRE(GetDepth(21, 30) == 0);
+    }
+}
+
+TEST_CASE("Depth testing only happens early when no later stage depends on it",
+          "[video_core][swrasterizer]") {
+    TestFramebuffer framebuffer;
+    auto& regs = g_state.regs;
+    REQUIRE(CanTestDepthEarly(regs));
+
+    SECTION("alpha test") {
+        regs.framebuffer.output_merger.alpha_test.enable.Assign(1);
+        regs.framebuffer.output_merger.alpha_test.func.Assign(FramebufferRegs::CompareFunc::Never);
+        REQUIRE_FALSE(CanTestDepthEarly(regs));
+
+        // Fragments discarded by the alpha test must not write their depth
+        TestFramebuffer::DrawRectangle(0.5f);
+        REQUIRE(GetDepth(20, 30) == max_depth);
+    }
+
+    SECTION("fog") {
+        regs.texturing.fog_mode.Assign(TexturingRegs::FogMode::Fog);
+        REQUIRE_FALSE(CanTestDepthEarly(regs));
+        regs.texturing.fog_mode.Assign(TexturingRegs::FogMode::Gas);
+        REQUIRE_FALSE(CanTestDepthEarly(regs));
+    }
+
+    SECTION("shadow output") {
+        regs.framebuffer.output_merger.fragment_operation_mode.Assign(
+            FramebufferRegs::FragmentOperationMode::Shadow);
+        REQUIRE_FALSE(CanTestDepthEarly(regs));
+
+        // Shadow rendering goes to the color buffer and leaves the depth buffer alone
+        TestFramebuffer::DrawRectangle(0.5f);
+        REQUIRE(GetDepth(20, 30) == max_depth);
+    }
+}
+
+} // namespace Rasterizer
+} // namespace Pica
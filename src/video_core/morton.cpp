@@ -0,0 +1,281 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <thread>
+#include <vector>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "common/thread_worker.h"
+#include "video_core/morton.h"
+
+namespace VideoCore {
+
+namespace {
+
+// Within an 8x8 tile, each pair of rows 2k and 2k + 1 is made up of four 2x2 blocks, stored as
+// four contiguous pixels each: (x, 2k), (x + 1, 2k), (x, 2k + 1), (x + 1, 2k + 1).
+// These are the Morton indices of the first pixel of each row pair and of each block within it.
+constexpr u32 row_pair_offsets[4] = {0, 8, 32, 40};
+constexpr u32 block_offsets[4] = {0, 4, 16, 20};
+
+template <MortonFormat format>
+void ConvertPixelToLinear(u8* linear, const u8* tiled) {
+    if (format == MortonFormat::D24X8) {
+        linear[0] = 0;
+        std::memcpy(linear + 1, tiled, 3);
+    } else if (format == MortonFormat::D24S8) {
+        linear[0] = tiled[3];
+        std::memcpy(linear + 1, tiled, 3);
+    } else {
+        std::memcpy(linear, tiled, MortonTiledBytesPerPixel(format));
+    }
+}
+
+template <MortonFormat format>
+void ConvertPixelToTiled(u8* tiled, const u8* linear) {
+    if (format == MortonFormat::D24X8) {
+        std::memcpy(tiled, linear + 1, 3);
+    } else if (format == MortonFormat::D24S8) {
+        std::memcpy(tiled, linear + 1, 3);
+        tiled[3] = linear[0];
+    } else {
+        std::memcpy(tiled, linear, MortonTiledBytesPerPixel(format));
+    }
+}
+
+/// Generic tile copy, moving each 2x2 block between the tiled and the linear image at once
+template <bool morton_to_linear, MortonFormat format>
+void CopyTileGeneric(u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    constexpr u32 bpp = MortonTiledBytesPerPixel(format);
+    constexpr u32 linear_bpp = MortonLinearBytesPerPixel(format);
+    constexpr bool plain_copy = bpp == linear_bpp;
+
+    for (u32 k = 0; k < 4; ++k) {
+        u8* row0 = linear + static_cast<std::ptrdiff_t>(2 * k) * pitch;
+        u8* row1 = row0 + pitch;
+        for (u32 j = 0; j < 4; ++j) {
+            u8* block = tile + (row_pair_offsets[k] + block_offsets[j]) * bpp;
+            u8* dst0 = row0 + 2 * j * linear_bpp;
+            u8* dst1 = row1 + 2 * j * linear_bpp;
+            if (plain_copy) {
+                // Two horizontally adjacent pixels are contiguous in both layouts
+                if (morton_to_linear) {
+                    std::memcpy(dst0, block, 2 * bpp);
+                    std::memcpy(dst1, block + 2 * bpp, 2 * bpp);
+                } else {
+                    std::memcpy(block, dst0, 2 * bpp);
+                    std::memcpy(block + 2 * bpp, dst1, 2 * bpp);
+                }
+            } else if (morton_to_linear) {
+                ConvertPixelToLinear<format>(dst0, block);
+                ConvertPixelToLinear<format>(dst0 + linear_bpp, block + bpp);
+                ConvertPixelToLinear<format>(dst1, block + 2 * bpp);
+                ConvertPixelToLinear<format>(dst1 + linear_bpp, block + 3 * bpp);
+            } else {
+                ConvertPixelToTiled<format>(block, dst0);
+                ConvertPixelToTiled<format>(block + bpp, dst0 + linear_bpp);
+                ConvertPixelToTiled<format>(block + 2 * bpp, dst1);
+                ConvertPixelToTiled<format>(block + 3 * bpp, dst1 + linear_bpp);
+            }
+        }
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+/// Rotates D24S8 pixels between the tiled (depth first) and the linear (stencil first) order
+template <bool morton_to_linear>
+__m128i RotateD24S8(__m128i pixels) {
+    if (morton_to_linear)
+        return _mm_or_si128(_mm_slli_epi32(pixels, 8), _mm_srli_epi32(pixels, 24));
+    return _mm_or_si128(_mm_srli_epi32(pixels, 8), _mm_slli_epi32(pixels, 24));
+}
+
+/// Tile copy for 32-bit pixels. Each 2x2 block is one 128-bit vector, and the two rows are
+/// separated with 64-bit unpacks.
+template <bool morton_to_linear, bool rotate_d24s8>
+void CopyTile4(u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    for (u32 k = 0; k < 4; ++k) {
+        u8* row0 = linear + static_cast<std::ptrdiff_t>(2 * k) * pitch;
+        u8* row1 = row0 + pitch;
+        __m128i* blocks = reinterpret_cast<__m128i*>(tile + row_pair_offsets[k] * 4);
+        if (morton_to_linear) {
+            __m128i b0 = _mm_loadu_si128(blocks + 0);
+            __m128i b1 = _mm_loadu_si128(blocks + 1);
+            __m128i b2 = _mm_loadu_si128(blocks + 4);
+            __m128i b3 = _mm_loadu_si128(blocks + 5);
+            if (rotate_d24s8) {
+                b0 = RotateD24S8<true>(b0);
+                b1 = RotateD24S8<true>(b1);
+                b2 = RotateD24S8<true>(b2);
+                b3 = RotateD24S8<true>(b3);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row0), _mm_unpacklo_epi64(b0, b1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row0 + 16), _mm_unpacklo_epi64(b2, b3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row1), _mm_unpackhi_epi64(b0, b1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row1 + 16), _mm_unpackhi_epi64(b2, b3));
+        } else {
+            const __m128i r0_lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+            const __m128i r0_hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 16));
+            const __m128i r1_lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+            const __m128i r1_hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 16));
+            __m128i b0 = _mm_unpacklo_epi64(r0_lo, r1_lo);
+            __m128i b1 = _mm_unpackhi_epi64(r0_lo, r1_lo);
+            __m128i b2 = _mm_unpacklo_epi64(r0_hi, r1_hi);
+            __m128i b3 = _mm_unpackhi_epi64(r0_hi, r1_hi);
+            if (rotate_d24s8) {
+                b0 = RotateD24S8<false>(b0);
+                b1 = RotateD24S8<false>(b1);
+                b2 = RotateD24S8<false>(b2);
+                b3 = RotateD24S8<false>(b3);
+            }
+            _mm_storeu_si128(blocks + 0, b0);
+            _mm_storeu_si128(blocks + 1, b1);
+            _mm_storeu_si128(blocks + 4, b2);
+            _mm_storeu_si128(blocks + 5, b3);
+        }
+    }
+}
+
+/// Tile copy for 16-bit pixels. Two 2x2 blocks make up one vector; swapping its middle 32-bit
+/// lanes groups the pixels of each row together.
+template <bool morton_to_linear>
+void CopyTile2(u8* tile, u8* linear, std::ptrdiff_t pitch) {
+    constexpr int swap_middle_lanes = _MM_SHUFFLE(3, 1, 2, 0);
+    for (u32 k = 0; k < 4; ++k) {
+        u8* row0 = linear + static_cast<std::ptrdiff_t>(2 * k) * pitch;
+        u8* row1 = row0 + pitch;
+        __m128i* blocks = reinterpret_cast<__m128i*>(tile + row_pair_offsets[k] * 2);
+        if (morton_to_linear) {
+            const __m128i left = _mm_shuffle_epi32(_mm_loadu_si128(blocks + 0), swap_middle_lanes);
+            const __m128i right = _mm_shuffle_epi32(_mm_loadu_si128(blocks + 2), swap_middle_lanes);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row0), _mm_unpacklo_epi64(left, right));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(row1), _mm_unpackhi_epi64(left, right));
+        } else {
+            const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+            const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+            _mm_storeu_si128(blocks + 0,
+                             _mm_shuffle_epi32(_mm_unpacklo_epi64(r0, r1), swap_middle_lanes));
+            _mm_storeu_si128(blocks + 2,
+                             _mm_shuffle_epi32(_mm_unpackhi_epi64(r0, r1), swap_middle_lanes));
+        }
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
+template <bool morton_to_linear, MortonFormat format>
+void CopyTile(u8* tile, u8* linear, std::ptrdiff_t pitch) {
+#ifdef ARCHITECTURE_x86_64
+    if (format == MortonFormat::Bytes2) {
+        CopyTile2<morton_to_linear>(tile, linear, pitch);
+        return;
+    }
+    if (format == MortonFormat::Bytes4 || format == MortonFormat::D24S8) {
+        CopyTile4<morton_to_linear, format == MortonFormat::D24S8>(tile, linear, pitch);
+        return;
+    }
+#endif
+    CopyTileGeneric<morton_to_linear, format>(tile, linear, pitch);
+}
+
+template <bool morton_to_linear, MortonFormat format>
+void CopyTiles(u32 width, u32 first_tile, u32 num_tiles, u8* tiled, u8* linear,
+               std::ptrdiff_t pitch) {
+    constexpr u32 tile_size = MortonTiledBytesPerPixel(format) * 64;
+    constexpr u32 linear_bpp = MortonLinearBytesPerPixel(format);
+    const u32 tiles_per_row = width / 8;
+
+    u32 tile_x = first_tile % tiles_per_row;
+    u32 tile_y = first_tile / tiles_per_row;
+    u8* linear_row = linear + static_cast<std::ptrdiff_t>(tile_y * 8) * pitch;
+
+    for (u32 i = 0; i < num_tiles; ++i, tiled += tile_size) {
+        CopyTile<morton_to_linear, format>(tiled, linear_row + tile_x * 8 * linear_bpp, pitch);
+        if (++tile_x == tiles_per_row) {
+            tile_x = 0;
+            linear_row += 8 * pitch;
+        }
+    }
+}
+
+using CopyTilesFunc = void (*)(u32, u32, u32, u8*, u8*, std::ptrdiff_t);
+
+template <bool morton_to_linear>
+CopyTilesFunc GetCopyTilesFunc(MortonFormat format) {
+    switch (format) {
+    case MortonFormat::Bytes2:
+        return CopyTiles<morton_to_linear, MortonFormat::Bytes2>;
+    case MortonFormat::Bytes3:
+        return CopyTiles<morton_to_linear, MortonFormat::Bytes3>;
+    case MortonFormat::Bytes4:
+        return CopyTiles<morton_to_linear, MortonFormat::Bytes4>;
+    case MortonFormat::D24X8:
+        return CopyTiles<morton_to_linear, MortonFormat::D24X8>;
+    case MortonFormat::D24S8:
+        return CopyTiles<morton_to_linear, MortonFormat::D24S8>;
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
+/// Copies below this size are not worth the cost of starting worker threads
+constexpr u32 PARALLEL_COPY_THRESHOLD = 1024 * 1024;
+constexpr u32 MAX_COPY_THREADS = 4;
+
+/// Threads that help the calling thread with large copies, started on the first one
+Common::ThreadWorker& GetCopyWorker() {
+    static Common::ThreadWorker worker(MAX_COPY_THREADS - 1, "MortonCopy");
+    return worker;
+}
+
+} // Anonymous namespace
+
+MICROPROFILE_DEFINE(GPU_MortonCopy, "GPU", "Morton Copy", MP_RGB(100, 100, 255));
+
+void MortonCopyTiles(bool morton_to_linear, MortonFormat format, u32 width, u32 first_tile,
+                     u32 num_tiles, u8* tiled, u8* linear, std::ptrdiff_t linear_pitch) {
+    MICROPROFILE_SCOPE(GPU_MortonCopy);
+    DEBUG_ASSERT(width % 8 == 0 && width != 0);
+
+    const CopyTilesFunc copy = morton_to_linear ? GetCopyTilesFunc<true>(format)
+                                                : GetCopyTilesFunc<false>(format);
+    const u32 tile_size = MortonTiledBytesPerPixel(format) * 64;
+
+    const u32 num_threads =
+        std::min({num_tiles * tile_size / PARALLEL_COPY_THRESHOLD + 1, MAX_COPY_THREADS,
+                  std::max(std::thread::hardware_concurrency(), 1u)});
+    if (num_threads <= 1) {
+        copy(width, first_tile, num_tiles, tiled, linear, linear_pitch);
+        return;
+    }
+
+    // Tiles don't overlap in either image, so large copies are split into independent chunks.
+    // The calling thread handles the last chunk itself.
+    const u32 tiles_per_thread = num_tiles / num_threads;
+    std::vector<std::future<void>> workers;
+    workers.reserve(num_threads - 1);
+    for (u32 i = 0; i < num_threads - 1; ++i) {
+        workers.push_back(GetCopyWorker().Submit([=] {
+            copy(width, first_tile + i * tiles_per_thread, tiles_per_thread,
+                 tiled + i * tiles_per_thread * tile_size, linear, linear_pitch);
+        }));
+    }
+
+    const u32 done = (num_threads - 1) * tiles_per_thread;
+    copy(width, first_tile + done, num_tiles - done, tiled + done * tile_size, linear,
+         linear_pitch);
+
+    for (auto& worker : workers) {
+        worker.wait();
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,50 @@
+// Copyright 2018 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace VideoCore {
+
+/**
+ * Pixel layouts supported by the tiled <-> linear copy functions. Tiled images are stored as a
+ * sequence of 8x8 tiles in Morton order (see GetMortonOffset in utils.h), tile rows one after
+ * another.
+ */
+enum class MortonFormat {
+    Bytes2, ///< 16-bit pixels, copied unchanged
+    Bytes3, ///< 24-bit pixels, copied unchanged
+    Bytes4, ///< 32-bit pixels, copied unchanged
+    D24X8,  ///< 24-bit tiled depth, stored in the upper bytes of 32-bit linear pixels
+    D24S8,  ///< Tiled depth-stencil, rotated to put the stencil into the first linear byte
+};
+
+constexpr u32 MortonTiledBytesPerPixel(MortonFormat format) {
+    return format == MortonFormat::Bytes2
+               ? 2
+               : (format == MortonFormat::Bytes3 || format == MortonFormat::D24X8) ? 3 : 4;
+}
+
+constexpr u32 MortonLinearBytesPerPixel(MortonFormat format) {
+    return format == MortonFormat::Bytes2 ? 2 : format == MortonFormat::Bytes3 ? 3 : 4;
+}
+
+/**
+ * Copies a range of tiles between a tiled and a linear image.
+ * @param morton_to_linear Direction of the copy
+ * @param format Pixel layout of both images
+ * @param width Width of both images in pixels, must be a multiple of 8
+ * @param first_tile Index of the first tile to copy
+ * @param num_tiles Number of tiles to copy
+ * @param tiled Pointer to the first tile to copy
+ * @param linear Pointer to the first pixel of row 0 of the linear image
+ * @param linear_pitch Distance in bytes between two consecutive rows of the linear image. Negative
+ *                     values store the linear image bottom-up.
+ */
+void MortonCopyTiles(bool morton_to_linear, MortonFormat format, u32 width, u32 first_tile,
+                     u32 num_tiles, u8* tiled, u8* linear, std::ptrdiff_t linear_pitch);
+
+} // namespace VideoCore
@@ -25,6 +25,7 @@
 #include "core/frontend/emu_window.h"
 #include "core/memory.h"
 #include "core/settings.h"
+#include "video_core/morton.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
@@ -81,30 +82,18 @@ static u16 GetResolutionScaleFactor() {
                : Settings::values.resolution_factor;
 }
 
-template <bool morton_to_gl, PixelFormat format>
-static void MortonCopyTile(u32 stride, u8* tile_buffer, u8* gl_buffer) {
-    constexpr u32 bytes_per_pixel = SurfaceParams::GetFormatBpp(format) / 8;
-    constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
-    for (u32 y = 0; y < 8; ++y) {
-        for (u32 x = 0; x < 8; ++x) {
-            u8* tile_ptr = tile_buffer + VideoCore::MortonInterleave(x, y) * bytes_per_pixel;
-            u8* gl_ptr = gl_buffer + ((7 - y) * stride + x) * gl_bytes_per_pixel;
-            if (morton_to_gl) {
-                if (format == PixelFormat::D24S8) {
-                    gl_ptr[0] = tile_ptr[3];
-                    std::memcpy(gl_ptr + 1, tile_ptr, 3);
-                } else {
-                    std::memcpy(gl_ptr, tile_ptr, bytes_per_pixel);
-                }
-            } else {
-                if (format == PixelFormat::D24S8) {
-                    std::memcpy(tile_ptr, gl_ptr + 1, 3);
-                    tile_ptr[3] = gl_ptr[0];
-                } else {
-                    std::memcpy(tile_ptr, gl_ptr, bytes_per_pixel);
-                }
-            }
-        }
+static constexpr VideoCore::MortonFormat GetMortonFormat(PixelFormat format) {
+    if (format == PixelFormat::D24)
+        return VideoCore::MortonFormat::D24X8;
+    if (format == PixelFormat::D24S8)
+        return VideoCore::MortonFormat::D24S8;
+    switch (SurfaceParams::GetFormatBpp(format)) {
+    case 16:
+        return VideoCore::MortonFormat::Bytes2;
+    case 24:
+        return VideoCore::MortonFormat::Bytes3;
+    default:
+        return VideoCore::MortonFormat::Bytes4;
     }
 }
 
@@ -114,8 +103,9 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
     constexpr u32 tile_size = bytes_per_pixel * 64;
 
     constexpr u32 gl_bytes_per_pixel = CachedSurface::GetGLBytesPerPixel(format);
-    static_assert(gl_bytes_per_pixel >= bytes_per_pixel, "");
-    gl_buffer += gl_bytes_per_pixel - bytes_per_pixel;
+    constexpr VideoCore::MortonFormat morton_format = GetMortonFormat(format);
+    static_assert(VideoCore::MortonTiledBytesPerPixel(morton_format) == bytes_per_pixel, "");
+    static_assert(VideoCore::MortonLinearBytesPerPixel(morton_format) == gl_bytes_per_pixel, "");
 
     const PAddr aligned_down_start = base + Common::AlignDown(start - base, tile_size);
     const PAddr aligned_start = base + Common::AlignUp(start - base, tile_size);
@@ -123,43 +113,36 @@ static void MortonCopy(u32 stride, u32 height, u8* gl_buffer, PAddr base, PAddr
 
     ASSERT(!morton_to_gl || (aligned_start == start && aligned_end == end));
 
-    const u32 begin_pixel_index = (aligned_down_start - base) / bytes_per_pixel;
-    u32 x = (begin_pixel_index % (stride * 8)) / 8;
-    u32 y = (begin_pixel_index / (stride * 8)) * 8;
-
-    gl_buffer += ((height - 8 - y) * stride + x) * gl_bytes_per_pixel;
-
-    auto glbuf_next_tile = [&] {
-        x = (x + 8) % stride;
-        gl_buffer += 8 * gl_bytes_per_pixel;
-        if (!x) {
-            y += 8;
-            gl_buffer -= stride * 9 * gl_bytes_per_pixel;
-        }
-    };
+    // GL images are stored bottom-up
+    u8* const gl_row0 = gl_buffer + (height - 1) * stride * gl_bytes_per_pixel;
+    const std::ptrdiff_t gl_pitch = -static_cast<std::ptrdiff_t>(stride * gl_bytes_per_pixel);
 
+    u32 tile_index = (aligned_down_start - base) / tile_size;
     u8* tile_buffer = Memory::GetPhysicalPointer(start);
 
     if (start < aligned_start && !morton_to_gl) {
         std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        VideoCore::MortonCopyTiles(false, morton_format, stride, tile_index, 1, &tmp_buf[0],
+                                   gl_row0, gl_pitch);
         std::memcpy(tile_buffer, &tmp_buf[start - aligned_down_start],
                     std::min(aligned_start, end) - start);
 
         tile_buffer += aligned_start - start;
-        glbuf_next_tile();
+        ++tile_index;
     }
 
-    const u8* const buffer_end = tile_buffer + aligned_end - aligned_start;
-    while (tile_buffer < buffer_end) {
-        MortonCopyTile<morton_to_gl, format>(stride, tile_buffer, gl_buffer);
-        tile_buffer += tile_size;
-        glbuf_next_tile();
+    if (aligned_end > aligned_start) {
+        const u32 num_tiles = (aligned_end - aligned_start) / tile_size;
+        VideoCore::MortonCopyTiles(morton_to_gl, morton_format, stride, tile_index, num_tiles,
+                                   tile_buffer, gl_row0, gl_pitch);
+        tile_buffer += num_tiles * tile_size;
+        tile_index += num_tiles;
     }
 
     if (end > std::max(aligned_start, aligned_end) && !morton_to_gl) {
         std::array<u8, tile_size> tmp_buf;
-        MortonCopyTile<morton_to_gl, format>(stride, &tmp_buf[0], gl_buffer);
+        VideoCore::MortonCopyTiles(false, morton_format, stride, tile_index, 1, &tmp_buf[0],
+                                   gl_row0, gl_pitch);
         std::memcpy(tile_buffer, &tmp_buf[0], end - aligned_end);
     }
 }
@@ -7,9 +7,12 @@
 #include <cstddef>
 #include <boost/container/static_vector.hpp>
 #include <boost/container/vector.hpp>
+#include <boost/optional.hpp>
+#include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/vector_math.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
@@ -51,22 +54,23 @@ private:
     Math::Vec4<float24> bias;
 };
 
-static void InitScreenCoordinates(Vertex& vtx) {
-    struct {
-        float24 halfsize_x;
-        float24 offset_x;
-        float24 halfsize_y;
-        float24 offset_y;
-        float24 zscale;
-        float24 offset_z;
-    } viewport;
-
-    const auto& regs = g_state.regs;
-    viewport.halfsize_x = float24::FromRaw(regs.rasterizer.viewport_size_x);
-    viewport.halfsize_y = float24::FromRaw(regs.rasterizer.viewport_size_y);
-    viewport.offset_x = float24::FromFloat32(static_cast<float>(regs.rasterizer.viewport_corner.x));
-    viewport.offset_y = float24::FromFloat32(static_cast<float>(regs.rasterizer.viewport_corner.y));
+struct Viewport {
+    float24 halfsize_x;
+    float24 offset_x;
+    float24 halfsize_y;
+    float24 offset_y;
+};
+
+static Viewport GetViewport(const RasterizerRegs& regs) {
+    Viewport viewport;
+    viewport.halfsize_x = float24::FromRaw(regs.viewport_size_x);
+    viewport.halfsize_y = float24::FromRaw(regs.viewport_size_y);
+    viewport.offset_x = float24::FromFloat32(static_cast<float>(regs.viewport_corner.x));
+    viewport.offset_y = float24::FromFloat32(static_cast<float>(regs.viewport_corner.y));
+    return viewport;
+}
 
+static void InitScreenCoordinates(Vertex& vtx, const Viewport& viewport) {
     float24 inv_w = float24::FromFloat32(1.f) / vtx.pos.w;
     vtx.pos.w = inv_w;
     vtx.quat *= inv_w;
@@ -84,7 +88,49 @@ static void InitScreenCoordinates(Vertex& vtx) {
     vtx.screenpos[2] = vtx.pos.z * inv_w;
 }
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2) {
+// NOTE: We clip against a w=epsilon plane to guarantee that the output has a positive w value.
+// TODO: Not sure if this is a valid approach. Also should probably instead use the smallest
+//       epsilon possible within float24 accuracy.
+static const float24 EPSILON = float24::FromFloat32(0.00001f);
+static const float24 f0 = float24::FromFloat32(0.0);
+static const float24 f1 = float24::FromFloat32(1.0);
+static const std::array<ClippingEdge, 7> clipping_edges = {{
+    {Math::MakeVec(-f1, f0, f0, f1)},                                           // x = +w
+    {Math::MakeVec(f1, f0, f0, f1)},                                            // x = -w
+    {Math::MakeVec(f0, -f1, f0, f1)},                                           // y = +w
+    {Math::MakeVec(f0, f1, f0, f1)},                                            // y = -w
+    {Math::MakeVec(f0, f0, -f1, f0)},                                           // z =  0
+    {Math::MakeVec(f0, f0, f1, f1)},                                            // z = -w
+    {Math::MakeVec(f0, f0, f0, f1), Math::Vec4<float24>(f0, f0, f0, -EPSILON)}, // w = EPSILON
+}};
+
+/// Outcode bit of the user-defined clipping plane, following the bits of clipping_edges
+constexpr u32 CUSTOM_EDGE_BIT = 1 << 7;
+/// Outcode bits of the x = +-w and y = +-w planes, which can be handled by the guard band
+constexpr u32 VIEWPORT_EDGE_BITS = 0xF;
+
+/**
+ * Triangles which only cross the x/y viewport planes are not clipped if all their vertices lie
+ * within this many pixels from the screen origin. The rasterizer limits its bounding box to the
+ * viewport instead. The size is chosen so that rasterizer coordinates stay within the 12.4 fixed
+ * point range and edge functions can not overflow.
+ */
+constexpr float GUARD_BAND_SIZE = 1024.0f;
+
+static bool IsInsideGuardBand(const Vertex& vtx, const Viewport& viewport) {
+    // This is only an estimate of InitScreenCoordinates, so keep a pixel of margin on each side
+    const float inv_w = 1.0f / vtx.pos.w.ToFloat32();
+    const float x = (vtx.pos.x.ToFloat32() * inv_w + 1.0f) * viewport.halfsize_x.ToFloat32() +
+                    viewport.offset_x.ToFloat32();
+    const float y = (vtx.pos.y.ToFloat32() * inv_w + 1.0f) * viewport.halfsize_y.ToFloat32() +
+                    viewport.offset_y.ToFloat32();
+    return x >= 1.0f && x < GUARD_BAND_SIZE - 1.0f && y >= 1.0f && y < GUARD_BAND_SIZE - 1.0f;
+}
+
+template <typename Handler>
+static void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                            const Viewport& viewport, const ClippingEdge* custom_edge,
+                            ClipStats& stats, const Handler& triangle_handler) {
     using boost::container::static_vector;
 
     // Clipping a planar n-gon against a plane will remove at least 1 vertex and introduces 2 at
@@ -95,6 +141,33 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
     static_vector<Vertex, MAX_VERTICES> buffer_a = {v0, v1, v2};
     static_vector<Vertex, MAX_VERTICES> buffer_b;
 
+    // Classify the vertices against all clipping planes. A triangle with all vertices outside of
+    // the same plane is invisible, and planes which no vertex is outside of do not need clipping.
+    u32 outcode_or = 0;
+    u32 outcode_and = ~0u;
+    for (const auto& vertex : buffer_a) {
+        u32 outcode = 0;
+        for (size_t i = 0; i < clipping_edges.size(); ++i) {
+            if (clipping_edges[i].IsOutSide(vertex))
+                outcode |= 1 << i;
+        }
+        if (custom_edge && custom_edge->IsOutSide(vertex))
+            outcode |= CUSTOM_EDGE_BIT;
+        outcode_or |= outcode;
+        outcode_and &= outcode;
+    }
+
+    if (outcode_and != 0) {
+        ++stats.rejected;
+        return;
+    }
+
+    if ((outcode_or & ~VIEWPORT_EDGE_BITS) == 0 &&
+        std::all_of(buffer_a.begin(), buffer_a.end(),
+                    [&](const Vertex& vtx) { return IsInsideGuardBand(vtx, viewport); })) {
+        outcode_or = 0;
+    }
+
     auto FlipQuaternionIfOpposite = [](auto& a, const auto& b) {
         if (Math::Dot(a, b) < float24::Zero())
             a = a * float24::FromFloat32(-1.0f);
@@ -108,24 +181,7 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
     auto* output_list = &buffer_a;
     auto* input_list = &buffer_b;
 
-    // NOTE: We clip against a w=epsilon plane to guarantee that the output has a positive w value.
-    // TODO: Not sure if this is a valid approach. Also should probably instead use the smallest
-    //       epsilon possible within float24 accuracy.
-    static const float24 EPSILON = float24::FromFloat32(0.00001f);
-    static const float24 f0 = float24::FromFloat32(0.0);
-    static const float24 f1 = float24::FromFloat32(1.0);
-    static const std::array<ClippingEdge, 7> clipping_edges = {{
-        {Math::MakeVec(-f1, f0, f0, f1)},                                          // x = +w
-        {Math::MakeVec(f1, f0, f0, f1)},                                           // x = -w
-        {Math::MakeVec(f0, -f1, f0, f1)},                                          // y = +w
-        {Math::MakeVec(f0, f1, f0, f1)},                                           // y = -w
-        {Math::MakeVec(f0, f0, -f1, f0)},                                          // z =  0
-        {Math::MakeVec(f0, f0, f1, f1)},                                           // z = -w
-        {Math::MakeVec(f0, f0, f0, f1), Math::Vec4<float24>(f0, f0, f0, EPSILON)}, // w = EPSILON
-    }};
-
     // Simple implementation of the Sutherland-Hodgman clipping algorithm.
-    // TODO: Make this less inefficient (currently lots of useless buffering overhead happens here)
     auto Clip = [&](const ClippingEdge& edge) {
         std::swap(input_list, output_list);
         output_list->clear();
@@ -147,31 +203,39 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
         }
     };
 
-    for (auto edge : clipping_edges) {
-        Clip(edge);
+    if (outcode_or == 0) {
+        ++stats.accepted;
+    } else {
+        ++stats.clipped;
 
-        // Need to have at least a full triangle to continue...
-        if (output_list->size() < 3)
-            return;
-    }
+        for (size_t i = 0; i < clipping_edges.size(); ++i) {
+            if ((outcode_or & (1 << i)) == 0)
+                continue;
+
+            Clip(clipping_edges[i]);
+
+            // Need to have at least a full triangle to continue...
+            if (output_list->size() < 3)
+                return;
+        }
 
-    if (g_state.regs.rasterizer.clip_enable) {
-        ClippingEdge custom_edge{g_state.regs.rasterizer.GetClipCoef()};
-        Clip(custom_edge);
+        if (outcode_or & CUSTOM_EDGE_BIT) {
+            Clip(*custom_edge);
 
-        if (output_list->size() < 3)
-            return;
+            if (output_list->size() < 3)
+                return;
+        }
     }
 
-    InitScreenCoordinates((*output_list)[0]);
-    InitScreenCoordinates((*output_list)[1]);
+    InitScreenCoordinates((*output_list)[0], viewport);
+    InitScreenCoordinates((*output_list)[1], viewport);
 
     for (size_t i = 0; i < output_list->size() - 2; i++) {
         Vertex& vtx0 = (*output_list)[0];
         Vertex& vtx1 = (*output_list)[i + 1];
         Vertex& vtx2 = (*output_list)[i + 2];
 
-        InitScreenCoordinates(vtx2);
+        InitScreenCoordinates(vtx2, viewport);
 
         LOG_TRACE(Render_Software,
                   "Triangle %lu/%lu at position (%.3f, %.3f, %.3f, %.3f), "
@@ -187,9 +251,44 @@ void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const Outpu
                   vtx1.screenpos.z.ToFloat32(), vtx2.screenpos.x.ToFloat32(),
                   vtx2.screenpos.y.ToFloat32(), vtx2.screenpos.z.ToFloat32());
 
-        Rasterizer::ProcessTriangle(vtx0, vtx1, vtx2);
+        triangle_handler(vtx0, vtx1, vtx2);
     }
 }
 
+template <typename Handler>
+static ClipStats ProcessTrianglesImpl(const std::vector<OutputVertex>& vertices,
+                                      const Handler& triangle_handler) {
+    ASSERT(vertices.size() % 3 == 0);
+
+    // The register state can not change within a batch, so set up everything derived from it once
+    const auto& regs = g_state.regs.rasterizer;
+    const Viewport viewport = GetViewport(regs);
+    boost::optional<ClippingEdge> custom_edge;
+    if (regs.clip_enable)
+        custom_edge.emplace(regs.GetClipCoef());
+
+    ClipStats stats;
+    for (size_t i = 0; i < vertices.size(); i += 3) {
+        ProcessTriangle(vertices[i], vertices[i + 1], vertices[i + 2], viewport,
+                        custom_edge.get_ptr(), stats, triangle_handler);
+    }
+    return stats;
+}
+
+ClipStats ProcessTriangles(const std::vector<OutputVertex>& vertices,
+                           const TriangleHandler& triangle_handler) {
+    return ProcessTrianglesImpl(vertices, triangle_handler);
+}
+
+void ProcessTriangles(const std::vector<OutputVertex>& vertices) {
+    // Call the rasterizer directly rather than through a TriangleHandler
+    const ClipStats stats = ProcessTrianglesImpl(vertices, Rasterizer::ProcessTriangle);
+
+    // Reported as meta counters of the drawing scope
+    MICROPROFILE_META_CPU("Triangles accepted", stats.accepted);
+    MICROPROFILE_META_CPU("Triangles rejected", stats.rejected);
+    MICROPROFILE_META_CPU("Triangles clipped", stats.clipped);
+}
+
 } // namespace Clipper
 } // namespace Pica
@@ -4,16 +4,42 @@
 
 #pragma once
 
+#include <functional>
+#include <vector>
+#include "common/common_types.h"
+
 namespace Pica {
 namespace Shader {
 struct OutputVertex;
 }
 
+namespace Rasterizer {
+struct Vertex;
+}
+
 namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+/// Numbers of triangles of a batch which were drawn unclipped, discarded and clipped
+struct ClipStats {
+    u32 accepted = 0;
+    u32 rejected = 0;
+    u32 clipped = 0;
+};
+
+using TriangleHandler = std::function<void(
+    const Rasterizer::Vertex& v0, const Rasterizer::Vertex& v1, const Rasterizer::Vertex& v2)>;
+
+/**
+ * Clips a batch of triangles, given as consecutive groups of three vertices, and passes the
+ * resulting triangles with their screen coordinates to the handler instead of the rasterizer.
+ */
+ClipStats ProcessTriangles(const std::vector<OutputVertex>& vertices,
+                           const TriangleHandler& triangle_handler);
+
+/// Clips and rasterizes a batch of triangles, given as consecutive groups of three vertices
+void ProcessTriangles(const std::vector<OutputVertex>& vertices);
 
 } // namespace Clipper
 } // namespace Pica
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <vector>
 
 #include "common/assert.h"
 #include "common/color.h"
@@ -157,6 +158,49 @@ u8 GetStencil(int x, int y) {
     }
 }
 
+namespace {
+
+/// Depth buffer configuration the coarse depth tiles were computed for
+struct DepthTileConfig {
+    PAddr addr = 0;
+    u32 size = 0;
+    u32 width = 0;
+    u32 height = 0;
+    FramebufferRegs::DepthFormat format{};
+
+    bool operator==(const DepthTileConfig& other) const {
+        return addr == other.addr && size == other.size && width == other.width &&
+               height == other.height && format == other.format;
+    }
+};
+
+struct DepthTile {
+    bool valid = false;
+    DepthTileRange range;
+};
+
+DepthTileConfig depth_tile_config;
+u32 depth_tiles_per_row = 0;
+std::vector<DepthTile> depth_tiles;
+/// Whether the tiles are usable for the current framebuffer configuration
+bool depth_tiles_enabled = false;
+
+DepthTile* GetDepthTile(int x, int y) {
+    if (x < 0 || y < 0 || x >= static_cast<int>(depth_tile_config.width) ||
+        y >= static_cast<int>(depth_tile_config.height))
+        return nullptr;
+
+    return &depth_tiles[(y / DEPTH_TILE_SIZE) * depth_tiles_per_row + x / DEPTH_TILE_SIZE];
+}
+
+void InvalidateAllDepthTiles() {
+    for (auto& tile : depth_tiles) {
+        tile.valid = false;
+    }
+}
+
+} // Anonymous namespace
+
 void SetDepth(int x, int y, u32 value) {
     const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
     const PAddr addr = framebuffer.GetDepthBufferPhysicalAddress();
@@ -190,6 +234,110 @@ void SetDepth(int x, int y, u32 value) {
         UNIMPLEMENTED();
         break;
     }
+
+    // Widen the range of the coarse depth tile instead of recomputing it
+    if (addr == depth_tile_config.addr) {
+        DepthTile* tile = GetDepthTile(x, framebuffer.height - y);
+        if (tile != nullptr && tile->valid) {
+            tile->range.min = std::min(tile->range.min, value);
+            tile->range.max = std::max(tile->range.max, value);
+        }
+    }
+}
+
+bool SyncDepthTiles() {
+    const auto& framebuffer = g_state.regs.framebuffer.framebuffer;
+
+    DepthTileConfig config;
+    config.addr = framebuffer.GetDepthBufferPhysicalAddress();
+    config.width = framebuffer.GetWidth();
+    config.height = framebuffer.GetHeight();
+    config.format = framebuffer.depth_format;
+    config.size = config.width * config.height * FramebufferRegs::BytesPerDepthPixel(config.format);
+
+    if (!(config == depth_tile_config)) {
+        // Keep the CPU from writing to the depth buffer behind our back: writes to cached pages
+        // are reported to the rasterizer through InvalidateRegion
+        if (depth_tile_config.size != 0)
+            Memory::RasterizerMarkRegionCached(depth_tile_config.addr, depth_tile_config.size,
+                                               false);
+        if (config.size != 0)
+            Memory::RasterizerMarkRegionCached(config.addr, config.size, true);
+
+        depth_tile_config = config;
+        depth_tiles_per_row = (config.width + DEPTH_TILE_SIZE - 1) / DEPTH_TILE_SIZE;
+        const u32 rows = (config.height + DEPTH_TILE_SIZE - 1) / DEPTH_TILE_SIZE;
+        depth_tiles.assign(depth_tiles_per_row * rows, DepthTile{});
+    }
+
+    // Color writes are not tracked, so the tiles can't be trusted while both buffers overlap
+    const u32 color_size =
+        config.width * config.height *
+        GPU::Regs::BytesPerPixel(GPU::Regs::PixelFormat(framebuffer.color_format.Value()));
+    const PAddr color_addr = framebuffer.GetColorBufferPhysicalAddress();
+    const bool overlaps_color =
+        color_addr < config.addr + config.size && config.addr < color_addr + color_size;
+
+    if (overlaps_color)
+        InvalidateAllDepthTiles();
+
+    depth_tiles_enabled = config.size != 0 && !overlaps_color;
+    return depth_tiles_enabled;
+}
+
+DepthTileRange GetDepthTileRange(int x, int y) {
+    DEBUG_ASSERT(depth_tiles_enabled);
+
+    DepthTile* tile = GetDepthTile(x, y);
+    if (tile == nullptr) {
+        // Outside of the depth buffer, nothing can be said about the contents
+        return {0, 0xFFFFFFFF};
+    }
+
+    if (!tile->valid) {
+        const int tile_x = x & ~(DEPTH_TILE_SIZE - 1);
+        const int tile_y = y & ~(DEPTH_TILE_SIZE - 1);
+        const int end_x = std::min<int>(tile_x + DEPTH_TILE_SIZE, depth_tile_config.width);
+        const int end_y = std::min<int>(tile_y + DEPTH_TILE_SIZE, depth_tile_config.height);
+
+        tile->range = {0xFFFFFFFF, 0};
+        if (tile_y == 0) {
+            // Row 0 is flipped to the row past the end of the depth buffer, see GetDepth. Don't
+            // read it and keep the tile conservative instead.
+            tile->range = {0, 0xFFFFFFFF};
+        }
+        for (int pixel_y = std::max(tile_y, 1); pixel_y < end_y; ++pixel_y) {
+            for (int pixel_x = tile_x; pixel_x < end_x; ++pixel_x) {
+                const u32 depth = GetDepth(pixel_x, pixel_y);
+                tile->range.min = std::min(tile->range.min, depth);
+                tile->range.max = std::max(tile->range.max, depth);
+            }
+        }
+        tile->valid = true;
+    }
+
+    return tile->range;
+}
+
+void InvalidateDepthTiles(PAddr addr, u32 size) {
+    if (depth_tile_config.size == 0)
+        return;
+
+    if (addr < depth_tile_config.addr + depth_tile_config.size &&
+        depth_tile_config.addr < addr + size) {
+        // Tiles don't map to contiguous memory ranges, so just drop all of them
+        InvalidateAllDepthTiles();
+    }
+}
+
+void ResetDepthTiles() {
+    if (depth_tile_config.size != 0)
+        Memory::RasterizerMarkRegionCached(depth_tile_config.addr, depth_tile_config.size, false);
+
+    depth_tile_config = {};
+    depth_tiles_per_row = 0;
+    depth_tiles.clear();
+    depth_tiles_enabled = false;
 }
 
 void SetStencil(int x, int y, u8 value) {
@@ -27,5 +27,31 @@ u8 LogicOp(u8 src, u8 dest, FramebufferRegs::LogicOp op);
 
 void DrawShadowMapPixel(int x, int y, u32 depth, u8 stencil);
 
+/**
+ * The coarse depth buffer keeps a conservative range of the depth values in each 8x8 pixel tile of
+ * the current depth buffer, so that the rasterizer can reject whole tiles of a triangle before
+ * doing any per-fragment work. Tiles are computed lazily, widened by SetDepth and invalidated by
+ * any other write to the depth buffer.
+ */
+constexpr int DEPTH_TILE_SIZE = 8;
+
+struct DepthTileRange {
+    u32 min;
+    u32 max;
+};
+
+/// Adapts the coarse depth buffer to the current framebuffer registers. Returns whether it can be
+/// used for the next draw.
+bool SyncDepthTiles();
+
+/// Returns the depth range of the tile containing the given pixel
+DepthTileRange GetDepthTileRange(int x, int y);
+
+/// Invalidates the coarse depth tiles if the given physical memory region overlaps the depth buffer
+void InvalidateDepthTiles(PAddr addr, u32 size);
+
+/// Drops all coarse depth tiles and stops tracking the depth buffer memory
+void ResetDepthTiles();
+
 } // namespace Rasterizer
 } // namespace Pica
@@ -2,29 +2,177 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <iterator>
+#ifdef ARCHITECTURE_x86_64
+#include <xmmintrin.h>
+#endif
 #include "common/math_util.h"
 #include "video_core/swrasterizer/lighting.h"
 
 namespace Pica {
 
-static float LookupLightingLut(const Pica::State::Lighting& lighting, size_t lut_index, u8 index,
+static void InitLutSampler(LightingSetup::LutSampler& sampler, const LightingRegs& regs,
+                           LightingRegs::LightingSampler lut, bool disabled, bool abs_disabled,
+                           LightingRegs::LightingLutInput input,
+                           LightingRegs::LightingScale scale) {
+    sampler.enabled = !disabled && LightingRegs::IsLightingSamplerSupported(regs.config0.config, lut);
+    sampler.abs_input = !abs_disabled;
+    sampler.input = input;
+    sampler.scale = regs.lut_scale.GetScale(scale);
+}
+
+void LightingSetup::Update(const LightingRegs& regs, const State::Lighting& state) {
+    for (size_t lut_index = 0; lut_index < luts.size(); ++lut_index) {
+        UpdateLut(lut_index, state);
+    }
+    UpdateParameters(regs);
+}
+
+void LightingSetup::UpdateLut(size_t lut_index, const State::Lighting& state) {
+    for (size_t index = 0; index < luts[lut_index].size(); ++index) {
+        const auto& entry = state.luts[lut_index][index];
+        luts[lut_index][index] = {entry.ToFloat(), entry.DiffToFloat()};
+    }
+}
+
+void LightingSetup::UpdateParameters(const LightingRegs& regs) {
+    using Sampler = LightingRegs::LightingSampler;
+    InitLutSampler(d0, regs, Sampler::Distribution0, regs.config1.disable_lut_d0 != 0,
+                   regs.abs_lut_input.disable_d0 != 0, regs.lut_input.d0, regs.lut_scale.d0);
+    InitLutSampler(d1, regs, Sampler::Distribution1, regs.config1.disable_lut_d1 != 0,
+                   regs.abs_lut_input.disable_d1 != 0, regs.lut_input.d1, regs.lut_scale.d1);
+    InitLutSampler(fr, regs, Sampler::Fresnel, regs.config1.disable_lut_fr != 0,
+                   regs.abs_lut_input.disable_fr != 0, regs.lut_input.fr, regs.lut_scale.fr);
+    InitLutSampler(rr, regs, Sampler::ReflectRed, regs.config1.disable_lut_rr != 0,
+                   regs.abs_lut_input.disable_rr != 0, regs.lut_input.rr, regs.lut_scale.rr);
+    InitLutSampler(rg, regs, Sampler::ReflectGreen, regs.config1.disable_lut_rg != 0,
+                   regs.abs_lut_input.disable_rg != 0, regs.lut_input.rg, regs.lut_scale.rg);
+    InitLutSampler(rb, regs, Sampler::ReflectBlue, regs.config1.disable_lut_rb != 0,
+                   regs.abs_lut_input.disable_rb != 0, regs.lut_input.rb, regs.lut_scale.rb);
+    // Spotlight attenuation is enabled per light, see Light::spot_atten_enabled
+    InitLutSampler(sp, regs, Sampler::SpotlightAttenuation, false,
+                   regs.abs_lut_input.disable_sp != 0, regs.lut_input.sp, regs.lut_scale.sp);
+
+    uses_norm_half_vector = false;
+    for (const auto* sampler : {&d0, &d1, &fr, &rr, &rg, &rb, &sp}) {
+        if (sampler->enabled && (sampler->input == LightingRegs::LightingLutInput::NH ||
+                                 sampler->input == LightingRegs::LightingLutInput::VH ||
+                                 sampler->input == LightingRegs::LightingLutInput::CP)) {
+            uses_norm_half_vector = true;
+        }
+    }
+
+    num_lights = regs.max_light_index + 1;
+    for (unsigned light_index = 0; light_index < num_lights; ++light_index) {
+        const unsigned num = regs.light_enable.GetNum(light_index);
+        const auto& light_config = regs.light[num];
+        auto& light = lights[light_index];
+
+        light.num = num;
+        light.position = {float16::FromRaw(light_config.x).ToFloat32(),
+                          float16::FromRaw(light_config.y).ToFloat32(),
+                          float16::FromRaw(light_config.z).ToFloat32()};
+        light.spot_direction =
+            Math::MakeVec(light_config.spot_x.Value(), light_config.spot_y.Value(),
+                          light_config.spot_z.Value())
+                .Cast<float>() /
+            2047.0f;
+        light.specular_0 = light_config.specular_0.ToVec3f();
+        light.specular_1 = light_config.specular_1.ToVec3f();
+        light.diffuse = light_config.diffuse.ToVec3f();
+        light.ambient = light_config.ambient.ToVec3f();
+        light.dist_atten_scale = float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
+        light.dist_atten_bias = float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
+        light.directional = light_config.config.directional != 0;
+        light.two_sided_diffuse = light_config.config.two_sided_diffuse != 0;
+        light.geometric_factor_0 = light_config.config.geometric_factor_0 != 0;
+        light.geometric_factor_1 = light_config.config.geometric_factor_1 != 0;
+        light.dist_atten_enabled = !regs.IsDistAttenDisabled(num);
+        light.spot_atten_enabled = sp.enabled && !regs.IsSpotAttenDisabled(num);
+        light.shadow_enabled = !regs.IsShadowDisabled(num);
+    }
+
+    global_ambient = regs.global_ambient.ToVec3f();
+}
+
+static LightingSetup cached_setup;
+static bool cached_parameters_dirty = true;
+static std::array<bool, LightingRegs::NumLightingSampler> cached_luts_valid{};
+
+void InvalidateLightingSetup() {
+    cached_parameters_dirty = true;
+    cached_luts_valid.fill(false);
+}
+
+void InvalidateLightingParameters() {
+    cached_parameters_dirty = true;
+}
+
+void InvalidateLightingLut(size_t lut_index) {
+    cached_luts_valid[lut_index] = false;
+}
+
+const LightingSetup& GetLightingSetup() {
+    for (size_t lut_index = 0; lut_index < cached_luts_valid.size(); ++lut_index) {
+        if (!cached_luts_valid[lut_index]) {
+            cached_setup.UpdateLut(lut_index, g_state.lighting);
+            cached_luts_valid[lut_index] = true;
+        }
+    }
+    if (cached_parameters_dirty) {
+        cached_setup.UpdateParameters(g_state.regs.lighting);
+        cached_parameters_dirty = false;
+    }
+    return cached_setup;
+}
+
+static float LookupLightingLut(const LightingSetup& setup, size_t lut_index, u8 index,
                                float delta) {
-    ASSERT_MSG(lut_index < lighting.luts.size(), "Out of range lut");
-    ASSERT_MSG(index < lighting.luts[lut_index].size(), "Out of range index");
+    const auto& lut = setup.luts[lut_index][index];
+    return lut.value + lut.diff * delta;
+}
 
-    const auto& lut = lighting.luts[lut_index][index];
+/// Samples a LUT at the position given by the value of its input for a fragment and a light
+static float SampleLut(const LightingSetup& setup, const LightingSetup::LutSampler& sampler,
+                       LightingRegs::LightingSampler lut, bool two_sided_diffuse, float input) {
+    u8 index;
+    float delta;
 
-    float lut_value = lut.ToFloat();
-    float lut_diff = lut.DiffToFloat();
+    if (sampler.abs_input) {
+        if (two_sided_diffuse)
+            input = std::abs(input);
+        else
+            input = std::max(input, 0.0f);
+
+        float flr = std::floor(input * 256.0f);
+        index = static_cast<u8>(MathUtil::Clamp(flr, 0.0f, 255.0f));
+        delta = input * 256 - index;
+    } else {
+        float flr = std::floor(input * 128.0f);
+        s8 signed_index = static_cast<s8>(MathUtil::Clamp(flr, -128.0f, 127.0f));
+        delta = input * 128.0f - signed_index;
+        index = static_cast<u8>(signed_index);
+    }
 
-    return lut_value + lut_diff * delta;
+    return sampler.scale * LookupLightingLut(setup, static_cast<size_t>(lut), index, delta);
 }
 
-std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
-    const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view,
-    const Math::Vec4<u8> (&texture_color)[4]) {
+static float SampleDistanceAttenuation(const LightingSetup& setup,
+                                       const LightingSetup::Light& light, float distance) {
+    size_t lut =
+        static_cast<size_t>(LightingRegs::LightingSampler::DistanceAttenuation) + light.num;
 
+    float sample_loc =
+        MathUtil::Clamp(light.dist_atten_scale * distance + light.dist_atten_bias, 0.0f, 1.0f);
+
+    u8 lutindex = static_cast<u8>(MathUtil::Clamp(std::floor(sample_loc * 256.0f), 0.0f, 255.0f));
+    float delta = sample_loc * 256 - lutindex;
+    return LookupLightingLut(setup, lut, lutindex, delta);
+}
+
+static Math::Vec4<float> GetShadow(const Pica::LightingRegs& lighting,
+                                   const Math::Vec4<u8> (&texture_color)[4]) {
     Math::Vec4<float> shadow;
     if (lighting.config0.enable_shadow) {
         shadow = texture_color[lighting.config0.shadow_selector].Cast<float>() / 255.0f;
@@ -34,6 +182,12 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
     } else {
         shadow = Math::MakeVec(1.0f, 1.0f, 1.0f, 1.0f);
     }
+    return shadow;
+}
+
+/// Returns the surface normal and tangent of a fragment before their rotation by its quaternion
+static std::tuple<Math::Vec3<float>, Math::Vec3<float>> GetSurfaceNormalAndTangent(
+    const Pica::LightingRegs& lighting, const Math::Vec4<u8> (&texture_color)[4]) {
 
     Math::Vec3<float> surface_normal;
     Math::Vec3<float> surface_tangent;
@@ -61,61 +215,73 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
         surface_tangent = Math::MakeVec(1.0f, 0.0f, 0.0f);
     }
 
+    return std::make_tuple(surface_normal, surface_tangent);
+}
+
+static Math::Vec4<u8> ToColor(const Math::Vec4<float>& sum) {
+    return Math::MakeVec<float>(MathUtil::Clamp(sum.x, 0.0f, 1.0f) * 255,
+                                MathUtil::Clamp(sum.y, 0.0f, 1.0f) * 255,
+                                MathUtil::Clamp(sum.z, 0.0f, 1.0f) * 255,
+                                MathUtil::Clamp(sum.w, 0.0f, 1.0f) * 255)
+        .Cast<u8>();
+}
+
+std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
+    const Pica::LightingRegs& lighting, const LightingSetup& setup,
+    const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view,
+    const Math::Vec4<u8> (&texture_color)[4]) {
+
+    const Math::Vec4<float> shadow = GetShadow(lighting, texture_color);
+
+    Math::Vec3<float> surface_normal;
+    Math::Vec3<float> surface_tangent;
+    std::tie(surface_normal, surface_tangent) = GetSurfaceNormalAndTangent(lighting, texture_color);
+
     // Use the normalized the quaternion when performing the rotation
     auto normal = Math::QuaternionRotate(normquat, surface_normal);
     auto tangent = Math::QuaternionRotate(normquat, surface_tangent);
 
+    // The view vector does not depend on the light, normalize it once for all lights
+    const Math::Vec3<float> norm_view = view.Normalized();
+
     Math::Vec4<float> diffuse_sum = {0.0f, 0.0f, 0.0f, 1.0f};
     Math::Vec4<float> specular_sum = {0.0f, 0.0f, 0.0f, 1.0f};
 
-    for (unsigned light_index = 0; light_index <= lighting.max_light_index; ++light_index) {
-        unsigned num = lighting.light_enable.GetNum(light_index);
-        const auto& light_config = lighting.light[num];
+    for (unsigned light_index = 0; light_index < setup.num_lights; ++light_index) {
+        const auto& light = setup.lights[light_index];
 
         Math::Vec3<float> refl_value = {};
-        Math::Vec3<float> position = {float16::FromRaw(light_config.x).ToFloat32(),
-                                      float16::FromRaw(light_config.y).ToFloat32(),
-                                      float16::FromRaw(light_config.z).ToFloat32()};
         Math::Vec3<float> light_vector;
 
-        if (light_config.config.directional)
-            light_vector = position;
+        if (light.directional)
+            light_vector = light.position;
         else
-            light_vector = position + view;
+            light_vector = light.position + view;
 
         light_vector.Normalize();
 
-        Math::Vec3<float> norm_view = view.Normalized();
         Math::Vec3<float> half_vector = norm_view + light_vector;
+        Math::Vec3<float> norm_half_vector;
+        if (setup.uses_norm_half_vector)
+            norm_half_vector = half_vector.Normalized();
 
         float dist_atten = 1.0f;
-        if (!lighting.IsDistAttenDisabled(num)) {
-            auto distance = (-view - position).Length();
-            float scale = Pica::float20::FromRaw(light_config.dist_atten_scale).ToFloat32();
-            float bias = Pica::float20::FromRaw(light_config.dist_atten_bias).ToFloat32();
-            size_t lut =
-                static_cast<size_t>(LightingRegs::LightingSampler::DistanceAttenuation) + num;
-
-            float sample_loc = MathUtil::Clamp(scale * distance + bias, 0.0f, 1.0f);
-
-            u8 lutindex =
-                static_cast<u8>(MathUtil::Clamp(std::floor(sample_loc * 256.0f), 0.0f, 255.0f));
-            float delta = sample_loc * 256 - lutindex;
-            dist_atten = LookupLightingLut(lighting_state, lut, lutindex, delta);
+        if (light.dist_atten_enabled) {
+            auto distance = (-view - light.position).Length();
+            dist_atten = SampleDistanceAttenuation(setup, light, distance);
         }
 
-        auto GetLutValue = [&](LightingRegs::LightingLutInput input, bool abs,
-                               LightingRegs::LightingScale scale_enum,
-                               LightingRegs::LightingSampler sampler) {
+        auto GetLutValue = [&](const LightingSetup::LutSampler& sampler,
+                               LightingRegs::LightingSampler lut) {
             float result = 0.0f;
 
-            switch (input) {
+            switch (sampler.input) {
             case LightingRegs::LightingLutInput::NH:
-                result = Math::Dot(normal, half_vector.Normalized());
+                result = Math::Dot(normal, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::VH:
-                result = Math::Dot(norm_view, half_vector.Normalized());
+                result = Math::Dot(norm_view, norm_half_vector);
                 break;
 
             case LightingRegs::LightingLutInput::NV:
@@ -126,15 +292,12 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
                 result = Math::Dot(light_vector, normal);
                 break;
 
-            case LightingRegs::LightingLutInput::SP: {
-                Math::Vec3<s32> spot_dir{light_config.spot_x.Value(), light_config.spot_y.Value(),
-                                         light_config.spot_z.Value()};
-                result = Math::Dot(light_vector, spot_dir.Cast<float>() / 2047.0f);
+            case LightingRegs::LightingLutInput::SP:
+                result = Math::Dot(light_vector, light.spot_direction);
                 break;
-            }
+
             case LightingRegs::LightingLutInput::CP:
                 if (lighting.config0.config == LightingRegs::LightingConfig::Config7) {
-                    const Math::Vec3<float> norm_half_vector = half_vector.Normalized();
                     const Math::Vec3<float> half_vector_proj =
                         norm_half_vector - normal * Math::Dot(normal, norm_half_vector);
                     result = Math::Dot(half_vector_proj, tangent);
@@ -143,112 +306,63 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
                 }
                 break;
             default:
-                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input %u\n", static_cast<u32>(input));
+                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input %u\n",
+                             static_cast<u32>(sampler.input));
                 UNIMPLEMENTED();
                 result = 0.0f;
             }
 
-            u8 index;
-            float delta;
-
-            if (abs) {
-                if (light_config.config.two_sided_diffuse)
-                    result = std::abs(result);
-                else
-                    result = std::max(result, 0.0f);
-
-                float flr = std::floor(result * 256.0f);
-                index = static_cast<u8>(MathUtil::Clamp(flr, 0.0f, 255.0f));
-                delta = result * 256 - index;
-            } else {
-                float flr = std::floor(result * 128.0f);
-                s8 signed_index = static_cast<s8>(MathUtil::Clamp(flr, -128.0f, 127.0f));
-                delta = result * 128.0f - signed_index;
-                index = static_cast<u8>(signed_index);
-            }
-
-            float scale = lighting.lut_scale.GetScale(scale_enum);
-            return scale *
-                   LookupLightingLut(lighting_state, static_cast<size_t>(sampler), index, delta);
+            return SampleLut(setup, sampler, lut, light.two_sided_diffuse, result);
         };
 
         // If enabled, compute spot light attenuation value
         float spot_atten = 1.0f;
-        if (!lighting.IsSpotAttenDisabled(num) &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::SpotlightAttenuation)) {
-            auto lut = LightingRegs::SpotlightAttenuationSampler(num);
-            spot_atten = GetLutValue(lighting.lut_input.sp, lighting.abs_lut_input.disable_sp == 0,
-                                     lighting.lut_scale.sp, lut);
+        if (light.spot_atten_enabled) {
+            spot_atten =
+                GetLutValue(setup.sp, LightingRegs::SpotlightAttenuationSampler(light.num));
         }
 
         // Specular 0 component
         float d0_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d0 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution0)) {
-            d0_lut_value =
-                GetLutValue(lighting.lut_input.d0, lighting.abs_lut_input.disable_d0 == 0,
-                            lighting.lut_scale.d0, LightingRegs::LightingSampler::Distribution0);
+        if (setup.d0.enabled) {
+            d0_lut_value = GetLutValue(setup.d0, LightingRegs::LightingSampler::Distribution0);
         }
 
-        Math::Vec3<float> specular_0 = d0_lut_value * light_config.specular_0.ToVec3f();
+        Math::Vec3<float> specular_0 = d0_lut_value * light.specular_0;
 
         // If enabled, lookup ReflectRed value, otherwise, 1.0 is used
-        if (lighting.config1.disable_lut_rr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectRed)) {
-            refl_value.x =
-                GetLutValue(lighting.lut_input.rr, lighting.abs_lut_input.disable_rr == 0,
-                            lighting.lut_scale.rr, LightingRegs::LightingSampler::ReflectRed);
+        if (setup.rr.enabled) {
+            refl_value.x = GetLutValue(setup.rr, LightingRegs::LightingSampler::ReflectRed);
         } else {
             refl_value.x = 1.0f;
         }
 
         // If enabled, lookup ReflectGreen value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rg == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectGreen)) {
-            refl_value.y =
-                GetLutValue(lighting.lut_input.rg, lighting.abs_lut_input.disable_rg == 0,
-                            lighting.lut_scale.rg, LightingRegs::LightingSampler::ReflectGreen);
+        if (setup.rg.enabled) {
+            refl_value.y = GetLutValue(setup.rg, LightingRegs::LightingSampler::ReflectGreen);
         } else {
             refl_value.y = refl_value.x;
         }
 
         // If enabled, lookup ReflectBlue value, otherwise, ReflectRed value is used
-        if (lighting.config1.disable_lut_rb == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::ReflectBlue)) {
-            refl_value.z =
-                GetLutValue(lighting.lut_input.rb, lighting.abs_lut_input.disable_rb == 0,
-                            lighting.lut_scale.rb, LightingRegs::LightingSampler::ReflectBlue);
+        if (setup.rb.enabled) {
+            refl_value.z = GetLutValue(setup.rb, LightingRegs::LightingSampler::ReflectBlue);
         } else {
             refl_value.z = refl_value.x;
         }
 
         // Specular 1 component
         float d1_lut_value = 1.0f;
-        if (lighting.config1.disable_lut_d1 == 0 &&
-            LightingRegs::IsLightingSamplerSupported(
-                lighting.config0.config, LightingRegs::LightingSampler::Distribution1)) {
-            d1_lut_value =
-                GetLutValue(lighting.lut_input.d1, lighting.abs_lut_input.disable_d1 == 0,
-                            lighting.lut_scale.d1, LightingRegs::LightingSampler::Distribution1);
+        if (setup.d1.enabled) {
+            d1_lut_value = GetLutValue(setup.d1, LightingRegs::LightingSampler::Distribution1);
         }
 
-        Math::Vec3<float> specular_1 =
-            d1_lut_value * refl_value * light_config.specular_1.ToVec3f();
+        Math::Vec3<float> specular_1 = d1_lut_value * refl_value * light.specular_1;
 
         // Fresnel
         // Note: only the last entry in the light slots applies the Fresnel factor
-        if (light_index == lighting.max_light_index && lighting.config1.disable_lut_fr == 0 &&
-            LightingRegs::IsLightingSamplerSupported(lighting.config0.config,
-                                                     LightingRegs::LightingSampler::Fresnel)) {
-
-            float lut_value =
-                GetLutValue(lighting.lut_input.fr, lighting.abs_lut_input.disable_fr == 0,
-                            lighting.lut_scale.fr, LightingRegs::LightingSampler::Fresnel);
+        if (light_index == setup.num_lights - 1 && setup.fr.enabled) {
+            float lut_value = GetLutValue(setup.fr, LightingRegs::LightingSampler::Fresnel);
 
             // Enabled for diffuse lighting alpha component
             if (lighting.config0.enable_primary_alpha) {
@@ -262,7 +376,7 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
         }
 
         auto dot_product = Math::Dot(light_vector, normal);
-        if (light_config.config.two_sided_diffuse)
+        if (light.two_sided_diffuse)
             dot_product = std::abs(dot_product);
         else
             dot_product = std::max(dot_product, 0.0f);
@@ -272,23 +386,21 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
             clamp_highlights = dot_product == 0.0f ? 0.0f : 1.0f;
         }
 
-        if (light_config.config.geometric_factor_0 || light_config.config.geometric_factor_1) {
+        if (light.geometric_factor_0 || light.geometric_factor_1) {
             float geo_factor = half_vector.Length2();
             geo_factor = geo_factor == 0.0f ? 0.0f : std::min(dot_product / geo_factor, 1.0f);
-            if (light_config.config.geometric_factor_0) {
+            if (light.geometric_factor_0) {
                 specular_0 *= geo_factor;
             }
-            if (light_config.config.geometric_factor_1) {
+            if (light.geometric_factor_1) {
                 specular_1 *= geo_factor;
             }
         }
 
-        auto diffuse =
-            (light_config.diffuse.ToVec3f() * dot_product + light_config.ambient.ToVec3f()) *
-            dist_atten * spot_atten;
+        auto diffuse = (light.diffuse * dot_product + light.ambient) * dist_atten * spot_atten;
         auto specular = (specular_0 + specular_1) * clamp_highlights * dist_atten * spot_atten;
 
-        if (!lighting.IsShadowDisabled(num)) {
+        if (light.shadow_enabled) {
             if (lighting.config0.shadow_primary) {
                 diffuse = diffuse * shadow.xyz();
             }
@@ -314,19 +426,439 @@ std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
         }
     }
 
-    diffuse_sum += Math::MakeVec(lighting.global_ambient.ToVec3f(), 0.0f);
+    diffuse_sum += Math::MakeVec(setup.global_ambient, 0.0f);
+
+    return std::make_tuple(ToColor(diffuse_sum), ToColor(specular_sum));
+}
+
+size_t LightingBatch::Add(const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view,
+                          const Math::Vec4<u8> (&color)[4]) {
+    const size_t index = count++;
+    normquat_x[index] = normquat.xyz.x;
+    normquat_y[index] = normquat.xyz.y;
+    normquat_z[index] = normquat.xyz.z;
+    normquat_w[index] = normquat.w;
+    view_x[index] = view.x;
+    view_y[index] = view.y;
+    view_z[index] = view.z;
+    std::copy(std::begin(color), std::end(color), std::begin(texture_color[index]));
+    return index;
+}
+
+namespace {
+
+#ifdef ARCHITECTURE_x86_64
+
+/**
+ * One float for each fragment of a lighting batch. Each operation is a single SSE instruction that
+ * rounds exactly like the scalar operation, so the batch gets the same results as the scalar path.
+ */
+class FloatLanes {
+public:
+    FloatLanes() = default;
+    FloatLanes(float value) : lanes(_mm_set1_ps(value)) {}
+
+    static FloatLanes Load(const float* values) {
+        return FloatLanes(_mm_loadu_ps(values));
+    }
+
+    void Store(float* values) const {
+        _mm_storeu_ps(values, lanes);
+    }
+
+    FloatLanes operator-() const {
+        return FloatLanes(_mm_xor_ps(lanes, _mm_set1_ps(-0.0f)));
+    }
+
+    FloatLanes& operator+=(FloatLanes other) {
+        return *this = *this + other;
+    }
+
+    FloatLanes& operator*=(FloatLanes other) {
+        return *this = *this * other;
+    }
+
+    friend FloatLanes operator+(FloatLanes a, FloatLanes b) {
+        return FloatLanes(_mm_add_ps(a.lanes, b.lanes));
+    }
+
+    friend FloatLanes operator-(FloatLanes a, FloatLanes b) {
+        return FloatLanes(_mm_sub_ps(a.lanes, b.lanes));
+    }
+
+    friend FloatLanes operator*(FloatLanes a, FloatLanes b) {
+        return FloatLanes(_mm_mul_ps(a.lanes, b.lanes));
+    }
+
+    friend FloatLanes operator/(FloatLanes a, FloatLanes b) {
+        return FloatLanes(_mm_div_ps(a.lanes, b.lanes));
+    }
+
+    /// std::max(a, b) for each lane, including for NaNs and zeros of different signs
+    friend FloatLanes Max(FloatLanes a, FloatLanes b) {
+        return FloatLanes(_mm_max_ps(b.lanes, a.lanes));
+    }
+
+    /// std::min(a, b) for each lane, including for NaNs and zeros of different signs
+    friend FloatLanes Min(FloatLanes a, FloatLanes b) {
+        return FloatLanes(_mm_min_ps(b.lanes, a.lanes));
+    }
+
+    friend FloatLanes Abs(FloatLanes a) {
+        return FloatLanes(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.lanes));
+    }
+
+    friend FloatLanes Sqrt(FloatLanes a) {
+        return FloatLanes(_mm_sqrt_ps(a.lanes));
+    }
+
+    /// condition == 0.0f ? 0.0f : value for each lane
+    friend FloatLanes ZeroIfZero(FloatLanes condition, FloatLanes value) {
+        return FloatLanes(
+            _mm_and_ps(_mm_cmpneq_ps(condition.lanes, _mm_setzero_ps()), value.lanes));
+    }
+
+private:
+    explicit FloatLanes(__m128 lanes) : lanes(lanes) {}
+
+    __m128 lanes;
+};
+
+#else
 
-    auto diffuse = Math::MakeVec<float>(MathUtil::Clamp(diffuse_sum.x, 0.0f, 1.0f) * 255,
-                                        MathUtil::Clamp(diffuse_sum.y, 0.0f, 1.0f) * 255,
-                                        MathUtil::Clamp(diffuse_sum.z, 0.0f, 1.0f) * 255,
-                                        MathUtil::Clamp(diffuse_sum.w, 0.0f, 1.0f) * 255)
-                       .Cast<u8>();
-    auto specular = Math::MakeVec<float>(MathUtil::Clamp(specular_sum.x, 0.0f, 1.0f) * 255,
-                                         MathUtil::Clamp(specular_sum.y, 0.0f, 1.0f) * 255,
-                                         MathUtil::Clamp(specular_sum.z, 0.0f, 1.0f) * 255,
-                                         MathUtil::Clamp(specular_sum.w, 0.0f, 1.0f) * 255)
-                        .Cast<u8>();
-    return std::make_tuple(diffuse, specular);
+/// One float for each fragment of a lighting batch, computed one after another.
+class FloatLanes {
+public:
+    FloatLanes() = default;
+    FloatLanes(float value) {
+        lanes.fill(value);
+    }
+
+    static FloatLanes Load(const float* values) {
+        FloatLanes result;
+        std::copy_n(values, result.lanes.size(), result.lanes.begin());
+        return result;
+    }
+
+    void Store(float* values) const {
+        std::copy(lanes.begin(), lanes.end(), values);
+    }
+
+    FloatLanes operator-() const {
+        return Map([](float a, float) { return -a; }, *this, *this);
+    }
+
+    FloatLanes& operator+=(FloatLanes other) {
+        return *this = *this + other;
+    }
+
+    FloatLanes& operator*=(FloatLanes other) {
+        return *this = *this * other;
+    }
+
+    friend FloatLanes operator+(FloatLanes a, FloatLanes b) {
+        return Map([](float x, float y) { return x + y; }, a, b);
+    }
+
+    friend FloatLanes operator-(FloatLanes a, FloatLanes b) {
+        return Map([](float x, float y) { return x - y; }, a, b);
+    }
+
+    friend FloatLanes operator*(FloatLanes a, FloatLanes b) {
+        return Map([](float x, float y) { return x * y; }, a, b);
+    }
+
+    friend FloatLanes operator/(FloatLanes a, FloatLanes b) {
+        return Map([](float x, float y) { return x / y; }, a, b);
+    }
+
+    friend FloatLanes Max(FloatLanes a, FloatLanes b) {
+        return Map([](float x, float y) { return std::max(x, y); }, a, b);
+    }
+
+    friend FloatLanes Min(FloatLanes a, FloatLanes b) {
+        return Map([](float x, float y) { return std::min(x, y); }, a, b);
+    }
+
+    friend FloatLanes Abs(FloatLanes a) {
+        return Map([](float x, float) { return std::abs(x); }, a, a);
+    }
+
+    friend FloatLanes Sqrt(FloatLanes a) {
+        return Map([](float x, float) { return std::sqrt(x); }, a, a);
+    }
+
+    friend FloatLanes ZeroIfZero(FloatLanes condition, FloatLanes value) {
+        return Map([](float c, float v) { return c == 0.0f ? 0.0f : v; }, condition, value);
+    }
+
+private:
+    template <typename Op>
+    static FloatLanes Map(Op op, FloatLanes a, FloatLanes b) {
+        FloatLanes result;
+        for (size_t i = 0; i < result.lanes.size(); ++i)
+            result.lanes[i] = op(a.lanes[i], b.lanes[i]);
+        return result;
+    }
+
+    std::array<float, LightingBatch::size> lanes;
+};
+
+#endif // ARCHITECTURE_x86_64
+
+using Vec3Lanes = Math::Vec3<FloatLanes>;
+using LaneArray = std::array<float, LightingBatch::size>;
+
+Vec3Lanes Broadcast(const Math::Vec3<float>& v) {
+    return Math::MakeVec<FloatLanes>(v.x, v.y, v.z);
+}
+
+Vec3Lanes Load(const LaneArray& x, const LaneArray& y, const LaneArray& z) {
+    return Math::MakeVec(FloatLanes::Load(x.data()), FloatLanes::Load(y.data()),
+                         FloatLanes::Load(z.data()));
+}
+
+FloatLanes Length2(const Vec3Lanes& v) {
+    return v.x * v.x + v.y * v.y + v.z * v.z;
+}
+
+Vec3Lanes Normalized(const Vec3Lanes& v) {
+    return v / Sqrt(Length2(v));
+}
+
+/// Applies a scalar function to the lanes of the fragments in the batch
+template <typename Function>
+FloatLanes MapLanes(FloatLanes values, size_t count, Function function) {
+    LaneArray lanes;
+    values.Store(lanes.data());
+    for (size_t i = 0; i < count; ++i)
+        lanes[i] = function(lanes[i]);
+    return FloatLanes::Load(lanes.data());
+}
+
+} // Anonymous namespace
+
+void ComputeFragmentsColors(const Pica::LightingRegs& lighting, const LightingSetup& setup,
+                            LightingBatch& batch) {
+    // What depends on the texture colors is prepared one fragment at a time
+    LaneArray shadow_r{}, shadow_g{}, shadow_b{}, shadow_a{};
+    LaneArray normal_x{}, normal_y{}, normal_z{};
+    LaneArray tangent_x{}, tangent_y{}, tangent_z{};
+    for (size_t i = 0; i < batch.count; ++i) {
+        const Math::Vec4<float> fragment_shadow = GetShadow(lighting, batch.texture_color[i]);
+        shadow_r[i] = fragment_shadow.r();
+        shadow_g[i] = fragment_shadow.g();
+        shadow_b[i] = fragment_shadow.b();
+        shadow_a[i] = fragment_shadow.a();
+
+        Math::Vec3<float> surface_normal;
+        Math::Vec3<float> surface_tangent;
+        std::tie(surface_normal, surface_tangent) =
+            GetSurfaceNormalAndTangent(lighting, batch.texture_color[i]);
+        normal_x[i] = surface_normal.x;
+        normal_y[i] = surface_normal.y;
+        normal_z[i] = surface_normal.z;
+        tangent_x[i] = surface_tangent.x;
+        tangent_y[i] = surface_tangent.y;
+        tangent_z[i] = surface_tangent.z;
+    }
+    const Vec3Lanes shadow = Load(shadow_r, shadow_g, shadow_b);
+    const FloatLanes shadow_alpha = FloatLanes::Load(shadow_a.data());
+
+    const Math::Quaternion<FloatLanes> normquat{
+        Load(batch.normquat_x, batch.normquat_y, batch.normquat_z),
+        FloatLanes::Load(batch.normquat_w.data())};
+    const Vec3Lanes normal =
+        Math::QuaternionRotate(normquat, Load(normal_x, normal_y, normal_z));
+    const Vec3Lanes tangent =
+        Math::QuaternionRotate(normquat, Load(tangent_x, tangent_y, tangent_z));
+
+    const Vec3Lanes view = Load(batch.view_x, batch.view_y, batch.view_z);
+    const Vec3Lanes norm_view = Normalized(view);
+
+    Vec3Lanes diffuse_sum = Broadcast({0.0f, 0.0f, 0.0f});
+    Vec3Lanes specular_sum = Broadcast({0.0f, 0.0f, 0.0f});
+    FloatLanes diffuse_alpha = 1.0f;
+    FloatLanes specular_alpha = 1.0f;
+
+    for (unsigned light_index = 0; light_index < setup.num_lights; ++light_index) {
+        const auto& light = setup.lights[light_index];
+
+        Vec3Lanes light_vector;
+        if (light.directional)
+            light_vector = Broadcast(light.position);
+        else
+            light_vector = Broadcast(light.position) + view;
+
+        light_vector = Normalized(light_vector);
+
+        const Vec3Lanes half_vector = norm_view + light_vector;
+        Vec3Lanes norm_half_vector;
+        if (setup.uses_norm_half_vector)
+            norm_half_vector = Normalized(half_vector);
+
+        FloatLanes dist_atten = 1.0f;
+        if (light.dist_atten_enabled) {
+            const Vec3Lanes to_light =
+                Math::MakeVec(-view.x, -view.y, -view.z) - Broadcast(light.position);
+            dist_atten = MapLanes(Sqrt(Length2(to_light)), batch.count, [&](float distance) {
+                return SampleDistanceAttenuation(setup, light, distance);
+            });
+        }
+
+        auto GetLutValue = [&](const LightingSetup::LutSampler& sampler,
+                               LightingRegs::LightingSampler lut) {
+            FloatLanes result = 0.0f;
+
+            switch (sampler.input) {
+            case LightingRegs::LightingLutInput::NH:
+                result = Math::Dot(normal, norm_half_vector);
+                break;
+
+            case LightingRegs::LightingLutInput::VH:
+                result = Math::Dot(norm_view, norm_half_vector);
+                break;
+
+            case LightingRegs::LightingLutInput::NV:
+                result = Math::Dot(normal, norm_view);
+                break;
+
+            case LightingRegs::LightingLutInput::LN:
+                result = Math::Dot(light_vector, normal);
+                break;
+
+            case LightingRegs::LightingLutInput::SP:
+                result = Math::Dot(light_vector, Broadcast(light.spot_direction));
+                break;
+
+            case LightingRegs::LightingLutInput::CP:
+                if (lighting.config0.config == LightingRegs::LightingConfig::Config7) {
+                    const Vec3Lanes half_vector_proj =
+                        norm_half_vector - normal * Math::Dot(normal, norm_half_vector);
+                    result = Math::Dot(half_vector_proj, tangent);
+                }
+                break;
+            default:
+                LOG_CRITICAL(HW_GPU, "Unknown lighting LUT input %u\n",
+                             static_cast<u32>(sampler.input));
+                UNIMPLEMENTED();
+            }
+
+            // The LUT lookups themselves are gathers, done one fragment at a time
+            return MapLanes(result, batch.count, [&](float input) {
+                return SampleLut(setup, sampler, lut, light.two_sided_diffuse, input);
+            });
+        };
+
+        FloatLanes spot_atten = 1.0f;
+        if (light.spot_atten_enabled) {
+            spot_atten =
+                GetLutValue(setup.sp, LightingRegs::SpotlightAttenuationSampler(light.num));
+        }
+
+        FloatLanes d0_lut_value = 1.0f;
+        if (setup.d0.enabled) {
+            d0_lut_value = GetLutValue(setup.d0, LightingRegs::LightingSampler::Distribution0);
+        }
+
+        Vec3Lanes specular_0 = Broadcast(light.specular_0) * d0_lut_value;
+
+        Vec3Lanes refl_value;
+        refl_value.x = setup.rr.enabled
+                           ? GetLutValue(setup.rr, LightingRegs::LightingSampler::ReflectRed)
+                           : FloatLanes(1.0f);
+        refl_value.y = setup.rg.enabled
+                           ? GetLutValue(setup.rg, LightingRegs::LightingSampler::ReflectGreen)
+                           : refl_value.x;
+        refl_value.z = setup.rb.enabled
+                           ? GetLutValue(setup.rb, LightingRegs::LightingSampler::ReflectBlue)
+                           : refl_value.x;
+
+        FloatLanes d1_lut_value = 1.0f;
+        if (setup.d1.enabled) {
+            d1_lut_value = GetLutValue(setup.d1, LightingRegs::LightingSampler::Distribution1);
+        }
+
+        Vec3Lanes specular_1 = refl_value * d1_lut_value * Broadcast(light.specular_1);
+
+        // Note: only the last entry in the light slots applies the Fresnel factor
+        if (light_index == setup.num_lights - 1 && setup.fr.enabled) {
+            const FloatLanes lut_value =
+                GetLutValue(setup.fr, LightingRegs::LightingSampler::Fresnel);
+            if (lighting.config0.enable_primary_alpha) {
+                diffuse_alpha = lut_value;
+            }
+            if (lighting.config0.enable_secondary_alpha) {
+                specular_alpha = lut_value;
+            }
+        }
+
+        FloatLanes dot_product = Math::Dot(light_vector, normal);
+        if (light.two_sided_diffuse)
+            dot_product = Abs(dot_product);
+        else
+            dot_product = Max(dot_product, 0.0f);
+
+        FloatLanes clamp_highlights = 1.0f;
+        if (lighting.config0.clamp_highlights) {
+            clamp_highlights = ZeroIfZero(dot_product, 1.0f);
+        }
+
+        if (light.geometric_factor_0 || light.geometric_factor_1) {
+            FloatLanes geo_factor = Length2(half_vector);
+            geo_factor = ZeroIfZero(geo_factor, Min(dot_product / geo_factor, 1.0f));
+            if (light.geometric_factor_0) {
+                specular_0 *= geo_factor;
+            }
+            if (light.geometric_factor_1) {
+                specular_1 *= geo_factor;
+            }
+        }
+
+        auto diffuse = (Broadcast(light.diffuse) * dot_product + Broadcast(light.ambient)) *
+                       dist_atten * spot_atten;
+        auto specular = (specular_0 + specular_1) * clamp_highlights * dist_atten * spot_atten;
+
+        if (light.shadow_enabled) {
+            if (lighting.config0.shadow_primary) {
+                diffuse = diffuse * shadow;
+            }
+            if (lighting.config0.shadow_secondary) {
+                specular = specular * shadow;
+            }
+        }
+
+        diffuse_sum += diffuse;
+        specular_sum += specular;
+    }
+
+    if (lighting.config0.shadow_alpha) {
+        if (lighting.config0.enable_primary_alpha) {
+            diffuse_alpha = diffuse_alpha * shadow_alpha;
+        }
+        if (lighting.config0.enable_secondary_alpha) {
+            specular_alpha = specular_alpha * shadow_alpha;
+        }
+    }
+
+    diffuse_sum += Broadcast(setup.global_ambient);
+
+    LaneArray diffuse[4];
+    LaneArray specular[4];
+    diffuse_sum.x.Store(diffuse[0].data());
+    diffuse_sum.y.Store(diffuse[1].data());
+    diffuse_sum.z.Store(diffuse[2].data());
+    diffuse_alpha.Store(diffuse[3].data());
+    specular_sum.x.Store(specular[0].data());
+    specular_sum.y.Store(specular[1].data());
+    specular_sum.z.Store(specular[2].data());
+    specular_alpha.Store(specular[3].data());
+    for (size_t i = 0; i < batch.count; ++i) {
+        batch.primary_color[i] =
+            ToColor({diffuse[0][i], diffuse[1][i], diffuse[2][i], diffuse[3][i]});
+        batch.secondary_color[i] =
+            ToColor({specular[0][i], specular[1][i], specular[2][i], specular[3][i]});
+    }
 }
 
 } // namespace Pica
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <tuple>
 #include "common/quaternion.h"
 #include "common/vector_math.h"
@@ -11,9 +12,121 @@
 
 namespace Pica {
 
+/**
+ * Lighting registers and LUTs converted to the float form used by ComputeFragmentsColors. Light
+ * parameters, enabled LUTs and their scales are the same for every fragment of a draw, so they are
+ * only regenerated when the lighting state changes.
+ */
+struct LightingSetup {
+    struct LutEntry {
+        float value;
+        float diff;
+    };
+
+    struct LutSampler {
+        bool enabled;
+        bool abs_input;
+        LightingRegs::LightingLutInput input;
+        float scale;
+    };
+
+    struct Light {
+        unsigned num; ///< Index of the light source this slot refers to
+        Math::Vec3<float> position;
+        Math::Vec3<float> spot_direction;
+        Math::Vec3<float> specular_0;
+        Math::Vec3<float> specular_1;
+        Math::Vec3<float> diffuse;
+        Math::Vec3<float> ambient;
+        float dist_atten_scale;
+        float dist_atten_bias;
+        bool directional;
+        bool two_sided_diffuse;
+        bool geometric_factor_0;
+        bool geometric_factor_1;
+        bool dist_atten_enabled;
+        bool spot_atten_enabled;
+        bool shadow_enabled;
+    };
+
+    /// Regenerates the setup from the given register and LUT state
+    void Update(const LightingRegs& regs, const State::Lighting& state);
+
+    /// Regenerates the float form of one LUT
+    void UpdateLut(size_t lut_index, const State::Lighting& state);
+
+    /// Regenerates everything but the LUTs from the given register state
+    void UpdateParameters(const LightingRegs& regs);
+
+    std::array<std::array<LutEntry, 256>, LightingRegs::NumLightingSampler> luts;
+
+    LutSampler d0;
+    LutSampler d1;
+    LutSampler fr;
+    LutSampler rr;
+    LutSampler rg;
+    LutSampler rb;
+    LutSampler sp;
+
+    /// Whether any enabled LUT is indexed by a value derived from the normalized half vector
+    bool uses_norm_half_vector;
+
+    std::array<Light, 8> lights;
+    unsigned num_lights;
+
+    Math::Vec3<float> global_ambient;
+};
+
+/// Marks the whole cached lighting setup as outdated, such as when the Pica state may have changed.
+void InvalidateLightingSetup();
+
+/// Marks the cached light and LUT parameters as outdated. Called when a lighting register changes.
+void InvalidateLightingParameters();
+
+/// Marks one cached LUT as outdated. Called when data is written to the LUT.
+void InvalidateLightingLut(size_t lut_index);
+
+/// Returns the lighting setup for the current Pica state, regenerating it if it is outdated
+const LightingSetup& GetLightingSetup();
+
 std::tuple<Math::Vec4<u8>, Math::Vec4<u8>> ComputeFragmentsColors(
-    const Pica::LightingRegs& lighting, const Pica::State::Lighting& lighting_state,
+    const Pica::LightingRegs& lighting, const LightingSetup& setup,
     const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view,
     const Math::Vec4<u8> (&texture_color)[4]);
 
+/**
+ * Fragments lit together by ComputeFragmentsColors. The inputs are stored as a structure of arrays,
+ * so that one component of every fragment of the batch is loaded and computed at once.
+ */
+struct LightingBatch {
+    static constexpr size_t size = 4;
+
+    /// Number of fragments in the batch, the remaining entries are ignored
+    size_t count = 0;
+
+    std::array<float, size> normquat_x{};
+    std::array<float, size> normquat_y{};
+    std::array<float, size> normquat_z{};
+    std::array<float, size> normquat_w{};
+    std::array<float, size> view_x{};
+    std::array<float, size> view_y{};
+    std::array<float, size> view_z{};
+    Math::Vec4<u8> texture_color[size][4]{};
+
+    /// Lighting results of each fragment, filled in by ComputeFragmentsColors
+    std::array<Math::Vec4<u8>, size> primary_color;
+    std::array<Math::Vec4<u8>, size> secondary_color;
+
+    /// Appends a fragment to the batch, and returns its index in the batch
+    size_t Add(const Math::Quaternion<float>& normquat, const Math::Vec3<float>& view,
+               const Math::Vec4<u8> (&texture_color)[4]);
+};
+
+/**
+ * Lights all fragments of a batch at once. Produces the same colors as lighting each fragment by
+ * itself with the function above.
+ */
+void ComputeFragmentsColors(const Pica::LightingRegs& lighting, const LightingSetup& setup,
+                            LightingBatch& batch);
+
 } // namespace Pica
@@ -15,14 +15,14 @@ using ProcTexShift = TexturingRegs::ProcTexShift;
 using ProcTexCombiner = TexturingRegs::ProcTexCombiner;
 using ProcTexFilter = TexturingRegs::ProcTexFilter;
 
-static float LookupLUT(const std::array<State::ProcTex::ValueEntry, 128>& lut, float coord) {
+static float LookupLUT(const std::array<ProcTexTables::LutEntry, 128>& lut, float coord) {
     // For NoiseLUT/ColorMap/AlphaMap, coord=0.0 is lut[0], coord=127.0/128.0 is lut[127] and
     // coord=1.0 is lut[127]+lut_diff[127]. For other indices, the result is interpolated using
     // value entries and difference entries.
     coord *= 128;
     const int index_int = std::min(static_cast<int>(coord), 127);
     const float frac = coord - index_int;
-    return lut[index_int].ToFloat() + frac * lut[index_int].DiffToFloat();
+    return lut[index_int].value + frac * lut[index_int].diff;
 }
 
 // These function are used to generate random noise for procedural texture. Their results are
@@ -46,13 +46,9 @@ static float NoiseRand2D(unsigned int x, unsigned int y) {
     return -1.0f + v2 * 2.0f / 15.0f;
 }
 
-static float NoiseCoef(float u, float v, TexturingRegs regs, State::ProcTex state) {
-    const float freq_u = float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32();
-    const float freq_v = float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32();
-    const float phase_u = float16::FromRaw(regs.proctex_noise_u.phase).ToFloat32();
-    const float phase_v = float16::FromRaw(regs.proctex_noise_v.phase).ToFloat32();
-    const float x = 9 * freq_u * std::abs(u + phase_u);
-    const float y = 9 * freq_v * std::abs(v + phase_v);
+static float NoiseCoef(float u, float v, const ProcTexTables& tables) {
+    const float x = 9 * tables.noise_freq_u * std::abs(u + tables.noise_phase_u);
+    const float y = 9 * tables.noise_freq_v * std::abs(v + tables.noise_phase_v);
     const int x_int = static_cast<int>(x);
     const int y_int = static_cast<int>(y);
     const float x_frac = x - x_int;
@@ -62,8 +58,8 @@ static float NoiseCoef(float u, float v, TexturingRegs regs, State::ProcTex stat
     const float g1 = NoiseRand2D(x_int + 1, y_int) * (x_frac + y_frac - 1);
     const float g2 = NoiseRand2D(x_int, y_int + 1) * (x_frac + y_frac - 1);
     const float g3 = NoiseRand2D(x_int + 1, y_int + 1) * (x_frac + y_frac - 2);
-    const float x_noise = LookupLUT(state.noise_table, x_frac);
-    const float y_noise = LookupLUT(state.noise_table, y_frac);
+    const float x_noise = LookupLUT(tables.noise_table, x_frac);
+    const float y_noise = LookupLUT(tables.noise_table, y_frac);
     return Math::BilinearInterp(g0, g1, g2, g3, x_noise, y_noise);
 }
 
@@ -113,8 +109,8 @@ static void ClampCoord(float& coord, ProcTexClamp mode) {
     }
 }
 
-float CombineAndMap(float u, float v, ProcTexCombiner combiner,
-                    const std::array<State::ProcTex::ValueEntry, 128>& map_table) {
+static float CombineAndMap(float u, float v, ProcTexCombiner combiner,
+                           const std::array<ProcTexTables::LutEntry, 128>& map_table) {
     float f;
     switch (combiner) {
     case ProcTexCombiner::U:
@@ -155,7 +151,48 @@ float CombineAndMap(float u, float v, ProcTexCombiner combiner,
     return LookupLUT(map_table, f);
 }
 
-Math::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state) {
+static void ConvertLUT(std::array<ProcTexTables::LutEntry, 128>& dest,
+                       const std::array<State::ProcTex::ValueEntry, 128>& src) {
+    for (std::size_t i = 0; i < src.size(); ++i) {
+        dest[i] = {src[i].ToFloat(), src[i].DiffToFloat()};
+    }
+}
+
+void ProcTexTables::Update(const TexturingRegs& regs, const State::ProcTex& state) {
+    noise_freq_u = float16::FromRaw(regs.proctex_noise_frequency.u).ToFloat32();
+    noise_freq_v = float16::FromRaw(regs.proctex_noise_frequency.v).ToFloat32();
+    noise_phase_u = float16::FromRaw(regs.proctex_noise_u.phase).ToFloat32();
+    noise_phase_v = float16::FromRaw(regs.proctex_noise_v.phase).ToFloat32();
+    noise_amplitude_u = static_cast<float>(regs.proctex_noise_u.amplitude);
+    noise_amplitude_v = static_cast<float>(regs.proctex_noise_v.amplitude);
+
+    ConvertLUT(noise_table, state.noise_table);
+    ConvertLUT(color_map_table, state.color_map_table);
+    ConvertLUT(alpha_map_table, state.alpha_map_table);
+
+    for (std::size_t i = 0; i < color_table.size(); ++i) {
+        color_table[i] = state.color_table[i].ToVector();
+        color_table_float[i] = color_table[i].Cast<float>();
+        color_diff_table[i] = state.color_diff_table[i].ToVector().Cast<float>();
+    }
+}
+
+static ProcTexTables cached_tables;
+static bool cached_tables_dirty = true;
+
+void InvalidateProcTexTables() {
+    cached_tables_dirty = true;
+}
+
+const ProcTexTables& GetProcTexTables() {
+    if (cached_tables_dirty) {
+        cached_tables.Update(g_state.regs.texturing, g_state.proctex);
+        cached_tables_dirty = false;
+    }
+    return cached_tables;
+}
+
+Math::Vec4<u8> ProcTex(float u, float v, const TexturingRegs& regs, const ProcTexTables& tables) {
     u = std::abs(u);
     v = std::abs(v);
 
@@ -165,9 +202,9 @@ Math::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex stat
 
     // Generate noise
     if (regs.proctex.noise_enable) {
-        float noise = NoiseCoef(u, v, regs, state);
-        u += noise * regs.proctex_noise_u.amplitude / 4095.0f;
-        v += noise * regs.proctex_noise_v.amplitude / 4095.0f;
+        float noise = NoiseCoef(u, v, tables);
+        u += noise * tables.noise_amplitude_u / 4095.0f;
+        v += noise * tables.noise_amplitude_v / 4095.0f;
         u = std::abs(u);
         v = std::abs(v);
     }
@@ -181,7 +218,7 @@ Math::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex stat
     ClampCoord(v, regs.proctex.v_clamp);
 
     // Combine and map
-    const float lut_coord = CombineAndMap(u, v, regs.proctex.color_combiner, state.color_map_table);
+    const float lut_coord = CombineAndMap(u, v, regs.proctex.color_combiner, tables.color_map_table);
 
     // Look up the color
     // For the color lut, coord=0.0 is lut[offset] and coord=1.0 is lut[offset+width-1]
@@ -196,15 +233,15 @@ Math::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex stat
     case ProcTexFilter::LinearMipmapNearest: {
         const int index_int = static_cast<int>(index);
         const float frac = index - index_int;
-        const auto color_value = state.color_table[index_int].ToVector().Cast<float>();
-        const auto color_diff = state.color_diff_table[index_int].ToVector().Cast<float>();
+        const auto& color_value = tables.color_table_float[index_int];
+        const auto& color_diff = tables.color_diff_table[index_int];
         final_color = (color_value + frac * color_diff).Cast<u8>();
         break;
     }
     case ProcTexFilter::Nearest:
     case ProcTexFilter::NearestMipmapLinear:
     case ProcTexFilter::NearestMipmapNearest:
-        final_color = state.color_table[static_cast<int>(std::round(index))].ToVector();
+        final_color = tables.color_table[static_cast<int>(std::round(index))];
         break;
     }
 
@@ -212,7 +249,7 @@ Math::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex stat
         // Note: in separate alpha mode, the alpha channel skips the color LUT look up stage. It
         // uses the output of CombineAndMap directly instead.
         const float final_alpha =
-            CombineAndMap(u, v, regs.proctex.alpha_combiner, state.alpha_map_table);
+            CombineAndMap(u, v, regs.proctex.alpha_combiner, tables.alpha_map_table);
         return Math::MakeVec<u8>(final_color.rgb(), static_cast<u8>(final_alpha * 255));
     } else {
         return final_color;
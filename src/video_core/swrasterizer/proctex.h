@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#pragma once
+
+#include <array>
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/pica_state.h"
@@ -9,8 +12,43 @@
 namespace Pica {
 namespace Rasterizer {
 
+/**
+ * Values derived from the procedural texture registers and LUTs, converted to the float form used
+ * by ProcTex. These only change when the proctex state changes, so they are generated once per
+ * state instead of once per fragment.
+ */
+struct ProcTexTables {
+    struct LutEntry {
+        float value;
+        float diff;
+    };
+
+    /// Regenerates the tables from the given register and LUT state
+    void Update(const TexturingRegs& regs, const State::ProcTex& state);
+
+    float noise_freq_u;
+    float noise_freq_v;
+    float noise_phase_u;
+    float noise_phase_v;
+    float noise_amplitude_u;
+    float noise_amplitude_v;
+
+    std::array<LutEntry, 128> noise_table;
+    std::array<LutEntry, 128> color_map_table;
+    std::array<LutEntry, 128> alpha_map_table;
+    std::array<Math::Vec4<u8>, 256> color_table;
+    std::array<Math::Vec4<float>, 256> color_table_float;
+    std::array<Math::Vec4<float>, 256> color_diff_table;
+};
+
+/// Marks the cached proctex tables as outdated. Called whenever a proctex register or LUT changes.
+void InvalidateProcTexTables();
+
+/// Returns the proctex tables for the current Pica state, regenerating them if they are outdated
+const ProcTexTables& GetProcTexTables();
+
 /// Generates procedural texture color for the given coordinates
-Math::Vec4<u8> ProcTex(float u, float v, TexturingRegs regs, State::ProcTex state);
+Math::Vec4<u8> ProcTex(float u, float v, const TexturingRegs& regs, const ProcTexTables& tables);
 
 } // namespace Rasterizer
 } // namespace Pica
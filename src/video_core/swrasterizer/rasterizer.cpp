@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <iterator>
 #include <tuple>
 #include "common/assert.h"
 #include "common/bit_field.h"
@@ -181,6 +182,22 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
         max_y = std::min(max_y, scissor_y2);
     }
 
+    // Triangles inside the clipper's guard band are not clipped against the viewport edges, so
+    // limit the bounding box to the viewport here. This has no effect on clipped triangles.
+    static auto ViewportToFix = [](float value) {
+        return static_cast<u16>(MathUtil::Clamp(std::round(value * 16.0f), 0.0f, 65535.0f));
+    };
+    const float viewport_x1 = static_cast<float>(regs.rasterizer.viewport_corner.x);
+    const float viewport_y1 = static_cast<float>(regs.rasterizer.viewport_corner.y);
+    const float viewport_x2 =
+        viewport_x1 + 2 * float24::FromRaw(regs.rasterizer.viewport_size_x).ToFloat32();
+    const float viewport_y2 =
+        viewport_y1 + 2 * float24::FromRaw(regs.rasterizer.viewport_size_y).ToFloat32();
+    min_x = std::max(min_x, ViewportToFix(viewport_x1));
+    min_y = std::max(min_y, ViewportToFix(viewport_y1));
+    max_x = std::min(max_x, ViewportToFix(viewport_x2));
+    max_y = std::min(max_y, ViewportToFix(viewport_y2));
+
     min_x &= Fix12P4::IntMask();
     min_y &= Fix12P4::IntMask();
     max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
@@ -220,220 +237,219 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
         g_state.regs.framebuffer.output_merger.stencil_test.enable &&
         g_state.regs.framebuffer.framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8;
     const auto stencil_test = g_state.regs.framebuffer.output_merger.stencil_test;
+    const auto& output_merger = regs.framebuffer.output_merger;
+
+    const bool shadow_mode =
+        output_merger.fragment_operation_mode == FramebufferRegs::FragmentOperationMode::Shadow;
+    const bool early_depth_stencil = CanTestDepthEarly(regs);
+
+    // Coarse depth rejection: a whole tile of the triangle can be skipped if the triangle's depth
+    // range fails the depth test against the depth range stored in the tile. This is only
+    // possible if failing fragments have no side effects, i.e. when stencil fail actions are Keep.
+    const auto depth_func = output_merger.depth_test_func.Value();
+    const bool coarse_depth_func = depth_func == FramebufferRegs::CompareFunc::LessThan ||
+                                   depth_func == FramebufferRegs::CompareFunc::LessThanOrEqual ||
+                                   depth_func == FramebufferRegs::CompareFunc::GreaterThan ||
+                                   depth_func == FramebufferRegs::CompareFunc::GreaterThanOrEqual;
+    const bool stencil_fail_keep =
+        !stencil_action_enable ||
+        (stencil_test.action_stencil_fail == FramebufferRegs::StencilAction::Keep &&
+         stencil_test.action_depth_fail == FramebufferRegs::StencilAction::Keep);
+    const bool use_depth_tiles =
+        SyncDepthTiles() && !shadow_mode && output_merger.depth_test_enable && coarse_depth_func &&
+        stencil_fail_keep &&
+        regs.rasterizer.depthmap_enable == RasterizerRegs::DepthBuffering::ZBuffering;
+
+    // The interpolated z / w of each fragment is a convex combination of the vertex values, so the
+    // depth of all fragments lies in the range spanned by the vertices
+    u32 triangle_min_z = 0;
+    u32 triangle_max_z = 0;
+    if (use_depth_tiles) {
+        const float depth_scale =
+            float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+        const float depth_offset =
+            float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+        const unsigned num_bits =
+            FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
+        const u32 max_z = (1u << num_bits) - 1;
+
+        auto VertexDepth = [&](const Vertex& vtx) {
+            const float depth = MathUtil::Clamp(
+                vtx.screenpos[2].ToFloat32() * depth_scale + depth_offset, 0.0f, 1.0f);
+            return static_cast<u32>(depth * max_z);
+        };
+        const u32 z0 = VertexDepth(v0);
+        const u32 z1 = VertexDepth(v1);
+        const u32 z2 = VertexDepth(v2);
+
+        // Leave some room for the rounding error of the per-fragment interpolation
+        constexpr u32 margin = 4;
+        triangle_min_z = std::max(std::min({z0, z1, z2}), margin) - margin;
+        triangle_max_z = std::min(std::max({z0, z1, z2}) + margin, max_z);
+    }
+
+    auto IsDepthTileRejected = [&](int pixel_x, int pixel_y) {
+        const DepthTileRange range = GetDepthTileRange(pixel_x, pixel_y);
+        switch (depth_func) {
+        case FramebufferRegs::CompareFunc::LessThan:
+            return triangle_min_z >= range.max;
+        case FramebufferRegs::CompareFunc::LessThanOrEqual:
+            return triangle_min_z > range.max;
+        case FramebufferRegs::CompareFunc::GreaterThan:
+            return triangle_max_z <= range.min;
+        case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+            return triangle_max_z < range.min;
+        default:
+            return false;
+        }
+    };
+
+    // Fragments are shaded in batches so that their lighting can be computed together
+    struct Fragment {
+        u16 x;
+        float depth;
+        Math::Vec4<u8> primary_color;
+        Math::Vec4<u8> texture_color[4];
+    };
+    std::array<Fragment, LightingBatch::size> fragments;
+    size_t num_fragments = 0;
+    LightingBatch lighting_batch;
 
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
     // TODO: Not sure if looping through x first might be faster
     for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
-
-            // Do not process the pixel if it's inside the scissor box and the scissor mode is set
-            // to Exclude
-            if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
-                if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2)
-                    continue;
-            }
+        // Stencil and depth tests, including the resulting buffer updates. Returns whether the
+        // fragment passed both tests.
+        auto PerformDepthStencilTest = [&](u16 x, float depth) -> bool {
+            u8 old_stencil = 0;
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            int wsum = w0 + w1 + w2;
+            auto UpdateStencil = [stencil_test, x, y,
+                                  &old_stencil](Pica::FramebufferRegs::StencilAction action) {
+                u8 new_stencil =
+                    PerformStencilAction(action, old_stencil, stencil_test.reference_value);
+                if (g_state.regs.framebuffer.framebuffer.allow_depth_stencil_write != 0)
+                    SetStencil(x >> 4, y >> 4,
+                               (new_stencil & stencil_test.write_mask) |
+                                   (old_stencil & ~stencil_test.write_mask));
+            };
 
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
-                continue;
+            if (stencil_action_enable) {
+                old_stencil = GetStencil(x >> 4, y >> 4);
+                u8 dest = old_stencil & stencil_test.input_mask;
+                u8 ref = stencil_test.reference_value & stencil_test.input_mask;
 
-            auto baricentric_coordinates =
-                Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
-                              float24::FromFloat32(static_cast<float>(w1)),
-                              float24::FromFloat32(static_cast<float>(w2)));
-            float24 interpolated_w_inverse =
-                float24::FromFloat32(1.0f) / Math::Dot(w_inverse, baricentric_coordinates);
+                bool pass = false;
+                switch (stencil_test.func) {
+                case FramebufferRegs::CompareFunc::Never:
+                    pass = false;
+                    break;
 
-            // interpolated_z = z / w
-            float interpolated_z_over_w =
-                (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
-                 v2.screenpos[2].ToFloat32() * w2) /
-                wsum;
+                case FramebufferRegs::CompareFunc::Always:
+                    pass = true;
+                    break;
 
-            // Not fully accurate. About 3 bits in precision are missing.
-            // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-            float depth_offset =
-                float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
-            float depth = interpolated_z_over_w * depth_scale + depth_offset;
+                case FramebufferRegs::CompareFunc::Equal:
+                    pass = (ref == dest);
+                    break;
 
-            // Potentially switch to W-Buffer
-            if (regs.rasterizer.depthmap_enable ==
-                Pica::RasterizerRegs::DepthBuffering::WBuffering) {
-                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                depth *= interpolated_w_inverse.ToFloat32() * wsum;
-            }
+                case FramebufferRegs::CompareFunc::NotEqual:
+                    pass = (ref != dest);
+                    break;
 
-            // Clamp the result
-            depth = MathUtil::Clamp(depth, 0.0f, 1.0f);
+                case FramebufferRegs::CompareFunc::LessThan:
+                    pass = (ref < dest);
+                    break;
 
-            // Perspective correct attribute interpolation:
-            // Attribute values cannot be calculated by simple linear interpolation since
-            // they are not linear in screen space. For example, when interpolating a
-            // texture coordinate across two vertices, something simple like
-            //     u = (u0*w0 + u1*w1)/(w0+w1)
-            // will not work. However, the attribute value divided by the
-            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-            // in screenspace. Hence, we can linearly interpolate these two independently and
-            // calculate the interpolated attribute by dividing the results.
-            // I.e.
-            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-            //     u = u_over_w / one_over_w
-            //
-            // The generalization to three vertices is straightforward in baricentric coordinates.
-            auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
-                auto attr_over_w = Math::MakeVec(attr0, attr1, attr2);
-                float24 interpolated_attr_over_w = Math::Dot(attr_over_w, baricentric_coordinates);
-                return interpolated_attr_over_w * interpolated_w_inverse;
-            };
+                case FramebufferRegs::CompareFunc::LessThanOrEqual:
+                    pass = (ref <= dest);
+                    break;
 
-            Math::Vec4<u8> primary_color{
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() *
-                    255)),
-                static_cast<u8>(round(
-                    GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() *
-                    255)),
-            };
+                case FramebufferRegs::CompareFunc::GreaterThan:
+                    pass = (ref > dest);
+                    break;
 
-            Math::Vec2<float24> uv[3];
-            uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-            uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-            uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-            uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-            uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-            uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+                    pass = (ref >= dest);
+                    break;
+                }
 
-            Math::Vec4<u8> texture_color[4]{};
-            for (int i = 0; i < 3; ++i) {
-                const auto& texture = textures[i];
-                if (!texture.enabled)
-                    continue;
+                if (!pass) {
+                    UpdateStencil(stencil_test.action_stencil_fail);
+                    return false;
+                }
+            }
 
-                DEBUG_ASSERT(0 != texture.config.address);
+            // Convert float to integer
+            unsigned num_bits =
+                FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
+            u32 z = (u32)(depth * ((1 << num_bits) - 1));
 
-                int coordinate_i =
-                    (i == 2 && regs.texturing.main_config.texture2_use_coord1) ? 1 : i;
-                float24 u = uv[coordinate_i].u();
-                float24 v = uv[coordinate_i].v();
+            if (output_merger.depth_test_enable) {
+                u32 ref_z = GetDepth(x >> 4, y >> 4);
 
-                // Only unit 0 respects the texturing type (according to 3DBrew)
-                // TODO: Refactor so cubemaps and shadowmaps can be handled
-                PAddr texture_address = texture.config.GetPhysicalAddress();
-                float24 shadow_z;
-                if (i == 0) {
-                    switch (texture.config.type) {
-                    case TexturingRegs::TextureConfig::Texture2D:
-                        break;
-                    case TexturingRegs::TextureConfig::ShadowCube:
-                    case TexturingRegs::TextureConfig::TextureCube: {
-                        auto w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                        std::tie(u, v, shadow_z, texture_address) =
-                            ConvertCubeCoord(u, v, w, regs.texturing);
-                        break;
-                    }
-                    case TexturingRegs::TextureConfig::Projection2D: {
-                        auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                        u /= tc0_w;
-                        v /= tc0_w;
-                        break;
-                    }
-                    case TexturingRegs::TextureConfig::Shadow2D: {
-                        auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                        if (!regs.texturing.shadow.orthographic) {
-                            u /= tc0_w;
-                            v /= tc0_w;
-                        }
+                bool pass = false;
 
-                        shadow_z = float24::FromFloat32(std::abs(tc0_w.ToFloat32()));
-                        break;
-                    }
-                    default:
-                        // TODO: Change to LOG_ERROR when more types are handled.
-                        LOG_DEBUG(HW_GPU, "Unhandled texture type %x", (int)texture.config.type);
-                        UNIMPLEMENTED();
-                        break;
-                    }
-                }
+                switch (output_merger.depth_test_func) {
+                case FramebufferRegs::CompareFunc::Never:
+                    pass = false;
+                    break;
 
-                int s = (int)(u * float24::FromFloat32(static_cast<float>(texture.config.width)))
-                            .ToFloat32();
-                int t = (int)(v * float24::FromFloat32(static_cast<float>(texture.config.height)))
-                            .ToFloat32();
+                case FramebufferRegs::CompareFunc::Always:
+                    pass = true;
+                    break;
 
-                bool use_border_s = false;
-                bool use_border_t = false;
+                case FramebufferRegs::CompareFunc::Equal:
+                    pass = z == ref_z;
+                    break;
 
-                if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder) {
-                    use_border_s = s < 0 || s >= static_cast<int>(texture.config.width);
-                } else if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder2) {
-                    use_border_s = s >= static_cast<int>(texture.config.width);
-                }
+                case FramebufferRegs::CompareFunc::NotEqual:
+                    pass = z != ref_z;
+                    break;
 
-                if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder) {
-                    use_border_t = t < 0 || t >= static_cast<int>(texture.config.height);
-                } else if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder2) {
-                    use_border_t = t >= static_cast<int>(texture.config.height);
-                }
+                case FramebufferRegs::CompareFunc::LessThan:
+                    pass = z < ref_z;
+                    break;
 
-                if (use_border_s || use_border_t) {
-                    auto border_color = texture.config.border_color;
-                    texture_color[i] = Math::MakeVec(border_color.r.Value(), border_color.g.Value(),
-                                                     border_color.b.Value(), border_color.a.Value())
-                                           .Cast<u8>();
-                } else {
-                    // Textures are laid out from bottom to top, hence we invert the t coordinate.
-                    // NOTE: This may not be the right place for the inversion.
-                    // TODO: Check if this applies to ETC textures, too.
-                    s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
-                    t = texture.config.height - 1 -
-                        GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
+                case FramebufferRegs::CompareFunc::LessThanOrEqual:
+                    pass = z <= ref_z;
+                    break;
 
-                    const u8* texture_data = Memory::GetPhysicalPointer(texture_address);
-                    auto info =
-                        Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
+                case FramebufferRegs::CompareFunc::GreaterThan:
+                    pass = z > ref_z;
+                    break;
 
-                    // TODO: Apply the min and mag filters to the texture
-                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+                    pass = z >= ref_z;
+                    break;
                 }
 
-                if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
-                               texture.config.type == TexturingRegs::TextureConfig::ShadowCube)) {
-
-                    s32 z_int = static_cast<s32>(std::min(shadow_z.ToFloat32(), 1.0f) * 0xFFFFFF);
-                    z_int -= regs.texturing.shadow.bias << 1;
-                    auto& color = texture_color[i];
-                    s32 z_ref = (color.w << 16) | (color.z << 8) | color.y;
-                    u8 density;
-                    if (z_ref >= z_int) {
-                        density = color.x;
-                    } else {
-                        density = 0;
-                    }
-                    texture_color[i] = {density, density, density, density};
+                if (!pass) {
+                    if (stencil_action_enable)
+                        UpdateStencil(stencil_test.action_depth_fail);
+                    return false;
                 }
             }
 
-            // sample procedural texture
-            if (regs.texturing.main_config.texture3_enable) {
-                const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
-                texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
-                                           g_state.regs.texturing, g_state.proctex);
+            if (regs.framebuffer.framebuffer.allow_depth_stencil_write != 0 &&
+                output_merger.depth_write_enable) {
+
+                SetDepth(x >> 4, y >> 4, z);
             }
 
+            // The stencil depth_pass action is executed even if depth testing is disabled
+            if (stencil_action_enable)
+                UpdateStencil(stencil_test.action_depth_pass);
+            return true;
+        };
+
+        // Everything from the texture environment on, for a fragment whose lighting is in
+        // lighting_batch at the given index
+        auto ShadeFragment = [&](const Fragment& fragment, size_t index) {
+            const u16 x = fragment.x;
+            const float depth = fragment.depth;
+            const auto& primary_color = fragment.primary_color;
+            const auto& texture_color = fragment.texture_color;
+
             // Texture environment - consists of 6 stages of color and alpha combining.
             //
             // Color combiners take three input color values from some source (e.g. interpolated
@@ -454,22 +470,8 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
             Math::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
 
             if (!g_state.regs.lighting.disable) {
-                Math::Quaternion<float> normquat =
-                    Math::Quaternion<float>{
-                        {GetInterpolatedAttribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
-                         GetInterpolatedAttribute(v0.quat.y, v1.quat.y, v2.quat.y).ToFloat32(),
-                         GetInterpolatedAttribute(v0.quat.z, v1.quat.z, v2.quat.z).ToFloat32()},
-                        GetInterpolatedAttribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
-                    }
-                        .Normalized();
-
-                Math::Vec3<float> view{
-                    GetInterpolatedAttribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
-                    GetInterpolatedAttribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
-                    GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
-                };
-                std::tie(primary_fragment_color, secondary_fragment_color) = ComputeFragmentsColors(
-                    g_state.regs.lighting, g_state.lighting, normquat, view, texture_color);
+                primary_fragment_color = lighting_batch.primary_color[index];
+                secondary_fragment_color = lighting_batch.secondary_color[index];
             }
 
             for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();
@@ -571,8 +573,6 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 }
             }
 
-            const auto& output_merger = regs.framebuffer.output_merger;
-
             if (output_merger.fragment_operation_mode ==
                 FramebufferRegs::FragmentOperationMode::Shadow) {
                 u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
@@ -580,7 +580,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 u8 stencil = combiner_output.y;
                 DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
                 // skip the normal output merger pipeline if it is in shadow mode
-                continue;
+                return;
             }
 
             // TODO: Does alpha testing happen before or after stencil?
@@ -622,7 +622,7 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 }
 
                 if (!pass)
-                    continue;
+                    return;
             }
 
             // Apply fog combiner
@@ -640,141 +640,25 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
                 if (g_state.regs.texturing.fog_flip) {
                     fog_index = (1.0f - depth) * 128.0f;
                 } else {
-                    fog_index = depth * 128.0f;
-                }
-
-                // Generate clamped fog factor from LUT for given fog index
-                float fog_i = MathUtil::Clamp(floorf(fog_index), 0.0f, 127.0f);
-                float fog_f = fog_index - fog_i;
-                const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
-                float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
-                fog_factor = MathUtil::Clamp(fog_factor, 0.0f, 1.0f);
-
-                // Blend the fog
-                for (unsigned i = 0; i < 3; i++) {
-                    combiner_output[i] = static_cast<u8>(fog_factor * combiner_output[i] +
-                                                         (1.0f - fog_factor) * fog_color[i]);
-                }
-            }
-
-            u8 old_stencil = 0;
-
-            auto UpdateStencil = [stencil_test, x, y,
-                                  &old_stencil](Pica::FramebufferRegs::StencilAction action) {
-                u8 new_stencil =
-                    PerformStencilAction(action, old_stencil, stencil_test.reference_value);
-                if (g_state.regs.framebuffer.framebuffer.allow_depth_stencil_write != 0)
-                    SetStencil(x >> 4, y >> 4,
-                               (new_stencil & stencil_test.write_mask) |
-                                   (old_stencil & ~stencil_test.write_mask));
-            };
-
-            if (stencil_action_enable) {
-                old_stencil = GetStencil(x >> 4, y >> 4);
-                u8 dest = old_stencil & stencil_test.input_mask;
-                u8 ref = stencil_test.reference_value & stencil_test.input_mask;
-
-                bool pass = false;
-                switch (stencil_test.func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = (ref == dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = (ref != dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = (ref < dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = (ref <= dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = (ref > dest);
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = (ref >= dest);
-                    break;
-                }
-
-                if (!pass) {
-                    UpdateStencil(stencil_test.action_stencil_fail);
-                    continue;
-                }
-            }
-
-            // Convert float to integer
-            unsigned num_bits =
-                FramebufferRegs::DepthBitsPerPixel(regs.framebuffer.framebuffer.depth_format);
-            u32 z = (u32)(depth * ((1 << num_bits) - 1));
-
-            if (output_merger.depth_test_enable) {
-                u32 ref_z = GetDepth(x >> 4, y >> 4);
-
-                bool pass = false;
-
-                switch (output_merger.depth_test_func) {
-                case FramebufferRegs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case FramebufferRegs::CompareFunc::Equal:
-                    pass = z == ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThan:
-                    pass = z < ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
-                    break;
-
-                case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
-                    break;
-                }
-
-                if (!pass) {
-                    if (stencil_action_enable)
-                        UpdateStencil(stencil_test.action_depth_fail);
-                    continue;
+                    fog_index = depth * 128.0f;
                 }
-            }
 
-            if (regs.framebuffer.framebuffer.allow_depth_stencil_write != 0 &&
-                output_merger.depth_write_enable) {
+                // Generate clamped fog factor from LUT for given fog index
+                float fog_i = MathUtil::Clamp(floorf(fog_index), 0.0f, 127.0f);
+                float fog_f = fog_index - fog_i;
+                const auto& fog_lut_entry = g_state.fog.lut[static_cast<unsigned int>(fog_i)];
+                float fog_factor = fog_lut_entry.ToFloat() + fog_lut_entry.DiffToFloat() * fog_f;
+                fog_factor = MathUtil::Clamp(fog_factor, 0.0f, 1.0f);
 
-                SetDepth(x >> 4, y >> 4, z);
+                // Blend the fog
+                for (unsigned i = 0; i < 3; i++) {
+                    combiner_output[i] = static_cast<u8>(fog_factor * combiner_output[i] +
+                                                         (1.0f - fog_factor) * fog_color[i]);
+                }
             }
 
-            // The stencil depth_pass action is executed even if depth testing is disabled
-            if (stencil_action_enable)
-                UpdateStencil(stencil_test.action_depth_pass);
+            if (!early_depth_stencil && !PerformDepthStencilTest(x, depth))
+                return;
 
             auto dest = GetPixel(x >> 4, y >> 4);
             Math::Vec4<u8> blend_output = combiner_output;
@@ -883,10 +767,286 @@ static void ProcessTriangleInternal(const Vertex& v0, const Vertex& v1, const Ve
 
             if (regs.framebuffer.framebuffer.allow_color_write != 0)
                 DrawPixel(x >> 4, y >> 4, result);
+        };
+
+        auto FlushFragments = [&] {
+            if (!g_state.regs.lighting.disable)
+                ComputeFragmentsColors(regs.lighting, GetLightingSetup(), lighting_batch);
+            for (size_t i = 0; i < num_fragments; ++i)
+                ShadeFragment(fragments[i], i);
+            num_fragments = 0;
+            lighting_batch.count = 0;
+        };
+
+        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
+
+            // Do not process the pixel if it's inside the scissor box and the scissor mode is set
+            // to Exclude
+            if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
+                if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2)
+                    continue;
+            }
+
+            // Skip to the next tile if no fragment of the triangle can pass the depth test in
+            // the current one
+            if (use_depth_tiles && IsDepthTileRejected(x >> 4, y >> 4)) {
+                const int next_tile_x = ((x >> 4) / DEPTH_TILE_SIZE + 1) * DEPTH_TILE_SIZE;
+                const int next_x = (next_tile_x << 4) + 8;
+                if (next_x >= max_x)
+                    break;
+                x = static_cast<u16>(next_x - 0x10);
+                continue;
+            }
+
+            // Calculate the barycentric coordinates w0, w1 and w2
+            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
+            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
+            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
+            int wsum = w0 + w1 + w2;
+
+            // If current pixel is not covered by the current primitive
+            if (w0 < 0 || w1 < 0 || w2 < 0)
+                continue;
+
+            auto baricentric_coordinates =
+                Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
+                              float24::FromFloat32(static_cast<float>(w1)),
+                              float24::FromFloat32(static_cast<float>(w2)));
+            float24 interpolated_w_inverse =
+                float24::FromFloat32(1.0f) / Math::Dot(w_inverse, baricentric_coordinates);
+
+            // interpolated_z = z / w
+            float interpolated_z_over_w =
+                (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
+                 v2.screenpos[2].ToFloat32() * w2) /
+                wsum;
+
+            // Not fully accurate. About 3 bits in precision are missing.
+            // Z-Buffer (z / w * scale + offset)
+            float depth_scale = float24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+            float depth_offset =
+                float24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+            float depth = interpolated_z_over_w * depth_scale + depth_offset;
+
+            // Potentially switch to W-Buffer
+            if (regs.rasterizer.depthmap_enable ==
+                Pica::RasterizerRegs::DepthBuffering::WBuffering) {
+                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
+                depth *= interpolated_w_inverse.ToFloat32() * wsum;
+            }
+
+            // Clamp the result
+            depth = MathUtil::Clamp(depth, 0.0f, 1.0f);
+
+            // Without alpha testing nothing after texturing can discard the fragment, so the
+            // tests can run before any of the expensive per-fragment work
+            if (early_depth_stencil && !PerformDepthStencilTest(x, depth))
+                continue;
+
+            // Perspective correct attribute interpolation:
+            // Attribute values cannot be calculated by simple linear interpolation since
+            // they are not linear in screen space. For example, when interpolating a
+            // texture coordinate across two vertices, something simple like
+            //     u = (u0*w0 + u1*w1)/(w0+w1)
+            // will not work. However, the attribute value divided by the
+            // clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+            // in screenspace. Hence, we can linearly interpolate these two independently and
+            // calculate the interpolated attribute by dividing the results.
+            // I.e.
+            //     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+            //     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+            //     u = u_over_w / one_over_w
+            //
+            // The generalization to three vertices is straightforward in baricentric coordinates.
+            auto GetInterpolatedAttribute = [&](float24 attr0, float24 attr1, float24 attr2) {
+                auto attr_over_w = Math::MakeVec(attr0, attr1, attr2);
+                float24 interpolated_attr_over_w = Math::Dot(attr_over_w, baricentric_coordinates);
+                return interpolated_attr_over_w * interpolated_w_inverse;
+            };
+
+            Math::Vec4<u8> primary_color{
+                static_cast<u8>(round(
+                    GetInterpolatedAttribute(v0.color.r(), v1.color.r(), v2.color.r()).ToFloat32() *
+                    255)),
+                static_cast<u8>(round(
+                    GetInterpolatedAttribute(v0.color.g(), v1.color.g(), v2.color.g()).ToFloat32() *
+                    255)),
+                static_cast<u8>(round(
+                    GetInterpolatedAttribute(v0.color.b(), v1.color.b(), v2.color.b()).ToFloat32() *
+                    255)),
+                static_cast<u8>(round(
+                    GetInterpolatedAttribute(v0.color.a(), v1.color.a(), v2.color.a()).ToFloat32() *
+                    255)),
+            };
+
+            Math::Vec2<float24> uv[3];
+            uv[0].u() = GetInterpolatedAttribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
+            uv[0].v() = GetInterpolatedAttribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
+            uv[1].u() = GetInterpolatedAttribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
+            uv[1].v() = GetInterpolatedAttribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
+            uv[2].u() = GetInterpolatedAttribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
+            uv[2].v() = GetInterpolatedAttribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+
+            Math::Vec4<u8> texture_color[4]{};
+            for (int i = 0; i < 3; ++i) {
+                const auto& texture = textures[i];
+                if (!texture.enabled)
+                    continue;
+
+                DEBUG_ASSERT(0 != texture.config.address);
+
+                int coordinate_i =
+                    (i == 2 && regs.texturing.main_config.texture2_use_coord1) ? 1 : i;
+                float24 u = uv[coordinate_i].u();
+                float24 v = uv[coordinate_i].v();
+
+                // Only unit 0 respects the texturing type (according to 3DBrew)
+                // TODO: Refactor so cubemaps and shadowmaps can be handled
+                PAddr texture_address = texture.config.GetPhysicalAddress();
+                float24 shadow_z;
+                if (i == 0) {
+                    switch (texture.config.type) {
+                    case TexturingRegs::TextureConfig::Texture2D:
+                        break;
+                    case TexturingRegs::TextureConfig::ShadowCube:
+                    case TexturingRegs::TextureConfig::TextureCube: {
+                        auto w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
+                        std::tie(u, v, shadow_z, texture_address) =
+                            ConvertCubeCoord(u, v, w, regs.texturing);
+                        break;
+                    }
+                    case TexturingRegs::TextureConfig::Projection2D: {
+                        auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
+                        u /= tc0_w;
+                        v /= tc0_w;
+                        break;
+                    }
+                    case TexturingRegs::TextureConfig::Shadow2D: {
+                        auto tc0_w = GetInterpolatedAttribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
+                        if (!regs.texturing.shadow.orthographic) {
+                            u /= tc0_w;
+                            v /= tc0_w;
+                        }
+
+                        shadow_z = float24::FromFloat32(std::abs(tc0_w.ToFloat32()));
+                        break;
+                    }
+                    default:
+                        // TODO: Change to LOG_ERROR when more types are handled.
+                        LOG_DEBUG(HW_GPU, "Unhandled texture type %x", (int)texture.config.type);
+                        UNIMPLEMENTED();
+                        break;
+                    }
+                }
+
+                int s = (int)(u * float24::FromFloat32(static_cast<float>(texture.config.width)))
+                            .ToFloat32();
+                int t = (int)(v * float24::FromFloat32(static_cast<float>(texture.config.height)))
+                            .ToFloat32();
+
+                bool use_border_s = false;
+                bool use_border_t = false;
+
+                if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder) {
+                    use_border_s = s < 0 || s >= static_cast<int>(texture.config.width);
+                } else if (texture.config.wrap_s == TexturingRegs::TextureConfig::ClampToBorder2) {
+                    use_border_s = s >= static_cast<int>(texture.config.width);
+                }
+
+                if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder) {
+                    use_border_t = t < 0 || t >= static_cast<int>(texture.config.height);
+                } else if (texture.config.wrap_t == TexturingRegs::TextureConfig::ClampToBorder2) {
+                    use_border_t = t >= static_cast<int>(texture.config.height);
+                }
+
+                if (use_border_s || use_border_t) {
+                    auto border_color = texture.config.border_color;
+                    texture_color[i] = Math::MakeVec(border_color.r.Value(), border_color.g.Value(),
+                                                     border_color.b.Value(), border_color.a.Value())
+                                           .Cast<u8>();
+                } else {
+                    // Textures are laid out from bottom to top, hence we invert the t coordinate.
+                    // NOTE: This may not be the right place for the inversion.
+                    // TODO: Check if this applies to ETC textures, too.
+                    s = GetWrappedTexCoord(texture.config.wrap_s, s, texture.config.width);
+                    t = texture.config.height - 1 -
+                        GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
+
+                    const u8* texture_data = Memory::GetPhysicalPointer(texture_address);
+                    auto info =
+                        Texture::TextureInfo::FromPicaRegister(texture.config, texture.format);
+
+                    // TODO: Apply the min and mag filters to the texture
+                    texture_color[i] = Texture::LookupTexture(texture_data, s, t, info);
+                }
+
+                if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
+                               texture.config.type == TexturingRegs::TextureConfig::ShadowCube)) {
+
+                    s32 z_int = static_cast<s32>(std::min(shadow_z.ToFloat32(), 1.0f) * 0xFFFFFF);
+                    z_int -= regs.texturing.shadow.bias << 1;
+                    auto& color = texture_color[i];
+                    s32 z_ref = (color.w << 16) | (color.z << 8) | color.y;
+                    u8 density;
+                    if (z_ref >= z_int) {
+                        density = color.x;
+                    } else {
+                        density = 0;
+                    }
+                    texture_color[i] = {density, density, density, density};
+                }
+            }
+
+            // sample procedural texture
+            if (regs.texturing.main_config.texture3_enable) {
+                const auto& proctex_uv = uv[regs.texturing.main_config.texture3_coordinates];
+                texture_color[3] = ProcTex(proctex_uv.u().ToFloat32(), proctex_uv.v().ToFloat32(),
+                                           regs.texturing, GetProcTexTables());
+            }
+
+            if (!g_state.regs.lighting.disable) {
+                Math::Quaternion<float> normquat =
+                    Math::Quaternion<float>{
+                        {GetInterpolatedAttribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
+                         GetInterpolatedAttribute(v0.quat.y, v1.quat.y, v2.quat.y).ToFloat32(),
+                         GetInterpolatedAttribute(v0.quat.z, v1.quat.z, v2.quat.z).ToFloat32()},
+                        GetInterpolatedAttribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
+                    }
+                        .Normalized();
+
+                Math::Vec3<float> view{
+                    GetInterpolatedAttribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
+                    GetInterpolatedAttribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
+                    GetInterpolatedAttribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
+                };
+                lighting_batch.Add(normquat, view, texture_color);
+            }
+
+            Fragment& fragment = fragments[num_fragments++];
+            fragment.x = x;
+            fragment.depth = depth;
+            fragment.primary_color = primary_color;
+            std::copy(std::begin(texture_color), std::end(texture_color),
+                      std::begin(fragment.texture_color));
+            if (num_fragments == fragments.size())
+                FlushFragments();
         }
+
+        FlushFragments();
     }
 }
 
+bool CanTestDepthEarly(const Regs& regs) {
+    const auto& output_merger = regs.framebuffer.output_merger;
+    // Alpha testing is the only stage after texturing that can discard a fragment. Shadow
+    // rendering replaces the depth test, and gas rendering, which shares its stage with fog, is
+    // based on the depth buffer contents, so these keep the tests in their usual place.
+    const bool shadow_mode =
+        output_merger.fragment_operation_mode == FramebufferRegs::FragmentOperationMode::Shadow;
+    return !shadow_mode && !output_merger.alpha_test.enable &&
+           regs.texturing.fog_mode == TexturingRegs::FogMode::None;
+}
+
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
     ProcessTriangleInternal(v0, v1, v2);
 }
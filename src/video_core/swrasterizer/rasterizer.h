@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "video_core/regs.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica {
@@ -42,5 +43,11 @@ struct Vertex : Shader::OutputVertex {
 
 void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2);
 
+/**
+ * Returns whether the depth and stencil tests can run right after rasterization, before any of the
+ * per-fragment work, with the given registers. Otherwise they run after fog, in the output merger.
+ */
+bool CanTestDepthEarly(const Regs& regs);
+
 } // namespace Rasterizer
 } // namespace Pica
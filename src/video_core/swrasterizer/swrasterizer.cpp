@@ -2,15 +2,93 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "video_core/pica_state.h"
+#include "video_core/regs.h"
 #include "video_core/swrasterizer/clipper.h"
+#include "video_core/swrasterizer/framebuffer.h"
+#include "video_core/swrasterizer/lighting.h"
+#include "video_core/swrasterizer/proctex.h"
 #include "video_core/swrasterizer/swrasterizer.h"
 
 namespace VideoCore {
 
+SWRasterizer::SWRasterizer() {
+    // The Pica state may have changed while another rasterizer was active
+    Pica::InvalidateLightingSetup();
+    Pica::Rasterizer::InvalidateProcTexTables();
+}
+
+SWRasterizer::~SWRasterizer() {
+    // Release the depth buffer pages so that they don't stay marked as cached
+    Pica::Rasterizer::ResetDepthTiles();
+}
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    vertex_batch.push_back(v0);
+    vertex_batch.push_back(v1);
+    vertex_batch.push_back(v2);
+}
+
+void SWRasterizer::DrawTriangles() {
+    if (vertex_batch.empty())
+        return;
+
+    Pica::Clipper::ProcessTriangles(vertex_batch);
+    vertex_batch.clear();
+}
+
+void SWRasterizer::InvalidateRegion(PAddr addr, u32 size) {
+    Pica::Rasterizer::InvalidateDepthTiles(addr, size);
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    Pica::Rasterizer::InvalidateDepthTiles(addr, size);
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    switch (id) {
+    // Lighting LUT data, which goes to the LUT selected by lut_config
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[0], 0x1c8):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[1], 0x1c9):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[2], 0x1ca):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[3], 0x1cb):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[4], 0x1cc):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[5], 0x1cd):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[6], 0x1ce):
+    case PICA_REG_INDEX_WORKAROUND(lighting.lut_data[7], 0x1cf):
+        Pica::InvalidateLightingLut(Pica::g_state.regs.lighting.lut_config.type);
+        return;
+    // Only selects where LUT data goes, nothing is derived from it
+    case PICA_REG_INDEX(lighting.lut_config):
+        return;
+    }
+
+    static constexpr u32 lighting_regs_begin = PICA_REG_INDEX(lighting);
+    static constexpr u32 lighting_regs_end =
+        lighting_regs_begin + sizeof(Pica::LightingRegs) / sizeof(u32);
+    if (id >= lighting_regs_begin && id < lighting_regs_end) {
+        Pica::InvalidateLightingParameters();
+        return;
+    }
+
+    switch (id) {
+    // ProcTex state
+    case PICA_REG_INDEX(texturing.proctex_noise_u):
+    case PICA_REG_INDEX(texturing.proctex_noise_v):
+    case PICA_REG_INDEX(texturing.proctex_noise_frequency):
+    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[0], 0xb0):
+    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[1], 0xb1):
+    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[2], 0xb2):
+    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[3], 0xb3):
+    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[4], 0xb4):
+    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[5], 0xb5):
+    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[6], 0xb6):
+    case PICA_REG_INDEX_WORKAROUND(texturing.proctex_lut_data[7], 0xb7):
+        Pica::Rasterizer::InvalidateProcTexTables();
+        break;
+    }
 }
 
 } // namespace VideoCore
@@ -4,26 +4,30 @@
 
 #pragma once
 
+#include <vector>
 #include "common/common_types.h"
 #include "video_core/rasterizer_interface.h"
-
-namespace Pica {
-namespace Shader {
-struct OutputVertex;
-}
-} // namespace Pica
+#include "video_core/shader/shader.h"
 
 namespace VideoCore {
 
 class SWRasterizer : public RasterizerInterface {
+public:
+    SWRasterizer();
+    ~SWRasterizer() override;
+
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
-    void NotifyPicaRegisterChanged(u32 id) override {}
+    void DrawTriangles() override;
+    void NotifyPicaRegisterChanged(u32 id) override;
     void FlushAll() override {}
     void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
+    void InvalidateRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+
+private:
+    /// Triangles of the current draw, processed together by DrawTriangles
+    std::vector<Pica::Shader::OutputVertex> vertex_batch;
 };
 
 } // namespace VideoCore